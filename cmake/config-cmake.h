@@ -24,6 +24,9 @@
 /* Define to 1 if you have the <sys/types.h> header file. */
 #cmakedefine HAVE_SYS_TYPES_H 1
 
+/* Define to 1 if you have the <sys/mman.h> header file. */
+#cmakedefine HAVE_SYS_MMAN_H 1
+
 /* Define to 1 if you have the <sys/xattr.h> header file. */
 #cmakedefine HAVE_SYS_XATTR_H 1
 
@@ -57,6 +60,9 @@
 /* Define to 1 if you have the 'strdup' function */
 #cmakedefine HAVE_STRDUP 1
 
+/* Define to 1 if you have the 'ftruncate' function */
+#cmakedefine HAVE_FTRUNCATE 1
+
 /* Define to 1 if you have the 'lsetxattr' and 'lgetxattr' functions */
 #cmakedefine HAVE_LXETXATTR 1
 
@@ -75,6 +81,9 @@
 /* Define to 1 to enable trace logs - undefine to slightly increase speed */
 #cmakedefine ENABLE_TRACING 1
 
+/* Subsystems with binary event tracing compiled in, see evtrace.h */
+#define EVTRACE_COMPILE_MASK (@EVTRACE_COMPILE_MASK@)
+
 /* Define to 1 if you have the 'posix_memalign' function */
 #cmakedefine HAVE_POSIX_MEMALIGN 1
 
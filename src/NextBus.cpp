@@ -3,6 +3,7 @@
 #include "NextBus.hpp"
 #include "nbic.h"
 #include "dimension.hpp"
+#include "evtrace.h"
 
 static Uint8 bus_error(Uint32 addr, int read, int size, uae_u32 val, const char* acc) {
     Log_Printf(LOG_WARN, "[NextBus] Bus error %s at %08X", acc, addr);
@@ -31,6 +32,7 @@ void NextBusSlot::board_bput(Uint32 addr, Uint8 val)  {bus_error(addr, BUS_ERROR
 
 void NextBusSlot::reset(void) {}
 void NextBusSlot::pause(bool pause) {}
+void NextBusSlot::snapshot(bool save) {}
 
 NextBusBoard::NextBusBoard(int slot) : NextBusSlot(slot) {}
 
@@ -72,43 +74,52 @@ extern "C" {
     /* Slot memory */
     Uint32 nextbus_slot_lget(Uint32 addr) {
         int slot = SLOT(addr);
-        Log_Printf(LOG_NEXTBUS_LEVEL, "[NextBus] Slot %i: lget at %08X",slot,addr);
         
-        return nextbus[slot]->slot_lget(addr);
+        Uint32 val = nextbus[slot]->slot_lget(addr);
+        EVTRACE_LOG(EV_BUS_SLOT_RD, slot, 32, addr, val,
+                    LOG_NEXTBUS_LEVEL, "[NextBus] Slot %i: lget at %08X, val %08X",slot,addr,val);
+        return val;
     }
     
     Uint32 nextbus_slot_wget(Uint32 addr) {
         int slot = SLOT(addr);
-        Log_Printf(LOG_NEXTBUS_LEVEL, "[NextBus] Slot %i: wget at %08X",slot,addr);
         
-        return nextbus[slot]->slot_wget(addr);
+        Uint32 val = nextbus[slot]->slot_wget(addr);
+        EVTRACE_LOG(EV_BUS_SLOT_RD, slot, 16, addr, val,
+                    LOG_NEXTBUS_LEVEL, "[NextBus] Slot %i: wget at %08X, val %04X",slot,addr,val);
+        return val;
     }
     
     Uint32 nextbus_slot_bget(Uint32 addr) {
         int slot = SLOT(addr);
-        Log_Printf(LOG_NEXTBUS_LEVEL, "[NextBus] Slot %i: bget at %08X",slot,addr);
         
-        return nextbus[slot]->slot_bget(addr);
+        Uint32 val = nextbus[slot]->slot_bget(addr);
+        EVTRACE_LOG(EV_BUS_SLOT_RD, slot, 8, addr, val,
+                    LOG_NEXTBUS_LEVEL, "[NextBus] Slot %i: bget at %08X, val %02X",slot,addr,val);
+        return val;
     }
     
     void nextbus_slot_lput(Uint32 addr, Uint32 val) {
         int slot = SLOT(addr);
-        Log_Printf(LOG_NEXTBUS_LEVEL, "[NextBus] Slot %i: lput at %08X, val %08X",slot,addr,val);
         
+        EVTRACE_LOG(EV_BUS_SLOT_WR, slot, 32, addr, val,
+                    LOG_NEXTBUS_LEVEL, "[NextBus] Slot %i: lput at %08X, val %08X",slot,addr,val);
         nextbus[slot]->slot_lput(addr, val);
     }
     
     void nextbus_slot_wput(Uint32 addr, Uint32 val) {
         int slot = SLOT(addr);
-        Log_Printf(LOG_NEXTBUS_LEVEL, "[NextBus] Slot %i: wput at %08X, val %04X",slot,addr,val);
         
+        EVTRACE_LOG(EV_BUS_SLOT_WR, slot, 16, addr, val,
+                    LOG_NEXTBUS_LEVEL, "[NextBus] Slot %i: wput at %08X, val %04X",slot,addr,val);
         nextbus[slot]->slot_wput(addr, val);
     }
     
     void nextbus_slot_bput(Uint32 addr, Uint32 val) {
         int slot = SLOT(addr);
-        Log_Printf(LOG_NEXTBUS_LEVEL, "[NextBus] Slot %i: bput at %08X, val %02X",slot,addr,val);
         
+        EVTRACE_LOG(EV_BUS_SLOT_WR, slot, 8, addr, val,
+                    LOG_NEXTBUS_LEVEL, "[NextBus] Slot %i: bput at %08X, val %02X",slot,addr,val);
         nextbus[slot]->slot_bput(addr, val);
     }
     
@@ -116,43 +127,52 @@ extern "C" {
 
     Uint32 nextbus_board_lget(Uint32 addr) {
         int board = BOARD(addr);
-        Log_Printf(LOG_NEXTBUS_LEVEL, "[NextBus] Board %i: lget at %08X",board,addr);
         
-        return nextbus[board]->board_lget(addr);
+        Uint32 val = nextbus[board]->board_lget(addr);
+        EVTRACE_LOG(EV_BUS_BOARD_RD, board, 32, addr, val,
+                    LOG_NEXTBUS_LEVEL, "[NextBus] Board %i: lget at %08X, val %08X",board,addr,val);
+        return val;
     }
     
     Uint32 nextbus_board_wget(Uint32 addr) {
         int board = BOARD(addr);
-        Log_Printf(LOG_NEXTBUS_LEVEL, "[NextBus] Board %i: wget at %08X",board,addr);
         
-        return nextbus[board]->board_wget(addr);
+        Uint32 val = nextbus[board]->board_wget(addr);
+        EVTRACE_LOG(EV_BUS_BOARD_RD, board, 16, addr, val,
+                    LOG_NEXTBUS_LEVEL, "[NextBus] Board %i: wget at %08X, val %04X",board,addr,val);
+        return val;
     }
     
     Uint32 nextbus_board_bget(Uint32 addr) {
         int board = BOARD(addr);
-        Log_Printf(LOG_NEXTBUS_LEVEL, "[NextBus] Board %i: bget at %08X",board,addr);
         
-        return nextbus[board]->board_bget(addr);
+        Uint32 val = nextbus[board]->board_bget(addr);
+        EVTRACE_LOG(EV_BUS_BOARD_RD, board, 8, addr, val,
+                    LOG_NEXTBUS_LEVEL, "[NextBus] Board %i: bget at %08X, val %02X",board,addr,val);
+        return val;
     }
     
     void nextbus_board_lput(Uint32 addr, Uint32 val) {
         int board = BOARD(addr);
-        Log_Printf(LOG_NEXTBUS_LEVEL, "[NextBus] Board %i: lput at %08X, val %08X",board,addr,val);
         
+        EVTRACE_LOG(EV_BUS_BOARD_WR, board, 32, addr, val,
+                    LOG_NEXTBUS_LEVEL, "[NextBus] Board %i: lput at %08X, val %08X",board,addr,val);
         nextbus[board]->board_lput(addr, val);
     }
     
     void nextbus_board_wput(Uint32 addr, Uint32 val) {
         int board = BOARD(addr);
-        Log_Printf(LOG_NEXTBUS_LEVEL, "[NextBus] Board %i: wput at %08X, val %04X",board,addr,val);
         
+        EVTRACE_LOG(EV_BUS_BOARD_WR, board, 16, addr, val,
+                    LOG_NEXTBUS_LEVEL, "[NextBus] Board %i: wput at %08X, val %04X",board,addr,val);
         nextbus[board]->board_wput(addr, val);
     }
     
     void nextbus_board_bput(Uint32 addr, Uint32 val) {
         int board = BOARD(addr);
-        Log_Printf(LOG_NEXTBUS_LEVEL, "[NextBus] Board %i: bput at %08X, val %02X",board,addr,val);
         
+        EVTRACE_LOG(EV_BUS_BOARD_WR, board, 8, addr, val,
+                    LOG_NEXTBUS_LEVEL, "[NextBus] Board %i: bput at %08X, val %02X",board,addr,val);
         nextbus[board]->board_bput(addr, val);
     }
     
@@ -188,4 +208,9 @@ extern "C" {
         for(int slot = 0; slot < 16; slot++)
             nextbus[slot]->pause(pause);
     }
+    
+    void NextBus_MemorySnapShot_Capture(bool bSave) {
+        for(int slot = 0; slot < 16; slot++)
+            nextbus[slot]->snapshot(bSave);
+    }
 }
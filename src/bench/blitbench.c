@@ -0,0 +1,122 @@
+/*
+  Previous - blitbench.c
+
+  This file is distributed under the GNU Public License, version 2 or at
+  your option any later version. Read the file gpl.txt for details.
+
+  Benchmark for the framebuffer conversion kernels of the repaint thread.
+  Converts full frames of the 2-bit grayscale, 16-bit color and 32-bit
+  NeXTdimension framebuffers with the scalar kernels and with each SIMD
+  instruction set supported by the host. Prints frames per second and
+  checks that every kernel produces the same output as the scalar one.
+
+  usage: blitbench [frames]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "main.h"
+#include "blit.h"
+
+#define BLITBENCH_WIDTH  1120
+#define BLITBENCH_HEIGHT 832
+#define BLITBENCH_PITCH  (BLITBENCH_WIDTH + 32)   /* non-Turbo line length in pixels */
+
+static const struct {
+    const char* name;
+    int         isa;
+} Isas[] = {
+    { "scalar", BLIT_ISA_SCALAR },
+    { "sse2",   BLIT_ISA_SSE2 },
+    { "avx2",   BLIT_ISA_AVX2 },
+    { "neon",   BLIT_ISA_NEON },
+};
+
+static Uint8  SrcBW[BLITBENCH_PITCH / 4 * BLITBENCH_HEIGHT];
+static Uint8  SrcColor[BLITBENCH_PITCH * 2 * BLITBENCH_HEIGHT];
+static Uint32 SrcDimension[BLITBENCH_PITCH * BLITBENCH_HEIGHT];
+static Uint32 Dst[BLITBENCH_WIDTH * BLITBENCH_HEIGHT];
+static Uint32 Ref[3][BLITBENCH_WIDTH * BLITBENCH_HEIGHT];
+
+static Uint64 Now(void) {
+    return SDL_GetPerformanceCounter();
+}
+
+static double Seconds(Uint64 start) {
+    return (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+}
+
+/* Convert one frame line by line like the repaint thread does */
+static void blitbench_frame(blitLineFunc line, const Uint8* src, int pitch) {
+    for(int y = 0; y < BLITBENCH_HEIGHT; y++)
+        line(&Dst[y * BLITBENCH_WIDTH], src + y * pitch, BLITBENCH_WIDTH);
+}
+
+static void blitbench_dimension_frame(blitDimensionLineFunc line, const ndformat_t* f) {
+    for(int y = 0; y < BLITBENCH_HEIGHT; y++)
+        line(&Dst[y * BLITBENCH_WIDTH], &SrcDimension[y * BLITBENCH_PITCH], BLITBENCH_WIDTH, f);
+}
+
+/* Returns frames per second, checks the output against ref (or sets ref) */
+static double blitbench_run(int kind, int isa, int frames, const ndformat_t* f, bool* ok) {
+    blitDimensionLineFunc dline = blitDimensionSelect(f, isa);
+    Uint64 start = Now();
+
+    for(int i = 0; i < frames; i++) {
+        switch (kind) {
+            case 0: blitbench_frame(blitBWLine,    SrcBW,    BLITBENCH_PITCH / 4); break;
+            case 1: blitbench_frame(blitColorLine, SrcColor, BLITBENCH_PITCH * 2); break;
+            case 2: blitbench_dimension_frame(dline, f); break;
+        }
+    }
+    double elapsed = Seconds(start);
+
+    if (isa == BLIT_ISA_SCALAR)
+        memcpy(Ref[kind], Dst, sizeof(Dst));
+    else if (memcmp(Ref[kind], Dst, sizeof(Dst)))
+        *ok = false;
+    return frames / elapsed;
+}
+
+int main(int argc, char* argv[]) {
+    int        frames = argc > 1 ? atoi(argv[1]) : 200;
+    Uint32     seed   = 1;
+    double     base[3] = {0, 0, 0};
+    bool       ok      = true;
+    ndformat_t f;
+
+    if (frames < 1) frames = 1;
+
+    /* Random framebuffer contents, so that no kernel can profit from runs */
+    for(size_t i = 0; i < sizeof(SrcBW); i++)        { seed = seed * 1103515245 + 12345; SrcBW[i]        = seed >> 16; }
+    for(size_t i = 0; i < sizeof(SrcColor); i++)     { seed = seed * 1103515245 + 12345; SrcColor[i]     = seed >> 16; }
+    for(size_t i = 0; i < BLITBENCH_PITCH * BLITBENCH_HEIGHT; i++) {
+        seed = seed * 1103515245 + 12345; SrcDimension[i] = seed;
+    }
+
+    /* Color kernels are written for ARGB8888 textures, NeXTdimension
+     * frames only need conversion for other formats */
+    blitInit(SDL_PIXELFORMAT_ARGB8888);
+    blitDimensionFormat(&f, SDL_PIXELFORMAT_ABGR8888);
+
+    printf("%d frames of %dx%d\n", frames, BLITBENCH_WIDTH, BLITBENCH_HEIGHT);
+    printf("isa      bw fps   speedup  color fps  speedup  dimension fps  speedup\n");
+    for(size_t i = 0; i < sizeof(Isas) / sizeof(Isas[0]); i++) {
+        double fps[3];
+        if (!blitSelect(SDL_PIXELFORMAT_ARGB8888, Isas[i].isa))
+            continue;
+        for(int kind = 0; kind < 3; kind++) {
+            fps[kind] = blitbench_run(kind, Isas[i].isa, frames, &f, &ok);
+            if (Isas[i].isa == BLIT_ISA_SCALAR) base[kind] = fps[kind];
+        }
+        printf("%-6s %9.0f  %6.2fx  %9.0f  %6.2fx  %13.0f  %6.2fx\n", Isas[i].name,
+               fps[0], fps[0] / base[0], fps[1], fps[1] / base[1], fps[2], fps[2] / base[2]);
+    }
+    if (!ok) {
+        fprintf(stderr, "SIMD output differs from scalar output\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,301 @@
+/*
+  Previous - cycintbench.c
+
+  This file is distributed under the GNU Public License, version 2 or at
+  your option any later version. Read the file gpl.txt for details.
+
+  Benchmark for the CycInt event queue. Replays a trace of add, remove and
+  acknowledge operations against cycInt.c and prints the operations per
+  second. Without a trace file a trace is generated from a model of the
+  periodic (VBL, hardclock, event loop) and short I/O (SCSI, M2M DMA,
+  Ethernet, sound, ...) handlers; if a file name is given that does not
+  exist yet, the generated trace is written to it so that the same trace
+  can be replayed against other versions of cycInt.c.
+
+  Trace file format, one operation per line:
+    a <interrupt_id> <cycles>   CycInt_AddRelativeInterruptCycles
+    r <interrupt_id>            CycInt_RemovePendingInterrupt
+    k <interrupt_id> <cycles>   run <cycles> CPU cycles, then the handler
+                                <interrupt_id> fires and is acknowledged
+                                (nothing fires for INTERRUPT_NULL)
+
+  usage: cycintbench [operations] [trace_file] [runs]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "main.h"
+#include "configuration.h"
+#include "cycInt.h"
+#include "memorySnapShot.h"
+
+CNF_PARAMS ConfigureParams;
+
+static int FiredInterrupt;
+
+/* cycInt.c only needs the handler functions, the host time and snapshots */
+#define CYCINTBENCH_HANDLER(name, id) void name(void) { FiredInterrupt = id; }
+
+CYCINTBENCH_HANDLER(Video_InterruptHandler_VBL,  INTERRUPT_VIDEO_VBL)
+CYCINTBENCH_HANDLER(Hardclock_InterruptHandler,  INTERRUPT_HARDCLOCK)
+CYCINTBENCH_HANDLER(Mouse_Handler,               INTERRUPT_MOUSE)
+CYCINTBENCH_HANDLER(ESP_InterruptHandler,        INTERRUPT_ESP)
+CYCINTBENCH_HANDLER(ESP_IO_Handler,              INTERRUPT_ESP_IO)
+CYCINTBENCH_HANDLER(M2MDMA_IO_Handler,           INTERRUPT_M2M_IO)
+CYCINTBENCH_HANDLER(MO_InterruptHandler,         INTERRUPT_MO)
+CYCINTBENCH_HANDLER(MO_IO_Handler,               INTERRUPT_MO_IO)
+CYCINTBENCH_HANDLER(ECC_IO_Handler,              INTERRUPT_ECC_IO)
+CYCINTBENCH_HANDLER(ENET_IO_Handler,             INTERRUPT_ENET_IO)
+CYCINTBENCH_HANDLER(FLP_IO_Handler,              INTERRUPT_FLP_IO)
+CYCINTBENCH_HANDLER(SND_Out_Handler,             INTERRUPT_SND_OUT)
+CYCINTBENCH_HANDLER(SND_In_Handler,              INTERRUPT_SND_IN)
+CYCINTBENCH_HANDLER(Printer_IO_Handler,          INTERRUPT_LP_IO)
+CYCINTBENCH_HANDLER(SCC_IO_Handler,              INTERRUPT_SCC_IO)
+CYCINTBENCH_HANDLER(Main_EventHandlerInterrupt,  INTERRUPT_EVENT_LOOP)
+CYCINTBENCH_HANDLER(nd_vbl_handler,              INTERRUPT_ND_VBL)
+CYCINTBENCH_HANDLER(nd_video_vbl_handler,        INTERRUPT_ND_VIDEO_VBL)
+
+Uint64 host_time_us(void) {
+    return 0;
+}
+
+void MemorySnapShot_Store(void *pData, int Size) {
+}
+
+enum {
+    OP_ADD,
+    OP_REMOVE,
+    OP_ACK,
+};
+
+typedef struct {
+    int          op;
+    interrupt_id id;
+    Sint64       cycles;
+} TRACEOP;
+
+static TRACEOP* Trace;
+static int      TraceCount;
+static int      TraceSize;
+
+static void trace_append(int op, interrupt_id id, Sint64 cycles) {
+    if (TraceCount == TraceSize) {
+        TraceSize = TraceSize ? TraceSize * 2 : 4096;
+        Trace     = realloc(Trace, TraceSize * sizeof(TRACEOP));
+        if (Trace == NULL) {
+            fprintf(stderr, "Out of memory\n");
+            exit(1);
+        }
+    }
+    Trace[TraceCount].op     = op;
+    Trace[TraceCount].id     = id;
+    Trace[TraceCount].cycles = cycles;
+    TraceCount++;
+}
+
+/* Same bookkeeping as M68000_AddCycles without the microsecond check */
+static inline void cycintbench_add_cycles(Sint64 cycles) {
+    if (PendingInterrupt.type == CYC_INT_CPU)
+        PendingInterrupt.time -= cycles;
+    nCyclesMainCounter += cycles;
+}
+
+/* Periodic handlers with their period in CPU cycles at 25 MHz */
+static const struct {
+    interrupt_id id;
+    Sint64       period;
+} PeriodicHandlers[] = {
+    { INTERRUPT_VIDEO_VBL,    25000000 / 68 },
+    { INTERRUPT_ND_VBL,       25000000 / 68 },
+    { INTERRUPT_ND_VIDEO_VBL, 25000000 / 68 },
+    { INTERRUPT_HARDCLOCK,    25000000 / 100 },
+    { INTERRUPT_EVENT_LOOP,   25000000 / 1000 },
+    { INTERRUPT_MOUSE,        25000000 / 100 },
+};
+
+/* Short I/O handlers which are scheduled after a few hundred or thousand
+ * cycles and are often removed before they fire */
+static const interrupt_id IOHandlers[] = {
+    INTERRUPT_ESP,
+    INTERRUPT_ESP_IO,
+    INTERRUPT_M2M_IO,
+    INTERRUPT_MO,
+    INTERRUPT_MO_IO,
+    INTERRUPT_ECC_IO,
+    INTERRUPT_ENET_IO,
+    INTERRUPT_FLP_IO,
+    INTERRUPT_SND_OUT,
+    INTERRUPT_SND_IN,
+    INTERRUPT_LP_IO,
+    INTERRUPT_SCC_IO,
+};
+
+#define NUM_PERIODIC (int)(sizeof(PeriodicHandlers) / sizeof(PeriodicHandlers[0]))
+#define NUM_IO       (int)(sizeof(IOHandlers) / sizeof(IOHandlers[0]))
+
+static Uint32 Seed = 1;
+
+static Uint32 cycintbench_random(void) {
+    Seed = Seed * 1103515245 + 12345;
+    return Seed >> 8;
+}
+
+/* Deadlines are rounded up so that each handler has its own residue modulo
+ * 32. Two handlers never become due at the same cycle, which keeps the firing
+ * order independent of how a cycInt.c version breaks ties. */
+static void cycintbench_add(interrupt_id id, Sint64 cycles) {
+    cycles += (id - (nCyclesMainCounter + cycles)) & 31;
+    trace_append(OP_ADD, id, cycles);
+    CycInt_AddRelativeInterruptCycles(cycles, id);
+}
+
+/**
+ * Generate a trace by running the model against cycInt.c itself.
+ */
+static void cycintbench_generate(int operations) {
+    int i;
+
+    CycInt_Reset();
+    for (i = 0; i < NUM_PERIODIC; i++)
+        cycintbench_add(PeriodicHandlers[i].id, PeriodicHandlers[i].period);
+
+    while (TraceCount < operations) {
+        /* Devices start and cancel I/O, then some CPU time passes */
+        Uint32       r  = cycintbench_random();
+        interrupt_id id = IOHandlers[r % NUM_IO];
+        Sint64       cycles;
+
+        if ((r >> 8) % 4 == 0 && CycInt_InterruptActive(id)) {
+            trace_append(OP_REMOVE, id, 0);
+            CycInt_RemovePendingInterrupt(id);
+        } else if ((r >> 8) % 4 == 1) {
+            cycintbench_add(id, 100 + (r >> 12) % 4000);
+        }
+
+        cycles = cycintbench_random() % 400;
+        if (cycles < PendingInterrupt.time) {
+            trace_append(OP_ACK, INTERRUPT_NULL, cycles);
+            cycintbench_add_cycles(cycles);
+            continue;
+        }
+
+        /* The next interrupt fires, periodic handlers reschedule themselves */
+        cycles = PendingInterrupt.time > 0 ? PendingInterrupt.time : 0;
+        cycintbench_add_cycles(cycles);
+        PendingInterrupt.pFunction();
+        trace_append(OP_ACK, FiredInterrupt, cycles);
+        CycInt_AcknowledgeInterrupt();
+        for (i = 0; i < NUM_PERIODIC; i++) {
+            if (PeriodicHandlers[i].id == FiredInterrupt)
+                cycintbench_add(FiredInterrupt, PeriodicHandlers[i].period);
+        }
+    }
+}
+
+/**
+ * Replay the trace, returns false if an interrupt fired in a different
+ * order than recorded.
+ */
+static bool cycintbench_replay(void) {
+    int i;
+
+    CycInt_Reset();
+    for (i = 0; i < TraceCount; i++) {
+        const TRACEOP* t = &Trace[i];
+        switch (t->op) {
+            case OP_ADD:
+                CycInt_AddRelativeInterruptCycles(t->cycles, t->id);
+                break;
+            case OP_REMOVE:
+                CycInt_RemovePendingInterrupt(t->id);
+                break;
+            case OP_ACK:
+                cycintbench_add_cycles(t->cycles);
+                if (t->id == INTERRUPT_NULL)
+                    break;
+                if (PendingInterrupt.time > 0 || PendingInterrupt.pFunction == NULL)
+                    return false;
+                PendingInterrupt.pFunction();
+                if (FiredInterrupt != t->id)
+                    return false;
+                CycInt_AcknowledgeInterrupt();
+                break;
+        }
+    }
+    return true;
+}
+
+static bool cycintbench_load(const char* name) {
+    FILE*  f = fopen(name, "r");
+    char   op;
+    int    id;
+    long long cycles;
+    char   line[128];
+
+    if (f == NULL)
+        return false;
+    while (fgets(line, sizeof(line), f)) {
+        cycles = 0;
+        if (sscanf(line, " %c %d %lld", &op, &id, &cycles) < 2 || id < 0 || id >= MAX_INTERRUPTS) {
+            fprintf(stderr, "Invalid trace line '%s'\n", line);
+            exit(1);
+        }
+        switch (op) {
+            case 'a': trace_append(OP_ADD,    id, cycles); break;
+            case 'r': trace_append(OP_REMOVE, id, 0);      break;
+            case 'k': trace_append(OP_ACK,    id, cycles); break;
+            default:
+                fprintf(stderr, "Invalid trace line '%s'\n", line);
+                exit(1);
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+static void cycintbench_save(const char* name) {
+    FILE* f = fopen(name, "w");
+    int   i;
+
+    if (f == NULL) {
+        fprintf(stderr, "Cannot create '%s'\n", name);
+        exit(1);
+    }
+    for (i = 0; i < TraceCount; i++)
+        fprintf(f, "%c %d %lld\n", "ark"[Trace[i].op], Trace[i].id, (long long)Trace[i].cycles);
+    fclose(f);
+}
+
+int main(int argc, char* argv[]) {
+    int    operations = argc > 1 ? atoi(argv[1]) : 10000000;
+    const char* name  = argc > 2 ? argv[2] : NULL;
+    int    runs       = argc > 3 ? atoi(argv[3]) : 5;
+    double best       = 0;
+    int    i;
+
+    ConfigureParams.System.nCpuFreq  = 25;
+    ConfigureParams.System.bRealtime = false;
+
+    if (name == NULL || !cycintbench_load(name)) {
+        cycintbench_generate(operations);
+        if (name)
+            cycintbench_save(name);
+    }
+
+    printf("%d operations, %d runs\n", TraceCount, runs);
+    for (i = 0; i < runs; i++) {
+        Uint64 start = SDL_GetPerformanceCounter();
+        if (!cycintbench_replay()) {
+            fprintf(stderr, "Replay diverged from trace\n");
+            return 1;
+        }
+        double elapsed = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+        double rate    = TraceCount / elapsed;
+        printf("run %d: %.1f Mops/s\n", i + 1, rate / 1e6);
+        if (rate > best) best = rate;
+    }
+    printf("best: %.1f Mops/s\n", best / 1e6);
+    return 0;
+}
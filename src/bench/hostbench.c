@@ -0,0 +1,128 @@
+/*
+  Previous - hostbench.c
+
+  This file is distributed under the GNU Public License, version 2 or at
+  your option any later version. Read the file gpl.txt for details.
+
+  Microbenchmark for the host time of host.c. The bench thread acts as the
+  m68k thread: it advances the cycle counter and calls host_time_us like
+  the CycInt paths do. With "cycle" the CPU is in supervisor mode and the
+  time is derived from the cycle counter, with "realtime" it is in user
+  mode with realtime enabled and the time is read from the performance
+  counter. 0 to <max_readers> other threads call host_get_save_time in a
+  loop like the SLIRP tick thread does. Prints the host_time_us calls per
+  second and the host_get_save_time calls per second of all readers.
+
+  usage: hostbench [max_readers] [seconds] [cycle|realtime]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "main.h"
+#include "configuration.h"
+#include "host.h"
+#include "memory.h"
+#include "newcpu.h"
+#include "memorySnapShot.h"
+#include "log.h"
+
+#define HOSTBENCH_MAX_READERS   8
+#define HOSTBENCH_CYCLES        40  /* m68k cycles between two calls */
+
+CNF_PARAMS       ConfigureParams;
+Sint64           nCyclesMainCounter;
+struct regstruct regs;
+mem_get_func     bank_lget[65536];
+
+/* host.c only needs logging, snapshots and the blank handlers */
+void _Log_Printf(LOGTYPE nType, const char *psFormat, ...) {
+}
+
+void MemorySnapShot_Store(void *pData, int Size) {
+}
+
+void nd_display_blank(int num) {
+}
+
+void nd_video_blank(int num) {
+}
+
+typedef struct {
+    atomic_int* running;
+    Uint64      calls;
+    Uint64      sum;
+} Reader;
+
+static int reader(void* data) {
+    Reader* r = (Reader*)data;
+    while (host_atomic_get(r->running)) {
+        r->sum += host_get_save_time();
+        r->calls++;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    int         maxReaders = argc > 1 ? atoi(argv[1]) : 4;
+    double      seconds    = argc > 2 ? atof(argv[2]) : 1.0;
+    const char* mode       = argc > 3 ? argv[3] : "cycle";
+    Reader      readers[HOSTBENCH_MAX_READERS];
+    thread_t*   threads[HOSTBENCH_MAX_READERS];
+    atomic_int  running;
+
+    if (strcmp(mode, "cycle") && strcmp(mode, "realtime")) {
+        fprintf(stderr, "Unknown mode '%s'\n", mode);
+        return 1;
+    }
+    if (maxReaders < 0) maxReaders = 0;
+    if (maxReaders > HOSTBENCH_MAX_READERS) maxReaders = HOSTBENCH_MAX_READERS;
+
+    ConfigureParams.System.nCpuFreq  = 25;
+    ConfigureParams.System.bRealtime = !strcmp(mode, "realtime");
+    regs.s = ConfigureParams.System.bRealtime ? 0 : 1;
+    host_reset();
+
+    printf("%s, %.1f s per run, %d host CPUs\n", mode, seconds, SDL_GetCPUCount());
+    printf("readers  host_time_us/s  (pct)    host_get_save_time/s\n");
+    double base = 0;
+    Uint64 sum  = 0;
+    for (int n = 0; n <= maxReaders; n++) {
+        host_atomic_set(&running, 1);
+        for (int i = 0; i < n; i++) {
+            readers[i].running = &running;
+            readers[i].calls   = 0;
+            readers[i].sum     = 0;
+            threads[i] = host_thread_create(reader, "hostbench", &readers[i]);
+        }
+
+        Uint64 calls = 0;
+        Uint64 start = SDL_GetPerformanceCounter();
+        Uint64 until = start + (Uint64)(seconds * SDL_GetPerformanceFrequency());
+        while (SDL_GetPerformanceCounter() < until) {
+            for (int i = 0; i < 1000; i++) {
+                nCyclesMainCounter += HOSTBENCH_CYCLES;
+                sum += host_time_us();
+            }
+            calls += 1000;
+        }
+        double elapsed = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+
+        host_atomic_set(&running, 0);
+        Uint64 readerCalls = 0;
+        for (int i = 0; i < n; i++) {
+            host_thread_wait(threads[i]);
+            readerCalls += readers[i].calls;
+            sum         += readers[i].sum;
+        }
+
+        double rate = calls / elapsed;
+        if (n == 0) base = rate;
+        printf("%7d  %14.0f  (%5.1f%%)  %20.0f\n", n, rate, 100.0 * rate / base, readerCalls / elapsed);
+    }
+    /* Keep the calls from being optimized away */
+    if (sum == 0)
+        printf("\n");
+    return 0;
+}
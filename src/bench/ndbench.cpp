@@ -0,0 +1,439 @@
+/*
+  Previous - ndbench.cpp
+
+  This file is distributed under the GNU Public License, version 2 or at
+  your option any later version. Read the file gpl.txt for details.
+
+  MIPS benchmark for the NeXTdimension i860 emulator. Boots each board from
+  a small ROM stub into a Display PostScript like workload: rectangle fills
+  and copies to VRAM with fld.d/fst.d, 1-bit alpha glyph compositing with
+  integer instructions and a path transformation with fmul/fadd. The
+  workload counts its iterations in board memory, the instructions per
+  iteration are known from the code, which gives the MIPS without help
+  from the emulator.
+
+  First the i860 runs on the bench thread like on the m68k thread without
+  Dimension.bI860Thread. Then the bench thread runs a synthetic m68k load
+  and calls i860_Run like the m68k thread does, with 0 to <max_boards>
+  boards on their own i860 threads. Prints the m68k side speed and the
+  MIPS of each board.
+
+  usage: ndbench [seconds] [interp|jit] [max_boards]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "main.h"
+#include "configuration.h"
+#include "m68000.h"
+#include "screen.h"
+#include "memorySnapShot.h"
+#include "file.h"
+#include "nbic.h"
+#include "sysReg.h"
+#include "dimension.hpp"
+
+#define NDBENCH_CODE    0xF8000000
+#define NDBENCH_COUNTER 0xF80FFF00
+#define NDBENCH_CONST   0xF80FFF80
+#define NDBENCH_SRC     0xF8100000
+#define NDBENCH_POINTS  0xF8200000
+#define NDBENCH_VRAM    0xFE000000
+#define NDBENCH_PITCH   (1152*4)
+#define NDBENCH_ROM     0xFFFFFF00  /* i860 reset vector */
+
+#define NDBENCH_M68K_CPI 4          /* cycles per synthetic m68k instruction */
+
+/* The Dimension library only needs a few things of the rest of the emulator */
+bool         bHeadless = true;
+volatile int mainPauseEmulation;
+
+extern "C" {
+    CNF_PARAMS         ConfigureParams;
+    struct SDL_Window* sdlWindow;
+    Sint64             nCyclesMainCounter;
+    struct regstruct   regs;
+    mem_get_func       bank_lget[65536];
+
+    void _Log_Printf(LOGTYPE nType, const char *psFormat, ...) {}
+    void MemorySnapShot_Store(void *pData, int Size) {}
+    void Statusbar_SetNdLed(int state) {}
+    void set_interrupt(Uint32 intr, Uint8 state) {}
+    void M68000_BusError(Uint32 addr, int ReadWrite, int Size, int AccessType, uae_u32 val) {}
+    void CycInt_AcknowledgeInterrupt(void) {}
+    void CycInt_AddRelativeInterruptUs(Sint64 us, Sint64 usreal, interrupt_id Handler) {}
+    bool blitDimension(Uint32* vram, volatile Uint8* dirty, SDL_Texture* tex) {return false;}
+
+    Uint32 nb_cpu_slot_lget(Uint32 addr) {return 0;}
+    Uint16 nb_cpu_slot_wget(Uint32 addr) {return 0;}
+    Uint8  nb_cpu_slot_bget(Uint32 addr) {return 0;}
+    void   nb_cpu_slot_lput(Uint32 addr, Uint32 l) {}
+    void   nb_cpu_slot_wput(Uint32 addr, Uint16 w) {}
+    void   nb_cpu_slot_bput(Uint32 addr, Uint8 b) {}
+
+    int Configuration_CheckDimensionMemory(int *banksize) {
+        return banksize[0] + banksize[1] + banksize[2] + banksize[3];
+    }
+
+    /* No ROM file, the bench writes its own boot code */
+    bool  File_Exists(const char *pszFileName) {return false;}
+    FILE* File_Open(const char *path, const char *mode) {return NULL;}
+    FILE* File_Close(FILE *fp) {return NULL;}
+}
+
+/* Minimal i860 assembler. Counts how many instructions the code executes,
+ * loop bodies are weighted with their trip count. */
+class NDAsm {
+    Uint64 weight;
+public:
+    std::vector<Uint32> code;
+    Uint64              executed;
+
+    NDAsm() : weight(1), executed(0) {}
+
+    Uint32 pc(void) {
+        return NDBENCH_CODE + code.size() * 4;
+    }
+
+    void emit(Uint32 insn) {
+        code.push_back(insn);
+        executed += weight;
+    }
+
+    /* Register and immediate forms, stores and branches use the split offset */
+    static Uint32 rrr(int op, int src1, int src2, int dest)  {return (op<<26)|(src2<<21)|(dest<<16)|(src1<<11);}
+    static Uint32 ri(int op, Uint32 imm, int src2, int dest) {return (op<<26)|(src2<<21)|(dest<<16)|(imm&0xFFFF);}
+    static Uint32 split(int op, Uint32 off, int src1, int src2) {
+        return (op<<26)|(src2<<21)|(((off>>11)&0x1F)<<16)|(src1<<11)|(off&0x7FF);
+    }
+    static Uint32 fp(int op, int fsrc1, int fsrc2, int fdest) {return (0x12<<26)|(fsrc2<<21)|(fdest<<16)|(fsrc1<<11)|op;}
+
+    Uint32 sbroff(Uint32 target) {return (target - (pc() + 4)) >> 2;}
+
+    void nop(void)                               {emit(0xA0000000);}
+    void orh(Uint32 imm, int src2, int dest)     {emit(ri(0x3B, imm, src2, dest));}
+    void or_(Uint32 imm, int src2, int dest)     {emit(ri(0x39, imm, src2, dest));}
+    void adds(Uint32 imm, int src2, int dest)    {emit(ri(0x25, imm, src2, dest));}
+    void shra(Uint32 imm, int src2, int dest)    {emit(ri(0x2F, imm, src2, dest));}
+    void and_(int src1, int src2, int dest)      {emit(rrr(0x30, src1, src2, dest));}
+    void andnot(int src1, int src2, int dest)    {emit(rrr(0x34, src1, src2, dest));}
+    void or_r(int src1, int src2, int dest)      {emit(rrr(0x38, src1, src2, dest));}
+    void ld_l(Uint32 off, int src2, int dest)    {emit(ri(0x05, off|1, src2, dest));}
+    void st_l(int src1, Uint32 off, int src2)    {emit(split(0x07, off|1, src1, src2));}
+    void fld_l(Uint32 off, int src2, int fdest, bool inc = false) {emit(ri(0x09, off|2|inc, src2, fdest));}
+    void fld_d(Uint32 off, int src2, int fdest, bool inc = false) {emit(ri(0x09, off|inc, src2, fdest));}
+    void fst_l(int fsrc, Uint32 off, int src2, bool inc = false)  {emit(ri(0x0B, off|2|inc, src2, fsrc));}
+    void fst_d(int fsrc, Uint32 off, int src2, bool inc = false)  {emit(ri(0x0B, off|inc, src2, fsrc));}
+    void fmul_ss(int fsrc1, int fsrc2, int fdest) {emit(fp(0x20, fsrc1, fsrc2, fdest));}
+    void fadd_ss(int fsrc1, int fsrc2, int fdest) {emit(fp(0x30, fsrc1, fsrc2, fdest));}
+    void br(Uint32 target)                       {emit((0x1A<<26)|(sbroff(target)&0x03FFFFFF));}
+    void btne(int src1, int src2, Uint32 target) {emit(split(0x14, sbroff(target), src1, src2));}
+    void bla(int src1, int src2, Uint32 target)  {emit(split(0x2D, sbroff(target), src1, src2));}
+
+    /* Outer loops count down r7 with btne */
+    Uint32 outer_begin(int n) {
+        or_(n, 0, 7);
+        weight *= n;
+        return pc();
+    }
+
+    void outer_end(Uint32 top, int n) {
+        adds(-1, 7, 7);
+        btne(7, 0, top);
+        weight /= n;
+    }
+
+    /* Inner loops use bla with r5 = -1 and r6 = n-1. The first bla only
+     * sets LCC, it continues at the loop start whether it branches or not.
+     * The loop ends with bla and its delay slot instruction. */
+    Uint32 inner_begin(int n) {
+        or_(n - 1, 0, 6);
+        bla(5, 6, pc() + 8);
+        nop();
+        weight *= n;
+        return pc();
+    }
+
+    void inner_end(Uint32 top) {
+        bla(5, 6, top);
+    }
+
+    void inner_done(int n) {
+        weight /= n;
+    }
+};
+
+/* Display PostScript like drawing, returns the executed instructions per iteration */
+static Uint64 ndbench_workload(NDAsm& a) {
+    /* r5 = -1, r16 = VRAM, r17 = source image, r18 = points, r19 = constants,
+     * r27 = iteration counter */
+    a.adds(-1, 0, 5);
+    a.orh(NDBENCH_VRAM >> 16, 0, 16);
+    a.orh(NDBENCH_SRC >> 16, 0, 17);
+    a.orh(NDBENCH_POINTS >> 16, 0, 18);
+    a.orh(NDBENCH_CONST >> 16, 0, 19);
+    a.or_(NDBENCH_CONST & 0xFFFF, 19, 19);
+    a.orh(NDBENCH_COUNTER >> 16, 0, 27);
+    a.or_(NDBENCH_COUNTER & 0xFFFF, 27, 27);
+    a.fld_d(0, 19, 2);                          /* fill color */
+    for(int i = 0; i < 6; i++)
+        a.fld_l(8 + i * 4, 19, 16 + i);         /* transformation matrix */
+    a.or_r(0, 0, 26);
+
+    const Uint64 setup = a.executed;
+    const Uint32 loop  = a.pc();
+
+    /* rectfill: 100 lines of 200 pixels */
+    a.adds(-8, 16, 20);
+    Uint32 top = a.outer_begin(100);
+    a.or_r(20, 0, 21);
+    Uint32 in = a.inner_begin(100);
+    a.inner_end(in);
+    a.fst_d(2, 8, 21, true);
+    a.inner_done(100);
+    a.adds(NDBENCH_PITCH, 20, 20);
+    a.outer_end(top, 100);
+
+    /* copybits: 100 lines of 128 pixels from memory to VRAM */
+    a.adds(-8, 17, 22);
+    a.or_(0x8000, 16, 20);
+    a.adds(-8, 20, 20);
+    top = a.outer_begin(100);
+    a.or_r(20, 0, 21);
+    in = a.inner_begin(64);
+    a.fld_d(8, 22, 4, true);
+    a.inner_end(in);
+    a.fst_d(4, 8, 21, true);
+    a.inner_done(64);
+    a.adds(NDBENCH_PITCH, 20, 20);
+    a.outer_end(top, 100);
+
+    /* glyphs: 64 lines of 64 pixels composited with a 1-bit alpha mask */
+    a.or_r(17, 0, 22);
+    a.orh(0x0010, 16, 20);
+    top = a.outer_begin(64);
+    a.or_r(20, 0, 21);
+    in = a.inner_begin(64);
+    a.ld_l(0, 22, 8);
+    a.ld_l(0, 21, 9);
+    a.shra(31, 8, 10);
+    a.and_(8, 10, 11);
+    a.andnot(10, 9, 12);
+    a.or_r(11, 12, 13);
+    a.st_l(13, 0, 21);
+    a.adds(4, 22, 22);
+    a.inner_end(in);
+    a.adds(4, 21, 21);
+    a.inner_done(64);
+    a.adds(NDBENCH_PITCH, 20, 20);
+    a.outer_end(top, 64);
+
+    /* path: transform 256 points with a 2x3 matrix */
+    a.adds(-4, 18, 24);
+    a.orh(0x0001, 18, 25);
+    a.adds(-4, 25, 25);
+    in = a.inner_begin(256);
+    a.fld_l(4, 24, 8, true);
+    a.fld_l(4, 24, 9, true);
+    a.fmul_ss(16, 8, 10);
+    a.fmul_ss(17, 9, 11);
+    a.fadd_ss(10, 11, 10);
+    a.fadd_ss(10, 18, 10);
+    a.fmul_ss(19, 8, 12);
+    a.fmul_ss(20, 9, 13);
+    a.fadd_ss(12, 13, 12);
+    a.fadd_ss(12, 21, 12);
+    a.fst_l(10, 4, 25, true);
+    a.inner_end(in);
+    a.fst_l(12, 4, 25, true);
+    a.inner_done(256);
+
+    /* Count the iteration in board memory */
+    a.adds(1, 26, 26);
+    a.st_l(26, 0, 27);
+    a.br(loop);
+    a.nop();
+
+    return a.executed - setup;
+}
+
+static Uint64 InsnsPerIteration;
+
+static void ndbench_wr32(NextDimension* nd, Uint32 addr, Uint32 val) {
+    NextDimension::i860_wr32_le(nd, addr, &val);
+}
+
+static Uint32 ndbench_rd32(NextDimension* nd, Uint32 addr) {
+    Uint32 val;
+    NextDimension::i860_rd32_le(nd, addr, &val);
+    return val;
+}
+
+static void ndbench_wrfloat(NextDimension* nd, Uint32 addr, float f) {
+    Uint32 val;
+    memcpy(&val, &f, sizeof(val));
+    ndbench_wr32(nd, addr, val);
+}
+
+static NextDimension* ndbench_board(int num) {
+    static const Uint32 boot[] = {
+        NDAsm::ri(0x3B, NDBENCH_CODE >> 16, 0, 4),  /* orh  NDBENCH_CODE,r0,r4 */
+        NDAsm::rrr(0x10, 4, 0, 0),                  /* bri  r4 */
+        NDAsm::rrr(0x0E, 0, CR_DIRBASE, 0),         /* st.c r0,dirbase: leave CS8 mode */
+        0xA0000000,                                 /* nop */
+    };
+    NDAsm a;
+
+    ConfigureParams.Dimension.board[num].bEnabled = true;
+    for(int i = 0; i < 4; i++)
+        ConfigureParams.Dimension.board[num].nMemoryBankSize[i] = 4;
+
+    NextDimension* nd = new NextDimension(ND_SLOT(num));
+
+    /* The ROM is fetched byte by byte in CS8 mode, instructions are little endian */
+    for(size_t i = 0; i < sizeof(boot) / sizeof(boot[0]); i++)
+        for(int b = 0; b < 4; b++)
+            nd->rom[((NDBENCH_ROM & 0x1FFFF) + i * 4 + b)] = boot[i] >> (b * 8);
+
+    InsnsPerIteration = ndbench_workload(a);
+    for(size_t i = 0; i < a.code.size(); i++)
+        ndbench_wr32(nd, NDBENCH_CODE + i * 4, a.code[i]);
+
+    Uint32 seed = 1;
+    for(Uint32 i = 0; i < 128 * 1024; i += 4) {
+        seed = seed * 1103515245 + 12345;
+        ndbench_wr32(nd, NDBENCH_SRC + i, seed);
+    }
+    for(int i = 0; i < 512; i++)
+        ndbench_wrfloat(nd, NDBENCH_POINTS + i * 4, (float)(i % 97) * 1.5f);
+    ndbench_wr32(nd, NDBENCH_CONST,     0xFF336699);
+    ndbench_wr32(nd, NDBENCH_CONST + 4, 0xFF336699);
+    ndbench_wrfloat(nd, NDBENCH_CONST + 8,  0.9f);
+    ndbench_wrfloat(nd, NDBENCH_CONST + 12, -0.4f);
+    ndbench_wrfloat(nd, NDBENCH_CONST + 16, 12.0f);
+    ndbench_wrfloat(nd, NDBENCH_CONST + 20, 0.4f);
+    ndbench_wrfloat(nd, NDBENCH_CONST + 24, 0.9f);
+    ndbench_wrfloat(nd, NDBENCH_CONST + 28, -7.0f);
+
+    nextbus[nd->slot] = nd;
+    return nd;
+}
+
+static void ndbench_remove(NextDimension* nd) {
+    nextbus[nd->slot] = NULL;
+    delete nd;
+}
+
+static double Seconds(Uint64 start) {
+    return (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+}
+
+/* Synthetic m68k emulation load */
+static volatile Uint32 M68kSink;
+
+static inline int ndbench_m68k(int instructions) {
+    Uint32 x = M68kSink;
+    for(int i = 0; i < instructions; i++)
+        x = x * 1103515245 + 12345;
+    M68kSink = x;
+    return instructions * NDBENCH_M68K_CPI;
+}
+
+/* i860 on the bench thread, i860_Run without m68k load */
+static double ndbench_inline(double seconds) {
+    ConfigureParams.Dimension.bI860Thread = false;
+    NextDimension* nd = ndbench_board(0);
+
+    /* Boot and run the first iteration before timing */
+    while(ndbench_rd32(nd, NDBENCH_COUNTER) == 0)
+        i860_Run(1000);
+
+    Uint32 first = ndbench_rd32(nd, NDBENCH_COUNTER);
+    Uint64 start = SDL_GetPerformanceCounter();
+    do {
+        for(int i = 0; i < 100; i++)
+            i860_Run(1000);
+    } while(Seconds(start) < seconds);
+    double elapsed = Seconds(start);
+
+    double mips = (ndbench_rd32(nd, NDBENCH_COUNTER) - first) * InsnsPerIteration / elapsed / 1e6;
+    ndbench_remove(nd);
+    return mips;
+}
+
+/* Bench thread as m68k thread, i860 threads for each board */
+static void ndbench_threads(int boards, double seconds, double* m68k, double* mips) {
+    NextDimension* nd[ND_MAX_BOARDS];
+    Uint32         first[ND_MAX_BOARDS];
+    int            ndCycles = 0;
+    Uint64         cycles   = 0;
+
+    ConfigureParams.Dimension.bI860Thread = true;
+    for(int i = 0; i < boards; i++)
+        nd[i] = ndbench_board(i);
+
+    /* Let all boards boot before timing */
+    for(int i = 0; i < boards; i++) {
+        while(ndbench_rd32(nd[i], NDBENCH_COUNTER) == 0) {
+            ndCycles = ndbench_m68k(25);
+            i860_Run(ndCycles);
+        }
+    }
+
+    for(int i = 0; i < boards; i++)
+        first[i] = ndbench_rd32(nd[i], NDBENCH_COUNTER);
+    Uint64 start = SDL_GetPerformanceCounter();
+    do {
+        /* Like run_other_MPUs in newcpu.c, bundle 100 m68k cycles */
+        for(int i = 0; i < 1000; i++) {
+            ndCycles = ndbench_m68k(25);
+            i860_Run(ndCycles);
+            cycles += ndCycles;
+        }
+    } while(Seconds(start) < seconds);
+    double elapsed = Seconds(start);
+
+    *m68k = cycles / NDBENCH_M68K_CPI / elapsed / 1e6;
+    for(int i = 0; i < boards; i++) {
+        mips[i] = (ndbench_rd32(nd[i], NDBENCH_COUNTER) - first[i]) * InsnsPerIteration / elapsed / 1e6;
+        ndbench_remove(nd[i]);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    double      seconds   = argc > 1 ? atof(argv[1]) : 2.0;
+    const char* mode      = argc > 2 ? argv[2] : "interp";
+    int         maxBoards = argc > 3 ? atoi(argv[3]) : ND_MAX_BOARDS;
+
+    if(strcmp(mode, "interp") && strcmp(mode, "jit")) {
+        fprintf(stderr, "Unknown mode '%s'\n", mode);
+        return 1;
+    }
+    if(maxBoards < 0)             maxBoards = 0;
+    if(maxBoards > ND_MAX_BOARDS) maxBoards = ND_MAX_BOARDS;
+
+    ConfigureParams.System.nCpuFreq       = 25;
+    ConfigureParams.Dimension.bI860JIT    = !strcmp(mode, "jit");
+    ConfigureParams.Screen.nMonitorType   = MONITOR_TYPE_CPU;
+
+    printf("%s, %.1f s per run, %d host CPUs\n", mode, seconds, host_num_cpus());
+    double inlineMips = ndbench_inline(seconds);
+    printf("%llu instructions per iteration\n", (unsigned long long)InsnsPerIteration);
+    printf("i860 on the m68k thread: %.1f MIPS\n", inlineMips);
+
+    printf("boards  m68k MIPS  i860 MIPS per board\n");
+    double base = 0;
+    for(int boards = 0; boards <= maxBoards; boards++) {
+        double m68k, mips[ND_MAX_BOARDS];
+        ndbench_threads(boards, seconds, &m68k, mips);
+        if(boards == 0) base = m68k;
+        printf("%6d  %9.1f  (%5.1f%%)", boards, m68k, 100.0 * m68k / base);
+        for(int i = 0; i < boards; i++)
+            printf("  %6.1f", mips[i]);
+        printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,330 @@
+/*
+  Previous - nfsbench.cpp
+
+  This file is distributed under the GNU Public License, version 2 or at
+  your option any later version. Read the file gpl.txt for details.
+
+  Stress test for the built-in NFS server. Starts the NFS program on a UDP
+  socket like nfsd_start does. Each client thread sends 8 KB NFSv3 READ,
+  WRITE or WRITE+COMMIT calls for its own file to the server over loopback
+  UDP and waits for the reply, like concurrent NFS clients do. Requests
+  go to random or to sequential offsets. With "pool" the calls are
+  processed by the worker threads of CRPCServer, with "inline" by the
+  receive thread of the socket, like the server did before the workers
+  were added. Prints the requests per second for 1 to <max_threads>
+  threads.
+
+  usage: nfsbench <scratch_dir> [read|write|commit] [max_threads] [seconds]
+                  [random|seq] [pool|inline]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <Winsock2.h>
+#else
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
+
+#include "FileTableNFSD.h"
+#include "RPCServer.h"
+#include "UDPServerSocket.h"
+#include "NFSProg.h"
+#include "nfsd.h"
+
+#define NFSBENCH_FILE_SIZE  (1024*1024)
+#define NFSBENCH_BLOCK_SIZE 8192
+#define NFSBENCH_RETRIES    5
+
+enum {
+    NFSPROC3_READ   = 6,
+    NFSPROC3_WRITE  = 7,
+    NFSPROC3_COMMIT = 21,
+};
+
+FileTableNFSD* nfsd_fts[] = {NULL};
+struct in_addr loopback_addr;
+
+/* The server only needs the threads and locks of host.c */
+mutex_t* host_mutex_create(void) {
+    return SDL_CreateMutex();
+}
+
+void host_mutex_lock(mutex_t* mutex) {
+    SDL_LockMutex(mutex);
+}
+
+void host_mutex_unlock(mutex_t* mutex) {
+    SDL_UnlockMutex(mutex);
+}
+
+void host_mutex_destroy(mutex_t* mutex) {
+    SDL_DestroyMutex(mutex);
+}
+
+cond_t* host_cond_create(void) {
+    return SDL_CreateCond();
+}
+
+void host_cond_wait(cond_t* cond, mutex_t* mutex, Uint32 ms) {
+    SDL_CondWaitTimeout(cond, mutex, ms);
+}
+
+void host_cond_signal(cond_t* cond) {
+    SDL_CondSignal(cond);
+}
+
+void host_cond_destroy(cond_t* cond) {
+    SDL_DestroyCond(cond);
+}
+
+thread_t* host_thread_create(thread_func_t func, const char* name, void* data) {
+    return SDL_CreateThread(func, name, data);
+}
+
+int host_thread_wait(thread_t* thread) {
+    int status;
+    SDL_WaitThread(thread, &status);
+    return status;
+}
+
+void host_lock(lock_t* lock) {
+    SDL_AtomicLock(lock);
+}
+
+void host_unlock(lock_t* lock) {
+    SDL_AtomicUnlock(lock);
+}
+
+enum {
+    OP_READ,
+    OP_WRITE,
+    OP_COMMIT,
+};
+
+struct Worker {
+    std::string path;
+    uint64_t    handle;
+    int         op;
+    bool        sequential;
+    uint16_t    port;
+    Uint64      until;
+    Uint64      requests;
+    Uint64      retries;
+    bool        failed;
+};
+
+/* Send an NFSv3 call for the file of the worker and wait for its reply,
+   returns false if the call failed or got no reply */
+static bool nfs_call(Worker* w, int sock, XDROutput& out, XDRInput& in, uint32_t xid, uint32_t proc, size_t offset, uint8_t* buffer, size_t count) {
+    out.reset();
+    out.write(xid);
+    out.write(0);        // CALL
+    out.write(2);        // RPC version
+    out.write(PROG_NFS);
+    out.write(3);
+    out.write(proc);
+    out.write(0);        // AUTH_NULL credential
+    out.write(0);
+    out.write(0);        // AUTH_NULL verifier
+    out.write(0);
+    uint64_t fh[FHSIZE_NFS3 / 8] = {w->handle};
+    out.write(FHSIZE_NFS3);
+    out.write(fh, FHSIZE_NFS3);
+    out.write((uint32_t)((uint64_t)offset >> 32));
+    out.write((uint32_t)offset);
+    out.write((uint32_t)count);
+    if(proc == NFSPROC3_WRITE) {
+        out.write(0);    // UNSTABLE
+        out.write(XDROpaque(buffer, count));
+    }
+
+    for(int retry = 0; retry < NFSBENCH_RETRIES; retry++) {
+        if(retry) w->retries++;
+        if(send(sock, (const char*)out.data(), out.size(), 0) != (ssize_t)out.size())
+            return false;
+        for(;;) {
+            ssize_t nBytes = recv(sock, (char*)in.data(), in.getCapacity(), 0);
+            if(nBytes < 0)
+                break;       // timeout, retransmit
+            in.resize(nBytes);
+            uint32_t replyXID = 0, msg = 1, replyStat = 1, verfFlavor, verfLength = 0, acceptStat = 1, status = 1;
+            in.read(&replyXID);
+            if(replyXID != xid)
+                continue;    // reply to a retransmission
+            in.read(&msg);
+            in.read(&replyStat);
+            in.read(&verfFlavor);
+            in.read(&verfLength);
+            in.skip(verfLength);
+            in.read(&acceptStat);
+            in.read(&status);
+            return msg == 1 && replyStat == 0 && acceptStat == 0 && status == 0;
+        }
+    }
+    return false;
+}
+
+static int worker(void* data) {
+    Worker*   w = (Worker*)data;
+    XDROutput out;
+    XDRInput  in;
+    uint8_t   buffer[NFSBENCH_BLOCK_SIZE];
+    uint32_t  seed = (uint32_t)w->handle;
+    uint32_t  xid  = seed << 16;
+    size_t    offset = 0;
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if(sock < 0) {
+        w->failed = true;
+        return 0;
+    }
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port   = htons(w->port);
+    addr.sin_addr   = loopback_addr;
+#ifdef _WIN32
+    DWORD timeout = 1000;
+#else
+    struct timeval timeout = {1, 0};
+#endif
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+    if(connect(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        ::close(sock);
+        w->failed = true;
+        return 0;
+    }
+
+    memset(buffer, 0x55, sizeof(buffer));
+    while(SDL_GetPerformanceCounter() < w->until) {
+        if(w->sequential) {
+            offset = (offset + NFSBENCH_BLOCK_SIZE) % NFSBENCH_FILE_SIZE;
+        } else {
+            seed   = seed * 1103515245 + 12345;
+            offset = ((seed >> 8) % (NFSBENCH_FILE_SIZE / NFSBENCH_BLOCK_SIZE)) * NFSBENCH_BLOCK_SIZE;
+        }
+        bool ok;
+        if(w->op == OP_READ)
+            ok = nfs_call(w, sock, out, in, ++xid, NFSPROC3_READ, offset, buffer, sizeof(buffer));
+        else
+            ok = nfs_call(w, sock, out, in, ++xid, NFSPROC3_WRITE, offset, buffer, sizeof(buffer));
+        if(ok && w->op == OP_COMMIT)
+            ok = nfs_call(w, sock, out, in, ++xid, NFSPROC3_COMMIT, 0, buffer, 0);
+        if(!ok) {
+            w->failed = true;
+            break;
+        }
+        w->requests++;
+    }
+    ::close(sock);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if(argc < 2) {
+        fprintf(stderr, "usage: %s <scratch_dir> [read|write|commit] [max_threads] [seconds] [random|seq] [pool|inline]\n", argv[0]);
+        return 1;
+    }
+    const char* opName     = argc > 2 ? argv[2] : "read";
+    int         maxThreads = argc > 3 ? atoi(argv[3]) : 8;
+    double      seconds    = argc > 4 ? atof(argv[4]) : 1.0;
+    const char* pattern    = argc > 5 ? argv[5] : "random";
+    const char* dispatch   = argc > 6 ? argv[6] : "pool";
+    int         op;
+
+    if     (!strcmp(opName, "read"))   op = OP_READ;
+    else if(!strcmp(opName, "write"))  op = OP_WRITE;
+    else if(!strcmp(opName, "commit")) op = OP_COMMIT;
+    else {
+        fprintf(stderr, "Unknown request type '%s'\n", opName);
+        return 1;
+    }
+    if(strcmp(pattern, "random") && strcmp(pattern, "seq")) {
+        fprintf(stderr, "Unknown access pattern '%s'\n", pattern);
+        return 1;
+    }
+    if(strcmp(dispatch, "pool") && strcmp(dispatch, "inline")) {
+        fprintf(stderr, "Unknown dispatch '%s'\n", dispatch);
+        return 1;
+    }
+    if(maxThreads < 1) maxThreads = 1;
+
+    /* One file per thread, filled so that reads hit data */
+    std::vector<uint8_t> data(NFSBENCH_FILE_SIZE, 0xAA);
+    for(int i = 0; i < maxThreads; i++) {
+        std::string name = std::string(argv[1]) + "/nfsbench" + std::to_string(i);
+        FILE* f = fopen(name.c_str(), "wb");
+        if(!f || fwrite(&data[0], 1, data.size(), f) != data.size()) {
+            fprintf(stderr, "Cannot create '%s'\n", name.c_str());
+            return 1;
+        }
+        fclose(f);
+    }
+
+    loopback_addr.s_addr = htonl(INADDR_LOOPBACK);
+    nfsd_fts[0] = new FileTableNFSD(HostPath(argv[1]), VFSPath("/"));
+
+    /* The NFS program on its own port, no portmapper needed. The server
+       runs until the program exits like in the emulator. */
+    CNFSProg*        nfsProg = new CNFSProg;
+    CRPCServer*      server  = new CRPCServer(strcmp(dispatch, "inline") ? RPC_WORKERS : 0);
+    UDPServerSocket* udp     = new UDPServerSocket(server);
+    server->set(nfsProg->getProgNum(), nfsProg);
+    server->setLogOn(false);
+    if(!udp->open(nfsProg->getProgNum())) {
+        fprintf(stderr, "Cannot open the server socket\n");
+        return 1;
+    }
+
+    /* File handles as returned by LOOKUP */
+    std::vector<Worker> workers(maxThreads);
+    for(int i = 0; i < maxThreads; i++) {
+        workers[i].path       = "/nfsbench" + std::to_string(i);
+        workers[i].handle     = nfsd_fts[0]->getFileHandle(workers[i].path);
+        workers[i].op         = op;
+        workers[i].sequential = !strcmp(pattern, "seq");
+        workers[i].port       = UDPServerSocket::toLocalPort(udp->getPort());
+    }
+
+    printf("%s, %s, %s, %d byte requests, %.1f s per run\n", opName, pattern, dispatch, NFSBENCH_BLOCK_SIZE, seconds);
+    printf("threads  requests/s  speedup  retransmits\n");
+    double base = 0;
+    for(int threads = 1; threads <= maxThreads; threads *= 2) {
+        std::vector<SDL_Thread*> running;
+        Uint64 start = SDL_GetPerformanceCounter();
+        Uint64 until = start + (Uint64)(seconds * SDL_GetPerformanceFrequency());
+        for(int i = 0; i < threads; i++) {
+            workers[i].until    = until;
+            workers[i].requests = 0;
+            workers[i].retries  = 0;
+            workers[i].failed   = false;
+            running.push_back(SDL_CreateThread(worker, "nfsbench", &workers[i]));
+        }
+        Uint64 requests = 0;
+        Uint64 retries  = 0;
+        for(int i = 0; i < threads; i++) {
+            SDL_WaitThread(running[i], NULL);
+            if(workers[i].failed) {
+                fprintf(stderr, "Request on '%s' failed\n", workers[i].path.c_str());
+                return 1;
+            }
+            requests += workers[i].requests;
+            retries  += workers[i].retries;
+        }
+        double elapsed = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+        double rate    = requests / elapsed;
+        if(threads == 1) base = rate;
+        printf("%7d  %10.0f  %6.2fx  %11llu\n", threads, rate, base ? rate / base : 0, (unsigned long long)retries);
+    }
+
+    for(int i = 0; i < maxThreads; i++)
+        remove((std::string(argv[1]) + "/nfsbench" + std::to_string(i)).c_str());
+    return 0;
+}
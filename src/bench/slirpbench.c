@@ -0,0 +1,244 @@
+/*
+  Previous - slirpbench.c
+
+  This file is distributed under the GNU Public License, version 2 or at
+  your option any later version. Read the file gpl.txt for details.
+
+  Loopback benchmark for the SLIRP network backend. Acts as the guest and
+  sends UDP packets through enet_slirp.c to the virtual host address
+  10.0.2.2, which SLIRP forwards to an echo server on 127.0.0.1. Replies
+  are picked up with enet_slirp_queue_poll like the emulation thread does.
+  Keeps <window> packets in flight and prints packets per second and the
+  mean round trip time. Before sending it counts how often the SLIRP
+  thread wakes up per second while the network is idle.
+
+  usage: slirpbench [window] [seconds] [payload_bytes]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "main.h"
+#include "configuration.h"
+#include "host.h"
+#include "ethernet.h"
+#include "enet_slirp.h"
+#include "log.h"
+
+#define SLIRPBENCH_GUEST_PORT 40000
+#define SLIRPBENCH_MAX_WINDOW 64
+#define SLIRPBENCH_IDLE_MS    2000
+
+static volatile Uint64 Wakeups;
+
+CNF_PARAMS     ConfigureParams;
+EthernetBuffer enet_rx_buffer;
+
+/* enet_slirp.c and SLIRP only need logging and a few functions of host.c */
+void _Log_Printf(LOGTYPE nType, const char *psFormat, ...) {
+}
+
+/* The SLIRP thread calls this once per wakeup */
+Uint64 host_get_save_time(void) {
+    Wakeups++;
+    return SDL_GetTicks() / 1000;
+}
+
+void host_sleep_ms(Uint32 ms) {
+    SDL_Delay(ms);
+}
+
+void host_lock(lock_t* lock) {
+    SDL_AtomicLock(lock);
+}
+
+void host_unlock(lock_t* lock) {
+    SDL_AtomicUnlock(lock);
+}
+
+int host_atomic_set(atomic_int* a, int newValue) {
+    return SDL_AtomicSet(a, newValue);
+}
+
+int host_atomic_get(atomic_int* a) {
+    return SDL_AtomicGet(a);
+}
+
+mutex_t* host_mutex_create(void) {
+    return SDL_CreateMutex();
+}
+
+void host_mutex_lock(mutex_t* mutex) {
+    SDL_LockMutex(mutex);
+}
+
+void host_mutex_unlock(mutex_t* mutex) {
+    SDL_UnlockMutex(mutex);
+}
+
+void host_mutex_destroy(mutex_t* mutex) {
+    SDL_DestroyMutex(mutex);
+}
+
+thread_t* host_thread_create(thread_func_t func, const char* name, void* data) {
+    return SDL_CreateThread(func, name, data);
+}
+
+int host_thread_wait(thread_t* thread) {
+    int status;
+    SDL_WaitThread(thread, &status);
+    return status;
+}
+
+static Uint16 EchoPort;
+static int    EchoSocket;
+static volatile bool EchoRunning;
+
+static Uint64 Sent[SLIRPBENCH_MAX_WINDOW];
+static Uint64 Received;
+static Uint64 RttSum;
+
+/* Replies from SLIRP to the guest */
+void enet_receive(Uint8 *pkt, int len) {
+    Uint32 seq;
+    /* Ethernet (14) + IP (20) + UDP (8) + sequence number */
+    if (len < 46 || pkt[12] != 0x08 || pkt[13] != 0x00 || pkt[23] != 17)
+        return;
+    if (((pkt[36] << 8) | pkt[37]) != SLIRPBENCH_GUEST_PORT)
+        return;
+    memcpy(&seq, &pkt[42], sizeof(seq));
+    RttSum += SDL_GetPerformanceCounter() - Sent[seq % SLIRPBENCH_MAX_WINDOW];
+    Received++;
+}
+
+static int echo_server(void* unused) {
+    Uint8              buf[2048];
+    struct sockaddr_in from;
+    socklen_t          fromLen;
+
+    while (EchoRunning) {
+        fromLen = sizeof(from);
+        ssize_t n = recvfrom(EchoSocket, buf, sizeof(buf), 0, (struct sockaddr*)&from, &fromLen);
+        if (n > 0)
+            sendto(EchoSocket, buf, n, 0, (struct sockaddr*)&from, fromLen);
+    }
+    return 0;
+}
+
+static Uint16 ip_checksum(const Uint8* p, int len) {
+    Uint32 sum = 0;
+    for (int i = 0; i < len; i += 2)
+        sum += (p[i] << 8) | p[i + 1];
+    while (sum >> 16)
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    return ~sum;
+}
+
+/* Build an Ethernet frame with a UDP packet from the guest to 10.0.2.2 */
+static int build_frame(Uint8* frame, const Uint8* mac, int payload) {
+    static const Uint8 gateway[6] = { 0x52, 0x54, 0x00, 0x12, 0x35, 0x02 };
+    Uint8* ip  = frame + 14;
+    Uint8* udp = ip + 20;
+    int    len = 20 + 8 + payload;
+    Uint16 sum;
+
+    memset(frame, 0, 14 + len);
+    memcpy(frame, gateway, 6);
+    memcpy(frame + 6, mac, 6);
+    frame[12] = 0x08;                                   /* IPv4 */
+    ip[0]  = 0x45;
+    ip[2]  = len >> 8; ip[3] = len;
+    ip[8]  = 64;                                        /* TTL */
+    ip[9]  = 17;                                        /* UDP */
+    ip[12] = 10; ip[13] = 0; ip[14] = 2; ip[15] = 15;   /* guest */
+    ip[16] = 10; ip[17] = 0; ip[18] = 2; ip[19] = 2;    /* host alias */
+    sum    = ip_checksum(ip, 20);
+    ip[10] = sum >> 8; ip[11] = sum;
+    udp[0] = SLIRPBENCH_GUEST_PORT >> 8; udp[1] = SLIRPBENCH_GUEST_PORT & 0xFF;
+    udp[2] = EchoPort >> 8;              udp[3] = EchoPort & 0xFF;
+    udp[4] = (8 + payload) >> 8;         udp[5] = 8 + payload;
+    return 14 + len;                                    /* UDP checksum 0: none */
+}
+
+int main(int argc, char* argv[]) {
+    static Uint8 mac[6] = { 0x00, 0x00, 0x0F, 0x00, 0x00, 0x01 };
+    int    window  = argc > 1 ? atoi(argv[1]) : 1;
+    double seconds = argc > 2 ? atof(argv[2]) : 2.0;
+    int    payload = argc > 3 ? atoi(argv[3]) : 64;
+    Uint8  frame[1600];
+    struct sockaddr_in addr;
+    socklen_t          addrLen = sizeof(addr);
+    struct timeval     tv = { 0, 100000 };
+
+    if (window < 1) window = 1;
+    if (window > SLIRPBENCH_MAX_WINDOW) window = SLIRPBENCH_MAX_WINDOW;
+    if (payload < 4) payload = 4;
+    if (payload > 1400) payload = 1400;
+
+    /* Echo server on the loopback interface */
+    EchoSocket = socket(AF_INET, SOCK_DGRAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (EchoSocket < 0 || bind(EchoSocket, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        getsockname(EchoSocket, (struct sockaddr*)&addr, &addrLen) < 0) {
+        fprintf(stderr, "Cannot create echo server socket\n");
+        return 1;
+    }
+    setsockopt(EchoSocket, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    EchoPort    = ntohs(addr.sin_port);
+    EchoRunning = true;
+    SDL_Thread* echo = SDL_CreateThread(echo_server, "echo", NULL);
+
+    enet_slirp_start(mac);
+
+    Uint64 idle = Wakeups;
+    SDL_Delay(SLIRPBENCH_IDLE_MS);
+    idle = Wakeups - idle;
+
+    int    len      = build_frame(frame, mac, payload);
+    Uint64 start    = SDL_GetPerformanceCounter();
+    Uint64 until    = start + (Uint64)(seconds * SDL_GetPerformanceFrequency());
+    Uint32 seq      = 0;
+    Uint64 timeout  = SDL_GetPerformanceFrequency();
+    Uint64 progress = start;
+
+    while (SDL_GetPerformanceCounter() < until) {
+        /* Keep the window full */
+        while (seq - Received < (Uint64)window) {
+            memcpy(&frame[42], &seq, sizeof(seq));
+            Sent[seq % SLIRPBENCH_MAX_WINDOW] = SDL_GetPerformanceCounter();
+            enet_slirp_input(frame, len);
+            seq++;
+        }
+        /* Poll for replies like the idle receiver of the emulation thread */
+        Uint64 before = Received;
+        enet_slirp_queue_poll();
+        if (Received != before) {
+            progress = SDL_GetPerformanceCounter();
+        } else if (SDL_GetPerformanceCounter() - progress > timeout) {
+            fprintf(stderr, "No reply for one second, %u sent, %llu received\n", seq, (unsigned long long)Received);
+            return 1;
+        } else {
+            SDL_Delay(0);
+        }
+    }
+    double elapsed = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+
+    enet_slirp_stop();
+    EchoRunning = false;
+    SDL_WaitThread(echo, NULL);
+    close(EchoSocket);
+
+    printf("%.1f idle wakeups/s\n", idle * 1000.0 / SLIRPBENCH_IDLE_MS);
+    printf("window %d, %d byte payload, %.1f s\n", window, payload, elapsed);
+    printf("%.0f packets/s, %.1f us mean round trip\n", Received / elapsed,
+           Received ? (double)RttSum / Received * 1e6 / SDL_GetPerformanceFrequency() : 0.0);
+    return 0;
+}
@@ -0,0 +1,272 @@
+/*
+  Previous - blit.c
+
+  This file is distributed under the GNU Public License, version 2 or at
+  your option any later version. Read the file gpl.txt for details.
+
+  Pixel conversion kernels for the repaint thread. The scalar versions are
+  the reference, the SIMD versions are selected at runtime in blitSelect if
+  the CPU supports them. Each kernel converts one line of the framebuffer.
+*/
+
+#include <SDL.h>
+#include <SDL_endian.h>
+
+#include "main.h"
+#include "blit.h"
+
+static Uint32 BW2RGB[0x400];
+static Uint32 COL2RGB[0x10000];
+
+static Uint32 bw2rgb(SDL_PixelFormat* format, int bw) {
+    switch(bw & 3) {
+        case 3:  return SDL_MapRGB(format, 0,   0,   0);
+        case 2:  return SDL_MapRGB(format, 85,  85,  85);
+        case 1:  return SDL_MapRGB(format, 170, 170, 170);
+        case 0:  return SDL_MapRGB(format, 255, 255, 255);
+        default: return 0;
+    }
+}
+
+static Uint32 col2rgb(SDL_PixelFormat* format, int col) {
+    int r = col & 0xF000; r >>= 12; r |= r << 4;
+    int g = col & 0x0F00; g >>= 8;  g |= g << 4;
+    int b = col & 0x00F0; b >>= 4;  b |= b << 4;
+    return SDL_MapRGB(format, r,   g,   b);
+}
+
+blitLineFunc blitBWLine;
+blitLineFunc blitColorLine;
+
+/*
+ BW format is 2bit per pixel
+ */
+static void blitBWLine_Scalar(Uint32* dst, const Uint8* src, int width) {
+    for(int x = 0; x < width/4; x++) {
+        int idx = *src++ * 4;
+        *dst++  = BW2RGB[idx+0];
+        *dst++  = BW2RGB[idx+1];
+        *dst++  = BW2RGB[idx+2];
+        *dst++  = BW2RGB[idx+3];
+    }
+}
+
+/*
+ Color format is 4bit per pixel, big-endian: RGBx
+ */
+static void blitColorLine_Scalar(Uint32* dst, const Uint8* src, int width) {
+    const Uint16* src16 = (const Uint16*)src;
+    for(int x = 0; x < width; x++) {
+        *dst++ = COL2RGB[*src16++];
+    }
+}
+
+/*
+ Dimension format is 8bit per pixel, big-endian: RRGGBBAA
+ */
+static void blitDimensionLine_Scalar(Uint32* dst, const Uint32* src, int width, const ndformat_t* f) {
+    for(int x = 0; x < width; x++) {
+        Uint32 v = *src++;
+        *dst++   = ((((v >> f->rIn) & 0xFF) >> f->rLoss) << f->rOut) |
+                   ((((v >> f->gIn) & 0xFF) >> f->gLoss) << f->gOut) |
+                   ((((v >> f->bIn) & 0xFF) >> f->bLoss) << f->bOut) | f->aMask;
+    }
+}
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLIT_SSE2 1
+#include <emmintrin.h>
+
+/* One BW source byte expands to four pixels, copy them at once */
+static void blitBWLine_SSE2(Uint32* dst, const Uint8* src, int width) {
+    for(int x = 0; x < width/4; x++) {
+        _mm_storeu_si128((__m128i*)dst, _mm_loadu_si128((const __m128i*)&BW2RGB[*src++ * 4]));
+        dst += 4;
+    }
+}
+
+/* Expand little-endian loaded RGBx words to ARGB8888 */
+static inline __m128i col2argb_SSE2(__m128i w) {
+    const __m128i m = _mm_set1_epi32(0xFF000000);
+    __m128i v = m;
+    v = _mm_or_si128(v, _mm_and_si128(_mm_slli_epi32(w, 16), _mm_set1_epi32(0x00F00000))); /* R high */
+    v = _mm_or_si128(v, _mm_and_si128(_mm_slli_epi32(w, 12), _mm_set1_epi32(0x000FF000))); /* R low, G high */
+    v = _mm_or_si128(v, _mm_and_si128(_mm_slli_epi32(w, 8),  _mm_set1_epi32(0x00000F00))); /* G low */
+    v = _mm_or_si128(v, _mm_and_si128(_mm_srli_epi32(w, 8),  _mm_set1_epi32(0x000000F0))); /* B high */
+    v = _mm_or_si128(v, _mm_and_si128(_mm_srli_epi32(w, 12), _mm_set1_epi32(0x0000000F))); /* B low */
+    return v;
+}
+
+static void blitColorLine_SSE2_ARGB8888(Uint32* dst, const Uint8* src, int width) {
+    const __m128i zero = _mm_setzero_si128();
+    int x;
+    for(x = 0; x + 8 <= width; x += 8) {
+        __m128i w = _mm_loadu_si128((const __m128i*)src);
+        _mm_storeu_si128((__m128i*)dst,     col2argb_SSE2(_mm_unpacklo_epi16(w, zero)));
+        _mm_storeu_si128((__m128i*)(dst+4), col2argb_SSE2(_mm_unpackhi_epi16(w, zero)));
+        src += 16;
+        dst += 8;
+    }
+    blitColorLine_Scalar(dst, src, width - x);
+}
+
+static void blitDimensionLine_SSE2(Uint32* dst, const Uint32* src, int width, const ndformat_t* f) {
+    const __m128i ff = _mm_set1_epi32(0xFF);
+    const __m128i a  = _mm_set1_epi32(f->aMask);
+    const __m128i ri = _mm_cvtsi32_si128(f->rIn),  ro = _mm_cvtsi32_si128(f->rOut);
+    const __m128i gi = _mm_cvtsi32_si128(f->gIn),  go = _mm_cvtsi32_si128(f->gOut);
+    const __m128i bi = _mm_cvtsi32_si128(f->bIn),  bo = _mm_cvtsi32_si128(f->bOut);
+    int x;
+    for(x = 0; x + 4 <= width; x += 4) {
+        __m128i w = _mm_loadu_si128((const __m128i*)src);
+        __m128i v = a;
+        v = _mm_or_si128(v, _mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(w, ri), ff), ro));
+        v = _mm_or_si128(v, _mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(w, gi), ff), go));
+        v = _mm_or_si128(v, _mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(w, bi), ff), bo));
+        _mm_storeu_si128((__m128i*)dst, v);
+        src += 4;
+        dst += 4;
+    }
+    blitDimensionLine_Scalar(dst, src, width - x, f);
+}
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BLIT_AVX2 1
+#include <immintrin.h>
+
+__attribute__((target("avx2")))
+static void blitColorLine_AVX2_ARGB8888(Uint32* dst, const Uint8* src, int width) {
+    const __m256i m = _mm256_set1_epi32(0xFF000000);
+    int x;
+    for(x = 0; x + 8 <= width; x += 8) {
+        __m256i w = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)src));
+        __m256i v = m;
+        v = _mm256_or_si256(v, _mm256_and_si256(_mm256_slli_epi32(w, 16), _mm256_set1_epi32(0x00F00000)));
+        v = _mm256_or_si256(v, _mm256_and_si256(_mm256_slli_epi32(w, 12), _mm256_set1_epi32(0x000FF000)));
+        v = _mm256_or_si256(v, _mm256_and_si256(_mm256_slli_epi32(w, 8),  _mm256_set1_epi32(0x00000F00)));
+        v = _mm256_or_si256(v, _mm256_and_si256(_mm256_srli_epi32(w, 8),  _mm256_set1_epi32(0x000000F0)));
+        v = _mm256_or_si256(v, _mm256_and_si256(_mm256_srli_epi32(w, 12), _mm256_set1_epi32(0x0000000F)));
+        _mm256_storeu_si256((__m256i*)dst, v);
+        src += 16;
+        dst += 8;
+    }
+    blitColorLine_Scalar(dst, src, width - x);
+}
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define BLIT_NEON 1
+#include <arm_neon.h>
+
+static void blitBWLine_NEON(Uint32* dst, const Uint8* src, int width) {
+    for(int x = 0; x < width/4; x++) {
+        vst1q_u32(dst, vld1q_u32(&BW2RGB[*src++ * 4]));
+        dst += 4;
+    }
+}
+
+static inline uint32x4_t col2argb_NEON(uint32x4_t w) {
+    uint32x4_t v = vdupq_n_u32(0xFF000000);
+    v = vorrq_u32(v, vandq_u32(vshlq_n_u32(w, 16), vdupq_n_u32(0x00F00000)));
+    v = vorrq_u32(v, vandq_u32(vshlq_n_u32(w, 12), vdupq_n_u32(0x000FF000)));
+    v = vorrq_u32(v, vandq_u32(vshlq_n_u32(w, 8),  vdupq_n_u32(0x00000F00)));
+    v = vorrq_u32(v, vandq_u32(vshrq_n_u32(w, 8),  vdupq_n_u32(0x000000F0)));
+    v = vorrq_u32(v, vandq_u32(vshrq_n_u32(w, 12), vdupq_n_u32(0x0000000F)));
+    return v;
+}
+
+static void blitColorLine_NEON_ARGB8888(Uint32* dst, const Uint8* src, int width) {
+    int x;
+    for(x = 0; x + 8 <= width; x += 8) {
+        uint16x8_t w = vld1q_u16((const uint16_t*)src);
+        vst1q_u32(dst,     col2argb_NEON(vmovl_u16(vget_low_u16(w))));
+        vst1q_u32(dst + 4, col2argb_NEON(vmovl_u16(vget_high_u16(w))));
+        src += 16;
+        dst += 8;
+    }
+    blitColorLine_Scalar(dst, src, width - x);
+}
+#endif
+
+/*
+ Select conversion kernels for the texture format, using instruction sets
+ up to isa. Returns false if isa is not available on this host.
+ */
+bool blitSelect(Uint32 format, int isa) {
+    bool supported = isa == BLIT_ISA_SCALAR || isa == BLIT_ISA_BEST;
+
+    blitBWLine    = blitBWLine_Scalar;
+    blitColorLine = blitColorLine_Scalar;
+    
+    /* The color kernels compute ARGB8888 directly and expect a little-endian host */
+    bool argb = format == SDL_PIXELFORMAT_ARGB8888 && SDL_BYTEORDER == SDL_LIL_ENDIAN;
+#if BLIT_SSE2
+    if (isa >= BLIT_ISA_SSE2 && SDL_HasSSE2()) {
+        blitBWLine = blitBWLine_SSE2;
+        if (argb) blitColorLine = blitColorLine_SSE2_ARGB8888;
+        supported |= isa == BLIT_ISA_SSE2;
+    }
+#endif
+#if BLIT_AVX2
+    if (isa >= BLIT_ISA_AVX2 && SDL_HasAVX2()) {
+        if (argb) blitColorLine = blitColorLine_AVX2_ARGB8888;
+        supported |= isa == BLIT_ISA_AVX2;
+    }
+#endif
+#if BLIT_NEON
+    if (isa >= BLIT_ISA_NEON && SDL_HasNEON()) {
+        blitBWLine = blitBWLine_NEON;
+        if (argb) blitColorLine = blitColorLine_NEON_ARGB8888;
+        supported |= isa == BLIT_ISA_NEON;
+    }
+#endif
+    return supported;
+}
+
+/*
+ Setup lookup tables for the texture format and select the fastest kernels.
+ */
+void blitInit(Uint32 format) {
+    SDL_PixelFormat* pformat = SDL_AllocFormat(format);
+    /* initialize BW lookup table */
+    for(int i = 0; i < 0x100; i++) {
+        BW2RGB[i*4+0] = bw2rgb(pformat, i>>6);
+        BW2RGB[i*4+1] = bw2rgb(pformat, i>>4);
+        BW2RGB[i*4+2] = bw2rgb(pformat, i>>2);
+        BW2RGB[i*4+3] = bw2rgb(pformat, i>>0);
+    }
+    /* initialize color lookup table */
+    for(int i = 0; i < 0x10000; i++)
+        COL2RGB[SDL_BYTEORDER == SDL_BIG_ENDIAN ? i : SDL_Swap16(i)] = col2rgb(pformat, i);
+    SDL_FreeFormat(pformat);
+    
+    blitSelect(format, BLIT_ISA_BEST);
+}
+
+/*
+ Derive NeXTdimension channel shifts from the texture format.
+ */
+void blitDimensionFormat(ndformat_t* f, Uint32 format) {
+    SDL_PixelFormat* pformat = SDL_AllocFormat(format);
+    f->rIn   = SDL_BYTEORDER == SDL_BIG_ENDIAN ? 8  : 16;
+    f->gIn   = SDL_BYTEORDER == SDL_BIG_ENDIAN ? 16 : 8;
+    f->bIn   = SDL_BYTEORDER == SDL_BIG_ENDIAN ? 24 : 0;
+    f->rOut  = pformat->Rshift; f->rLoss = pformat->Rloss;
+    f->gOut  = pformat->Gshift; f->gLoss = pformat->Gloss;
+    f->bOut  = pformat->Bshift; f->bLoss = pformat->Bloss;
+    f->aMask = pformat->Amask;
+    SDL_FreeFormat(pformat);
+}
+
+/*
+ Select NeXTdimension conversion kernel, using instruction sets up to isa.
+ */
+blitDimensionLineFunc blitDimensionSelect(const ndformat_t* f, int isa) {
+#if BLIT_SSE2
+    if (isa >= BLIT_ISA_SSE2 && SDL_HasSSE2() && !f->rLoss && !f->gLoss && !f->bLoss) {
+        return blitDimensionLine_SSE2;
+    }
+#endif
+    return blitDimensionLine_Scalar;
+}
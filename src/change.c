@@ -103,6 +103,12 @@ bool Change_DoNeedReset(CNF_PARAMS *current, CNF_PARAMS *changed)
         return true;
     }
 
+    /* Did we change the disk image access method? */
+    if (current->System.bMapDiskImages != changed->System.bMapDiskImages) {
+        printf("disk image access reset\n");
+        return true;
+    }
+
     /* Did we change the realtime flag? */
     if(current->System.bRealtime != changed->System.bRealtime) {
         printf("realtime flag reset\n");
@@ -192,7 +198,8 @@ bool Change_DoNeedReset(CNF_PARAMS *current, CNF_PARAMS *changed)
                  return true;
              }
     }
-    if(current->SCSI.nWriteProtection != changed->SCSI.nWriteProtection) {
+    if(current->SCSI.nWriteProtection != changed->SCSI.nWriteProtection ||
+       strcmp(current->SCSI.szOverlayDir, changed->SCSI.szOverlayDir)) {
         printf("scsi disk reset\n");
         return true;
     }
@@ -234,6 +241,7 @@ bool Change_DoNeedReset(CNF_PARAMS *current, CNF_PARAMS *changed)
         }
     }
     if (current->Dimension.bI860Thread != changed->Dimension.bI860Thread ||
+        current->Dimension.bI860JIT != changed->Dimension.bI860JIT ||
         current->Dimension.bMainDisplay != changed->Dimension.bMainDisplay ||
         current->Dimension.nMainDisplay != changed->Dimension.nMainDisplay) {
         printf("dimension display reset\n");
@@ -19,6 +19,7 @@ const char Configuration_fileid[] = "Hatari configuration.c : " __DATE__ " " __T
 #include "file.h"
 #include "log.h"
 #include "m68000.h"
+#include "memorySnapShot.h"
 #include "paths.h"
 #include "screen.h"
 #include "video.h"
@@ -101,6 +102,8 @@ static const struct Config_Tag configs_ShortCutWithMod[] =
 	{ "keyQuit",        Int_Tag, &ConfigureParams.Shortcut.withModifier[SHORTCUT_QUIT] },
 	{ "keyDimension",   Int_Tag, &ConfigureParams.Shortcut.withModifier[SHORTCUT_DIMENSION] },
 	{ "keyStatusbar",   Int_Tag, &ConfigureParams.Shortcut.withModifier[SHORTCUT_STATUSBAR] },
+	{ "keySaveMem",     Int_Tag, &ConfigureParams.Shortcut.withModifier[SHORTCUT_SAVEMEM] },
+	{ "keyLoadMem",     Int_Tag, &ConfigureParams.Shortcut.withModifier[SHORTCUT_LOADMEM] },
 	{ NULL , Error_Tag, NULL }
 };
 
@@ -120,6 +123,8 @@ static const struct Config_Tag configs_ShortCutWithoutMod[] =
 	{ "keyQuit",        Int_Tag, &ConfigureParams.Shortcut.withoutModifier[SHORTCUT_QUIT] },
 	{ "keyDimension",   Int_Tag, &ConfigureParams.Shortcut.withoutModifier[SHORTCUT_DIMENSION] },
 	{ "keyStatusbar",   Int_Tag, &ConfigureParams.Shortcut.withoutModifier[SHORTCUT_STATUSBAR] },
+	{ "keySaveMem",     Int_Tag, &ConfigureParams.Shortcut.withoutModifier[SHORTCUT_SAVEMEM] },
+	{ "keyLoadMem",     Int_Tag, &ConfigureParams.Shortcut.withoutModifier[SHORTCUT_LOADMEM] },
 	{ NULL , Error_Tag, NULL }
 };
 
@@ -140,6 +145,7 @@ static const struct Config_Tag configs_Memory[] =
 	{ "nMemoryBankSize2", Int_Tag, &ConfigureParams.Memory.nMemoryBankSize[2] },
 	{ "nMemoryBankSize3", Int_Tag, &ConfigureParams.Memory.nMemoryBankSize[3] },
     { "nMemorySpeed", Int_Tag, &ConfigureParams.Memory.nMemorySpeed },
+	{ "szMemoryCaptureFileName", String_Tag, ConfigureParams.Memory.szMemoryCaptureFileName },
 	{ NULL , Error_Tag, NULL }
 };
 
@@ -196,6 +202,7 @@ static const struct Config_Tag configs_SCSI[] =
     { "bWriteProtected6", Bool_Tag, &ConfigureParams.SCSI.target[6].bWriteProtected },
 
     { "nWriteProtection", Int_Tag, &ConfigureParams.SCSI.nWriteProtection },
+    { "szOverlayDir", String_Tag, ConfigureParams.SCSI.szOverlayDir },
     
     { NULL , Error_Tag, NULL }
 };
@@ -292,6 +299,7 @@ static const struct Config_Tag configs_System[] =
     { "n_FPUType", Int_Tag, &ConfigureParams.System.n_FPUType },
     { "bCompatibleFPU", Bool_Tag, &ConfigureParams.System.bCompatibleFPU },
     { "bMMU", Bool_Tag, &ConfigureParams.System.bMMU },
+    { "bMapDiskImages", Bool_Tag, &ConfigureParams.System.bMapDiskImages },
     { NULL , Error_Tag, NULL }
 };
 
@@ -299,6 +307,7 @@ static const struct Config_Tag configs_System[] =
 static const struct Config_Tag configs_Dimension[] =
 {
     { "bI860Thread",       Bool_Tag, &ConfigureParams.Dimension.bI860Thread },
+    { "bI860JIT",          Bool_Tag, &ConfigureParams.Dimension.bI860JIT },
     { "bMainDisplay",      Bool_Tag, &ConfigureParams.Dimension.bMainDisplay },
     { "nMainDisplay",      Int_Tag,  &ConfigureParams.Dimension.nMainDisplay },
 
@@ -376,6 +385,7 @@ void Configuration_SetDefault(void)
         ConfigureParams.SCSI.target[i].bWriteProtected = false;
     }
     ConfigureParams.SCSI.nWriteProtection = WRITEPROT_OFF;
+    ConfigureParams.SCSI.szOverlayDir[0] = '\0';
     
     /* Set defaults for MO drives */
     for (i = 0; i < MO_MAX_DRIVES; i++) {
@@ -430,11 +440,15 @@ void Configuration_SetDefault(void)
 	ConfigureParams.Shortcut.withModifier[SHORTCUT_QUIT]          = SDLK_q;
 	ConfigureParams.Shortcut.withModifier[SHORTCUT_DIMENSION]     = SDLK_n;
 	ConfigureParams.Shortcut.withModifier[SHORTCUT_STATUSBAR]     = SDLK_b;
+	ConfigureParams.Shortcut.withModifier[SHORTCUT_SAVEMEM]       = SDLK_k;
+	ConfigureParams.Shortcut.withModifier[SHORTCUT_LOADMEM]       = SDLK_l;
 
 	/* Set defaults for Memory */
 	memset(ConfigureParams.Memory.nMemoryBankSize, 16, 
            sizeof(ConfigureParams.Memory.nMemoryBankSize)); /* 64 MiB */
     ConfigureParams.Memory.nMemorySpeed = MEMORY_100NS;
+	sprintf(ConfigureParams.Memory.szMemoryCaptureFileName, "%s%cprevious.sav",
+	        psWorkingDir, PATHSEP);
 
 	/* Set defaults for Printer */
 	ConfigureParams.Printer.bPrinterConnected = false;
@@ -484,9 +498,11 @@ void Configuration_SetDefault(void)
     ConfigureParams.System.n_FPUType = FPU_68882;
     ConfigureParams.System.bCompatibleFPU = true;
     ConfigureParams.System.bMMU = true;
+    ConfigureParams.System.bMapDiskImages = true;
     
     /* Set defaults for Dimension */
     ConfigureParams.Dimension.bI860Thread  = host_num_cpus() != 1;
+    ConfigureParams.Dimension.bI860JIT     = false;
     ConfigureParams.Dimension.bMainDisplay = false;
     ConfigureParams.Dimension.nMainDisplay = 0;
     for (i = 0; i < ND_MAX_BOARDS; i++) {
@@ -912,3 +928,23 @@ void Configuration_Save(void)
     Configuration_SaveSection(sConfigFileName, configs_Dimension, "[Dimension]");
 }
 
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Save/restore snapshot of the configuration variables which define the
+ * emulated machine ('MemorySnapShot_Store' handles type)
+ */
+void Configuration_MemorySnapShot_Capture(bool bSave)
+{
+	MemorySnapShot_Store(&ConfigureParams.Rom, sizeof(ConfigureParams.Rom));
+	MemorySnapShot_Store(&ConfigureParams.System, sizeof(ConfigureParams.System));
+	MemorySnapShot_Store(ConfigureParams.Memory.nMemoryBankSize, sizeof(ConfigureParams.Memory.nMemoryBankSize));
+	MemorySnapShot_Store(&ConfigureParams.Memory.nMemorySpeed, sizeof(ConfigureParams.Memory.nMemorySpeed));
+	MemorySnapShot_Store(&ConfigureParams.Boot, sizeof(ConfigureParams.Boot));
+	MemorySnapShot_Store(&ConfigureParams.SCSI, sizeof(ConfigureParams.SCSI));
+	MemorySnapShot_Store(&ConfigureParams.MO, sizeof(ConfigureParams.MO));
+	MemorySnapShot_Store(&ConfigureParams.Floppy, sizeof(ConfigureParams.Floppy));
+	MemorySnapShot_Store(&ConfigureParams.Ethernet, sizeof(ConfigureParams.Ethernet));
+	MemorySnapShot_Store(&ConfigureParams.Printer, sizeof(ConfigureParams.Printer));
+	MemorySnapShot_Store(&ConfigureParams.Dimension, sizeof(ConfigureParams.Dimension));
+}
@@ -76,11 +76,15 @@ struct mmu_icache mmu_icache_data[MMU_ICACHE_SZ];
 #if MMU_IPAGECACHE
 uae_u32 atc_last_ins_laddr, atc_last_ins_paddr;
 uae_u8 atc_last_ins_cache;
+uae_u8 *atc_last_ins_host;
 #endif
 #if MMU_DPAGECACHE
 struct mmufastcache atc_data_cache_read[MMUFASTCACHE_ENTRIES];
 struct mmufastcache atc_data_cache_write[MMUFASTCACHE_ENTRIES];
 #endif
+/* Page caches may point directly to host memory, only if physical
+ * accesses do not emulate caches or timing */
+static bool mmu_host_access;
 
 #if CACHE_HIT_COUNT
 int mmu_ins_hit, mmu_ins_miss;
@@ -364,13 +368,12 @@ static void flush_shortcut_cache(uaecptr addr, bool super)
 		memset(&atc_data_cache_read, 0xff, sizeof atc_data_cache_read);
 		memset(&atc_data_cache_write, 0xff, sizeof atc_data_cache_write);
 	} else {
-		for (int i = 0; i < MMUFASTCACHE_ENTRIES; i++) {
-			uae_u32 idx = ((addr & mmu_pagemaski) >> mmu_pageshift1m) | (super ? 1 : 0);
-			if (atc_data_cache_read[i].log == idx)
-				atc_data_cache_read[i].log = 0xffffffff;
-			if (atc_data_cache_write[i].log == idx)
-				atc_data_cache_write[i].log = 0xffffffff;
-		}
+		uae_u32 idx1 = ((addr & mmu_pagemaski) >> mmu_pageshift1m) | (super ? 1 : 0);
+		uae_u32 idx2 = idx1 & (MMUFASTCACHE_ENTRIES - 1);
+		if (atc_data_cache_read[idx2].log == idx1)
+			atc_data_cache_read[idx2].log = 0xffffffff;
+		if (atc_data_cache_write[idx2].log == idx1)
+			atc_data_cache_write[idx2].log = 0xffffffff;
 	}
 #endif
 }
@@ -665,6 +668,10 @@ static uae_u32 mmu_fill_atc(uaecptr addr, bool super, uae_u32 tag, bool write, s
     int i;
 	int old_s;
     
+    // Page caches only hold pages that are in the ATC
+    if (l->valid && l->tag != tag)
+        flush_shortcut_cache((l->tag << 1) & mmu_pagemaski, (l->tag & 0x80000000) != 0);
+
     // Always use supervisor mode to access descriptors
     old_s = regs.s;
     regs.s = 1;
@@ -816,6 +823,7 @@ static void mmu_add_cache(uaecptr addr, uaecptr phys, bool super, bool data, boo
 		atc_last_ins_laddr = laddr;
 		atc_last_ins_paddr = phys;
 		atc_last_ins_cache = mmu_cache_state;
+		atc_last_ins_host = mmu_host_access ? get_host_read(phys) : NULL;
 #else
 	;
 #endif
@@ -828,12 +836,14 @@ static void mmu_add_cache(uaecptr addr, uaecptr phys, bool super, bool data, boo
 				atc_data_cache_write[idx2].log = idx1;
 				atc_data_cache_write[idx2].phys = phys;
 				atc_data_cache_write[idx2].cache_state = mmu_cache_state;
+				atc_data_cache_write[idx2].host = mmu_host_access ? get_host_write(phys) : NULL;
 			}
 		} else {
 			if (idx2 < MMUFASTCACHE_ENTRIES - 1) {
 				atc_data_cache_read[idx2].log = idx1;
 				atc_data_cache_read[idx2].phys = phys;
 				atc_data_cache_read[idx2].cache_state = mmu_cache_state;
+				atc_data_cache_read[idx2].host = mmu_host_access ? get_host_read(phys) : NULL;
 			}
 		}
 #endif
@@ -1474,6 +1484,8 @@ void REGPARAM2 mmu_set_funcs(void)
 	x_phys_put_byte = phys_put_byte;
 	x_phys_put_word = phys_put_word;
 	x_phys_put_long = phys_put_long;
+	mmu_host_access = !currprefs.cpu_memory_cycle_exact && !currprefs.cpu_compatible;
+	flush_shortcut_cache(0xffffffff, 0);
 	if (currprefs.cpu_memory_cycle_exact || currprefs.cpu_compatible) {
 		x_phys_get_iword = get_word_icache040;
 		x_phys_get_ilong = get_long_icache040;
@@ -30,8 +30,8 @@
 #include "uae/types.h"
 
 #define MMU_ICACHE 0
-#define MMU_IPAGECACHE 0
-#define MMU_DPAGECACHE 0
+#define MMU_IPAGECACHE 1
+#define MMU_DPAGECACHE 1
 
 #define CACHE_HIT_COUNT 0
 
@@ -244,6 +244,7 @@ extern void mmu_put_move16(uaecptr addr, uae_u32 *val, bool data, int size);
 #if MMU_IPAGECACHE
 extern uae_u32 atc_last_ins_laddr, atc_last_ins_paddr;
 extern uae_u8 atc_last_ins_cache;
+extern uae_u8 *atc_last_ins_host;
 #endif
 
 #if MMU_DPAGECACHE
@@ -253,6 +254,7 @@ struct mmufastcache
 	uae_u32 log;
 	uae_u32 phys;
 	uae_u8 cache_state;
+	uae_u8 *host;	/* host address of the page for RAM and ROM, else NULL */
 };
 extern struct mmufastcache atc_data_cache_read[MMUFASTCACHE_ENTRIES];
 extern struct mmufastcache atc_data_cache_write[MMUFASTCACHE_ENTRIES];
@@ -273,6 +275,8 @@ static ALWAYS_INLINE uae_u32 mmu_get_ilong(uaecptr addr, int size)
 #if CACHE_HIT_COUNT
 			mmu_ins_hit++;
 #endif
+			if (atc_last_ins_host)
+				return do_get_mem_long(atc_last_ins_host + (addr & mmu_pagemask));
 			addr = atc_last_ins_paddr | (addr & mmu_pagemask);
 			mmu_cache_state = atc_last_ins_cache;
 		} else {
@@ -297,6 +301,8 @@ static ALWAYS_INLINE uae_u16 mmu_get_iword(uaecptr addr, int size)
 #if CACHE_HIT_COUNT
 			mmu_ins_hit++;
 #endif
+			if (atc_last_ins_host)
+				return do_get_mem_word(atc_last_ins_host + (addr & mmu_pagemask));
 			addr = atc_last_ins_paddr | (addr & mmu_pagemask);
 			mmu_cache_state = atc_last_ins_cache;
 		} else {
@@ -326,6 +332,8 @@ static ALWAYS_INLINE uae_u32 mmu_get_long(uaecptr addr, bool data, int size)
 #if CACHE_HIT_COUNT
 			mmu_data_read_hit++;
 #endif
+			if (atc_data_cache_read[idx2].host)
+				return do_get_mem_long(atc_data_cache_read[idx2].host + (addr & mmu_pagemask));
 		} else {
 #if CACHE_HIT_COUNT
 			mmu_data_read_miss++;
@@ -352,6 +360,8 @@ static ALWAYS_INLINE uae_u16 mmu_get_word(uaecptr addr, bool data, int size)
 #if CACHE_HIT_COUNT
 			mmu_data_read_hit++;
 #endif
+			if (atc_data_cache_read[idx2].host)
+				return do_get_mem_word(atc_data_cache_read[idx2].host + (addr & mmu_pagemask));
 		} else {
 #if CACHE_HIT_COUNT
 			mmu_data_read_miss++;
@@ -378,6 +388,8 @@ static ALWAYS_INLINE uae_u8 mmu_get_byte(uaecptr addr, bool data, int size)
 #if CACHE_HIT_COUNT
 			mmu_data_read_hit++;
 #endif
+			if (atc_data_cache_read[idx2].host)
+				return atc_data_cache_read[idx2].host[addr & mmu_pagemask];
 		} else {
 #if CACHE_HIT_COUNT
 			mmu_data_read_miss++;
@@ -400,10 +412,14 @@ static ALWAYS_INLINE void mmu_put_long(uaecptr addr, uae_u32 val, bool data, int
 		uae_u32 idx2 = idx1 & (MMUFASTCACHE_ENTRIES - 1);
 		if (atc_data_cache_write[idx2].log == idx1) {
 			addr = atc_data_cache_write[idx2].phys | (addr & mmu_pagemask);
-			mmu_cache_state = atc_data_cache_read[idx2].cache_state;
+			mmu_cache_state = atc_data_cache_write[idx2].cache_state;
 #if CACHE_HIT_COUNT
 			mmu_data_write_hit++;
 #endif
+			if (atc_data_cache_write[idx2].host) {
+				do_put_mem_long(atc_data_cache_write[idx2].host + (addr & mmu_pagemask), val);
+				return;
+			}
 		} else {
 #if CACHE_HIT_COUNT
 			mmu_data_write_miss++;
@@ -426,10 +442,14 @@ static ALWAYS_INLINE void mmu_put_word(uaecptr addr, uae_u16 val, bool data, int
 		uae_u32 idx2 = idx1 & (MMUFASTCACHE_ENTRIES - 1);
 		if (atc_data_cache_write[idx2].log == idx1) {
 			addr = atc_data_cache_write[idx2].phys | (addr & mmu_pagemask);
-			mmu_cache_state = atc_data_cache_read[idx2].cache_state;
+			mmu_cache_state = atc_data_cache_write[idx2].cache_state;
 #if CACHE_HIT_COUNT
 			mmu_data_write_hit++;
 #endif
+			if (atc_data_cache_write[idx2].host) {
+				do_put_mem_word(atc_data_cache_write[idx2].host + (addr & mmu_pagemask), val);
+				return;
+			}
 		} else {
 #if CACHE_HIT_COUNT
 			mmu_data_write_miss++;
@@ -452,10 +472,14 @@ static ALWAYS_INLINE void mmu_put_byte(uaecptr addr, uae_u8 val, bool data, int
 		uae_u32 idx2 = idx1 & (MMUFASTCACHE_ENTRIES - 1);
 		if (atc_data_cache_write[idx2].log == idx1) {
 			addr = atc_data_cache_write[idx2].phys | (addr & mmu_pagemask);
-			mmu_cache_state = atc_data_cache_read[idx2].cache_state;
+			mmu_cache_state = atc_data_cache_write[idx2].cache_state;
 #if CACHE_HIT_COUNT
 			mmu_data_write_hit++;
 #endif
+			if (atc_data_cache_write[idx2].host) {
+				atc_data_cache_write[idx2].host[addr & mmu_pagemask] = val;
+				return;
+			}
 		} else {
 #if CACHE_HIT_COUNT
 			mmu_data_write_miss++;
@@ -562,7 +586,7 @@ static ALWAYS_INLINE void mmu_put_user_long(uaecptr addr, uae_u32 val, bool supe
 		uae_u32 idx2 = idx1 & (MMUFASTCACHE_ENTRIES - 1);
 		if (atc_data_cache_write[idx2].log == idx1) {
 			addr = atc_data_cache_write[idx2].phys | (addr & mmu_pagemask);
-			mmu_cache_state = atc_data_cache_read[idx2].cache_state;
+			mmu_cache_state = atc_data_cache_write[idx2].cache_state;
 #if CACHE_HIT_COUNT
 			mmu_data_write_hit++;
 #endif
@@ -590,7 +614,7 @@ static ALWAYS_INLINE void mmu_put_user_word(uaecptr addr, uae_u16 val, bool supe
 		uae_u32 idx2 = idx1 & (MMUFASTCACHE_ENTRIES - 1);
 		if (atc_data_cache_write[idx2].log == idx1) {
 			addr = atc_data_cache_write[idx2].phys | (addr & mmu_pagemask);
-			mmu_cache_state = atc_data_cache_read[idx2].cache_state;
+			mmu_cache_state = atc_data_cache_write[idx2].cache_state;
 #if CACHE_HIT_COUNT
 			mmu_data_write_hit++;
 #endif
@@ -618,7 +642,7 @@ static ALWAYS_INLINE void mmu_put_user_byte(uaecptr addr, uae_u8 val, bool super
 		uae_u32 idx2 = idx1 & (MMUFASTCACHE_ENTRIES - 1);
 		if (atc_data_cache_write[idx2].log == idx1) {
 			addr = atc_data_cache_write[idx2].phys | (addr & mmu_pagemask);
-			mmu_cache_state = atc_data_cache_read[idx2].cache_state;
+			mmu_cache_state = atc_data_cache_write[idx2].cache_state;
 #if CACHE_HIT_COUNT
 			mmu_data_write_hit++;
 #endif
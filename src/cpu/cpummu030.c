@@ -97,10 +97,14 @@ struct mmufastcache030
 	uae_u32 log;
 	uae_u32 phys;
 	uae_u8 cs;
+	uae_u8 *host;	/* host address of the page for RAM and ROM, else NULL */
 };
 static struct mmufastcache030 atc_data_cache_read[MMUFASTCACHE_ENTRIES030];
 static struct mmufastcache030 atc_data_cache_write[MMUFASTCACHE_ENTRIES030];
 #endif
+/* Page caches may point directly to host memory, only if physical
+ * accesses do not emulate timing */
+static bool mmu030_host_access;
 
 /* for debugging messages */
 static char table_letter[4] = {'A','B','C','D'};
@@ -169,11 +173,8 @@ static struct {
 
 #if MMU_IPAGECACHE030
 	uae_u8 mmu030_cache_state;
-#if MMU_DIRECT_ACCESS
-	uae_u8 *mmu030_last_physical_address_real;
-#else
+	uae_u8 *mmu030_last_host;
 	uae_u32 mmu030_last_physical_address;
-#endif
 	uae_u32 mmu030_last_logical_address;
 #endif
 
@@ -439,6 +440,7 @@ bool mmu_op30_pmove (uaecptr pc, uae_u32 opcode, uae_u16 next, uaecptr extra)
             else {
                 tt0_030 = x_get_long (extra);
                 mmu030.transparent.tt0 = mmu030_decode_tt(tt0_030);
+                mmu030_flush_cache(0xffffffff);
             }
             break;
         case 0x03: // TT1
@@ -447,6 +449,7 @@ bool mmu_op30_pmove (uaecptr pc, uae_u32 opcode, uae_u16 next, uaecptr extra)
             else {
                 tt1_030 = x_get_long (extra);
                 mmu030.transparent.tt1 = mmu030_decode_tt(tt1_030);
+                mmu030_flush_cache(0xffffffff);
             }
             break;
         default:
@@ -1631,6 +1634,10 @@ static uae_u32 mmu030_table_search(uaecptr addr, uae_u32 fc, bool write, int lev
 		write_log (_T("ATC entry not found!!!\n"));
 	}
 
+    /* Page caches only hold pages that are in the ATC */
+    if (mmu030.atc[i].logical.valid)
+        mmu030_flush_cache(mmu030.atc[i].logical.addr);
+
     mmu030_atc_handle_history_bit(i);
     
     /* Create ATC entry */
@@ -1913,6 +1920,7 @@ static void mmu030_add_data_read_cache(uaecptr addr, uaecptr phys, uae_u32 fc)
 		atc_data_cache_read[idx2].log = idx1;
 		atc_data_cache_read[idx2].phys = phys;
 		atc_data_cache_read[idx2].cs = mmu030_cache_state;
+		atc_data_cache_read[idx2].host = mmu030_host_access ? get_host_read(phys) : NULL;
 	}
 #endif
 }
@@ -1926,6 +1934,7 @@ static void mmu030_add_data_write_cache(uaecptr addr, uaecptr phys, uae_u32 fc)
 		atc_data_cache_write[idx2].log = idx1;
 		atc_data_cache_write[idx2].phys = phys;
 		atc_data_cache_write[idx2].cs = mmu030_cache_state;
+		atc_data_cache_write[idx2].host = mmu030_host_access ? get_host_write(phys) : NULL;
 	}
 #endif
 }
@@ -1991,11 +2000,8 @@ static uaecptr mmu030_get_i_atc(uaecptr addr, int l, uae_u32 fc, uae_u32 size) {
 
 #if MMU_IPAGECACHE030
 	mmu030.mmu030_cache_state = mmu030.atc[l].physical.cache_inhibit;
-#if MMU_DIRECT_ACCESS
-	mmu030.mmu030_last_physical_address_real = get_real_address(physical_addr);
-#else
+	mmu030.mmu030_last_host = mmu030_host_access ? get_host_read(physical_addr) : NULL;
 	mmu030.mmu030_last_physical_address = physical_addr;
-#endif
 	mmu030.mmu030_last_logical_address = (addr & mmu030.translation.page.imask) | fc;
 #endif
 
@@ -2107,6 +2113,10 @@ void mmu030_put_long(uaecptr addr, uae_u32 val, uae_u32 fc)
 		uae_u32 idx1 = ((addr & mmu030.translation.page.imask) >> mmu030.translation.page.size3m) | fc;
 		uae_u32 idx2 = idx1 & (MMUFASTCACHE_ENTRIES030 - 1);
 		if (atc_data_cache_write[idx2].log == idx1) {
+			if (atc_data_cache_write[idx2].host) {
+				do_put_mem_long(atc_data_cache_write[idx2].host + (addr & mmu030.translation.page.mask), val);
+				return;
+			}
 			addr = atc_data_cache_write[idx2].phys | (addr & mmu030.translation.page.mask);
 			mmu030_cache_state = atc_data_cache_write[idx2].cs;
 		} else
@@ -2133,6 +2143,10 @@ void mmu030_put_word(uaecptr addr, uae_u16 val, uae_u32 fc)
 		uae_u32 idx1 = ((addr & mmu030.translation.page.imask) >> mmu030.translation.page.size3m) | fc;
 		uae_u32 idx2 = idx1 & (MMUFASTCACHE_ENTRIES030 - 1);
 		if (atc_data_cache_write[idx2].log == idx1) {
+			if (atc_data_cache_write[idx2].host) {
+				do_put_mem_word(atc_data_cache_write[idx2].host + (addr & mmu030.translation.page.mask), val);
+				return;
+			}
 			addr = atc_data_cache_write[idx2].phys | (addr & mmu030.translation.page.mask);
 			mmu030_cache_state = atc_data_cache_write[idx2].cs;
 		} else
@@ -2159,6 +2173,10 @@ void mmu030_put_byte(uaecptr addr, uae_u8 val, uae_u32 fc)
 		uae_u32 idx1 = ((addr & mmu030.translation.page.imask) >> mmu030.translation.page.size3m) | fc;
 		uae_u32 idx2 = idx1 & (MMUFASTCACHE_ENTRIES030 - 1);
 		if (atc_data_cache_write[idx2].log == idx1) {
+			if (atc_data_cache_write[idx2].host) {
+				atc_data_cache_write[idx2].host[addr & mmu030.translation.page.mask] = val;
+				return;
+			}
 			addr = atc_data_cache_write[idx2].phys | (addr & mmu030.translation.page.mask);
 			mmu030_cache_state = atc_data_cache_write[idx2].cs;
 		} else
@@ -2186,6 +2204,8 @@ uae_u32 mmu030_get_long(uaecptr addr, uae_u32 fc)
 		uae_u32 idx1 = ((addr & mmu030.translation.page.imask) >> mmu030.translation.page.size3m) | fc;
 		uae_u32 idx2 = idx1 & (MMUFASTCACHE_ENTRIES030 - 1);
 		if (atc_data_cache_read[idx2].log == idx1) {
+			if (atc_data_cache_read[idx2].host)
+				return do_get_mem_long(atc_data_cache_read[idx2].host + (addr & mmu030.translation.page.mask));
 			addr = atc_data_cache_read[idx2].phys | (addr & mmu030.translation.page.mask);
 			mmu030_cache_state = atc_data_cache_read[idx2].cs;
 		} else
@@ -2213,6 +2233,8 @@ uae_u16 mmu030_get_word(uaecptr addr, uae_u32 fc)
 		uae_u32 idx1 = ((addr & mmu030.translation.page.imask) >> mmu030.translation.page.size3m) | fc;
 		uae_u32 idx2 = idx1 & (MMUFASTCACHE_ENTRIES030 - 1);
 		if (atc_data_cache_read[idx2].log == idx1) {
+			if (atc_data_cache_read[idx2].host)
+				return do_get_mem_word(atc_data_cache_read[idx2].host + (addr & mmu030.translation.page.mask));
 			addr = atc_data_cache_read[idx2].phys | (addr & mmu030.translation.page.mask);
 			mmu030_cache_state = atc_data_cache_read[idx2].cs;
 		} else
@@ -2240,6 +2262,8 @@ uae_u8 mmu030_get_byte(uaecptr addr, uae_u32 fc)
 		uae_u32 idx1 = ((addr & mmu030.translation.page.imask) >> mmu030.translation.page.size3m) | fc;
 		uae_u32 idx2 = idx1 & (MMUFASTCACHE_ENTRIES030 - 1);
 		if (atc_data_cache_read[idx2].log == idx1) {
+			if (atc_data_cache_read[idx2].host)
+				return atc_data_cache_read[idx2].host[addr & mmu030.translation.page.mask];
 			addr = atc_data_cache_read[idx2].phys | (addr & mmu030.translation.page.mask);
 			mmu030_cache_state = atc_data_cache_read[idx2].cs;
 		} else
@@ -2265,14 +2289,11 @@ uae_u32 mmu030_get_ilong(uaecptr addr, uae_u32 fc)
 	uae_u32 v;
 #if MMU_IPAGECACHE030
 	if (((addr & mmu030.translation.page.imask) | fc) == mmu030.mmu030_last_logical_address) {
-#if MMU_DIRECT_ACCESS
-		uae_u8 *p = &mmu030.mmu030_last_physical_address_real[addr & mmu030.translation.page.mask];
-		return (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | (p[3]);
-#else
+		if (mmu030.mmu030_last_host)
+			return do_get_mem_long(mmu030.mmu030_last_host + (addr & mmu030.translation.page.mask));
 		mmu030_cache_state = mmu030.mmu030_cache_state;
 		v = x_phys_get_ilong(mmu030.mmu030_last_physical_address + (addr & mmu030.translation.page.mask));
 		return v;
-#endif
 	}
 	mmu030.mmu030_last_logical_address = 0xffffffff;
 #endif
@@ -2297,14 +2318,11 @@ uae_u16 mmu030_get_iword(uaecptr addr, uae_u32 fc)
 	uae_u16 v;
 #if MMU_IPAGECACHE030
 	if (((addr & mmu030.translation.page.imask) | fc) == mmu030.mmu030_last_logical_address) {
-#if MMU_DIRECT_ACCESS
-		uae_u8 *p = &mmu030.mmu030_last_physical_address_real[addr & mmu030.translation.page.mask];
-		return (p[0] << 8) | p[1];
-#else
+		if (mmu030.mmu030_last_host)
+			return do_get_mem_word(mmu030.mmu030_last_host + (addr & mmu030.translation.page.mask));
 		mmu030_cache_state = mmu030.mmu030_cache_state;
 		v = x_phys_get_iword(mmu030.mmu030_last_physical_address + (addr & mmu030.translation.page.mask));
 		return v;
-#endif
 	}
 	mmu030.mmu030_last_logical_address = 0xffffffff;
 #endif
@@ -2660,10 +2678,21 @@ void mmu030_reset(int hardreset)
 	mmu030_set_funcs();
 }
 
+/* Decode MMU registers after they have been set from a memory snapshot */
+void mmu030_decode_regs(void)
+{
+    mmu030.transparent.tt0 = mmu030_decode_tt(tt0_030);
+    mmu030.transparent.tt1 = mmu030_decode_tt(tt1_030);
+    mmu030_decode_tc(tc_030, false);
+    mmu030_flush_atc_all();
+}
+
 void mmu030_set_funcs(void)
 {
 	if (currprefs.mmu_model != 68030)
 		return;
+	mmu030_host_access = !currprefs.cpu_memory_cycle_exact;
+	mmu030_flush_cache(0xffffffff);
 	if (currprefs.cpu_memory_cycle_exact) {
 		x_phys_get_iword = mem_access_delay_wordi_read_ce020;
 		x_phys_get_ilong = mem_access_delay_longi_read_ce020;
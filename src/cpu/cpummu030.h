@@ -7,8 +7,8 @@
 
 #include "mmu_common.h"
 
-#define MMU_DPAGECACHE030 0
-#define MMU_IPAGECACHE030 0
+#define MMU_DPAGECACHE030 1
+#define MMU_IPAGECACHE030 1
 
 extern uae_u64 srp_030, crp_030;
 extern uae_u32 tt0_030, tt1_030, tc_030;
@@ -68,6 +68,7 @@ bool mmu030_decode_rp(uae_u64 RP);
 
 void mmu030_flush_atc_all(void);
 void mmu030_reset(int hardreset);
+void mmu030_decode_regs(void);
 void mmu030_set_funcs(void);
 uaecptr mmu030_translate(uaecptr addr, bool super, bool data, bool write);
 void mmu030_hardware_bus_error(uaecptr addr, uae_u32 v, bool read, bool ins, int size);
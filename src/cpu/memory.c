@@ -27,6 +27,7 @@ const char Memory_fileid[] = "Previous memory.c : " __DATE__ " " __TIME__;
 #include "reset.h"
 #include "m68000.h"
 #include "configuration.h"
+#include "memorySnapShot.h"
 #include "NextBus.hpp"
 
 #include "newcpu.h"
@@ -172,6 +173,11 @@ uae_u8*    NEXTRam        = NULL;
 uae_u8*    NEXTRom        = NULL;
 uae_u8*    NEXTIo         = NULL;
 
+/* One byte per block of video memory, set by writes and cleared by the repainter */
+volatile uae_u8 NEXTVideoDirty[NEXT_VIDEO_DIRTY_SIZE];
+
+#define NEXT_VIDEO_DIRTY(addr) (NEXTVideoDirty[(addr)>>NEXT_VIDEO_DIRTY_SHIFT] = 1)
+
 /* Unused stuff */
 uae_u8 ce_banktype[65536], ce_cachable[65536];
 
@@ -530,18 +536,23 @@ static void mem_video_lput(uaecptr addr, uae_u32 l)
 {
 	addr &= NEXT_VRAM_MASK;
 	do_put_mem_long(NEXTVideo + addr, l);
+	NEXT_VIDEO_DIRTY(addr);
+	NEXT_VIDEO_DIRTY(addr+3);
 }
 
 static void mem_video_wput(uaecptr addr, uae_u32 w)
 {
 	addr &= NEXT_VRAM_MASK;
 	do_put_mem_word(NEXTVideo + addr, w);
+	NEXT_VIDEO_DIRTY(addr);
+	NEXT_VIDEO_DIRTY(addr+1);
 }
 
 static void mem_video_bput(uaecptr addr, uae_u32 b)
 {
 	addr &= NEXT_VRAM_MASK;
 	NEXTVideo[addr] = b;
+	NEXT_VIDEO_DIRTY(addr);
 }
 
 
@@ -759,18 +770,23 @@ static void mem_color_video_lput(uaecptr addr, uae_u32 l)
 {
 	addr &= NEXT_VRAM_COLOR_MASK;
 	do_put_mem_long(NEXTVideo + addr, l);
+	NEXT_VIDEO_DIRTY(addr);
+	NEXT_VIDEO_DIRTY(addr+3);
 }
 
 static void mem_color_video_wput(uaecptr addr, uae_u32 w)
 {
 	addr &= NEXT_VRAM_COLOR_MASK;
 	do_put_mem_word(NEXTVideo + addr, w);
+	NEXT_VIDEO_DIRTY(addr);
+	NEXT_VIDEO_DIRTY(addr+1);
 }
 
 static void mem_color_video_bput(uaecptr addr, uae_u32 b)
 {
 	addr &= NEXT_VRAM_COLOR_MASK;
 	NEXTVideo[addr] = b;
+	NEXT_VIDEO_DIRTY(addr);
 }
 
 
@@ -977,6 +993,8 @@ static void init_mem_banks (void)
         put_mem_bank (bank_lput, i<<16, BusErrMem_bank.lput);
         put_mem_bank (bank_wput, i<<16, BusErrMem_bank.wput);
         put_mem_bank (bank_bput, i<<16, BusErrMem_bank.bput);
+		bank_host_read[i]  = NULL;
+		bank_host_write[i] = NULL;
     }
 }
 
@@ -992,6 +1010,9 @@ mem_put_func bank_lput[65536];
 mem_get_func bank_bget[65536];
 mem_put_func bank_bput[65536];
 
+uae_u8* bank_host_read[65536];
+uae_u8* bank_host_write[65536];
+
 /*
  * Initialize the memory banks
  */
@@ -1031,9 +1052,11 @@ const char* memory_init(int *nNewNEXTMemSize)
 	
 	/* Map ROM */
 	map_banks(&ROM_bank, NEXT_EPROM_START >> 16, NEXT_EPROM_SIZE>>16);
+	map_banks_host(NEXTRom, NEXT_EPROM_MASK, NEXT_EPROM_START >> 16, NEXT_EPROM_SIZE>>16, false);
 	write_log("Mapping ROM at $%08x: %ikB\n", NEXT_EPROM_START, NEXT_EPROM_SIZE/1024);
 	if (ConfigureParams.System.nMachineType != NEXT_CUBE030) {
 		map_banks(&ROM_bank, NEXT_EPROM_BMAP_START >> 16, NEXT_EPROM_SIZE>>16);
+		map_banks_host(NEXTRom, NEXT_EPROM_MASK, NEXT_EPROM_BMAP_START >> 16, NEXT_EPROM_SIZE>>16, false);
 		write_log("Mapping ROM trough BMAP at $%08x: %ikB\n", NEXT_EPROM_BMAP_START, NEXT_EPROM_SIZE/1024);
 	}
 	
@@ -1041,6 +1064,7 @@ const char* memory_init(int *nNewNEXTMemSize)
 	if (nNewNEXTMemSize[0]) {
 		NEXT_ram_bank0_mask = NEXT_ram_bank_mask|((nNewNEXTMemSize[0]<<20)-1);
 		map_banks(&RAM_bank0, bankstart[0]>>16, NEXT_ram_bank_size >> 16);
+		map_banks_host(NEXTRam, NEXT_ram_bank0_mask, bankstart[0]>>16, NEXT_ram_bank_size >> 16, true);
 		write_log("Mapping main memory bank0 at $%08x: %iMB\n", bankstart[0], nNewNEXTMemSize[0]);
 	} else {
 		NEXT_ram_bank0_mask = 0;
@@ -1051,6 +1075,7 @@ const char* memory_init(int *nNewNEXTMemSize)
 	if (nNewNEXTMemSize[1]) {
 		NEXT_ram_bank1_mask = NEXT_ram_bank_mask|((nNewNEXTMemSize[1]<<20)-1);
 		map_banks(&RAM_bank1, bankstart[1]>>16, NEXT_ram_bank_size >> 16);
+		map_banks_host(NEXTRam, NEXT_ram_bank1_mask, bankstart[1]>>16, NEXT_ram_bank_size >> 16, true);
 		write_log("Mapping main memory bank1 at $%08x: %iMB\n", bankstart[1], nNewNEXTMemSize[1]);
 	} else {
 		NEXT_ram_bank1_mask = 0;
@@ -1061,6 +1086,7 @@ const char* memory_init(int *nNewNEXTMemSize)
 	if (nNewNEXTMemSize[2]) {
 		NEXT_ram_bank2_mask = NEXT_ram_bank_mask|((nNewNEXTMemSize[2]<<20)-1);
 		map_banks(&RAM_bank2, bankstart[2]>>16, NEXT_ram_bank_size >> 16);
+		map_banks_host(NEXTRam, NEXT_ram_bank2_mask, bankstart[2]>>16, NEXT_ram_bank_size >> 16, true);
 		write_log("Mapping main memory bank2 at $%08x: %iMB\n", bankstart[2], nNewNEXTMemSize[2]);
 	} else {
 		NEXT_ram_bank2_mask = 0;
@@ -1071,6 +1097,7 @@ const char* memory_init(int *nNewNEXTMemSize)
 	if (nNewNEXTMemSize[3]) {
 		NEXT_ram_bank3_mask = NEXT_ram_bank_mask|((nNewNEXTMemSize[3]<<20)-1);
 		map_banks(&RAM_bank3, bankstart[3]>>16, NEXT_ram_bank_size >> 16);
+		map_banks_host(NEXTRam, NEXT_ram_bank3_mask, bankstart[3]>>16, NEXT_ram_bank_size >> 16, true);
 		write_log("Mapping main memory bank3 at $%08x: %iMB\n", bankstart[3], nNewNEXTMemSize[3]);
 	} else {
 		NEXT_ram_bank3_mask = 0;
@@ -1210,6 +1237,7 @@ const char* memory_init(int *nNewNEXTMemSize)
 	} else {
 		for (i=0;i<NEXT_VRAM_COLOR_SIZE;i++) NEXTVideo[i]=0xFF;
 	}
+	memset((void*)NEXTVideoDirty, 1, NEXT_VIDEO_DIRTY_SIZE);
 	for (i=0;i<NEXT_RAM_MAX_SIZE;i++) NEXTRam[i]=0;
 	for (i=0;i<NEXT_IO_SIZE;i++) NEXTIo[i]=0;
 	
@@ -1219,6 +1247,25 @@ const char* memory_init(int *nNewNEXTMemSize)
 }
 
 
+/*
+ * Save/restore RAM, video memory and IO register space to/from a memory
+ * snapshot. Only the populated part of each RAM bank is stored.
+ */
+void Memory_MemorySnapShot_Capture(bool bSave)
+{
+	int i;
+
+	for (i=0; i<N_BANKS; i++) {
+		MemorySnapShot_Store(NEXTRam + NEXT_ram_bank_size * i,
+		                     ConfigureParams.Memory.nMemoryBankSize[i] << 20);
+	}
+	MemorySnapShot_Store(NEXTVideo, NEXT_VRAM_COLOR_SIZE);
+	MemorySnapShot_Store(NEXTIo, NEXT_IO_SIZE);
+	if (!bSave)
+		memset((void*)NEXTVideoDirty, 1, NEXT_VIDEO_DIRTY_SIZE);
+}
+
+
 /*
  * Uninitialize the memory banks.
  */
@@ -1237,6 +1284,22 @@ void map_banks (addrbank *bank, int start, int size) {
         put_mem_bank (bank_lput, bnr << 16, bank->lput);
         put_mem_bank (bank_wput, bnr << 16, bank->wput);
         put_mem_bank (bank_bput, bnr << 16, bank->bput);
+		bank_host_read[bnr]  = NULL;
+		bank_host_write[bnr] = NULL;
     }
 	return;
 }
+
+/*
+ * Allow direct host access to banks that map plain memory. The host
+ * address of addr is base + (addr & mask), like in the bank's access
+ * functions. Call after map_banks, which clears the host pointers.
+ */
+void map_banks_host (uae_u8 *base, uae_u32 mask, int start, int size, bool writable) {
+	int bnr;
+
+	for (bnr = start; bnr < start + size; bnr++) {
+		bank_host_read[bnr]  = base + (((uae_u32)bnr << 16) & mask);
+		bank_host_write[bnr] = writable ? bank_host_read[bnr] : NULL;
+	}
+}
@@ -31,6 +31,11 @@ extern uae_u8* NEXTRam;
 extern uae_u8* NEXTRom;
 extern uae_u8* NEXTIo;
 
+/* Dirty map for video memory, one byte per 256 bytes */
+#define NEXT_VIDEO_DIRTY_SHIFT 8
+#define NEXT_VIDEO_DIRTY_SIZE  ((0x00200000>>NEXT_VIDEO_DIRTY_SHIFT)+1)
+extern volatile uae_u8 NEXTVideoDirty[];
+
 typedef uae_u32 (*mem_get_func)(uaecptr) REGPARAM;
 typedef void (*mem_put_func)(uaecptr, uae_u32) REGPARAM;
 
@@ -53,9 +58,29 @@ extern mem_put_func bank_bput[65536];
 #define get_mem_bank(bank, addr)    (bank[bankindex(addr)])
 #define put_mem_bank(bank, addr, b) (bank[bankindex(addr)] = (b))
 
+/* Host pointers to the start of each bank for plain RAM and ROM, NULL for
+ * banks that have to go through their access functions (I/O, video, memory
+ * write functions, bus errors). ROM is only present in bank_host_read. */
+extern uae_u8* bank_host_read[65536];
+extern uae_u8* bank_host_write[65536];
+
+STATIC_INLINE uae_u8* get_host_read(uaecptr addr)
+{
+	uae_u8* base = bank_host_read[bankindex(addr)];
+	return base ? base + (addr & 0xFFFF) : NULL;
+}
+
+STATIC_INLINE uae_u8* get_host_write(uaecptr addr)
+{
+	uae_u8* base = bank_host_write[bankindex(addr)];
+	return base ? base + (addr & 0xFFFF) : NULL;
+}
+
 const char* memory_init(int *membanks);
 void memory_uninit (void);
+void Memory_MemorySnapShot_Capture(bool bSave);
 void map_banks(addrbank *bank, int first, int count);
+void map_banks_host(uae_u8 *base, uae_u32 mask, int first, int count, bool writable);
 
 #define get_long(addr)   (call_mem_get_func(get_mem_bank(bank_lget, addr), addr))
 #define get_word(addr)   (call_mem_get_func(get_mem_bank(bank_wget, addr), addr))
@@ -4704,6 +4704,11 @@ void doint(void)
 		set_special (SPCFLAG_INT);
 	else
 		set_special (SPCFLAG_DOINT);
+#else
+	/* Previous: interrupt mask changed, check if a pending interrupt
+	 * can be taken now */
+	if (intlev() > regs.intmask)
+		set_special (SPCFLAG_INT);
 #endif // Previous
 }
 
@@ -4825,13 +4830,14 @@ static int do_specialties (int cycles)
 			CALL_VAR(PendingInterrupt.pFunction);		/* call the interrupt handler */
 		}
 		
-		/* Previous: for now we poll the interrupt pins with every instruction.
-		 * TODO: only do this when an actual interrupt is active to not
-		 * unneccessarily slow down emulation.
-		 */
-		int intr = intlev ();
-		if (intr > regs.intmask || intr == 7)
-			do_interrupt (intr);
+		/* Previous: the interrupt level only needs to be checked
+		 * if it or the interrupt mask changed (see sysReg.c) */
+		if (regs.spcflags & SPCFLAG_INT) {
+			unset_special (SPCFLAG_INT);
+			int intr = intlev ();
+			if (intr > regs.intmask || intr == 7)
+				do_interrupt (intr);
+		}
 #endif
 		first = false;
 #if 0 // Previous: for now this is done inside the run loops
@@ -6007,6 +6013,8 @@ static void m68k_run_mmu040 (void)
 	check_halt();
 #ifdef WINUAE_FOR_HATARI
 	Log_Printf(LOG_DEBUG,  "m68k_run_mmu040\n");
+	/* check the interrupt level before the first instruction */
+	set_special(SPCFLAG_INT);
 #endif
 
 	while (!halt) {
@@ -6038,18 +6046,20 @@ static void m68k_run_mmu040 (void)
                 while ( ( PendingInterrupt.time <= 0 ) && ( PendingInterrupt.pFunction ) && ( ( regs.spcflags & SPCFLAG_STOP ) == 0 ) ) {
                     CALL_VAR(PendingInterrupt.pFunction);		/* call the interrupt handler */
                 }
-                
-                /* Previous: for now we poll the interrupt pins with every instruction.
-                 * TODO: only do this when an actual interrupt is active to not
-                 * unneccessarily slow down emulation.
-                 */
-                intr = intlev ();
-                if (intr>regs.intmask || (intr==7 && intr>lastintr))
-                    Exception (intr + 24);
-                lastintr = intr;
 #endif
 
 				if (regs.spcflags) {
+#ifdef WINUAE_FOR_HATARI
+					/* Previous: the interrupt level only needs to be checked
+					 * if it or the interrupt mask changed (see sysReg.c) */
+					if (regs.spcflags & SPCFLAG_INT) {
+						unset_special (SPCFLAG_INT);
+						intr = intlev ();
+						if (intr>regs.intmask || (intr==7 && intr>lastintr))
+							Exception (intr + 24);
+						lastintr = intr;
+					}
+#endif
 					if (do_specialties (cpu_cycles)) {
 						STOPTRY;
 						return;
@@ -6090,6 +6100,8 @@ static void m68k_run_mmu030 (void)
 
 #ifdef WINUAE_FOR_HATARI
 	Log_Printf(LOG_DEBUG,  "m68k_run_mmu030\n");
+	/* check the interrupt level before the first instruction */
+	set_special(SPCFLAG_INT);
 #endif
 
 	mmu030_opcode_stageb = -1;
@@ -6170,16 +6182,19 @@ insretry:
 				while ( ( PendingInterrupt.time <= 0 ) && ( PendingInterrupt.pFunction ) && ( ( regs.spcflags & SPCFLAG_STOP ) == 0 ) ) {
 					CALL_VAR(PendingInterrupt.pFunction);		/* call the interrupt handler */
 				}
-				/* Previous: for now we poll the interrupt pins with every instruction.
-				 * TODO: only do this when an actual interrupt is active to not
-				 * unneccessarily slow down emulation.
-				 */
-				intr = intlev ();
-				if (intr>regs.intmask || (intr==7 && intr>lastintr))
-					Exception (intr + 24);
-				lastintr = intr;
 #endif
 				if (regs.spcflags) {
+#ifdef WINUAE_FOR_HATARI
+					/* Previous: the interrupt level only needs to be checked
+					 * if it or the interrupt mask changed (see sysReg.c) */
+					if (regs.spcflags & SPCFLAG_INT) {
+						unset_special (SPCFLAG_INT);
+						intr = intlev ();
+						if (intr>regs.intmask || (intr==7 && intr>lastintr))
+							Exception (intr + 24);
+						lastintr = intr;
+					}
+#endif
 					if (do_specialties (cpu_cycles)) {
 						STOPTRY;
 						return;
@@ -7149,6 +7164,9 @@ void m68k_go (int may_quit)
 #endif
 			custom_reset (cpu_hardreset != 0, cpu_keyboardreset);
 			m68k_reset2 (cpu_hardreset != 0);
+#ifdef WINUAE_FOR_HATARI
+			M68000_ApplySnapShot();
+#endif
 //			if (cpu_hardreset) {
 //				memory_clear ();
 //				write_log (_T("hardreset, memory cleared\n"));
@@ -38,13 +38,13 @@ const char CycInt_fileid[] = "Previous cycInt.c : " __DATE__ " " __TIME__;
 #include "scc.h"
 #include "configuration.h"
 #include "main.h"
+#include "memorySnapShot.h"
 #include "nd_sdl.hpp"
 
 void (*PendingInterruptFunction)(void);
 Sint64 PendingInterruptCounter;
 int    usCheckCycles;
 
-Sint64 nCyclesOver;
 Sint64 nCyclesMainCounter;         /* Main cycles counter, counts emulated CPU cycles sind reset */
 
 
@@ -77,8 +77,113 @@ static INTERRUPTHANDLER InterruptHandlers[MAX_INTERRUPTS];
 INTERRUPTHANDLER        PendingInterrupt;
 static int              ActiveInterrupt=0;
 
+/* Pending interrupts are kept in two binary min-heaps ordered by their
+ * absolute deadline: one for CPU cycle based interrupts (deadline in
+ * nCyclesMainCounter units) and one for microsecond based interrupts
+ * (deadline in host_time_us() units). QueuePos holds the position of each
+ * handler inside its heap or -1 if it is not queued. */
+typedef struct {
+    int          count;
+    interrupt_id entry[MAX_INTERRUPTS];
+} INTERRUPTQUEUE;
+
+static INTERRUPTQUEUE CpuQueue;
+static INTERRUPTQUEUE UsQueue;
+static int            QueuePos[MAX_INTERRUPTS];
+
 static void CycInt_SetNewInterrupt(void);
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Helper functions for maintaining the interrupt queues.
+ */
+static inline bool CycInt_QueueLess(interrupt_id a, interrupt_id b) {
+    return InterruptHandlers[a].time < InterruptHandlers[b].time;
+}
+
+static inline void CycInt_QueueSet(INTERRUPTQUEUE* q, int pos, interrupt_id Handler) {
+    q->entry[pos]     = Handler;
+    QueuePos[Handler] = pos;
+}
+
+static void CycInt_QueueSiftUp(INTERRUPTQUEUE* q, int pos) {
+    interrupt_id Handler = q->entry[pos];
+    
+    while (pos > 0) {
+        int parent = (pos - 1) / 2;
+        if (!CycInt_QueueLess(Handler, q->entry[parent]))
+            break;
+        CycInt_QueueSet(q, pos, q->entry[parent]);
+        pos = parent;
+    }
+    CycInt_QueueSet(q, pos, Handler);
+}
+
+static void CycInt_QueueSiftDown(INTERRUPTQUEUE* q, int pos) {
+    interrupt_id Handler = q->entry[pos];
+    
+    for (;;) {
+        int child = 2 * pos + 1;
+        if (child >= q->count)
+            break;
+        if (child + 1 < q->count && CycInt_QueueLess(q->entry[child + 1], q->entry[child]))
+            child++;
+        if (!CycInt_QueueLess(q->entry[child], Handler))
+            break;
+        CycInt_QueueSet(q, pos, q->entry[child]);
+        pos = child;
+    }
+    CycInt_QueueSet(q, pos, Handler);
+}
+
+static INTERRUPTQUEUE* CycInt_Queue(int type) {
+    switch (type) {
+        case CYC_INT_CPU: return &CpuQueue;
+        case CYC_INT_US:  return &UsQueue;
+        default:          return NULL;
+    }
+}
+
+/**
+ * Remove handler from the queue it is currently in (if any).
+ */
+static void CycInt_Dequeue(interrupt_id Handler) {
+    INTERRUPTQUEUE* q   = CycInt_Queue(InterruptHandlers[Handler].type);
+    int             pos = QueuePos[Handler];
+    
+    InterruptHandlers[Handler].type = CYC_INT_NONE;
+    QueuePos[Handler]               = -1;
+    
+    if (q == NULL || pos < 0)
+        return;
+    
+    q->count--;
+    if (pos < q->count) {
+        CycInt_QueueSet(q, pos, q->entry[q->count]);
+        if (pos > 0 && CycInt_QueueLess(q->entry[pos], q->entry[(pos - 1) / 2]))
+            CycInt_QueueSiftUp(q, pos);
+        else
+            CycInt_QueueSiftDown(q, pos);
+    }
+}
+
+/**
+ * Insert handler with given type and absolute deadline, replacing any
+ * previously scheduled instance of the same handler.
+ */
+static void CycInt_Enqueue(interrupt_id Handler, int type, Sint64 time) {
+    INTERRUPTQUEUE* q = CycInt_Queue(type);
+    
+    CycInt_Dequeue(Handler);
+    
+    InterruptHandlers[Handler].type = type;
+    InterruptHandlers[Handler].time = time;
+    
+    CycInt_QueueSet(q, q->count, Handler);
+    q->count++;
+    CycInt_QueueSiftUp(q, QueuePos[Handler]);
+}
+
 /*-----------------------------------------------------------------------*/
 /**
  * Reset interrupts, handlers
@@ -87,9 +192,10 @@ void CycInt_Reset(void) {
 	int i;
 
 	/* Reset counts */
-    PendingInterrupt.time = 0;
+    PendingInterrupt.type      = CYC_INT_NONE;
+    PendingInterrupt.time      = INT64_MAX;
+    PendingInterrupt.pFunction = NULL;
 	ActiveInterrupt       = 0;
-	nCyclesOver           = 0;
     nCyclesMainCounter    = 0;
     usCheckCycles         = 0;
         
@@ -98,62 +204,77 @@ void CycInt_Reset(void) {
 		InterruptHandlers[i].type      = CYC_INT_NONE;
 		InterruptHandlers[i].time      = INT64_MAX;
 		InterruptHandlers[i].pFunction = pIntHandlerFunctions[i];
+		QueuePos[i]                    = -1;
 	}
+	CpuQueue.count = 0;
+	UsQueue.count  = 0;
 }
 
 /*-----------------------------------------------------------------------*/
 /**
- * Find next interrupt to occur, and store to global variables for decrement
- * in instruction decode loop.
- * (SC) Microsecond interrupts are skipped here and handled in the decode loop.
+ * Save and restore snapshot of interrupt variables. Deadlines are absolute,
+ * so they become valid again as soon as the main cycle counter and the host
+ * time are restored.
  */
-static void CycInt_SetNewInterrupt(void) {
-	Sint64       LowestCycleCount = INT64_MAX;
-	interrupt_id LowestInterrupt  = INTERRUPT_NULL;
-    
-	/* Find next interrupt to go off */
-	for(int i = INTERRUPT_NULL+1; i < MAX_INTERRUPTS; i++) {
-        /* Is interrupt pending? */
-        if(InterruptHandlers[i].type == CYC_INT_CPU && InterruptHandlers[i].time < LowestCycleCount) {
-            LowestCycleCount = InterruptHandlers[i].time;
-            LowestInterrupt  = i;
-        }
+void CycInt_MemorySnapShot_Capture(bool bSave)
+{
+	int i;
+	int type;
+	Sint64 time;
+
+	MemorySnapShot_Store(&nCyclesMainCounter, sizeof(nCyclesMainCounter));
+	MemorySnapShot_Store(&usCheckCycles, sizeof(usCheckCycles));
+
+	for (i=0; i<MAX_INTERRUPTS; i++) {
+		type = InterruptHandlers[i].type;
+		time = InterruptHandlers[i].time;
+		MemorySnapShot_Store(&type, sizeof(type));
+		MemorySnapShot_Store(&time, sizeof(time));
+
+		if (!bSave) {
+			if (type == CYC_INT_CPU || type == CYC_INT_US)
+				CycInt_Enqueue(i, type, time);
+			else
+				CycInt_Dequeue(i);
+		}
 	}
 
-	/* Set new counts, active interrupt */
-    PendingInterrupt = InterruptHandlers[LowestInterrupt];
-	ActiveInterrupt  = LowestInterrupt;
+	if (!bSave)
+		CycInt_SetNewInterrupt();
 }
 
 /*-----------------------------------------------------------------------*/
 /**
- * Adjust all interrupt timings, MUST call CycInt_SetNewInterrupt after this.
+ * Find next interrupt to occur, and store to global variables for decrement
+ * in instruction decode loop. The global counter is relative to the current
+ * value of nCyclesMainCounter.
+ * (SC) Microsecond interrupts are skipped here and handled in the decode loop.
  */
-static void CycInt_UpdateInterrupt(void) {
-	int i;
-
-	/* Adjust table by subtracting cycles that have passed since last update */
-	for (i = 0; i < MAX_INTERRUPTS; i++) {
-		if (InterruptHandlers[i].type == CYC_INT_CPU)
-			InterruptHandlers[i].time -= nCyclesOver;
+static void CycInt_SetNewInterrupt(void) {
+	if (CpuQueue.count > 0) {
+		interrupt_id LowestInterrupt = CpuQueue.entry[0];
+		
+		PendingInterrupt       = InterruptHandlers[LowestInterrupt];
+		PendingInterrupt.time -= nCyclesMainCounter;
+		ActiveInterrupt        = LowestInterrupt;
+	} else {
+		PendingInterrupt = InterruptHandlers[INTERRUPT_NULL];
+		ActiveInterrupt  = INTERRUPT_NULL;
 	}
-    nCyclesOver = 0;
 }
 
 /*-----------------------------------------------------------------------*/
 /**
- * Check all microsecond interrupt timings
+ * Check the next microsecond interrupt timing
  */
 bool CycInt_SetNewInterruptUs(void) {
-    Sint64 now = host_time_us();
-    if (ConfigureParams.System.bRealtime) {
-        for(int i = 0; i < MAX_INTERRUPTS; i++) {
-            if (InterruptHandlers[i].type == CYC_INT_US && now > InterruptHandlers[i].time) {
-                PendingInterrupt = InterruptHandlers[i];
-                PendingInterrupt.time = -1;
-                ActiveInterrupt       = i;
-                return true;
-            }
+    if (ConfigureParams.System.bRealtime && UsQueue.count > 0) {
+        interrupt_id i = UsQueue.entry[0];
+        if (host_time_us() > InterruptHandlers[i].time) {
+            PendingInterrupt      = InterruptHandlers[i];
+            PendingInterrupt.time = -1;
+            ActiveInterrupt       = i;
+            return true;
         }
     }
     return false;
@@ -161,15 +282,11 @@ bool CycInt_SetNewInterruptUs(void) {
 
 /*-----------------------------------------------------------------------*/
 /**
- * Adjust all interrupt timings as 'ActiveInterrupt' has occured, and
- * remove from active list.
+ * Remove 'ActiveInterrupt' from active list as it has occured.
  */
 void CycInt_AcknowledgeInterrupt(void) {
-	/* Update list cycle counts */
-	CycInt_UpdateInterrupt();
-
 	/* Disable interrupt entry which has just occured */
-	InterruptHandlers[ActiveInterrupt].type = CYC_INT_NONE;
+	CycInt_Dequeue(ActiveInterrupt);
 
 	/* Set new */
 	CycInt_SetNewInterrupt();
@@ -182,13 +299,7 @@ void CycInt_AcknowledgeInterrupt(void) {
 void CycInt_AddRelativeInterruptCycles(Sint64 CycleTime, interrupt_id Handler) {
 	assert(CycleTime >= 0);
 
-	/* Update list cycle counts with current PendingInterruptCount before adding a new int, */
-	/* because CycInt_SetNewInterrupt can change the active int / PendingInterruptCount */
-	if ( ActiveInterrupt > 0 )
-		CycInt_UpdateInterrupt();
-
-	InterruptHandlers[Handler].type = CYC_INT_CPU;
-	InterruptHandlers[Handler].time = CycleTime;
+	CycInt_Enqueue(Handler, CYC_INT_CPU, nCyclesMainCounter + CycleTime);
 
 	/* Set new active int and compute a new value for PendingInterruptCount*/
 	CycInt_SetNewInterrupt();
@@ -203,14 +314,9 @@ void CycInt_AddRelativeInterruptUs(Sint64 us, Sint64 usreal, interrupt_id Handle
     assert(us >= 0);
     
     if(ConfigureParams.System.bRealtime) {
-        /* Update list cycle counts with current PendingInterruptCount before adding a new int, */
-        /* because CycInt_SetNewInterrupt can change the active int / PendingInterruptCount */
-        if ( ActiveInterrupt > 0 ) CycInt_UpdateInterrupt();
-        
         if ( usreal > 0 ) us = usreal;
         
-        InterruptHandlers[Handler].type = CYC_INT_US;
-        InterruptHandlers[Handler].time = host_time_us() + us;
+        CycInt_Enqueue(Handler, CYC_INT_US, host_time_us() + us);
         
         /* Set new active int and compute a new value for PendingInterruptCount*/
         CycInt_SetNewInterrupt();
@@ -238,12 +344,8 @@ void CycInt_AddRelativeInterruptUsCycles(Sint64 us, Sint64 usreal, interrupt_id
  * Remove a pending interrupt from our table
  */
 void CycInt_RemovePendingInterrupt(interrupt_id Handler) {
-	/* Update list cycle counts, including the handler we want to remove */
-	/* to be able to resume it later */
-	CycInt_UpdateInterrupt();
-
-	/* Stop interrupt after CycInt_UpdateInterrupt */
-	InterruptHandlers[Handler].type = CYC_INT_NONE;
+	/* Stop interrupt */
+	CycInt_Dequeue(Handler);
 
 	/* Set new */
 	CycInt_SetNewInterrupt();
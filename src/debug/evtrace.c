@@ -0,0 +1,176 @@
+/*
+  Previous - evtrace.c
+
+  This file is distributed under the GNU Public License, version 2 or at
+  your option any later version. Read the file gpl.txt for details.
+
+  Binary event trace rings. Each thread gets its own ring on its first
+  event, so recording needs neither locks nor atomics. The rings are
+  linked into a list with a compare-and-swap and written to the trace
+  file on exit.
+*/
+const char EvTrace_fileid[] = "Previous evtrace.c : " __DATE__ " " __TIME__;
+
+#include "main.h"
+#include "file.h"
+#include "evtrace.h"
+
+Uint32 EvTrace_Mask = 0;
+EVTRACE_TLS evtrace_ring_t* EvTrace_Ring = NULL;
+
+static evtrace_ring_t* evtraceRings = NULL;
+static const char*     evtraceFile  = NULL;
+
+static const char* evtraceSubsystems[] = {
+#define EVTRACE_SUB(sub, name) name,
+    EVTRACE_SUBSYSTEMS
+#undef EVTRACE_SUB
+};
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Parse a comma separated list of subsystem names. Returns false for
+ * unknown names.
+ */
+static bool evtrace_parse_mask(const char *pszMask, Uint32 *mask) {
+    char name[16];
+    int  i, len;
+
+    *mask = 0;
+    while (*pszMask) {
+        len = strcspn(pszMask, ",");
+        if (len >= (int)sizeof(name)) {
+            len = sizeof(name) - 1;
+        }
+        strncpy(name, pszMask, len);
+        name[len] = '\0';
+        pszMask += strcspn(pszMask, ",");
+        if (*pszMask) {
+            pszMask++;
+        }
+
+        if (!strcmp(name, "all")) {
+            *mask |= EVTRACE_ALL;
+            continue;
+        }
+        for (i = 0; i < EVTRACE_NUM_SUBSYSTEMS; i++) {
+            if (!strcmp(name, evtraceSubsystems[i])) {
+                *mask |= 1 << i;
+                break;
+            }
+        }
+        if (i == EVTRACE_NUM_SUBSYSTEMS) {
+            fprintf(stderr, "Unknown event trace subsystem '%s'\n", name);
+            return false;
+        }
+    }
+    return true;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Enable event tracing to pszFileName for the subsystems in pszMask
+ * (all if NULL). Returns false if the mask is invalid.
+ */
+bool EvTrace_Init(const char *pszFileName, const char *pszMask) {
+    Uint32 mask = EVTRACE_ALL;
+
+    if (pszMask && !evtrace_parse_mask(pszMask, &mask)) {
+        return false;
+    }
+    if (!pszFileName) {
+        return true;
+    }
+    if ((mask & EVTRACE_COMPILE_MASK) != mask) {
+        fprintf(stderr, "Warning: event tracing for some subsystems is not compiled in "
+                "(EVTRACE_COMPILE_MASK=%X)\n", EVTRACE_COMPILE_MASK);
+    }
+    evtraceFile  = pszFileName;
+    EvTrace_Mask = mask;
+    return true;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Allocate the ring for the calling thread and link it into the list
+ * of rings.
+ */
+evtrace_ring_t* EvTrace_NewRing(void) {
+    evtrace_ring_t* ring = calloc(1, sizeof(evtrace_ring_t));
+
+    if (!ring) {
+        fprintf(stderr, "Cannot allocate event trace ring\n");
+        exit(-1);
+    }
+    snprintf(ring->name, sizeof(ring->name), "thread %lu", (unsigned long)SDL_ThreadID());
+
+    do {
+        ring->next = evtraceRings;
+    } while (!SDL_AtomicCASPtr((void**)&evtraceRings, ring->next, ring));
+
+    EvTrace_Ring = ring;
+    return ring;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Write all rings to the trace file, oldest record first, and stop
+ * tracing. Threads still running may add a few records while the file
+ * is written; those are lost or overwrite the oldest records.
+ */
+void EvTrace_UnInit(void) {
+    evtrace_header_t      header;
+    evtrace_ring_header_t ringHeader;
+    evtrace_ring_t*       ring;
+    evtrace_ring_t*       next;
+    FILE*                 fp;
+    Uint64                pos;
+    Uint32                first;
+
+    if (!evtraceFile) {
+        return;
+    }
+    EvTrace_Mask = 0;
+
+    fp = File_Open(evtraceFile, "wb");
+    if (!fp) {
+        fprintf(stderr, "Cannot write event trace '%s'\n", evtraceFile);
+    } else {
+        memcpy(header.magic, EVTRACE_MAGIC, sizeof(header.magic));
+        header.version = EVTRACE_VERSION;
+        header.rings   = 0;
+        for (ring = evtraceRings; ring; ring = ring->next) {
+            header.rings++;
+        }
+        fwrite(&header, sizeof(header), 1, fp);
+
+        for (ring = evtraceRings; ring; ring = ring->next) {
+            pos = ring->pos;
+            memcpy(ringHeader.name, ring->name, sizeof(ringHeader.name));
+            ringHeader.records = pos < EVTRACE_RING_SIZE ? pos : EVTRACE_RING_SIZE;
+            fwrite(&ringHeader, sizeof(ringHeader), 1, fp);
+
+            first = (pos - ringHeader.records) & (EVTRACE_RING_SIZE-1);
+            if (first) {
+                fwrite(&ring->rec[first], sizeof(evtrace_record_t), EVTRACE_RING_SIZE - first, fp);
+                fwrite(&ring->rec[0], sizeof(evtrace_record_t), first, fp);
+            } else {
+                fwrite(&ring->rec[0], sizeof(evtrace_record_t), ringHeader.records, fp);
+            }
+        }
+        File_Close(fp);
+        fprintf(stderr, "Event trace written to '%s'\n", evtraceFile);
+    }
+
+    /* Rings of threads that are still running are not freed */
+    for (ring = evtraceRings; ring; ring = next) {
+        next = ring->next;
+        if (ring == EvTrace_Ring) {
+            EvTrace_Ring = NULL;
+            free(ring);
+        }
+    }
+    evtraceRings = NULL;
+    evtraceFile  = NULL;
+}
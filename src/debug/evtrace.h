@@ -0,0 +1,94 @@
+/*
+  Previous - evtrace.h
+
+  This file is distributed under the GNU Public License, version 2 or at
+  your option any later version. Read the file gpl.txt for details.
+
+  Binary event tracing for hot paths. Events are fixed size records
+  written to a ring per thread, without locks or formatting. The rings
+  are saved on exit and decoded offline with tracedump.
+
+  Tracing code is only compiled in for the subsystems in
+  EVTRACE_COMPILE_MASK, e.g. (1<<EVTRACE_BUS)|(1<<EVTRACE_DMA) or
+  EVTRACE_ALL. It is set with the CMake cache variable of the same
+  name. The subsystems recorded at runtime are selected with
+  --evtrace-mask.
+*/
+
+#pragma once
+
+#ifndef __EVTRACE_H__
+#define __EVTRACE_H__
+
+#include "main.h"
+#include "log.h"
+#include "cycInt.h"
+#include "evtrace_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#ifndef EVTRACE_COMPILE_MASK
+#define EVTRACE_COMPILE_MASK 0
+#endif
+
+#define EVTRACE_RING_SIZE (1<<16) /* records per thread */
+
+#if defined(_MSC_VER)
+#define EVTRACE_TLS __declspec(thread)
+#else
+#define EVTRACE_TLS __thread
+#endif
+
+typedef struct evtrace_ring {
+    Uint64               pos;
+    struct evtrace_ring* next;
+    char                 name[24];
+    evtrace_record_t     rec[EVTRACE_RING_SIZE];
+} evtrace_ring_t;
+
+extern Uint32 EvTrace_Mask;
+extern EVTRACE_TLS evtrace_ring_t* EvTrace_Ring;
+
+bool            EvTrace_Init(const char *pszFileName, const char *pszMask);
+void            EvTrace_UnInit(void);
+evtrace_ring_t* EvTrace_NewRing(void);
+
+static inline void EvTrace_Write(Uint32 event, Uint32 a0, Uint32 a1, Uint32 a2, Uint32 a3) {
+    evtrace_ring_t*   ring = EvTrace_Ring;
+    evtrace_record_t* r;
+
+    if (unlikely(!ring)) {
+        ring = EvTrace_NewRing();
+    }
+    r = &ring->rec[ring->pos & (EVTRACE_RING_SIZE-1)];
+    r->cycles = nCyclesMainCounter;
+    r->event  = event;
+    r->arg[0] = a0;
+    r->arg[1] = a1;
+    r->arg[2] = a2;
+    r->arg[3] = a3;
+    ring->pos++;
+}
+
+#define EVTRACE(event, a0, a1, a2, a3) do { \
+    if ((EVTRACE_COMPILE_MASK & (1 << EVTRACE_SUB_OF(event))) && \
+        unlikely(EvTrace_Mask & (1 << EVTRACE_SUB_OF(event)))) \
+        EvTrace_Write(event, a0, a1, a2, a3); \
+} while (0)
+
+/* Event with a log message for builds without tracing. If the subsystem
+ * is in EVTRACE_COMPILE_MASK the message is not compiled in. */
+#define EVTRACE_LOG(event, a0, a1, a2, a3, level, ...) do { \
+    if (EVTRACE_COMPILE_MASK & (1 << EVTRACE_SUB_OF(event))) \
+        EVTRACE(event, a0, a1, a2, a3); \
+    else \
+        Log_Printf(level, __VA_ARGS__); \
+} while (0)
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __EVTRACE_H__ */
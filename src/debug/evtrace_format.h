@@ -0,0 +1,88 @@
+/*
+  Previous - evtrace_format.h
+
+  This file is distributed under the GNU Public License, version 2 or at
+  your option any later version. Read the file gpl.txt for details.
+
+  Binary event trace file format and list of events. Shared by the
+  emulator (evtrace.c) and the offline decoder (tracedump).
+*/
+
+#pragma once
+
+#ifndef __EVTRACE_FORMAT_H__
+#define __EVTRACE_FORMAT_H__
+
+#include <stdint.h>
+
+#define EVTRACE_MAGIC   "PRVTRACE"
+#define EVTRACE_VERSION 2
+#define EVTRACE_ARGS    4
+
+/* Subsystems: name, option name */
+#define EVTRACE_SUBSYSTEMS \
+    EVTRACE_SUB(BUS,  "bus")  \
+    EVTRACE_SUB(DMA,  "dma")  \
+    EVTRACE_SUB(ESP,  "esp")  \
+    EVTRACE_SUB(SCSI, "scsi") \
+    EVTRACE_SUB(I860, "i860")
+
+enum {
+#define EVTRACE_SUB(sub, name) EVTRACE_##sub,
+    EVTRACE_SUBSYSTEMS
+#undef EVTRACE_SUB
+    EVTRACE_NUM_SUBSYSTEMS
+};
+
+#define EVTRACE_ALL            ((1 << EVTRACE_NUM_SUBSYSTEMS) - 1)
+
+/* Event ids carry their subsystem in the upper bits */
+#define EVTRACE_ID(sub, num)   (((sub) << 8) | (num))
+#define EVTRACE_SUB_OF(id)     ((id) >> 8)
+
+/* Events: name, subsystem, number, decoder format of the arguments */
+#define EVTRACE_EVENTS \
+    EVTRACE_EVENT(EV_BUS_SLOT_RD,  BUS,  0, "slot %u read%u at %08X val %08X") \
+    EVTRACE_EVENT(EV_BUS_SLOT_WR,  BUS,  1, "slot %u write%u at %08X val %08X") \
+    EVTRACE_EVENT(EV_BUS_BOARD_RD, BUS,  2, "board %u read%u at %08X val %08X") \
+    EVTRACE_EVENT(EV_BUS_BOARD_WR, BUS,  3, "board %u write%u at %08X val %08X") \
+    EVTRACE_EVENT(EV_DMA_CSR_RD,   DMA,  0, "channel %u CSR read %02X") \
+    EVTRACE_EVENT(EV_DMA_CSR_WR,   DMA,  1, "channel %u CSR write %02X") \
+    EVTRACE_EVENT(EV_DMA_INTR,     DMA,  2, "channel %u interrupt CSR %02X next %08X limit %08X") \
+    EVTRACE_EVENT(EV_ESP_FIFO_RD,  ESP,  0, "FIFO read %02X, %u left") \
+    EVTRACE_EVENT(EV_ESP_FIFO_WR,  ESP,  1, "FIFO write %02X, %u used") \
+    EVTRACE_EVENT(EV_ESP_CMD,      ESP,  2, "command %02X") \
+    EVTRACE_EVENT(EV_ESP_IRQ,      ESP,  3, "raise IRQ status %02X intstatus %02X") \
+    EVTRACE_EVENT(EV_SCSI_CMD,     SCSI, 0, "target %u command %02X") \
+    EVTRACE_EVENT(EV_SCSI_SEND,    SCSI, 1, "send %02X, %u left") \
+    EVTRACE_EVENT(EV_SCSI_RECV,    SCSI, 2, "receive %02X, %u of %u") \
+    EVTRACE_EVENT(EV_SCSI_BURST,   SCSI, 3, "send burst of %u, %u left") \
+    EVTRACE_EVENT(EV_I860_RD,      I860, 0, "read%u at %08X val %08X pc %08X") \
+    EVTRACE_EVENT(EV_I860_WR,      I860, 1, "write%u at %08X val %08X pc %08X")
+
+enum {
+#define EVTRACE_EVENT(ev, sub, num, fmt) ev = EVTRACE_ID(EVTRACE_##sub, num),
+    EVTRACE_EVENTS
+#undef EVTRACE_EVENT
+};
+
+/* File layout: header, then per ring a ring header followed by its
+ * records, oldest first. All values are in host byte order. */
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t rings;
+} evtrace_header_t;
+
+typedef struct {
+    char     name[24];
+    uint64_t records;
+} evtrace_ring_header_t;
+
+typedef struct {
+    uint64_t cycles;    /* nCyclesMainCounter when the event was recorded */
+    uint32_t event;
+    uint32_t arg[EVTRACE_ARGS];
+} evtrace_record_t;
+
+#endif /* __EVTRACE_FORMAT_H__ */
@@ -6,6 +6,7 @@
 #include "nd_nbic.hpp"
 #include "nd_mem.hpp"
 #include "nd_sdl.hpp"
+#include "memorySnapShot.h"
 
 #define nd_get_mem_bank(addr)    (nd->mem_banks[nd_bankindex((addr)|ND_BOARD_BITS)])
 #define nd68k_get_mem_bank(addr) (mem_banks[nd_bankindex(addr)])
@@ -31,9 +32,10 @@ NextDimension::NextDimension(int slot) :
     mem_banks(new ND_Addrbank*[65536]),
     ram(host_malloc_aligned(64*1024*1024)),
     vram(host_malloc_aligned(4*1024*1024)),
+    vram_dirty((Uint8*)calloc(ND_VRAM_DIRTY_SIZE, 1)),
     rom(host_malloc_aligned(128*1024)),
     rom_last_addr(0),
-    sdl(slot, (Uint32*)vram),
+    sdl(slot, (Uint32*)vram, vram_dirty),
     i860(this),
     nbic(slot, ND_NBIC_ID),
     mc(this),
@@ -57,13 +59,14 @@ NextDimension::~NextDimension() {
     i860.uninit();
     sdl.destroy();
     
-    for(size_t i = toDelete.size(); --i >= 0;)
+    for(size_t i = toDelete.size(); i-- > 0;)
         delete toDelete[i];
     toDelete.clear();
     
     delete[] mem_banks;
     free(ram);
     free(vram);
+    free((void*)vram_dirty);
     free(rom);
 
 }
@@ -78,6 +81,55 @@ void NextDimension::pause(bool pause) {
     sdl.pause(pause);
 }
 
+#define STORE(var) MemorySnapShot_Store(&(var), sizeof(var))
+
+void NextDimension::snapshot(bool save) {
+    /* No i860 access to board memory and no message handling from here */
+    i860.stop_thread();
+    
+    MemorySnapShot_Store(ram,  64*1024*1024);
+    MemorySnapShot_Store(vram, 4*1024*1024);
+    if (!save) {
+        memset((void*)vram_dirty, 1, ND_VRAM_DIRTY_SIZE);
+    }
+    MemorySnapShot_Store(rom,  128*1024);
+    
+    STORE(dmem);
+    STORE(rom_command);
+    STORE(rom_last_addr);
+    STORE(bankmask);
+    
+    STORE(mc.csr0);       STORE(mc.csr1);       STORE(mc.csr2);
+    STORE(mc.sid);        STORE(mc.dma_csr);    STORE(mc.dma_start);
+    STORE(mc.dma_width);  STORE(mc.dma_pstart); STORE(mc.dma_pwidth);
+    STORE(mc.dma_sstart); STORE(mc.dma_swidth); STORE(mc.dma_bsstart);
+    STORE(mc.dma_bswidth);STORE(mc.dma_top);    STORE(mc.dma_bottom);
+    STORE(mc.dma_line_a); STORE(mc.dma_curr_a); STORE(mc.dma_scurr_a);
+    STORE(mc.dma_out_a);  STORE(mc.vram);       STORE(mc.dram);
+    
+    STORE(dp.iic_addr);   STORE(dp.iic_msg);    STORE(dp.iic_msgsz);
+    STORE(dp.iic_busy);   STORE(dp.doff);       STORE(dp.csr);
+    STORE(dp.alpha);      STORE(dp.dma);        STORE(dp.cpu_x);
+    STORE(dp.cpu_y);      STORE(dp.dma_x);      STORE(dp.dma_y);
+    STORE(dp.iic_stat_addr); STORE(dp.iic_data);
+    
+    STORE(dmcd.addr);  STORE(dmcd.reg);
+    STORE(dcsc0.addr); STORE(dcsc0.ctrl); STORE(dcsc0.lut);
+    STORE(dcsc1.addr); STORE(dcsc1.ctrl); STORE(dcsc1.lut);
+    STORE(ramdac);
+    
+    nbic.snapshot(save);
+    i860.snapshot(save);
+    
+    /* Drop the reset message sent to the freshly created board */
+    if(!save)
+        host_atomic_set(&m_port, 0);
+    
+    i860.start_thread();
+}
+
+#undef STORE
+
 /* NeXTdimension board memory access (m68k) */
 
  Uint32 NextDimension::board_lget(Uint32 addr) {
@@ -182,116 +234,278 @@ void NextDimension::send_msg(int msg) {
             default: break;
         }
     } while (!host_atomic_cas(&m_port, old_value, new_value));
+    i860.wake();
 }
 
 /* NeXTdimension board memory access (i860) */
 
+/* RAM and VRAM pages are accessed through host pointers, everything else
+ * goes through the memory banks. 8 and 16 bit VRAM accesses also use the
+ * banks because of the ARGB byte order. Accesses wider than 8 bit are
+ * aligned (the i860 traps otherwise) and do not cross page boundaries. */
+#define nd_ram_page(addr)  nd_get_page(nd->ram_pages,  addr)
+#define nd_vram_page(addr) nd_get_page(nd->vram_pages, addr)
+
+static inline Uint32 nd_vram_get(const Uint8* p) {
+    return ((Uint32)p[2] << 24) | (p[1] << 16) | (p[0] << 8) | p[3];
+}
+
+static inline void nd_vram_put(Uint8* p, Uint32 l) {
+    p[2] = l >> 24; p[1] = l >> 16; p[0] = l >> 8; p[3] = l;
+}
+
+static inline void nd_vram_dirty(const NextDimension* nd, const Uint8* p, int size) {
+    Uint32 off = (Uint32)(p - nd->vram);
+    nd->vram_dirty[off >> ND_VRAM_DIRTY_SHIFT] = 1;
+    nd->vram_dirty[(off + size - 1) >> ND_VRAM_DIRTY_SHIFT] = 1;
+}
+
 Uint8  NextDimension::i860_cs8get(const NextDimension* nd, Uint32 addr) {
     return nd_cs8get(addr);
 }
 
 void   NextDimension::i860_rd8_be(const NextDimension* nd, Uint32 addr, Uint32* val) {
-    *((Uint8*)val) = nd_byteget(addr);
+    Uint8* p = nd_ram_page(addr);
+    if (p)
+        *((Uint8*)val) = p[addr & ND_PAGE_MASK];
+    else
+        *((Uint8*)val) = nd_byteget(addr);
 }
 
 void   NextDimension::i860_rd16_be(const NextDimension* nd, Uint32 addr, Uint32* val) {
-    *((Uint16*)val) = nd_wordget(addr);
+    Uint8* p = nd_ram_page(addr);
+    if (p)
+        *((Uint16*)val) = do_get_mem_word(p + (addr & ND_PAGE_MASK));
+    else
+        *((Uint16*)val) = nd_wordget(addr);
 }
 
 void   NextDimension::i860_rd32_be(const NextDimension* nd, Uint32 addr, Uint32* val) {
-    val[0] = nd_longget(addr);
+    Uint8* p;
+    if ((p = nd_ram_page(addr))) {
+        val[0] = do_get_mem_long(p + (addr & ND_PAGE_MASK));
+    } else if ((p = nd_vram_page(addr))) {
+        val[0] = nd_vram_get(p + (addr & ND_PAGE_MASK));
+    } else {
+        val[0] = nd_longget(addr);
+    }
 }
 
 void   NextDimension::i860_rd64_be(const NextDimension* nd, Uint32 addr, Uint32* val) {
-    const ND_Addrbank* ab = nd_get_mem_bank(addr);
-    val[0] = ab->lget(addr+4);
-    val[1] = ab->lget(addr+0);
+    Uint8* p;
+    if ((p = nd_ram_page(addr))) {
+        p += addr & ND_PAGE_MASK;
+        val[0] = do_get_mem_long(p+4);
+        val[1] = do_get_mem_long(p+0);
+    } else if ((p = nd_vram_page(addr))) {
+        p += addr & ND_PAGE_MASK;
+        val[0] = nd_vram_get(p+4);
+        val[1] = nd_vram_get(p+0);
+    } else {
+        const ND_Addrbank* ab = nd_get_mem_bank(addr);
+        val[0] = ab->lget(addr+4);
+        val[1] = ab->lget(addr+0);
+    }
 }
 
 void   NextDimension::i860_rd128_be(const NextDimension* nd, Uint32 addr, Uint32* val) {
-    const ND_Addrbank* ab = nd_get_mem_bank(addr);
-    val[0]  = ab->lget(addr+4);
-    val[1]  = ab->lget(addr+0);
-    val[2]  = ab->lget(addr+12);
-    val[3]  = ab->lget(addr+8);
+    Uint8* p;
+    if ((p = nd_ram_page(addr))) {
+        p += addr & ND_PAGE_MASK;
+        val[0]  = do_get_mem_long(p+4);
+        val[1]  = do_get_mem_long(p+0);
+        val[2]  = do_get_mem_long(p+12);
+        val[3]  = do_get_mem_long(p+8);
+    } else if ((p = nd_vram_page(addr))) {
+        p += addr & ND_PAGE_MASK;
+        val[0]  = nd_vram_get(p+4);
+        val[1]  = nd_vram_get(p+0);
+        val[2]  = nd_vram_get(p+12);
+        val[3]  = nd_vram_get(p+8);
+    } else {
+        const ND_Addrbank* ab = nd_get_mem_bank(addr);
+        val[0]  = ab->lget(addr+4);
+        val[1]  = ab->lget(addr+0);
+        val[2]  = ab->lget(addr+12);
+        val[3]  = ab->lget(addr+8);
+    }
 }
 
 void   NextDimension::i860_wr8_be(const NextDimension* nd, Uint32 addr, const Uint32* val) {
-    nd_byteput(addr, *((const Uint8*)val));
+    Uint8* p = nd_ram_page(addr);
+    if (p)
+        p[addr & ND_PAGE_MASK] = *((const Uint8*)val);
+    else
+        nd_byteput(addr, *((const Uint8*)val));
 }
 
 void   NextDimension::i860_wr16_be(const NextDimension* nd, Uint32 addr, const Uint32* val) {
-    nd_wordput(addr, *((const Uint16*)val));
+    Uint8* p = nd_ram_page(addr);
+    if (p)
+        do_put_mem_word(p + (addr & ND_PAGE_MASK), *((const Uint16*)val));
+    else
+        nd_wordput(addr, *((const Uint16*)val));
 }
 
 void   NextDimension::i860_wr32_be(const NextDimension* nd, Uint32 addr, const Uint32* val) {
-    nd_longput(addr, val[0]);
+    Uint8* p;
+    if ((p = nd_ram_page(addr))) {
+        do_put_mem_long(p + (addr & ND_PAGE_MASK), val[0]);
+    } else if ((p = nd_vram_page(addr))) {
+        p += addr & ND_PAGE_MASK;
+        nd_vram_put(p, val[0]);
+        nd_vram_dirty(nd, p, 4);
+    } else {
+        nd_longput(addr, val[0]);
+    }
 }
 
 void   NextDimension::i860_wr64_be(const NextDimension* nd, Uint32 addr, const Uint32* val) {
-    const ND_Addrbank* ab = nd_get_mem_bank(addr);
-    ab->lput(addr+4, val[0]);
-    ab->lput(addr+0, val[1]);
+    Uint8* p;
+    if ((p = nd_ram_page(addr))) {
+        p += addr & ND_PAGE_MASK;
+        do_put_mem_long(p+4, val[0]);
+        do_put_mem_long(p+0, val[1]);
+    } else if ((p = nd_vram_page(addr))) {
+        p += addr & ND_PAGE_MASK;
+        nd_vram_put(p+4, val[0]);
+        nd_vram_put(p+0, val[1]);
+        nd_vram_dirty(nd, p, 8);
+    } else {
+        const ND_Addrbank* ab = nd_get_mem_bank(addr);
+        ab->lput(addr+4, val[0]);
+        ab->lput(addr+0, val[1]);
+    }
 }
 
 void   NextDimension::i860_wr128_be(const NextDimension* nd, Uint32 addr, const Uint32* val) {
-    const ND_Addrbank* ab = nd_get_mem_bank(addr);
-    ab->lput(addr+4,  val[0]);
-    ab->lput(addr+0,  val[1]);
-    ab->lput(addr+12, val[2]);
-    ab->lput(addr+8,  val[3]);
+    Uint8* p;
+    if ((p = nd_ram_page(addr))) {
+        p += addr & ND_PAGE_MASK;
+        do_put_mem_long(p+4,  val[0]);
+        do_put_mem_long(p+0,  val[1]);
+        do_put_mem_long(p+12, val[2]);
+        do_put_mem_long(p+8,  val[3]);
+    } else if ((p = nd_vram_page(addr))) {
+        p += addr & ND_PAGE_MASK;
+        nd_vram_put(p+4,  val[0]);
+        nd_vram_put(p+0,  val[1]);
+        nd_vram_put(p+12, val[2]);
+        nd_vram_put(p+8,  val[3]);
+        nd_vram_dirty(nd, p, 16);
+    } else {
+        const ND_Addrbank* ab = nd_get_mem_bank(addr);
+        ab->lput(addr+4,  val[0]);
+        ab->lput(addr+0,  val[1]);
+        ab->lput(addr+12, val[2]);
+        ab->lput(addr+8,  val[3]);
+    }
 }
 
 void   NextDimension::i860_rd8_le(const NextDimension* nd, Uint32 addr, Uint32* val) {
-    *((Uint8*)val) = nd_byteget(addr^7);
+    i860_rd8_be(nd, addr^7, val);
 }
 
 void   NextDimension::i860_rd16_le(const NextDimension* nd, Uint32 addr, Uint32* val) {
-    *((Uint16*)val) = nd_wordget(addr^6);
+    i860_rd16_be(nd, addr^6, val);
 }
 
 void   NextDimension::i860_rd32_le(const NextDimension* nd, Uint32 addr, Uint32* val) {
-    val[0] = nd_longget(addr^4);
+    i860_rd32_be(nd, addr^4, val);
 }
 
 void   NextDimension::i860_rd64_le(const NextDimension* nd, Uint32 addr, Uint32* val) {
-    const ND_Addrbank* ab = nd_get_mem_bank(addr);
-    val[0] = ab->lget(addr+0);
-    val[1] = ab->lget(addr+4);
+    Uint8* p;
+    if ((p = nd_ram_page(addr))) {
+        p += addr & ND_PAGE_MASK;
+        val[0] = do_get_mem_long(p+0);
+        val[1] = do_get_mem_long(p+4);
+    } else if ((p = nd_vram_page(addr))) {
+        p += addr & ND_PAGE_MASK;
+        val[0] = nd_vram_get(p+0);
+        val[1] = nd_vram_get(p+4);
+    } else {
+        const ND_Addrbank* ab = nd_get_mem_bank(addr);
+        val[0] = ab->lget(addr+0);
+        val[1] = ab->lget(addr+4);
+    }
 }
 
 void   NextDimension::i860_rd128_le(const NextDimension* nd, Uint32 addr, Uint32* val) {
-    const ND_Addrbank* ab = nd_get_mem_bank(addr);
-    val[0]  = ab->lget(addr+0);
-    val[1]  = ab->lget(addr+4);
-    val[2]  = ab->lget(addr+8);
-    val[3]  = ab->lget(addr+12);
+    Uint8* p;
+    if ((p = nd_ram_page(addr))) {
+        p += addr & ND_PAGE_MASK;
+        val[0]  = do_get_mem_long(p+0);
+        val[1]  = do_get_mem_long(p+4);
+        val[2]  = do_get_mem_long(p+8);
+        val[3]  = do_get_mem_long(p+12);
+    } else if ((p = nd_vram_page(addr))) {
+        p += addr & ND_PAGE_MASK;
+        val[0]  = nd_vram_get(p+0);
+        val[1]  = nd_vram_get(p+4);
+        val[2]  = nd_vram_get(p+8);
+        val[3]  = nd_vram_get(p+12);
+    } else {
+        const ND_Addrbank* ab = nd_get_mem_bank(addr);
+        val[0]  = ab->lget(addr+0);
+        val[1]  = ab->lget(addr+4);
+        val[2]  = ab->lget(addr+8);
+        val[3]  = ab->lget(addr+12);
+    }
 }
 
 void   NextDimension::i860_wr8_le(const NextDimension* nd, Uint32 addr, const Uint32* val) {
-    nd_byteput(addr^7, *((const Uint8*)val));
+    i860_wr8_be(nd, addr^7, val);
 }
 
 void   NextDimension::i860_wr16_le(const NextDimension* nd, Uint32 addr, const Uint32* val) {
-    nd_wordput(addr^6, *((const Uint16*)val));
+    i860_wr16_be(nd, addr^6, val);
 }
 
 void   NextDimension::i860_wr32_le(const NextDimension* nd, Uint32 addr, const Uint32* val) {
-    nd_longput(addr^4, val[0]);
+    i860_wr32_be(nd, addr^4, val);
 }
 
 void   NextDimension::i860_wr64_le(const NextDimension* nd, Uint32 addr, const Uint32* val) {
-    const ND_Addrbank* ab = nd_get_mem_bank(addr);
-    ab->lput(addr+0, val[0]);
-    ab->lput(addr+4, val[1]);
+    Uint8* p;
+    if ((p = nd_ram_page(addr))) {
+        p += addr & ND_PAGE_MASK;
+        do_put_mem_long(p+0, val[0]);
+        do_put_mem_long(p+4, val[1]);
+    } else if ((p = nd_vram_page(addr))) {
+        p += addr & ND_PAGE_MASK;
+        nd_vram_put(p+0, val[0]);
+        nd_vram_put(p+4, val[1]);
+        nd_vram_dirty(nd, p, 8);
+    } else {
+        const ND_Addrbank* ab = nd_get_mem_bank(addr);
+        ab->lput(addr+0, val[0]);
+        ab->lput(addr+4, val[1]);
+    }
 }
 
 void   NextDimension::i860_wr128_le(const NextDimension* nd, Uint32 addr, const Uint32* val) {
-    const ND_Addrbank* ab = nd_get_mem_bank(addr);
-    ab->lput(addr+0,  val[0]);
-    ab->lput(addr+4,  val[1]);
-    ab->lput(addr+8,  val[2]);
-    ab->lput(addr+12, val[3]);
+    Uint8* p;
+    if ((p = nd_ram_page(addr))) {
+        p += addr & ND_PAGE_MASK;
+        do_put_mem_long(p+0,  val[0]);
+        do_put_mem_long(p+4,  val[1]);
+        do_put_mem_long(p+8,  val[2]);
+        do_put_mem_long(p+12, val[3]);
+    } else if ((p = nd_vram_page(addr))) {
+        p += addr & ND_PAGE_MASK;
+        nd_vram_put(p+0,  val[0]);
+        nd_vram_put(p+4,  val[1]);
+        nd_vram_put(p+8,  val[2]);
+        nd_vram_put(p+12, val[3]);
+        nd_vram_dirty(nd, p, 16);
+    } else {
+        const ND_Addrbank* ab = nd_get_mem_bank(addr);
+        ab->lput(addr+0,  val[0]);
+        ab->lput(addr+4,  val[1]);
+        ab->lput(addr+8,  val[2]);
+        ab->lput(addr+12, val[3]);
+    }
 }
 
 /* Message disaptcher - executed on i860 thread, safe to call i860 methods */
@@ -324,12 +538,21 @@ extern "C" {
     }
 
     const char* nd_reports(Uint64 realTime, Uint64 hostTime) {
+        static char report[ND_MAX_BOARDS*1100];
+        size_t      len = 0;
+        
+        report[0] = 0;
         FOR_EACH_SLOT(slot) {
             IF_NEXT_DIMENSION(slot, nd) {
-                return nd->i860.reports(realTime, hostTime);
+                const char* msg = nd->i860.reports(realTime, hostTime);
+                if(msg[0] && len < sizeof(report)) {
+                    int n = snprintf(report + len, sizeof(report) - len, "%sslot%d:%s", len ? " " : "", slot, msg);
+                    if(n > 0)
+                        len += n;
+                }
             }
         }
-        return "";
+        return report;
     }
     
     Uint32* nd_vram_for_slot(int slot) {
@@ -338,6 +561,13 @@ extern "C" {
         else
             return NULL;
     }
+    
+    volatile Uint8* nd_vram_dirty_for_slot(int slot) {
+        IF_NEXT_DIMENSION(slot, nd)
+            return nd->vram_dirty;
+        else
+            return NULL;
+    }
 }
 
 
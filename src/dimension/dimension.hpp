@@ -12,6 +12,10 @@
 #define ND_SLOT(num) ((num)*2+2)
 #define ND_NUM(slot) ((slot)/2-1)
 
+/* VRAM dirty map granularity, one byte per 256 bytes */
+#define ND_VRAM_DIRTY_SHIFT 8
+#define ND_VRAM_DIRTY_SIZE  (((4*1024*1024)>>ND_VRAM_DIRTY_SHIFT)+1)
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -21,6 +25,7 @@ extern "C" {
     void nd_start_debugger(void);
     const char* nd_reports(Uint64 realTime, Uint64 hostTime);
     Uint32* nd_vram_for_slot(int slot);
+    volatile Uint8* nd_vram_dirty_for_slot(int slot);
     
 #define ND_LOG_IO_RD LOG_NONE
 #define ND_LOG_IO_WR LOG_NONE
@@ -132,11 +137,16 @@ public:
     
     Uint8*                    ram;
     Uint8*                    vram;
+    volatile Uint8*           vram_dirty;
     Uint8*                    rom;
     
     Uint32                    rom_last_addr;;
     Uint32                    bankmask[4];
     
+    /* Host pointers of RAM and VRAM pages, NULL for all other banks */
+    Uint8*                    ram_pages[ND_PAGES];
+    Uint8*                    vram_pages[ND_PAGES];
+    
     NDSDL                     sdl;
     i860_cpu_device           i860;
     NBIC                      nbic;
@@ -154,6 +164,7 @@ public:
     void mem_init(void);
     void init_mem_banks(void);
     void map_banks (ND_Addrbank *bank, int start, int size);
+    void map_pages (Uint8** pages, Uint8* base, Uint32 mask, int start, int size);
 
     virtual Uint32 board_lget(Uint32 addr);
     virtual Uint16 board_wget(Uint32 addr);
@@ -171,6 +182,7 @@ public:
 
     virtual void   reset(void);
     virtual void   pause(bool pause);
+    virtual void   snapshot(bool save);
 
     static Uint8  i860_cs8get  (const NextDimension* nd, Uint32 addr);
     static void   i860_rd8_be  (const NextDimension* nd, Uint32 addr, Uint32* val);
@@ -24,13 +24,25 @@
 #include "i860.hpp"
 #include "dimension.hpp"
 #include "log.h"
+#include "memorySnapShot.h"
+#include "evtrace.h"
 
 extern "C" {
     static void i860_run_nop(int nHostCycles) {}
 
     i860_run_func i860_Run = i860_run_nop;
 
+    /* i860 of each board by board number, avoids slot lookups on the m68k thread */
+    static i860_cpu_device* i860_boards[ND_MAX_BOARDS];
+
     static void i860_run_thread(int nHostCycles) {
+        int cycles = nHostCycles * 33; // i860 @ 33MHz
+        cycles /= ConfigureParams.System.nCpuFreq;
+        
+        for(int i = 0; i < ND_MAX_BOARDS; i++) {
+            if(i860_boards[i])
+                i860_boards[i]->post_credits(cycles);
+        }
         nd_nbic_interrupt();
     }
 
@@ -41,14 +53,12 @@ extern "C" {
             IF_NEXT_DIMENSION(slot, nd) {
                 nd->handle_msgs();
                 
-                if(nd->i860.is_halted()) return;
+                if(nd->i860.is_halted()) continue;
                 
                 cycles = nHostCycles * 33; // i860 @ 33MHz
                 cycles /= ConfigureParams.System.nCpuFreq;
-                while (cycles > 0) {
-                    nd->i860.run_cycle();
-                    cycles --;
-                }
+                while (cycles > 0)
+                    cycles -= nd->i860.run_cycle();
             }
         }
         nd_nbic_interrupt();
@@ -58,6 +68,15 @@ extern "C" {
 i860_cpu_device::i860_cpu_device(NextDimension* nd) : nd(nd) {
     m_thread = NULL;
     m_halt   = true;
+    m_paused = false;
+    
+    host_atomic_set(&m_credits, 0);
+    host_atomic_set(&m_wakeup,  0);
+    host_atomic_set(&m_waiting, 0);
+    m_wait_lock = host_mutex_create();
+    m_wait_cond = host_cond_create();
+    
+    i860_boards[ND_NUM(nd->slot)] = this;
     
     sprintf(m_thread_name, "[ND] Slot %d: i860", nd->slot);
     
@@ -74,10 +93,40 @@ i860_cpu_device::i860_cpu_device(NextDimension* nd) : nd(nd) {
                 decoder_tbl[i] = decode_tbl[upper6];
         }
     }
+    
+    /* run_cycle() executes this line if an ifetch traps */
+    m_icache[I860_ICACHE_FAULT] = 0xffeeffeeffeeffeeLL;
+    predecode(I860_ICACHE_FAULT);
+    
+#if ENABLE_I860_JIT
+    m_jit       = false;
+    m_jit_code  = NULL;
+    m_jit_insns = NULL;
+#endif
+}
+
+i860_cpu_device::~i860_cpu_device() {
+    i860_boards[ND_NUM(nd->slot)] = NULL;
+    host_cond_destroy(m_wait_cond);
+    host_mutex_destroy(m_wait_lock);
+}
+
+/* Give each board's i860 thread a host CPU of its own. Boards take the
+ * highest numbered CPUs and leave at least two for the m68k and SDL threads. */
+void i860_cpu_device::set_affinity(void) {
+    int cpu = host_num_cpus() - 1 - ND_NUM(nd->slot);
+    
+    if(cpu < 2)
+        return;
+    if(host_thread_affinity(cpu))
+        Log_Printf(LOG_INFO, "[i860] Slot %d: i860 thread pinned to CPU %d", nd->slot, cpu);
+    else
+        Log_Printf(LOG_DEBUG, "[i860] Slot %d: Could not pin i860 thread to CPU %d", nd->slot, cpu);
 }
 
 int i860_cpu_device::thread(void* data) {
     SDL_SetThreadPriority(SDL_THREAD_PRIORITY_LOW);
+    ((i860_cpu_device*)data)->set_affinity();
     ((i860_cpu_device*)data)->run();
     return 0;
 }
@@ -241,28 +290,58 @@ inline void i860_cpu_device::dim_switch() {
     m_flow &= ~DIM_OP;
 }
 
-void i860_cpu_device::run_cycle() {
+inline void i860_cpu_device::end_cycle() {
+    if (m_flow & FP_OP_SKIPPED) {
+        m_flow &= ~FP_OP_SKIPPED;
+        SET_PSR_KNF(0);
+    }
+    
+    // If at 64-bit boundary, switch DIM for next instruction.
+    if (!(m_pc & 4))
+        dim_switch();
+    
+    // Check for external interrupts and trap if an interrupt is pending.
+    gen_interrupt();
+    if (m_flow & TRAP_WAS_EXTERNAL)
+        handle_trap(m_pc);
+}
+
+/* Execute the instruction(s) at the PC. Returns the number of instructions executed. */
+int i860_cpu_device::run_cycle() {
     CLEAR_FLOW();
     m_dim_cc_valid = false;
+#if ENABLE_I860_JIT
+    if (m_jit) {
+        const int retired = jit_run();
+        if (retired)
+            return retired;
+    }
+#endif
     UINT32 savepc  = m_pc;
-    UINT64 insn64  = ifetch64(m_pc);
+    int    count   = 1;
+    
+    /* Keep a copy of the line, the low instruction may refill or flush the icache */
+    const int       cidx      = ifetch_line(m_pc);
+    const UINT64    insn64    = m_icache[cidx];
+    const insn_func funcHigh  = m_icache_func[cidx][1];
+    const UINT8     flagsHigh = m_icache_flags[cidx][1];
     
     if(!(m_pc & 4)) {
 #if ENABLE_DEBUGGER
         if(m_single_stepping) debugger(0,0);
 #endif
         
-        UINT32 insnLow = insn64;
-        if(insnLow == INSN_FNOP_DIM) {
+        const UINT8 flagsLow = m_icache_flags[cidx][0];
+        if(flagsLow & PREDEC_FNOP_DIM) {
             if(m_dim) m_flow |=  DIM_OP;
             else      m_flow &= ~DIM_OP;
-        } else if((insnLow & INSN_MASK_DIM) == INSN_FP_DIM)
+        } else if(flagsLow & PREDEC_FP_DIM)
             m_flow |= DIM_OP;
         
-        if ((insnLow & INSN_MASK) == INSN_FP && GET_PSR_KNF())
+        if ((flagsLow & PREDEC_FP) && GET_PSR_KNF())
             m_flow |= FP_OP_SKIPPED;
         else
-            decode_exec(insnLow);
+            decode_exec(m_icache_func[cidx][0], insn64);
 
         if (PENDING_TRAP()) {
             handle_trap(savepc);
@@ -273,6 +352,7 @@ void i860_cpu_device::run_cycle() {
             // If the PC wasn't updated by a control flow instruction, just bump to next sequential instruction.
             m_pc   += 4;
             CLEAR_FLOW();
+            count++;
         }
     }
     
@@ -284,12 +364,10 @@ void i860_cpu_device::run_cycle() {
         if(m_single_stepping && !(m_dim)) debugger(0,0);
 #endif
 
-        UINT32 insnHigh = insn64 >> 32;
-        
-        if ((insnHigh & INSN_MASK) == INSN_FP && GET_PSR_KNF() && !(m_flow & FP_OP_SKIPPED))
+        if ((flagsHigh & PREDEC_FP) && GET_PSR_KNF() && !(m_flow & FP_OP_SKIPPED))
             m_flow |= FP_OP_SKIPPED;
         else
-            decode_exec(insnHigh);
+            decode_exec(funcHigh, insn64 >> 32);
         
         if (PENDING_TRAP()) {
             handle_trap(savepc);
@@ -303,19 +381,11 @@ void i860_cpu_device::run_cycle() {
     }
     
 done:
-    if (m_flow & FP_OP_SKIPPED) {
-        m_flow &= ~FP_OP_SKIPPED;
-        SET_PSR_KNF(0);
-    }
-    
-    // If at 64-bit boundary, switch DIM for next instruction.
-    if (!(m_pc & 4))
-        dim_switch();
-    
-    // Check for external interrupts and trap if an interrupt is pending.
-    gen_interrupt();
-    if (m_flow & TRAP_WAS_EXTERNAL)
-        handle_trap(m_pc);
+#if ENABLE_PERF_COUNTERS
+    m_predec_exec += count;
+#endif
+    end_cycle();
+    return count;
 }
 
 int i860_cpu_device::memtest(bool be) {
@@ -452,6 +522,10 @@ void i860_cpu_device::init(void) {
     memset(m_fregs, 0, sizeof(m_fregs));
     
     set_mem_access(false);
+    
+#if ENABLE_I860_JIT
+    jit_init();
+#endif
 
     // some sanity checks for endianess
     int    err    = 0;
@@ -538,17 +612,22 @@ error:
     }
 
     nd->send_msg(MSG_I860_RESET);
-    if(ConfigureParams.Dimension.bI860Thread) {
-        i860_Run = i860_run_thread;
-        m_thread = host_thread_create(i860_cpu_device::thread, m_thread_name, this);
-    } else {
-        i860_Run = i860_run_no_thread;
-    }
+    set_run_func();
+    start_thread();
 }
 
 void i860_cpu_device::uninit() {
 	halt(true);
 
+    stop_thread();
+}
+
+void i860_cpu_device::start_thread() {
+    if(ConfigureParams.Dimension.bI860Thread && !m_thread)
+        m_thread = host_thread_create(i860_cpu_device::thread, m_thread_name, this);
+}
+
+void i860_cpu_device::stop_thread() {
     if(m_thread) {
         nd->send_msg(MSG_I860_KILL);
         host_thread_wait(m_thread);
@@ -556,6 +635,35 @@ void i860_cpu_device::uninit() {
     }
 }
 
+/* Save/restore i860 state. The i860 thread must be stopped. */
+void i860_cpu_device::snapshot(bool save) {
+    MemorySnapShot_Store(&m_pc,            sizeof(m_pc));
+    MemorySnapShot_Store(&m_delay_slot_pc, sizeof(m_delay_slot_pc));
+    MemorySnapShot_Store(m_iregs,          sizeof(m_iregs));
+    MemorySnapShot_Store(m_fregs,          sizeof(m_fregs));
+    MemorySnapShot_Store(m_cregs,          sizeof(m_cregs));
+    MemorySnapShot_Store(&m_dim,           sizeof(m_dim));
+    MemorySnapShot_Store(&m_dim_cc,        sizeof(m_dim_cc));
+    MemorySnapShot_Store(&m_dim_cc_valid,  sizeof(m_dim_cc_valid));
+    MemorySnapShot_Store(&m_KR,            sizeof(m_KR));
+    MemorySnapShot_Store(&m_KI,            sizeof(m_KI));
+    MemorySnapShot_Store(&m_T,             sizeof(m_T));
+    MemorySnapShot_Store(&m_merge,         sizeof(m_merge));
+    MemorySnapShot_Store(m_A,              sizeof(m_A));
+    MemorySnapShot_Store(m_M,              sizeof(m_M));
+    MemorySnapShot_Store(m_L,              sizeof(m_L));
+    MemorySnapShot_Store(&m_G,             sizeof(m_G));
+    MemorySnapShot_Store(&m_flow,          sizeof(m_flow));
+    MemorySnapShot_Store(&m_fpcs,          sizeof(m_fpcs));
+    MemorySnapShot_Store((void*)&m_halt,   sizeof(m_halt));
+    
+    if(!save) {
+        invalidate_icache();
+        invalidate_tlb();
+        set_mem_access(GET_EPSR_BE());
+    }
+}
+
 /* Message disaptcher - executed on i860 thread, safe to call i860 methods */
 bool i860_cpu_device::handle_msgs(int msg) {
     if(msg & MSG_I860_KILL)
@@ -572,23 +680,67 @@ bool i860_cpu_device::handle_msgs(int msg) {
     return true;
 }
 
+/* Add cycle credits for the i860 thread, called from m68k thread.
+ * Credits are capped so that the i860 never runs far ahead of the m68k. */
+void i860_cpu_device::post_credits(int cycles) {
+    int old_value, new_value;
+    do {
+        old_value = host_atomic_get(&m_credits);
+        new_value = old_value + cycles;
+        if(new_value > I860_MAX_CREDITS)
+            new_value = I860_MAX_CREDITS;
+    } while (!host_atomic_cas(&m_credits, old_value, new_value));
+    
+    if(old_value <= 0 && host_atomic_get(&m_waiting))
+        wake();
+}
+
+/* Wake up the i860 thread, called after posting a message or resuming */
+void i860_cpu_device::wake(void) {
+    host_atomic_set(&m_wakeup, 1);
+    if(host_atomic_get(&m_waiting)) {
+        host_mutex_lock(m_wait_lock);
+        host_cond_signal(m_wait_cond);
+        host_mutex_unlock(m_wait_lock);
+    }
+}
+
+/* Block the i860 thread until there is work or the timeout expires. Wakers
+ * check m_waiting after publishing their work, so no wakeup can be lost. */
+void i860_cpu_device::wait(Uint32 ms) {
+    host_mutex_lock(m_wait_lock);
+    host_atomic_set(&m_waiting, 1);
+    if(!host_atomic_set(&m_wakeup, 0) && (is_halted() || host_atomic_get(&m_credits) <= 0))
+        host_cond_wait(m_wait_cond, m_wait_lock, ms);
+    host_atomic_set(&m_waiting, 0);
+    host_mutex_unlock(m_wait_lock);
+}
+
 void i860_cpu_device::run() {
+    int cycles = 0;
+    
     while(nd->handle_msgs()) {
         
-        /* Sleep a bit if halted */
+        /* Wait for a message if halted */
         if(is_halted()) {
-            host_sleep_ms(100);
+            wait(100);
             continue;
         }
         
-        if (i860cycles > 0) {
-            /* Run some i860 cycles before re-checking messages */
-            for(int i = 16; --i >= 0;)
-                run_cycle();
-            
-            i860cycles -= 16;
-        } else {
-            host_sleep_ms(1);
+        /* Take all posted credits, wait if there are none */
+        if (cycles <= 0) {
+            cycles = host_atomic_set(&m_credits, 0);
+            if (cycles <= 0) {
+                wait(10);
+                continue;
+            }
+        }
+        
+        /* Run some i860 cycles before re-checking messages */
+        for(int i = 16; i > 0;) {
+            const int n = run_cycle();
+            i      -= n;
+            cycles -= n;
         }
     }
 }
@@ -600,9 +752,11 @@ const char* i860_cpu_device::reports(Uint64 realTime, Uint64 hostTime) {
         m_report[0] = 0;
     } else {
         if(dVT == 0) dVT = 0.0001;
-        sprintf(m_report, "i860:{MIPS=%.1f icache_hit=%lld%% tlb_hit=%lld%% tlb_search=%lld%% icach_inval/s=%.0f tlb_inval/s=%.0f intr/s=%0.f}",
-                               (float) (m_insn_decoded / (dVT*1000*1000)),
+        sprintf(m_report, "i860:{MIPS=%.1f icache_hit=%lld%% predec_reuse=%.1f jit=%lld%% tlb_hit=%lld%% tlb_search=%lld%% icach_inval/s=%.0f tlb_inval/s=%.0f intr/s=%0.f}",
+                               (float) ((m_insn_decoded+m_jit_native) / (dVT*1000*1000)),
                                m_icache_hit+m_icache_miss == 0 ? 0LL : (100LL * m_icache_hit) / (m_icache_hit+m_icache_miss) ,
+                               m_predec_lines == 0 ? 0.0 : (double) m_predec_exec / m_predec_lines,
+                               m_insn_decoded+m_jit_native == 0 ? 0LL : (100LL * m_jit_native) / (m_insn_decoded+m_jit_native) ,
                                m_tlb_hit+m_tlb_miss       == 0 ? 0LL : (100LL * m_tlb_hit)    / (m_tlb_hit+m_tlb_miss),
                                m_tlb_hit+m_tlb_miss       == 0 ? 0LL : (100LL * m_tlb_search) / (m_tlb_hit+m_tlb_miss),
                                (float) (m_icache_inval)/dVT,
@@ -614,6 +768,9 @@ const char* i860_cpu_device::reports(Uint64 realTime, Uint64 hostTime) {
         m_icache_hit    = 0;
         m_icache_miss   = 0;
         m_icache_inval  = 0;
+        m_predec_lines  = 0;
+        m_predec_exec   = 0;
+        m_jit_native    = 0;
         m_tlb_hit       = 0;
         m_tlb_search    = 0;
         m_tlb_miss      = 0;
@@ -640,3 +797,10 @@ offs_t i860_cpu_device::disasm(char* buffer, offs_t pc) {
  * The debugger code.
  **************************************************************************/
 #include "i860dbg.cpp"
+
+/**************************************************************************
+ * The trace compiler.
+ **************************************************************************/
+#if ENABLE_I860_JIT
+#include "i860jit.cpp"
+#endif
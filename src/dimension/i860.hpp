@@ -380,14 +380,32 @@ const UINT32 INSN_FP_DIM   = INSN_FP   | INSN_DIM;
 const UINT32 INSN_MASK     = 0xFC000000;
 const UINT32 INSN_MASK_DIM = INSN_MASK | INSN_DIM;
 
+/* Predecoded instruction flags, checked by run_cycle() before dispatch */
+enum {
+    PREDEC_FP          = 0x01, // f-op, skipped if PSR.KNF is set
+    PREDEC_FP_DIM      = 0x02, // f-op with DIM bit set
+    PREDEC_FNOP_DIM    = 0x04, // fnop with DIM bit set
+};
+
 const size_t I860_ICACHE_SZ       = 9;  // in powers of two lines (2^9 = 512; 512 x 2 words = 4 kbytes)
 const size_t I860_ICACHE_MASK     = (1<<I860_ICACHE_SZ)-1;
+const size_t I860_ICACHE_FAULT    = 1<<I860_ICACHE_SZ; // extra line holding the result of a faulting ifetch
 const size_t I860_TLB_SETS        = 4;  // in powers of two (2^4 = 16 sets)
 const size_t I860_TLB_WAYS        = 2;  // in powers of two (2^2 =  4 ways)
 const size_t I860_PAGE_SZ         = 12; // in powers of two
 const size_t I860_PAGE_OFF_MASK   = (1<<I860_PAGE_SZ)-1;
 const size_t I860_PAGE_FRAME_MASK = ~I860_PAGE_OFF_MASK;
 
+const size_t I860_JIT_TRACES      = 12;    // in powers of two (2^12 = 4096 traces)
+const size_t I860_JIT_TRACE_MASK  = (1<<I860_JIT_TRACES)-1;
+const size_t I860_JIT_MAX_INSNS   = 32;    // instructions per trace
+const size_t I860_JIT_INSNS       = 1<<16; // instructions of all traces
+const size_t I860_JIT_CODE_SZ     = 1<<21; // host code of all traces
+const size_t I860_JIT_INSN_CODE   = 512;   // upper bound of host code per instruction
+const UINT32 I860_JIT_HOT         = 16;    // executions before a trace is compiled
+
+const int    I860_MAX_CREDITS     = (1000*1000*33)/136; // at most one ND VBL of cycles ahead of the m68k
+
 /* Control register numbers.  */
 enum {
     CR_FIR     = 0,
@@ -438,19 +456,25 @@ public:
     
 	// construction/destruction
     i860_cpu_device(NextDimension* nd);
+    ~i860_cpu_device();
     
     /* External interface */
     void init(void);
     void set_run_func(void);
     void uninit(void);
+    void start_thread(void);
+    void stop_thread(void);
     void halt(bool state);
     void pause(bool state);
-    inline bool is_halted(void) {return m_halt;};
+    inline bool is_halted(void) {return m_halt || m_paused;};
+    void snapshot(bool save);
 
-    /* i860 cycle counter */
-    int i860cycles;
+    /* Post i860 cycle credits, called from m68k thread */
+    void post_credits(int cycles);
+    /* Wake up the i860 thread if it is waiting */
+    void wake(void);
     /* Run one i860 cycle */
-    void    run_cycle(void);
+    int     run_cycle(void);
     /* Run the i860 thread */
     void run();
     /* i860 thread message handler */
@@ -468,11 +492,23 @@ private:
     float_status m_fpcs;
     
     thread_t*    m_thread;
+    
+    /* Cycle credits and wakeup flag, posted by the m68k thread */
+    atomic_int   m_credits;
+    atomic_int   m_wakeup;
+    atomic_int   m_waiting;
+    mutex_t*     m_wait_lock;
+    cond_t*      m_wait_cond;
+    void         wait(Uint32 ms);
+    void         set_affinity(void);
 
     UINT64 m_insn_decoded;
     UINT64 m_icache_hit;
     UINT64 m_icache_miss;
     UINT64 m_icache_inval;
+    UINT64 m_predec_lines;  // icache lines predecoded
+    UINT64 m_predec_exec;   // instructions dispatched from predecoded lines
+    UINT64 m_jit_native;
     UINT64 m_tlb_hit;
     UINT64 m_tlb_search;
     UINT64 m_tlb_miss;
@@ -584,19 +620,73 @@ private:
 		} stat;
 	} m_G;
 
+    typedef void (i860_cpu_device::*insn_func)(UINT32);
+
     /* Instruction cache */
-    UINT64 m_icache[1<<I860_ICACHE_SZ];
-    UINT32 m_icache_vaddr[1<<I860_ICACHE_SZ];
+    UINT64    m_icache[(1<<I860_ICACHE_SZ)+1];
+    UINT32    m_icache_vaddr[1<<I860_ICACHE_SZ];
+    /* Predecoded handlers and flags for the low and high instruction of each line */
+    insn_func m_icache_func[(1<<I860_ICACHE_SZ)+1][2];
+    UINT8     m_icache_flags[(1<<I860_ICACHE_SZ)+1][2];
     
     /* Translation look-aside buffer */
     UINT32 m_tlb_vaddr[1<<I860_TLB_WAYS][1<<I860_TLB_SETS];
     UINT32 m_tlb_paddr[1<<I860_TLB_WAYS][1<<I860_TLB_SETS];
     UINT32 m_way;
+
+#if ENABLE_I860_JIT
+    /* Trace compiler */
+    typedef int (*jit_func)(i860_cpu_device* cpu, UINT32* iregs, UINT32* cregs, UINT32* pc);
+    struct jit_insn {
+        insn_func func;
+        UINT32    insn;
+        UINT32    pc;
+    };
+    struct jit_trace {
+        UINT32    vaddr;
+        UINT32    hits;   // executions before the trace got compiled
+        UINT32    count;  // number of instructions
+        jit_func  func;
+        jit_insn* insns;
+    };
+    struct jit_slow {
+        UINT8*    jumps[12]; // jumps of a fast path to its interpreter fallback
+        int       count;
+    };
+    bool      m_jit;
+    UINT8*    m_jit_code;
+    size_t    m_jit_code_used;
+    jit_insn* m_jit_insns;
+    size_t    m_jit_insns_used;
+    jit_trace m_jit_traces[1<<I860_JIT_TRACES];
+#if ENABLE_I860_JIT_VERIFY
+    /* Memory accesses of the compiled run of a trace, replayed to the interpreter */
+    struct jit_access {
+        UINT32    addr;
+        UINT32    size;
+        bool      write;
+        UINT8     data[16];
+    };
+    jit_access  m_jit_log[I860_JIT_MAX_INSNS * 8];
+    int         m_jit_log_count;
+    int         m_jit_log_pos;
+    int         m_jit_log_err;  // first access the interpreter did differently or -1
+    jit_access  m_jit_log_interp;
+    UINT32      m_jit_log_addr; // physical address of the last native access
+    mem_rd_func m_jit_rdmem[17];
+    mem_wr_func m_jit_wrmem[17];
+#endif
+#endif
     
 	/*
 	 * Halt state. Can be set externally
 	 */
     volatile bool m_halt;
+    
+    /*
+     * Pause state. Set while the emulation is paused
+     */
+    volatile bool m_paused;
         
 	/* Indicate an instruction just generated a trap,
      needs to go to the trap address or a control-flow 
@@ -696,10 +786,13 @@ private:
     void   set_fregval_d (int fr, FLOAT64 d);
     void   SET_PSR_CC(int val);
     
+    inline void end_cycle();
     void   invalidate_icache();
     void   invalidate_tlb();
     inline UINT64 ifetch64(const UINT32 pc);
     UINT64 ifetch64(const UINT32 pc, const UINT32 vaddr, int const cidx);
+    inline int ifetch_line(const UINT32 pc);
+    void   predecode(int cidx);
     UINT32 ifetch(const UINT32 pc);
     UINT32 ifetch_notrap(const UINT32 pc);
     const char* trap_info();
@@ -708,6 +801,7 @@ private:
     void   unrecog_opcode (UINT32 pc, UINT32 insn);
     
     void   decode_exec (UINT32 insn);
+    inline void decode_exec (insn_func func, UINT32 insn);
     void   dump_pipe (int type);
     void   dump_state ();
 	UINT32 disasm (UINT32 addr, int len);
@@ -722,6 +816,31 @@ private:
     void   dbg_check_wr(UINT32 addr, int size, UINT8* data);
     
     void gen_interrupt();
+
+#if ENABLE_I860_JIT
+    void   jit_init();
+    void   jit_flush();
+    int    jit_run();
+    void   jit_compile(jit_trace& trace);
+    bool   jit_native(UINT8*& code, insn_func func, UINT32 insn);
+    bool   jit_native_mem(UINT8*& code, const jit_insn* insn, UINT32 retired);
+    bool   jit_native_fp(UINT8*& code, const jit_insn* insn, UINT32 retired);
+    void   jit_emit_translate(UINT8*& code, jit_slow& slow, int size, bool is_write);
+    static void jit_emit_jcc_slow(UINT8*& code, jit_slow& slow, int cc);
+    static void jit_emit_slow_path(UINT8*& code, jit_slow& slow, const jit_insn* insn, UINT32 retired);
+    static UINT32 jit_exec(i860_cpu_device* cpu, const jit_insn* insn);
+#if ENABLE_I860_JIT_VERIFY
+    int    jit_verify(const jit_trace& trace);
+    void   jit_mem_log(bool replay);
+    void   jit_log(UINT32 addr, int size, const UINT32* data, bool write);
+    void   jit_replay(UINT32 addr, int size, UINT32* data, bool write);
+    static UINT64 jit_log_native(i860_cpu_device* cpu, UINT64 val, UINT32 size, UINT32 write);
+    template<int SIZE> static void jit_log_rd(const NextDimension* nd, UINT32 addr, UINT32* val);
+    template<int SIZE> static void jit_log_wr(const NextDimension* nd, UINT32 addr, const UINT32* val);
+    template<int SIZE> static void jit_replay_rd(const NextDimension* nd, UINT32 addr, UINT32* val);
+    template<int SIZE> static void jit_replay_wr(const NextDimension* nd, UINT32 addr, const UINT32* val);
+#endif
+#endif
     
     /* This is the interface for reseting the i860.  */
     void reset();
@@ -730,7 +849,6 @@ private:
     /* This is the interface for clearing an external interrupt of the i860.  */
     void lower_intr();
 
-	typedef void (i860_cpu_device::*insn_func)(UINT32);
 	static const insn_func decode_tbl[64];
 	static const insn_func core_esc_decode_tbl[8];
 	static const insn_func fp_decode_tbl[128];
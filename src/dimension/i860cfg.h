@@ -39,6 +39,7 @@
 #define ENABLE_I860_DB_BREAK   0
 #define ENABLE_PERF_COUNTERS   1
 #define ENABLE_DEBUGGER        1
+#define ENABLE_I860_JIT_VERIFY 1
 
 #elif CONF_I860==CONF_I860_SPEED
 #define TRACE_RDWR_MEM         LOG_NONE
@@ -50,6 +51,7 @@
 #define ENABLE_I860_DB_BREAK   0
 #define ENABLE_PERF_COUNTERS   0
 #define ENABLE_DEBUGGER        0
+#define ENABLE_I860_JIT_VERIFY 0
 
 
 #elif CONF_I860==CONF_I860_NO_THREAD
@@ -62,7 +64,16 @@
 #define ENABLE_I860_DB_BREAK   0
 #define ENABLE_PERF_COUNTERS   0
 #define ENABLE_DEBUGGER        0
+#define ENABLE_I860_JIT_VERIFY 0
 
 #endif
 
+/* Trace compiler, x86-64 hosts only. Switched on with Dimension.bI860JIT.
+   ENABLE_I860_JIT_VERIFY runs every compiled trace against the interpreter. */
+#if defined(__x86_64__) || defined(_M_X64)
+#define ENABLE_I860_JIT        1
+#else
+#define ENABLE_I860_JIT        0
+#endif
+
 #endif /* i860cfg_h */
@@ -367,11 +367,12 @@ void i860_cpu_device::halt(bool state) {
 
 void i860_cpu_device::pause(bool state) {
     if(state) {
-        m_halt = true;
+        m_paused = true;
         Log_Printf(LOG_WARN, "[i860] **** PAUSED ****");
     } else {
         Log_Printf(LOG_WARN, "[i860] **** RESUMED ****");
-        m_halt = false;
+        m_paused = false;
+        wake();
     }
 }
 
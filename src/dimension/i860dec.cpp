@@ -106,6 +106,9 @@ void i860_cpu_device::gen_interrupt()
 
 void i860_cpu_device::invalidate_icache() {
     memset(m_icache_vaddr, 0xff, sizeof(UINT32) * (1<<I860_ICACHE_SZ));
+#if ENABLE_I860_JIT
+    jit_flush();
+#endif
 #if ENABLE_PERF_COUNTERS
     m_icache_inval++;
 #endif
@@ -162,10 +165,34 @@ UINT64 i860_cpu_device::ifetch64(const UINT32 pc, const UINT32 vaddr, int const
         NextDimension::i860_rd64_be(nd, paddr, (UINT32*)&insn64);
     }
     m_icache[cidx] = insn64;
+    predecode(cidx);
     
     return insn64;
 }
 
+/* Look up the handlers and run_cycle() flags of both instructions in an icache line
+   once when the line is filled. Writes to code are picked up when the i860 flushes
+   the instruction cache, just like on the real hardware. */
+void i860_cpu_device::predecode(int cidx) {
+#if ENABLE_PERF_COUNTERS
+    m_predec_lines++;
+#endif
+    for(int i = 0; i < 2; i++) {
+        UINT32 insn  = m_icache[cidx] >> (i * 32);
+        UINT8  flags = 0;
+        
+        if((insn & INSN_MASK) == INSN_FP)
+            flags |= PREDEC_FP;
+        if(insn == INSN_FNOP_DIM)
+            flags |= PREDEC_FNOP_DIM;
+        else if((insn & INSN_MASK_DIM) == INSN_FP_DIM)
+            flags |= PREDEC_FP_DIM;
+        
+        m_icache_func[cidx][i]  = decoder_tbl[((insn >> 19) & 0x1F80) | (insn & 0x7F)];
+        m_icache_flags[cidx][i] = flags;
+    }
+}
+
 inline UINT64 i860_cpu_device::ifetch64(const UINT32 pc) {
     const UINT32 vaddr = pc & ~7;
     const int    cidx = (vaddr>>3) & I860_ICACHE_MASK;
@@ -179,6 +206,21 @@ inline UINT64 i860_cpu_device::ifetch64(const UINT32 pc) {
     }
 }
 
+/* Fetch the icache line for pc and return its index. Returns I860_ICACHE_FAULT
+   if the ifetch trapped. */
+inline int i860_cpu_device::ifetch_line(const UINT32 pc) {
+    const UINT32 vaddr = pc & ~7;
+    const int    cidx  = (vaddr>>3) & I860_ICACHE_MASK;
+    if(m_icache_vaddr[cidx] != vaddr) {
+        ifetch64(pc, vaddr, cidx);
+        return (m_flow & EXITING_IFETCH) ? I860_ICACHE_FAULT : cidx;
+    }
+#if ENABLE_PERF_COUNTERS
+    m_icache_hit++;
+#endif
+    return cidx;
+}
+
 /* Given a virtual address, perform the i860 address translation and
    return the corresponding physical address.
      vaddr:      virtual address
@@ -438,6 +480,7 @@ inline void i860_cpu_device::writemem_emu (UINT32 addr, int size, UINT8 *data) {
 #endif
     
 	/* Now do the actual write.  */
+    EVTRACE(EV_I860_WR, size*8, addr, *(UINT32*)data, m_pc);
     wrmem[size](nd, addr, (UINT32*)data);
 }
 
@@ -474,6 +517,7 @@ inline void i860_cpu_device::readmem_emu (UINT32 addr, int size, UINT8 *dest)
 	}
 #endif
     rdmem[size](nd, addr, (UINT32*)dest);
+    EVTRACE(EV_I860_RD, size*8, addr, *(UINT32*)dest, m_pc);
 }
 
 
@@ -510,6 +554,7 @@ inline void i860_cpu_device::writemem_emu (UINT32 addr, int size, UINT8 *data, U
 	}
 #endif
         
+    EVTRACE(EV_I860_WR, size*8, addr, *(UINT32*)data, m_pc);
     if(size == 8 && wmask != 0xff) {
         if (wmask & 0x80) wrmem[1](nd, addr+0, (UINT32*)&data[0]);
         if (wmask & 0x40) wrmem[1](nd, addr+1, (UINT32*)&data[1]);
@@ -3929,6 +3974,11 @@ i860_cpu_device::insn_func i860_cpu_device::decoder_tbl[8192];
  *  non_shadow = This insn is not in the shadow of a delayed branch - (SC) unused, removed).
  */
 void i860_cpu_device::decode_exec (UINT32 insn) {
+    decode_exec(decoder_tbl[((insn >> 19) & 0x1F80) | (insn & 0x7F)], insn);
+}
+
+/* Execute an instruction with an already decoded handler */
+inline void i860_cpu_device::decode_exec (insn_func func, UINT32 insn) {
     if(m_flow & EXITING_IFETCH) return;
     
 #if ENABLE_PERF_COUNTERS
@@ -3941,7 +3991,7 @@ void i860_cpu_device::decode_exec (UINT32 insn) {
         m_traceback_idx = 0;
 #endif    
 //    (this->*decode_tbl[(insn >> 26) & 0x3f])(insn);
-    (this->*decoder_tbl[((insn >> 19) & 0x1F80) | (insn & 0x7F)])(insn);
+    (this->*func)(insn);
 }
 
 void i860_cpu_device::dec_unrecog(UINT32 insn) {
@@ -0,0 +1,1226 @@
+/***************************************************************************
+
+    i860jit.cpp
+
+    Trace compiler for the Intel i860 emulator (x86-64 hosts).
+
+    Changes for previous/NeXTdimension by Simon Schubiger (SC)
+
+***************************************************************************/
+
+/*
+ * Straight-line runs of instructions starting at a hot PC are compiled to
+ * host code. Integer arithmetic, logic and shift instructions are translated
+ * to x86-64 instructions operating directly on m_iregs and the PSR/EPSR
+ * flags. Loads, stores and some f-ops are translated as described below.
+ * All other instructions (branches, traps, graphics ops, ...) are compiled to calls of their interpreter handlers through jit_exec().
+ * A trace is left as soon as a handler updates the PC or raises a trap,
+ * the trap is then handled exactly like in run_cycle().
+ *
+ * Traces only run outside of dual instruction mode with PSR.KNF cleared.
+ * They stop at instructions which switch DIM, at control register accesses
+ * and at the end of the page. Instructions are taken from the instruction
+ * cache, so traces are flushed together with it in invalidate_icache().
+ *
+ * A trace returns the number of instructions it retired, including the one
+ * which left it, so run_cycle() can charge them against the cycle budget.
+ *
+ * Loads and stores (ld.x, st.x, fld.{l,d}, fst.{l,d}) are translated with an
+ * inline fast path for aligned accesses to board RAM. With address
+ * translation on, it only probes the TLB entry of the current way and needs
+ * a hit whose PTE grants the access without the interpreter's fault checks.
+ * Everything else (misalignment, misses, VRAM, MMIO, traced events) takes the
+ * interpreter handler, which starts from the same state since the fast path
+ * does not write anything before it is committed.
+ *
+ * [p]fadd, [p]fsub, [p]fmul and pf[m]am/pf[m]sm are translated to SSE. Their
+ * fast path requires round to nearest, the result precision in the pipeline
+ * stages it reads and no NaN results, so it gives the same bits as softfloat.
+ * The softfloat exception flags are not kept, the i860 never reads them.
+ */
+
+#if defined _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+/* Host registers */
+enum {
+    JIT_EAX = 0,
+    JIT_ECX = 1,
+    JIT_EDX = 2,
+    JIT_ESI = 6,
+    JIT_EDI = 7,
+    JIT_R12 = 12, // m_iregs
+    JIT_R13 = 13, // m_cregs
+};
+
+/* Host condition codes for setcc */
+enum {
+    JIT_CC_O  = 0x0,
+    JIT_CC_C  = 0x2,
+    JIT_CC_Z  = 0x4,
+    JIT_CC_NZ = 0x5,
+    JIT_CC_P  = 0xA,
+    JIT_CC_L  = 0xC,
+};
+
+/* Host scalar SSE operations (opcode of "op xmm, xmm/m", F3 prefix for single, F2 for double) */
+enum {
+    JIT_LDS   = 0x10, // movss/movsd xmm, m
+    JIT_STS   = 0x11, // movss/movsd m, xmm
+    JIT_ADDS  = 0x58,
+    JIT_MULS  = 0x59,
+    JIT_CVTS  = 0x5A, // cvtss2sd/cvtsd2ss
+    JIT_SUBS  = 0x5C,
+};
+
+/* Offset of a member from the cpu in rbx */
+#define JIT_OFS(member) ((INT32)((const UINT8*)&(member) - (const UINT8*)this))
+
+/* Host ALU operations (opcode of "op r/m32, r32") */
+enum {
+    JIT_ADD = 0x01,
+    JIT_OR  = 0x09,
+    JIT_AND = 0x21,
+    JIT_SUB = 0x29,
+    JIT_XOR = 0x31,
+};
+
+/* Host shift operations (reg field of "shift r/m32, cl") */
+enum {
+    JIT_SHL = 4,
+    JIT_SHR = 5,
+    JIT_SAR = 7,
+};
+
+static inline void jit_emit8(UINT8*& code, UINT8 val) {
+    *code++ = val;
+}
+
+static inline void jit_emit32(UINT8*& code, UINT32 val) {
+    memcpy(code, &val, sizeof(val));
+    code += sizeof(val);
+}
+
+static inline void jit_emit64(UINT8*& code, UINT64 val) {
+    memcpy(code, &val, sizeof(val));
+    code += sizeof(val);
+}
+
+/* ModR/M for [base + disp8], base is r12 or r13 */
+static void jit_emit_mem(UINT8*& code, int reg, int base, int disp) {
+    jit_emit8(code, 0x40 | (reg << 3) | (base & 7));
+    if((base & 7) == 4)
+        jit_emit8(code, 0x24); // SIB for r12
+    jit_emit8(code, disp);
+}
+
+/* mov reg, iregs[src] */
+static void jit_emit_load(UINT8*& code, int reg, int src) {
+    if(src == 0) {
+        jit_emit8(code, 0x31); // xor reg, reg
+        jit_emit8(code, 0xC0 | (reg << 3) | reg);
+    } else {
+        jit_emit8(code, 0x41);
+        jit_emit8(code, 0x8B);
+        jit_emit_mem(code, reg, JIT_R12, src * 4);
+    }
+}
+
+/* mov iregs[dest], eax - writes to r0 are dropped */
+static void jit_emit_store(UINT8*& code, int dest) {
+    if(dest == 0) return;
+    jit_emit8(code, 0x41);
+    jit_emit8(code, 0x89);
+    jit_emit_mem(code, JIT_EAX, JIT_R12, dest * 4);
+}
+
+/* mov reg, imm32 */
+static void jit_emit_imm(UINT8*& code, int reg, UINT32 imm) {
+    jit_emit8(code, 0xB8 + reg);
+    jit_emit32(code, imm);
+}
+
+/* op eax, ecx */
+static void jit_emit_alu(UINT8*& code, UINT8 op) {
+    jit_emit8(code, op);
+    jit_emit8(code, 0xC8);
+}
+
+/* shift eax, cl */
+static void jit_emit_shift(UINT8*& code, int op) {
+    jit_emit8(code, 0xD3);
+    jit_emit8(code, 0xC0 | (op << 3));
+}
+
+/* setcc reg8; movzx reg, reg8 */
+static void jit_emit_setcc(UINT8*& code, int cc, int reg) {
+    jit_emit8(code, 0x0F);
+    jit_emit8(code, 0x90 | cc);
+    jit_emit8(code, 0xC0 | reg);
+    jit_emit8(code, 0x0F);
+    jit_emit8(code, 0xB6);
+    jit_emit8(code, 0xC0 | (reg << 3) | reg);
+}
+
+/* Insert the low bits of reg into cregs[creg] at bit position shift */
+static void jit_emit_creg_bits(UINT8*& code, int reg, int creg, UINT32 mask, int shift) {
+    if(shift) {
+        jit_emit8(code, 0xC1); // shl reg, shift
+        jit_emit8(code, 0xE0 | reg);
+        jit_emit8(code, shift);
+    }
+    jit_emit8(code, 0x41); // and cregs[creg], ~mask
+    jit_emit8(code, 0x81);
+    jit_emit_mem(code, 4, JIT_R13, creg * 4);
+    jit_emit32(code, ~mask);
+    jit_emit8(code, 0x41); // or cregs[creg], reg
+    jit_emit8(code, 0x09);
+    jit_emit_mem(code, reg, JIT_R13, creg * 4);
+}
+
+/* Set PSR.CC from a host condition */
+static void jit_emit_cc(UINT8*& code, int cc) {
+    jit_emit_setcc(code, cc, JIT_EDX);
+    jit_emit_creg_bits(code, JIT_EDX, CR_PSR, 1 << 2, 2);
+}
+
+/* ModR/M for [rbx + disp32], rbx is the cpu */
+static void jit_emit_cpu(UINT8*& code, int reg, INT32 disp) {
+    jit_emit8(code, 0x83 | (reg << 3));
+    jit_emit32(code, (UINT32)disp);
+}
+
+/* Scalar SSE op xmm, [rbx + disp32] */
+static void jit_emit_sse(UINT8*& code, bool dbl, UINT8 op, int xmm, INT32 disp) {
+    jit_emit8(code, dbl ? 0xF2 : 0xF3);
+    jit_emit8(code, 0x0F);
+    jit_emit8(code, op);
+    jit_emit_cpu(code, xmm, disp);
+}
+
+/* Scalar SSE op xmm, xmm */
+static void jit_emit_sse_rr(UINT8*& code, bool dbl, UINT8 op, int dst, int src) {
+    jit_emit8(code, dbl ? 0xF2 : 0xF3);
+    jit_emit8(code, 0x0F);
+    jit_emit8(code, op);
+    jit_emit8(code, 0xC0 | (dst << 3) | src);
+}
+
+/* movups xmm, [rbx + disp32] or movups [rbx + disp32], xmm */
+static void jit_emit_movups(UINT8*& code, bool store, int xmm, INT32 disp) {
+    jit_emit8(code, 0x0F);
+    jit_emit8(code, store ? 0x11 : 0x10);
+    jit_emit_cpu(code, xmm, disp);
+}
+
+/* Set or clear bits of cregs[creg] */
+static void jit_emit_creg_const(UINT8*& code, int creg, UINT32 mask, bool set) {
+    jit_emit8(code, 0x41); // and/or cregs[creg], imm32
+    jit_emit8(code, 0x81);
+    jit_emit_mem(code, set ? 1 : 4, JIT_R13, creg * 4);
+    jit_emit32(code, set ? mask : ~mask);
+}
+
+static void jit_emit_prologue(UINT8*& code) {
+    jit_emit8(code, 0x53);                          // push rbx
+    jit_emit8(code, 0x41); jit_emit8(code, 0x54);   // push r12
+    jit_emit8(code, 0x41); jit_emit8(code, 0x55);   // push r13
+    jit_emit8(code, 0x41); jit_emit8(code, 0x56);   // push r14
+#if defined _WIN32
+    jit_emit8(code, 0x56);                          // push rsi
+    jit_emit8(code, 0x57);                          // push rdi
+    jit_emit8(code, 0x48); jit_emit8(code, 0x83); jit_emit8(code, 0xEC); jit_emit8(code, 0x28); // sub rsp, 40
+    jit_emit8(code, 0x48); jit_emit8(code, 0x89); jit_emit8(code, 0xCB); // mov rbx, rcx
+    jit_emit8(code, 0x49); jit_emit8(code, 0x89); jit_emit8(code, 0xD4); // mov r12, rdx
+    jit_emit8(code, 0x4D); jit_emit8(code, 0x89); jit_emit8(code, 0xC5); // mov r13, r8
+    jit_emit8(code, 0x4D); jit_emit8(code, 0x89); jit_emit8(code, 0xCE); // mov r14, r9
+#else
+    jit_emit8(code, 0x48); jit_emit8(code, 0x83); jit_emit8(code, 0xEC); jit_emit8(code, 0x08); // sub rsp, 8
+    jit_emit8(code, 0x48); jit_emit8(code, 0x89); jit_emit8(code, 0xFB); // mov rbx, rdi
+    jit_emit8(code, 0x49); jit_emit8(code, 0x89); jit_emit8(code, 0xF4); // mov r12, rsi
+    jit_emit8(code, 0x49); jit_emit8(code, 0x89); jit_emit8(code, 0xD5); // mov r13, rdx
+    jit_emit8(code, 0x49); jit_emit8(code, 0x89); jit_emit8(code, 0xCE); // mov r14, rcx
+#endif
+}
+
+static void jit_emit_epilogue(UINT8*& code) {
+#if defined _WIN32
+    jit_emit8(code, 0x48); jit_emit8(code, 0x83); jit_emit8(code, 0xC4); jit_emit8(code, 0x28); // add rsp, 40
+    jit_emit8(code, 0x5F);                          // pop rdi
+    jit_emit8(code, 0x5E);                          // pop rsi
+#else
+    jit_emit8(code, 0x48); jit_emit8(code, 0x83); jit_emit8(code, 0xC4); jit_emit8(code, 0x08); // add rsp, 8
+#endif
+    jit_emit8(code, 0x41); jit_emit8(code, 0x5E);   // pop r14
+    jit_emit8(code, 0x41); jit_emit8(code, 0x5D);   // pop r13
+    jit_emit8(code, 0x41); jit_emit8(code, 0x5C);   // pop r12
+    jit_emit8(code, 0x5B);                          // pop rbx
+    jit_emit8(code, 0xC3);                          // ret
+}
+
+/* Call jit_exec(this, insn) and leave the trace with retired instructions in eax if it returns non-zero */
+static void jit_emit_call(UINT8*& code, const void* func, const void* insn, UINT32 retired) {
+#if defined _WIN32
+    jit_emit8(code, 0x48); jit_emit8(code, 0x89); jit_emit8(code, 0xD9); // mov rcx, rbx
+    jit_emit8(code, 0x48); jit_emit8(code, 0xBA);                        // mov rdx, insn
+#else
+    jit_emit8(code, 0x48); jit_emit8(code, 0x89); jit_emit8(code, 0xDF); // mov rdi, rbx
+    jit_emit8(code, 0x48); jit_emit8(code, 0xBE);                        // mov rsi, insn
+#endif
+    jit_emit64(code, (UINT64)(uintptr_t)insn);
+    jit_emit8(code, 0x48); jit_emit8(code, 0xB8);                        // mov rax, func
+    jit_emit64(code, (UINT64)(uintptr_t)func);
+    jit_emit8(code, 0xFF); jit_emit8(code, 0xD0);                        // call rax
+    jit_emit8(code, 0x85); jit_emit8(code, 0xC0);                        // test eax, eax
+    UINT8* skip = code;
+    jit_emit8(code, 0x74); jit_emit8(code, 0);                           // jz next
+    jit_emit_imm(code, JIT_EAX, retired);
+    jit_emit_epilogue(code);
+    skip[1] = code - (skip + 2);
+}
+
+#if ENABLE_I860_JIT_VERIFY
+/* Log the native access of size bytes in rax through jit_log_native(), which returns rax again */
+static void jit_emit_log(UINT8*& code, const void* func, int size, bool write) {
+#if defined _WIN32
+    jit_emit8(code, 0x48); jit_emit8(code, 0x89); jit_emit8(code, 0xD9); // mov rcx, rbx
+    jit_emit8(code, 0x48); jit_emit8(code, 0x89); jit_emit8(code, 0xC2); // mov rdx, rax
+    jit_emit8(code, 0x41); jit_emit8(code, 0xB8); jit_emit32(code, size); // mov r8d, size
+    jit_emit8(code, 0x41); jit_emit8(code, 0xB9); jit_emit32(code, write); // mov r9d, write
+#else
+    jit_emit8(code, 0x48); jit_emit8(code, 0x89); jit_emit8(code, 0xDF); // mov rdi, rbx
+    jit_emit8(code, 0x48); jit_emit8(code, 0x89); jit_emit8(code, 0xC6); // mov rsi, rax
+    jit_emit_imm(code, JIT_EDX, size);
+    jit_emit_imm(code, JIT_ECX, write);
+#endif
+    jit_emit8(code, 0x48); jit_emit8(code, 0xB8);                        // mov rax, func
+    jit_emit64(code, (UINT64)(uintptr_t)func);
+    jit_emit8(code, 0xFF); jit_emit8(code, 0xD0);                        // call rax
+}
+#endif
+
+/* Jump to the interpreter fallback of the current instruction on host condition cc */
+void i860_cpu_device::jit_emit_jcc_slow(UINT8*& code, jit_slow& slow, int cc) {
+    assert(slow.count < (int)(sizeof(slow.jumps) / sizeof(slow.jumps[0])));
+    jit_emit8(code, 0x0F);
+    jit_emit8(code, 0x80 | cc);
+    slow.jumps[slow.count++] = code;
+    jit_emit32(code, 0);
+}
+
+/* End a fast path and emit the interpreter fallback its jumps go to */
+void i860_cpu_device::jit_emit_slow_path(UINT8*& code, jit_slow& slow, const jit_insn* insn, UINT32 retired) {
+    jit_emit8(code, 0xE9); // jmp done
+    UINT8* done = code;
+    jit_emit32(code, 0);
+    for(int i = 0; i < slow.count; i++) {
+        const UINT32 rel = code - (slow.jumps[i] + 4);
+        memcpy(slow.jumps[i], &rel, sizeof(rel));
+    }
+    jit_emit_call(code, (const void*)&i860_cpu_device::jit_exec, insn, retired);
+    const UINT32 rel = code - (done + 4);
+    memcpy(done, &rel, sizeof(rel));
+}
+
+void i860_cpu_device::jit_init() {
+    m_jit = ConfigureParams.Dimension.bI860JIT;
+    if(!(m_jit) || m_jit_code)
+        return;
+
+#if defined _WIN32
+    m_jit_code = (UINT8*)VirtualAlloc(NULL, I860_JIT_CODE_SZ, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+#else
+    m_jit_code = (UINT8*)mmap(NULL, I860_JIT_CODE_SZ, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANON, -1, 0);
+    if(m_jit_code == (UINT8*)MAP_FAILED)
+        m_jit_code = NULL;
+#endif
+    m_jit_insns = (jit_insn*)malloc(sizeof(jit_insn) * I860_JIT_INSNS);
+
+    if(!(m_jit_code) || !(m_jit_insns)) {
+        Log_Printf(LOG_WARN, "[i860] Could not allocate trace compiler memory. Running interpreter only.");
+        m_jit = false;
+        return;
+    }
+    jit_flush();
+}
+
+void i860_cpu_device::jit_flush() {
+    if(!(m_jit_code))
+        return;
+
+    m_jit_code_used  = 0;
+    m_jit_insns_used = 0;
+    for(size_t i = 0; i < (1<<I860_JIT_TRACES); i++) {
+        m_jit_traces[i].vaddr = ~0;
+        m_jit_traces[i].func  = NULL;
+    }
+}
+
+/* Execute an instruction of a trace through the interpreter. Returns non-zero if the trace has to be left. */
+UINT32 i860_cpu_device::jit_exec(i860_cpu_device* cpu, const jit_insn* insn) {
+    cpu->m_pc = insn->pc;
+    cpu->decode_exec(insn->func, insn->insn);
+    return cpu->m_flow & (TRAP_MASK | PC_UPDATED);
+}
+
+/* Translate an instruction to host code. Returns false if the instruction has no translation. */
+bool i860_cpu_device::jit_native(UINT8*& code, insn_func func, UINT32 insn) {
+    const int    isrc1 = get_isrc1(insn);
+    const int    isrc2 = get_isrc2(insn);
+    const int    idest = get_idest(insn);
+    const UINT32 imm   = get_imm16(insn);
+    const UINT32 simm  = sign_ext(imm, 16);
+
+    /* Logical operations: CC = (result == 0) */
+    UINT8  op  = 0;
+    bool   reg = false;
+    UINT32 src1val = 0;
+    if     (func == &i860_cpu_device::insn_and)         {op = JIT_AND; reg = true;}
+    else if(func == &i860_cpu_device::insn_and_imm)     {op = JIT_AND; src1val = imm;}
+    else if(func == &i860_cpu_device::insn_andh_imm)    {op = JIT_AND; src1val = imm << 16;}
+    else if(func == &i860_cpu_device::insn_andnot)      {op = JIT_AND; reg = true;}
+    else if(func == &i860_cpu_device::insn_andnot_imm)  {op = JIT_AND; src1val = ~imm;}
+    else if(func == &i860_cpu_device::insn_andnoth_imm) {op = JIT_AND; src1val = ~(imm << 16);}
+    else if(func == &i860_cpu_device::insn_or)          {op = JIT_OR;  reg = true;}
+    else if(func == &i860_cpu_device::insn_or_imm)      {op = JIT_OR;  src1val = imm;}
+    else if(func == &i860_cpu_device::insn_orh_imm)     {op = JIT_OR;  src1val = imm << 16;}
+    else if(func == &i860_cpu_device::insn_xor)         {op = JIT_XOR; reg = true;}
+    else if(func == &i860_cpu_device::insn_xor_imm)     {op = JIT_XOR; src1val = imm;}
+    else if(func == &i860_cpu_device::insn_xorh_imm)    {op = JIT_XOR; src1val = imm << 16;}
+    if(op) {
+        if(reg) jit_emit_load(code, JIT_EAX, isrc1);
+        else    jit_emit_imm(code, JIT_EAX, src1val);
+        if(func == &i860_cpu_device::insn_andnot) {
+            jit_emit8(code, 0xF7); // not eax
+            jit_emit8(code, 0xD0);
+        }
+        jit_emit_load(code, JIT_ECX, isrc2);
+        jit_emit_alu(code, op);
+        jit_emit_store(code, idest);
+        jit_emit_cc(code, JIT_CC_Z);
+        return true;
+    }
+
+    /* Integer arithmetic */
+    bool imm_form = false;
+    if     (func == &i860_cpu_device::insn_addu) {op = JIT_ADD;}
+    else if(func == &i860_cpu_device::insn_adds) {op = JIT_ADD | 0x80;}
+    else if(func == &i860_cpu_device::insn_subu) {op = JIT_SUB;}
+    else if(func == &i860_cpu_device::insn_subs) {op = JIT_SUB | 0x80;}
+    else if(func == &i860_cpu_device::insn_addu_imm) {op = JIT_ADD;        imm_form = true;}
+    else if(func == &i860_cpu_device::insn_adds_imm) {op = JIT_ADD | 0x80; imm_form = true;}
+    else if(func == &i860_cpu_device::insn_subu_imm) {op = JIT_SUB;        imm_form = true;}
+    else if(func == &i860_cpu_device::insn_subs_imm) {op = JIT_SUB | 0x80; imm_form = true;}
+    if(op) {
+        const bool is_signed = op & 0x80;
+        op &= 0x7F;
+
+        if(imm_form) jit_emit_imm(code, JIT_EAX, simm);
+        else         jit_emit_load(code, JIT_EAX, isrc1);
+        jit_emit_load(code, JIT_ECX, isrc2);
+
+        if(op == JIT_ADD && is_signed) {
+            /* CC set if isrc2 < -isrc1 */
+            jit_emit8(code, 0x89); jit_emit8(code, 0xC2); // mov edx, eax
+            jit_emit8(code, 0xF7); jit_emit8(code, 0xDA); // neg edx
+            jit_emit8(code, 0x39); jit_emit8(code, 0xD1); // cmp ecx, edx
+            jit_emit_cc(code, JIT_CC_L);
+        }
+
+        if(op == JIT_ADD && is_signed) {
+            /* OF like the interpreter: sign(isrc1) != sign(isrc2) && sign(isrc1) != sign(result) */
+            jit_emit8(code, 0x89); jit_emit8(code, 0xC2); // mov edx, eax
+            jit_emit_alu(code, op);
+            jit_emit_store(code, idest);
+            jit_emit8(code, 0x31); jit_emit8(code, 0xD1); // xor ecx, edx
+            jit_emit8(code, 0x31); jit_emit8(code, 0xC2); // xor edx, eax
+            jit_emit8(code, 0x21); jit_emit8(code, 0xCA); // and edx, ecx
+            jit_emit8(code, 0xC1); jit_emit8(code, 0xEA); jit_emit8(code, 0x1F); // shr edx, 31
+            jit_emit_creg_bits(code, JIT_EDX, CR_EPSR, 1 << 24, 24);
+            return true;
+        }
+
+        jit_emit_alu(code, op);
+        jit_emit_store(code, idest);
+
+        if(is_signed) {
+            /* CC set if isrc2 > isrc1, OF = signed overflow */
+            jit_emit_setcc(code, JIT_CC_L, JIT_EDX);
+            jit_emit_setcc(code, JIT_CC_O, JIT_ECX);
+            jit_emit_creg_bits(code, JIT_EDX, CR_PSR, 1 << 2, 2);
+            jit_emit_creg_bits(code, JIT_ECX, CR_EPSR, 1 << 24, 24);
+        } else {
+            /* addu: CC = OF = carry, subu: CC = not borrow, OF = borrow */
+            jit_emit_setcc(code, JIT_CC_C, JIT_EDX);
+            jit_emit8(code, 0x89); jit_emit8(code, 0xD1); // mov ecx, edx
+            jit_emit_creg_bits(code, JIT_ECX, CR_EPSR, 1 << 24, 24);
+            if(op == JIT_SUB) {
+                jit_emit8(code, 0x83); jit_emit8(code, 0xF2); jit_emit8(code, 0x01); // xor edx, 1
+            }
+            jit_emit_creg_bits(code, JIT_EDX, CR_PSR, 1 << 2, 2);
+        }
+        return true;
+    }
+
+    /* Shifts */
+    int shift = -1;
+    if     (func == &i860_cpu_device::insn_shl)      {shift = JIT_SHL;}
+    else if(func == &i860_cpu_device::insn_shr)      {shift = JIT_SHR;}
+    else if(func == &i860_cpu_device::insn_shra)     {shift = JIT_SAR;}
+    else if(func == &i860_cpu_device::insn_shl_imm)  {shift = JIT_SHL; imm_form = true;}
+    else if(func == &i860_cpu_device::insn_shr_imm)  {shift = JIT_SHR; imm_form = true;}
+    else if(func == &i860_cpu_device::insn_shra_imm) {shift = JIT_SAR; imm_form = true;}
+    if(shift >= 0) {
+        if(imm_form) jit_emit_imm(code, JIT_ECX, simm);
+        else         jit_emit_load(code, JIT_ECX, isrc1);
+        jit_emit_load(code, JIT_EAX, isrc2);
+        jit_emit_shift(code, shift);
+        jit_emit_store(code, idest);
+        if(shift == JIT_SHR) {
+            /* shr also sets PSR.SC */
+            jit_emit8(code, 0x83); jit_emit8(code, 0xE1); jit_emit8(code, 0x1F); // and ecx, 0x1f
+            jit_emit_creg_bits(code, JIT_ECX, CR_PSR, 0x003e0000, 17);
+        }
+        return true;
+    }
+
+    return false;
+}
+
+/* Translate the virtual address in ecx to a host pointer in rsi for an aligned access of size
+   bytes to board RAM, leaving the physical address in edx. Jumps to the fallback otherwise. */
+void i860_cpu_device::jit_emit_translate(UINT8*& code, jit_slow& slow, int size, bool is_write) {
+    if(size > 1) {
+        jit_emit8(code, 0xF7); jit_emit8(code, 0xC1); jit_emit32(code, size - 1); // test ecx, size-1
+        jit_emit_jcc_slow(code, slow, JIT_CC_NZ);
+    }
+
+    /* With DIRBASE.ATE, hit in the current TLB way with a PTE that needs none of the fault checks */
+    jit_emit8(code, 0x41); jit_emit8(code, 0xF6);                   // test byte cregs[CR_DIRBASE], 1
+    jit_emit_mem(code, 0, JIT_R13, CR_DIRBASE * 4);
+    jit_emit8(code, 0x01);
+    UINT8* phys = code;
+    jit_emit8(code, 0x74); jit_emit8(code, 0);                      // jz phys
+    jit_emit8(code, 0x89); jit_emit8(code, 0xC8);                   // mov eax, ecx
+    jit_emit8(code, 0xC1); jit_emit8(code, 0xE8); jit_emit8(code, 12); // shr eax, 12
+    jit_emit8(code, 0x83); jit_emit8(code, 0xE0); jit_emit8(code, 0x0F); // and eax, 15
+    jit_emit8(code, 0x8B); jit_emit_cpu(code, JIT_EDX, JIT_OFS(m_way)); // mov edx, m_way
+    jit_emit8(code, 0xC1); jit_emit8(code, 0xE2); jit_emit8(code, I860_TLB_SETS); // shl edx, I860_TLB_SETS
+    jit_emit8(code, 0x01); jit_emit8(code, 0xC2);                   // add edx, eax
+    jit_emit8(code, 0x8B); jit_emit8(code, 0xB4); jit_emit8(code, 0x93); // mov esi, m_tlb_vaddr[rdx]
+    jit_emit32(code, JIT_OFS(m_tlb_vaddr));
+    jit_emit8(code, 0x89); jit_emit8(code, 0xC8);                   // mov eax, ecx
+    jit_emit8(code, 0x31); jit_emit8(code, 0xF0);                   // xor eax, esi
+    jit_emit8(code, 0xA9); jit_emit32(code, 0xFFFF0000);            // test eax, TLB_TAG_MASK
+    jit_emit_jcc_slow(code, slow, JIT_CC_NZ);
+    jit_emit8(code, 0x41); jit_emit8(code, 0x8B);                   // mov eax, cregs[CR_PSR]
+    jit_emit_mem(code, JIT_EAX, JIT_R13, CR_PSR * 4);
+    jit_emit8(code, 0xC1); jit_emit8(code, 0xE8); jit_emit8(code, 4); // shr eax, 4 (PSR.U to PTE_U)
+    jit_emit8(code, 0x83); jit_emit8(code, 0xE0); jit_emit8(code, 0x04); // and eax, PTE_U
+    jit_emit8(code, 0x83); jit_emit8(code, 0xC8);                   // or eax, PTE_P [| PTE_W | PTE_D]
+    jit_emit8(code, is_write ? 0x43 : 0x01);
+    jit_emit8(code, 0x21); jit_emit8(code, 0xC6);                   // and esi, eax
+    jit_emit8(code, 0x39); jit_emit8(code, 0xC6);                   // cmp esi, eax
+    jit_emit_jcc_slow(code, slow, JIT_CC_NZ);
+    jit_emit8(code, 0x8B); jit_emit8(code, 0xB4); jit_emit8(code, 0x93); // mov esi, m_tlb_paddr[rdx]
+    jit_emit32(code, JIT_OFS(m_tlb_paddr));
+    jit_emit8(code, 0x81); jit_emit8(code, 0xE6); jit_emit32(code, 0xFFFFF000); // and esi, TLB_PAGE_MASK
+    jit_emit8(code, 0x81); jit_emit8(code, 0xE1); jit_emit32(code, 0x00000FFF); // and ecx, TLB_OFF_MASK
+    jit_emit8(code, 0x09); jit_emit8(code, 0xF1);                   // or ecx, esi
+    assert(code - (phys + 2) < 128);
+    phys[1] = code - (phys + 2);
+
+    /* Host page of board RAM like nd_ram_page() */
+    jit_emit8(code, 0x89); jit_emit8(code, 0xC8);                   // mov eax, ecx
+    jit_emit8(code, 0xC1); jit_emit8(code, 0xE8); jit_emit8(code, 28); // shr eax, 28
+    jit_emit8(code, 0x83); jit_emit8(code, 0xF8); jit_emit8(code, 0x0F); // cmp eax, 15
+    jit_emit_jcc_slow(code, slow, JIT_CC_NZ);
+    jit_emit8(code, 0x89); jit_emit8(code, 0xC8);                   // mov eax, ecx
+    jit_emit8(code, 0xC1); jit_emit8(code, 0xE8); jit_emit8(code, 16); // shr eax, 16
+    jit_emit8(code, 0x25); jit_emit32(code, ND_PAGES - 1);          // and eax, ND_PAGES-1
+    jit_emit8(code, 0x48); jit_emit8(code, 0xBE);                   // mov rsi, ram_pages
+    jit_emit64(code, (UINT64)(uintptr_t)nd->ram_pages);
+    jit_emit8(code, 0x48); jit_emit8(code, 0x8B); jit_emit8(code, 0x34); jit_emit8(code, 0xC6); // mov rsi, [rsi+rax*8]
+    jit_emit8(code, 0x48); jit_emit8(code, 0x85); jit_emit8(code, 0xF6); // test rsi, rsi
+    jit_emit_jcc_slow(code, slow, JIT_CC_Z);
+
+    /* The little endian rdmem/wrmem functions swap the address within 8 bytes */
+    jit_emit8(code, 0x89); jit_emit8(code, 0xCA);                   // mov edx, ecx
+    if(size < 8) {
+        jit_emit8(code, 0x41); jit_emit8(code, 0xF7);               // test cregs[CR_EPSR], EPSR.BE
+        jit_emit_mem(code, 0, JIT_R13, CR_EPSR * 4);
+        jit_emit32(code, 1 << 23);
+        jit_emit8(code, 0x75); jit_emit8(code, 3);                  // jnz be
+        jit_emit8(code, 0x83); jit_emit8(code, 0xF1); jit_emit8(code, 8 - size); // xor ecx, 8-size
+    }
+    jit_emit8(code, 0x81); jit_emit8(code, 0xE1); jit_emit32(code, ND_PAGE_MASK); // and ecx, ND_PAGE_MASK
+    jit_emit8(code, 0x48); jit_emit8(code, 0x01); jit_emit8(code, 0xCE); // add rsi, rcx
+}
+
+/* Swap the words of a 64 bit access in rax if EPSR.BE is clear (i860_rd64_le/i860_wr64_le) */
+static void jit_emit_swap64_le(UINT8*& code) {
+    jit_emit8(code, 0x41); jit_emit8(code, 0xF7);                   // test cregs[CR_EPSR], EPSR.BE
+    jit_emit_mem(code, 0, JIT_R13, CR_EPSR * 4);
+    jit_emit32(code, 1 << 23);
+    jit_emit8(code, 0x75); jit_emit8(code, 4);                      // jnz be
+    jit_emit8(code, 0x48); jit_emit8(code, 0xC1); jit_emit8(code, 0xC0); jit_emit8(code, 32); // rol rax, 32
+}
+
+/* Translate ld.x, st.x, fld.{l,d} and fst.{l,d}. Returns false if the instruction has no translation. */
+bool i860_cpu_device::jit_native_mem(UINT8*& code, const jit_insn* insn, UINT32 retired) {
+    static const int isizes[4] = {1, 1, 2, 4};
+    static const int fsizes[4] = {8, 4, 16, 4};
+
+    const insn_func func  = insn->func;
+    const UINT32    op    = insn->insn;
+    const int       isrc1 = get_isrc1(op);
+    const int       isrc2 = get_isrc2(op);
+    const int       dest  = get_idest(op);
+    bool reg_form = !(op & 0x04000000);
+    bool is_write = false;
+    bool is_fp    = false;
+    bool auto_inc = false;
+    int  size     = 0;
+    INT32 imm     = sign_ext(get_imm16(op), 16);
+
+    if(func == &i860_cpu_device::insn_ldx) {
+        size = isizes[((op >> 27) & 2) | (op & 1)];
+    } else if(func == &i860_cpu_device::insn_stx) {
+        size     = isizes[((op >> 27) & 2) | (op & 1)];
+        imm      = sign_ext(((op >> 5) & 0xf800) | (op & 0x07ff), 16);
+        reg_form = false;
+        is_write = true;
+    } else if(func == &i860_cpu_device::insn_fldy || func == &i860_cpu_device::insn_fsty) {
+        size     = fsizes[(op >> 1) & 3];
+        is_write = func == &i860_cpu_device::insn_fsty;
+        is_fp    = true;
+        auto_inc = op & 1;
+        /* No pfld, fld.q/fst.q, loads to f0/f1 which the handler clears again or undefined auto-increments */
+        if((op & 0x40000000) || size == 16 || (!(is_write) && dest < 2) || (auto_inc && isrc1 == isrc2))
+            return false;
+    } else
+        return false;
+    imm &= ~(size - 1);
+
+    const INT32 freg = JIT_OFS(m_fregs[4 * dest]);
+    jit_slow    slow = {{0}, 0};
+
+    /* ecx = edi = effective address */
+    jit_emit_load(code, JIT_ECX, isrc2);
+    if(reg_form) {
+        jit_emit_load(code, JIT_EAX, isrc1);
+        jit_emit8(code, 0x01); jit_emit8(code, 0xC1);                   // add ecx, eax
+    } else if(imm) {
+        jit_emit8(code, 0x81); jit_emit8(code, 0xC1); jit_emit32(code, imm); // add ecx, imm
+    }
+    jit_emit8(code, 0x89); jit_emit8(code, 0xCF);                       // mov edi, ecx
+
+#if ENABLE_DEBUGGER
+    /* Console writes caught by dbg_check_wr() */
+    if(func == &i860_cpu_device::insn_stx) {
+        jit_emit8(code, 0x81); jit_emit8(code, 0xFF); jit_emit32(code, 0xF83FE800); // cmp edi, imm
+        jit_emit_jcc_slow(code, slow, JIT_CC_Z);
+        jit_emit8(code, 0x81); jit_emit8(code, 0xFF); jit_emit32(code, 0xF80FF800); // cmp edi, imm
+        jit_emit_jcc_slow(code, slow, JIT_CC_Z);
+    }
+#endif
+    if(EVTRACE_COMPILE_MASK & (1 << EVTRACE_SUB_OF(EV_I860_RD))) {
+        jit_emit8(code, 0x48); jit_emit8(code, 0xB8);                   // mov rax, &EvTrace_Mask
+        jit_emit64(code, (UINT64)(uintptr_t)&EvTrace_Mask);
+        jit_emit8(code, 0xF7); jit_emit8(code, 0x00);                   // test dword [rax], imm
+        jit_emit32(code, 1 << EVTRACE_SUB_OF(EV_I860_RD));
+        jit_emit_jcc_slow(code, slow, JIT_CC_NZ);
+    }
+
+    jit_emit_translate(code, slow, size, is_write);
+#if ENABLE_I860_JIT_VERIFY
+    jit_emit8(code, 0x89); jit_emit_cpu(code, JIT_EDX, JIT_OFS(m_jit_log_addr)); // mov m_jit_log_addr, edx
+#endif
+    if(auto_inc && isrc2) {
+        jit_emit8(code, 0x41); jit_emit8(code, 0x89);                   // mov iregs[isrc2], edi
+        jit_emit_mem(code, JIT_EDI, JIT_R12, isrc2 * 4);
+    }
+
+    if(is_write) {
+        if(is_fp) {
+            if(size == 8) jit_emit8(code, 0x48);
+            jit_emit8(code, 0x8B); jit_emit_cpu(code, JIT_EAX, freg);   // mov rax, fregs[dest]
+        } else
+            jit_emit_load(code, JIT_EAX, isrc1);
+        switch(size) {
+            case 1:
+                jit_emit8(code, 0x88); jit_emit8(code, 0x06);           // mov [rsi], al
+                break;
+            case 2:
+                jit_emit8(code, 0x66); jit_emit8(code, 0xC1); jit_emit8(code, 0xC0); jit_emit8(code, 8); // rol ax, 8
+                jit_emit8(code, 0x66); jit_emit8(code, 0x89); jit_emit8(code, 0x06); // mov [rsi], ax
+                break;
+            case 4:
+                jit_emit8(code, 0x0F); jit_emit8(code, 0xC8);           // bswap eax
+                jit_emit8(code, 0x89); jit_emit8(code, 0x06);           // mov [rsi], eax
+                break;
+            case 8:
+                jit_emit_swap64_le(code);
+                jit_emit8(code, 0x48); jit_emit8(code, 0x0F); jit_emit8(code, 0xC8); // bswap rax
+                jit_emit8(code, 0x48); jit_emit8(code, 0x89); jit_emit8(code, 0x06); // mov [rsi], rax
+                break;
+        }
+#if ENABLE_I860_JIT_VERIFY
+        if(is_fp) {
+            if(size == 8) jit_emit8(code, 0x48);
+            jit_emit8(code, 0x8B); jit_emit_cpu(code, JIT_EAX, freg);   // mov rax, fregs[dest]
+        } else
+            jit_emit_load(code, JIT_EAX, isrc1);
+        jit_emit_log(code, (const void*)&i860_cpu_device::jit_log_native, size, true);
+#endif
+    } else {
+        switch(size) {
+            case 1:
+                jit_emit8(code, 0x0F); jit_emit8(code, 0xB6); jit_emit8(code, 0x06); // movzx eax, byte [rsi]
+                break;
+            case 2:
+                jit_emit8(code, 0x0F); jit_emit8(code, 0xB7); jit_emit8(code, 0x06); // movzx eax, word [rsi]
+                jit_emit8(code, 0x66); jit_emit8(code, 0xC1); jit_emit8(code, 0xC0); jit_emit8(code, 8); // rol ax, 8
+                break;
+            case 4:
+                jit_emit8(code, 0x8B); jit_emit8(code, 0x06);           // mov eax, [rsi]
+                jit_emit8(code, 0x0F); jit_emit8(code, 0xC8);           // bswap eax
+                break;
+            case 8:
+                jit_emit8(code, 0x48); jit_emit8(code, 0x8B); jit_emit8(code, 0x06); // mov rax, [rsi]
+                jit_emit8(code, 0x48); jit_emit8(code, 0x0F); jit_emit8(code, 0xC8); // bswap rax
+                jit_emit_swap64_le(code);
+                break;
+        }
+#if ENABLE_I860_JIT_VERIFY
+        jit_emit_log(code, (const void*)&i860_cpu_device::jit_log_native, size, false);
+#endif
+        if(is_fp) {
+            if(size == 8) jit_emit8(code, 0x48);
+            jit_emit8(code, 0x89); jit_emit_cpu(code, JIT_EAX, freg);   // mov fregs[dest], rax
+        } else {
+            /* The i860 sign-extends 8- or 16-bit integer loads */
+            if(size == 1) {jit_emit8(code, 0x0F); jit_emit8(code, 0xBE); jit_emit8(code, 0xC0);} // movsx eax, al
+            if(size == 2) {jit_emit8(code, 0x0F); jit_emit8(code, 0xBF); jit_emit8(code, 0xC0);} // movsx eax, ax
+            jit_emit_store(code, dest);
+        }
+    }
+
+    jit_emit_slow_path(code, slow, insn, retired);
+    return true;
+}
+
+#if WITH_SOFTFLOAT_I860
+/* xmm[dst] = v1 op v2 with operands of src_dbl precision at cpu offsets, rounded like softfloat to
+   res_dbl precision. Sets PF for a NaN result. */
+static void jit_emit_fop(UINT8*& code, UINT8 op, INT32 v1, INT32 v2, bool src_dbl, bool res_dbl, int dst, int tmp) {
+    const bool dbl = src_dbl || res_dbl;
+
+    jit_emit_sse(code, src_dbl, JIT_LDS, dst, v1);
+    jit_emit_sse(code, src_dbl, JIT_LDS, tmp, v2);
+    if(dbl && !(src_dbl)) {
+        jit_emit_sse_rr(code, false, JIT_CVTS, dst, dst);
+        jit_emit_sse_rr(code, false, JIT_CVTS, tmp, tmp);
+    }
+    jit_emit_sse_rr(code, dbl, op, dst, tmp);
+    if(dbl && !(res_dbl))
+        jit_emit_sse_rr(code, true, JIT_CVTS, dst, dst);
+    if(res_dbl) jit_emit8(code, 0x66);
+    jit_emit8(code, 0x0F); jit_emit8(code, 0x2E);                       // ucomiss/ucomisd dst, dst
+    jit_emit8(code, 0xC0 | (dst << 3) | dst);
+}
+
+/* Copy a value of dbl precision between cpu offsets through xmm1 */
+static void jit_emit_fcopy(UINT8*& code, bool dbl, INT32 dst, INT32 src) {
+    jit_emit_sse(code, dbl, JIT_LDS, 1, src);
+    jit_emit_sse(code, dbl, JIT_STS, 1, dst);
+}
+
+/* Compare a stage status byte with the result precision */
+static void jit_emit_stat_cmp(UINT8*& code, INT32 stat, bool dbl) {
+    jit_emit8(code, 0x80); jit_emit_cpu(code, 7, stat); jit_emit8(code, dbl); // cmp byte stat, dbl
+}
+
+/* Write a stage status byte */
+static void jit_emit_stat_set(UINT8*& code, INT32 stat, bool dbl) {
+    jit_emit8(code, 0xC6); jit_emit_cpu(code, 0, stat); jit_emit8(code, dbl); // mov byte stat, dbl
+}
+#endif
+
+/* Translate [p]fadd, [p]fsub, [p]fmul and pf[m]am/pf[m]sm. Returns false if the instruction has no translation. */
+bool i860_cpu_device::jit_native_fp(UINT8*& code, const jit_insn* insn, UINT32 retired) {
+#if WITH_SOFTFLOAT_I860
+    const insn_func func    = insn->func;
+    const UINT32    op      = insn->insn;
+    const int       fsrc1   = get_fsrc1(op);
+    const int       fsrc2   = get_fsrc2(op);
+    const int       fdest   = get_fdest(op);
+    const bool      src_dbl = op & 0x100;
+    const bool      res_dbl = op & 0x080;
+    const bool      piped   = op & 0x400;
+
+    const bool is_add  = func == &i860_cpu_device::insn_fadd_sub;
+    const bool is_mul  = func == &i860_cpu_device::insn_fmul;
+    const bool is_dual = func == &i860_cpu_device::insn_dualop;
+    if(!(is_add || is_mul || is_dual))
+        return false;
+    /* No .ds, pfmul3.dd or flushed denormals */
+    if((src_dbl && !(res_dbl)) || (is_mul && (op & 4)) || m_fpcs.flush_to_zero || m_fpcs.flush_inputs_to_zero)
+        return false;
+
+    /* Last stages and the ones which end up in FSR */
+    const int mstages = src_dbl ? 2 : 3;
+    const INT32 a_last = JIT_OFS(m_A[2].val);
+    const INT32 m_last = JIT_OFS(m_M[mstages - 1].val);
+    const INT32 freg1  = JIT_OFS(m_fregs[4 * fsrc1]);
+    const INT32 freg2  = JIT_OFS(m_fregs[4 * fsrc2]);
+    const INT32 fregd  = JIT_OFS(m_fregs[4 * fdest]);
+    jit_slow    slow   = {{0}, 0};
+
+    jit_emit8(code, 0x80); jit_emit_cpu(code, 7, JIT_OFS(m_fpcs.float_rounding_mode)); // cmp byte rounding mode
+    jit_emit8(code, float_round_nearest_even);
+    jit_emit_jcc_slow(code, slow, JIT_CC_NZ);
+
+    /* The pipeline stages which are read have to hold results of res_dbl precision */
+    const bool uses_a = (is_add && piped) || is_dual;
+    const bool uses_m = (is_mul && piped) || is_dual;
+    if(uses_a) {
+        jit_emit_stat_cmp(code, JIT_OFS(m_A[2].stat.arp), res_dbl);
+        jit_emit_jcc_slow(code, slow, JIT_CC_NZ);
+        jit_emit_stat_cmp(code, JIT_OFS(m_A[1].stat.arp), res_dbl);
+        jit_emit_jcc_slow(code, slow, JIT_CC_NZ);
+    }
+    if(uses_m) {
+        jit_emit_stat_cmp(code, JIT_OFS(m_M[mstages - 1].stat.mrp), res_dbl);
+        jit_emit_jcc_slow(code, slow, JIT_CC_NZ);
+        jit_emit_stat_cmp(code, JIT_OFS(m_M[mstages - 2].stat.mrp), res_dbl);
+        jit_emit_jcc_slow(code, slow, JIT_CC_NZ);
+    }
+
+    /* Operands, pipelined results in xmm0 (multiplier) and xmm2 (adder) */
+    if(is_add || is_mul) {
+        const INT32 last = is_add ? a_last : m_last;
+        INT32 v1 = freg1;
+        INT32 v2 = freg2;
+        /* Bypass of the last stage, reads as 0 if its precision differs from the sources */
+        if(piped && fdest != 0 && ((is_add && fsrc1 == fdest) || fsrc2 == fdest)) {
+            if(src_dbl != res_dbl)
+                return false;
+            if(is_add && fsrc1 == fdest) v1 = last;
+            if(fsrc2 == fdest)           v2 = last;
+        }
+        jit_emit_fop(code, is_mul ? JIT_MULS : (op & 1) ? JIT_SUBS : JIT_ADDS, v1, v2, src_dbl, res_dbl, 0, 1);
+        jit_emit_jcc_slow(code, slow, JIT_CC_P);
+
+        if(!(piped)) {
+            if(fdest > 1)
+                jit_emit_sse(code, res_dbl, JIT_STS, 0, fregd);
+        } else if(is_add) {
+            jit_emit_creg_const(code, CR_FSR, 0x20000000, res_dbl);
+            if(fdest > 1)
+                jit_emit_fcopy(code, res_dbl, fregd, a_last);
+            jit_emit_movups(code, false, 1, JIT_OFS(m_A[1]));
+            jit_emit_movups(code, true,  1, JIT_OFS(m_A[2]));
+            jit_emit_movups(code, false, 1, JIT_OFS(m_A[0]));
+            jit_emit_movups(code, true,  1, JIT_OFS(m_A[1]));
+            jit_emit_sse(code, res_dbl, JIT_STS, 0, JIT_OFS(m_A[0].val));
+            jit_emit_stat_set(code, JIT_OFS(m_A[0].stat.arp), res_dbl);
+        } else {
+            jit_emit_creg_const(code, CR_FSR, 0x10000000, res_dbl);
+            if(fdest > 1)
+                jit_emit_fcopy(code, res_dbl, fregd, m_last);
+            if(mstages == 3) {
+                jit_emit_movups(code, false, 1, JIT_OFS(m_M[1]));
+                jit_emit_movups(code, true,  1, JIT_OFS(m_M[2]));
+            }
+            jit_emit_movups(code, false, 1, JIT_OFS(m_M[0]));
+            jit_emit_movups(code, true,  1, JIT_OFS(m_M[1]));
+            jit_emit_sse(code, res_dbl, JIT_STS, 0, JIT_OFS(m_M[0].val));
+            jit_emit_stat_set(code, JIT_OFS(m_M[0].stat.mrp), res_dbl);
+        }
+    } else {
+        const bool is_pfam = op & 0x400;
+        const int  dpc     = op & 0xf;
+        int m_op1 = src_opers[dpc].M_unit_op1;
+        int m_op2 = src_opers[dpc].M_unit_op2;
+        int a_op1 = src_opers[dpc].A_unit_op1;
+        int a_op2 = src_opers[dpc].A_unit_op2;
+        if(!(is_pfam)) {
+            m_op2 = (m_op2 & FLAGM) ? OP_MPIPE : m_op2;
+            a_op1 = (a_op1 & FLAGM) ? OP_MPIPE : a_op1;
+            a_op2 = (a_op2 & FLAGM) ? OP_MPIPE : a_op2;
+        }
+        const INT32 last = is_pfam ? a_last : m_last;
+
+        /* Like get_fval_from_optype_s/d() */
+        INT32 opnd[4];
+        const int  optype[4] = {m_op1, m_op2, a_op1, a_op2};
+        const bool dbl[4]    = {src_dbl, src_dbl, res_dbl, res_dbl};
+        for(int i = 0; i < 4; i++) {
+            switch(optype[i] & ~FLAGM) {
+                case OP_SRC1:  opnd[i] = freg1;                                  break;
+                case OP_SRC2:  opnd[i] = freg2;                                  break;
+                case OP_KI:    opnd[i] = JIT_OFS(m_KI);                          break;
+                case OP_KR:    opnd[i] = JIT_OFS(m_KR);                          break;
+                case OP_T:     opnd[i] = JIT_OFS(m_T);                           break;
+                case OP_MPIPE: opnd[i] = JIT_OFS(m_M[dbl[i] ? 1 : 2].val);       break;
+                case OP_APIPE: opnd[i] = a_last;                                 break;
+                default:       return false;
+            }
+        }
+        if(m_op2 == OP_SRC2 && fdest != 0 && fsrc2 == fdest) {
+            if(src_dbl != res_dbl)
+                return false;
+            opnd[1] = last;
+        }
+        if(a_op1 == OP_SRC1 && fdest != 0 && fsrc1 == fdest) opnd[2] = last;
+        if(a_op2 == OP_SRC2 && fdest != 0 && fsrc2 == fdest) opnd[3] = last;
+
+        jit_emit_fop(code, JIT_MULS, opnd[0], opnd[1], src_dbl, res_dbl, 0, 1);
+        jit_emit_jcc_slow(code, slow, JIT_CC_P);
+        jit_emit_fop(code, (op & 0x10) ? JIT_SUBS : JIT_ADDS, opnd[2], opnd[3], res_dbl, res_dbl, 2, 1);
+        jit_emit_jcc_slow(code, slow, JIT_CC_P);
+
+        if(src_opers[dpc].T_loaded)
+            jit_emit_fcopy(code, res_dbl, JIT_OFS(m_T), m_last);
+        if(src_opers[dpc].K_loaded)
+            jit_emit_fcopy(code, src_dbl, JIT_OFS(m_op1 == OP_KI ? m_KI : m_KR), freg1);
+        if(fdest > 1)
+            jit_emit_fcopy(code, res_dbl, fregd, last);
+
+        jit_emit_creg_const(code, CR_FSR, 0x10000000, res_dbl);
+        if(mstages == 3) {
+            jit_emit_movups(code, false, 1, JIT_OFS(m_M[1]));
+            jit_emit_movups(code, true,  1, JIT_OFS(m_M[2]));
+        }
+        jit_emit_movups(code, false, 1, JIT_OFS(m_M[0]));
+        jit_emit_movups(code, true,  1, JIT_OFS(m_M[1]));
+        jit_emit_sse(code, res_dbl, JIT_STS, 0, JIT_OFS(m_M[0].val));
+        jit_emit_stat_set(code, JIT_OFS(m_M[0].stat.mrp), res_dbl);
+
+        jit_emit_creg_const(code, CR_FSR, 0x20000000, res_dbl);
+        jit_emit_movups(code, false, 1, JIT_OFS(m_A[1]));
+        jit_emit_movups(code, true,  1, JIT_OFS(m_A[2]));
+        jit_emit_movups(code, false, 1, JIT_OFS(m_A[0]));
+        jit_emit_movups(code, true,  1, JIT_OFS(m_A[1]));
+        jit_emit_sse(code, res_dbl, JIT_STS, 2, JIT_OFS(m_A[0].val));
+        jit_emit_stat_set(code, JIT_OFS(m_A[0].stat.arp), res_dbl);
+    }
+
+    jit_emit_slow_path(code, slow, insn, retired);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void i860_cpu_device::jit_compile(jit_trace& trace) {
+    if(m_jit_code_used + (I860_JIT_MAX_INSNS + 1) * I860_JIT_INSN_CODE > I860_JIT_CODE_SZ ||
+       m_jit_insns_used + I860_JIT_MAX_INSNS > I860_JIT_INSNS) {
+        const UINT32 vaddr = trace.vaddr;
+        jit_flush();
+        trace.vaddr = vaddr;
+    }
+
+    UINT8*    const start = m_jit_code + m_jit_code_used;
+    UINT8*    code        = start;
+    jit_insn* insns       = m_jit_insns + m_jit_insns_used;
+    UINT32    count       = 0;
+    UINT32    pc          = trace.vaddr;
+
+    jit_emit_prologue(code);
+
+    while(count < I860_JIT_MAX_INSNS && !((pc ^ trace.vaddr) & I860_PAGE_FRAME_MASK)) {
+        const UINT32 vaddr = pc & ~7;
+        const int    cidx  = (vaddr>>3) & I860_ICACHE_MASK;
+        const int    word  = (pc >> 2) & 1;
+        if(m_icache_vaddr[cidx] != vaddr)
+            break;
+
+        const insn_func func = m_icache_func[cidx][word];
+        const UINT32    insn = m_icache[cidx] >> (word * 32);
+
+        /* Leave DIM switching and control register accesses to run_cycle() */
+        if(m_icache_flags[cidx][word] & (PREDEC_FP_DIM | PREDEC_FNOP_DIM))
+            break;
+        if(func == &i860_cpu_device::insn_ld_ctrl || func == &i860_cpu_device::insn_st_ctrl)
+            break;
+        if(((insn >> 26) & 0x3f) == 0x13) // core escape (lock, unlock, calli, intovr)
+            break;
+
+        insns[count].func = func;
+        insns[count].insn = insn;
+        insns[count].pc   = pc;
+
+        UINT8* const insn_code = code;
+        if(!(jit_native(code, func, insn)) &&
+           !(jit_native_mem(code, &insns[count], count + 1)) &&
+           !(jit_native_fp(code, &insns[count], count + 1)))
+            jit_emit_call(code, (const void*)&i860_cpu_device::jit_exec, &insns[count], count + 1);
+        assert(code - insn_code <= (ptrdiff_t)I860_JIT_INSN_CODE);
+
+        pc += 4;
+        count++;
+    }
+
+    if(count == 0) {
+        trace.hits = 0;
+        return;
+    }
+
+    /* mov dword [r14], pc */
+    jit_emit8(code, 0x41); jit_emit8(code, 0xC7); jit_emit8(code, 0x06);
+    jit_emit32(code, pc);
+    jit_emit_imm(code, JIT_EAX, count);
+    jit_emit_epilogue(code);
+
+    m_jit_code_used  += code - start;
+    m_jit_insns_used += count;
+
+    trace.func  = (jit_func)start;
+    trace.insns = insns;
+    trace.count = count;
+}
+
+/* Run a compiled trace at the current PC. Returns the number of retired instructions or 0 if the cycle has to be interpreted. */
+int i860_cpu_device::jit_run() {
+    if(m_dim != DIM_NONE || (m_flow & DIM_OP) || GET_PSR_KNF())
+        return 0;
+#if ENABLE_DEBUGGER
+    if(m_single_stepping)
+        return 0;
+#endif
+
+    jit_trace& trace = m_jit_traces[(m_pc >> 2) & I860_JIT_TRACE_MASK];
+    if(trace.vaddr != m_pc) {
+        trace.vaddr = m_pc;
+        trace.hits  = 0;
+        trace.func  = NULL;
+        return 0;
+    }
+    if(!(trace.func)) {
+        if(++trace.hits < I860_JIT_HOT)
+            return 0;
+        jit_compile(trace);
+        if(!(trace.func))
+            return 0;
+    }
+
+#if ENABLE_PERF_COUNTERS
+    /* Handler calls are counted in m_insn_decoded by decode_exec() */
+    const UINT64 decoded = m_insn_decoded;
+#endif
+
+#if ENABLE_I860_JIT_VERIFY
+    const int retired = jit_verify(trace);
+#else
+    const int retired = trace.func(this, m_iregs, m_cregs, &m_pc);
+#endif
+
+#if ENABLE_PERF_COUNTERS
+    m_jit_native += retired - (m_insn_decoded - decoded);
+#endif
+
+    /* The trapping instruction left its address in m_pc */
+    if (PENDING_TRAP())
+        handle_trap(m_pc);
+
+    end_cycle();
+    return retired;
+}
+
+#if ENABLE_I860_JIT_VERIFY
+void i860_cpu_device::jit_log(UINT32 addr, int size, const UINT32* data, bool write) {
+    if(m_jit_log_count == (int)(sizeof(m_jit_log) / sizeof(m_jit_log[0]))) {
+        if(m_jit_log_err < 0) m_jit_log_err = m_jit_log_count;
+        return;
+    }
+    jit_access& a = m_jit_log[m_jit_log_count++];
+    a.addr  = addr;
+    a.size  = size;
+    a.write = write;
+    memcpy(a.data, data, size);
+}
+
+/* Writes of the interpreter are compared with the logged ones, reads return the logged data */
+void i860_cpu_device::jit_replay(UINT32 addr, int size, UINT32* data, bool write) {
+    const jit_access* a = m_jit_log_pos < m_jit_log_count ? &m_jit_log[m_jit_log_pos] : NULL;
+    if(m_jit_log_err < 0 && (!(a) || a->addr != addr || a->size != (UINT32)size || a->write != write ||
+                             (write && memcmp(a->data, data, size)))) {
+        m_jit_log_err          = m_jit_log_pos;
+        m_jit_log_interp.addr  = addr;
+        m_jit_log_interp.size  = size;
+        m_jit_log_interp.write = write;
+        memcpy(m_jit_log_interp.data, data, write ? size : 0);
+    }
+    if(!(write)) {
+        if(a && a->size == (UINT32)size) memcpy(data, a->data, size);
+        else                             memset(data, 0, size);
+    }
+    m_jit_log_pos++;
+}
+
+UINT64 i860_cpu_device::jit_log_native(i860_cpu_device* cpu, UINT64 val, UINT32 size, UINT32 write) {
+    cpu->jit_log(cpu->m_jit_log_addr, size, (const UINT32*)&val, write);
+    return val;
+}
+
+template<int SIZE> void i860_cpu_device::jit_log_rd(const NextDimension* nd, UINT32 addr, UINT32* val) {
+    i860_cpu_device& cpu = ((NextDimension*)nd)->i860;
+    cpu.m_jit_rdmem[SIZE](nd, addr, val);
+    cpu.jit_log(addr, SIZE, val, false);
+}
+
+template<int SIZE> void i860_cpu_device::jit_log_wr(const NextDimension* nd, UINT32 addr, const UINT32* val) {
+    i860_cpu_device& cpu = ((NextDimension*)nd)->i860;
+    cpu.m_jit_wrmem[SIZE](nd, addr, val);
+    cpu.jit_log(addr, SIZE, val, true);
+}
+
+template<int SIZE> void i860_cpu_device::jit_replay_rd(const NextDimension* nd, UINT32 addr, UINT32* val) {
+    ((NextDimension*)nd)->i860.jit_replay(addr, SIZE, val, false);
+}
+
+template<int SIZE> void i860_cpu_device::jit_replay_wr(const NextDimension* nd, UINT32 addr, const UINT32* val) {
+    ((NextDimension*)nd)->i860.jit_replay(addr, SIZE, (UINT32*)val, true);
+}
+
+/* Route the memory accesses of the handlers through the log or its replay */
+void i860_cpu_device::jit_mem_log(bool replay) {
+    if(replay) {
+        rdmem[1]  = jit_replay_rd<1>;  wrmem[1]  = jit_replay_wr<1>;
+        rdmem[2]  = jit_replay_rd<2>;  wrmem[2]  = jit_replay_wr<2>;
+        rdmem[4]  = jit_replay_rd<4>;  wrmem[4]  = jit_replay_wr<4>;
+        rdmem[8]  = jit_replay_rd<8>;  wrmem[8]  = jit_replay_wr<8>;
+        rdmem[16] = jit_replay_rd<16>; wrmem[16] = jit_replay_wr<16>;
+    } else {
+        rdmem[1]  = jit_log_rd<1>;     wrmem[1]  = jit_log_wr<1>;
+        rdmem[2]  = jit_log_rd<2>;     wrmem[2]  = jit_log_wr<2>;
+        rdmem[4]  = jit_log_rd<4>;     wrmem[4]  = jit_log_wr<4>;
+        rdmem[8]  = jit_log_rd<8>;     wrmem[8]  = jit_log_wr<8>;
+        rdmem[16] = jit_log_rd<16>;    wrmem[16] = jit_log_wr<16>;
+    }
+}
+
+/* State a trace can change */
+#define JIT_STATE(X) X(m_iregs) X(m_fregs) X(m_cregs) X(m_pc) X(m_delay_slot_pc) X(m_flow) X(m_dim) \
+    X(m_dim_cc) X(m_dim_cc_valid) X(m_KR) X(m_KI) X(m_T) X(m_merge) X(m_A) X(m_M) X(m_L) X(m_G) \
+    X(m_tlb_vaddr) X(m_tlb_paddr) X(m_way) X(m_fpcs)
+#define JIT_STATE_FIELD(m)   decltype(i860_cpu_device::m) m;
+#define JIT_STATE_SAVE(m)    memcpy(&s.m, &m, sizeof(m));
+#define JIT_STATE_RESTORE(m) memcpy(&m, &s.m, sizeof(m));
+
+/* Run a trace and the interpreter on the same state and compare the results. The interpreter
+   executes the instructions the trace retired, its memory accesses are checked against and
+   served from the ones of the trace, so MMIO is only accessed once. */
+int i860_cpu_device::jit_verify(const jit_trace& trace) {
+    struct state {
+        JIT_STATE(JIT_STATE_FIELD)
+    } before, jit;
+    const jit_insn* insns = trace.insns; // the trace may get flushed by a handler
+    const UINT32    count = trace.count;
+
+    {state& s = before; JIT_STATE(JIT_STATE_SAVE)}
+
+    memcpy(m_jit_rdmem, rdmem, sizeof(rdmem));
+    memcpy(m_jit_wrmem, wrmem, sizeof(wrmem));
+    m_jit_log_count = 0;
+    m_jit_log_pos   = 0;
+    m_jit_log_err   = -1;
+
+    jit_mem_log(false);
+    const int retired = trace.func(this, m_iregs, m_cregs, &m_pc);
+
+    {state& s = jit; JIT_STATE(JIT_STATE_SAVE)}
+    {state& s = before; JIT_STATE(JIT_STATE_RESTORE)}
+
+#if ENABLE_PERF_COUNTERS
+    const UINT64 decoded = m_insn_decoded;
+#endif
+    jit_mem_log(true);
+    int executed = 0;
+    while(executed < retired) {
+        m_pc = insns[executed].pc;
+        decode_exec(insns[executed].insn);
+        executed++;
+        if(m_flow & (TRAP_MASK | PC_UPDATED))
+            break;
+    }
+    if(!(m_flow & (TRAP_MASK | PC_UPDATED)))
+        m_pc += 4;
+    memcpy(rdmem, m_jit_rdmem, sizeof(rdmem));
+    memcpy(wrmem, m_jit_wrmem, sizeof(wrmem));
+#if ENABLE_PERF_COUNTERS
+    m_insn_decoded = decoded;
+#endif
+
+    /* Softfloat exception flags are not kept by the trace */
+    m_fpcs = jit.m_fpcs;
+
+    bool differs = executed != retired || m_jit_log_err >= 0 || m_jit_log_pos != m_jit_log_count ||
+                   ((jit.m_flow ^ m_flow) & (TRAP_MASK | PC_UPDATED));
+#define JIT_STATE_CMP(m) differs |= memcmp(&jit.m, &m, sizeof(m)) != 0;
+    JIT_STATE_CMP(m_iregs) JIT_STATE_CMP(m_fregs) JIT_STATE_CMP(m_cregs) JIT_STATE_CMP(m_pc)
+    JIT_STATE_CMP(m_delay_slot_pc) JIT_STATE_CMP(m_dim) JIT_STATE_CMP(m_dim_cc) JIT_STATE_CMP(m_dim_cc_valid)
+    JIT_STATE_CMP(m_KR) JIT_STATE_CMP(m_KI) JIT_STATE_CMP(m_T) JIT_STATE_CMP(m_merge) JIT_STATE_CMP(m_way)
+#undef JIT_STATE_CMP
+    /* Pipeline stages without their padding */
+    for(int i = 0; i < 3; i++) {
+        differs |= jit.m_A[i].val.d != m_A[i].val.d || jit.m_A[i].stat.arp != m_A[i].stat.arp;
+        differs |= jit.m_M[i].val.d != m_M[i].val.d || jit.m_M[i].stat.mrp != m_M[i].stat.mrp;
+        differs |= jit.m_L[i].val.d != m_L[i].val.d || jit.m_L[i].stat.lrp != m_L[i].stat.lrp;
+    }
+    differs |= jit.m_G.val.d != m_G.val.d || jit.m_G.stat.irp != m_G.stat.irp;
+
+    if(differs) {
+        Log_Printf(LOG_WARN, "[i860] Trace at %08X (%d instructions, %d retired) differs from interpreter",
+                   before.m_pc, count, retired);
+        if(executed != retired)
+            Log_Printf(LOG_WARN, "[i860]   left after %d instructions, expected %d", retired, executed);
+        if(m_jit_log_err >= 0) {
+            const jit_access& i = m_jit_log_interp;
+            if(m_jit_log_err < m_jit_log_count) {
+                const jit_access& a = m_jit_log[m_jit_log_err];
+                Log_Printf(LOG_WARN, "[i860]   access %d: %s%d at %08X (%08X), expected %s%d at %08X (%08X)", m_jit_log_err,
+                           a.write ? "wr" : "rd", a.size * 8, a.addr, *(const UINT32*)a.data,
+                           i.write ? "wr" : "rd", i.size * 8, i.addr, *(const UINT32*)i.data);
+            } else
+                Log_Printf(LOG_WARN, "[i860]   access %d: missing, expected %s%d at %08X", m_jit_log_err,
+                           i.write ? "wr" : "rd", i.size * 8, i.addr);
+        } else if(m_jit_log_pos != m_jit_log_count)
+            Log_Printf(LOG_WARN, "[i860]   %d accesses, expected %d", m_jit_log_count, m_jit_log_pos);
+        for(int i = 0; i < 32; i++) {
+            if(jit.m_iregs[i] != m_iregs[i])
+                Log_Printf(LOG_WARN, "[i860]   r%d=%08X, expected %08X", i, jit.m_iregs[i], m_iregs[i]);
+        }
+        for(int i = 0; i < 32; i++) {
+            const UINT32 val = *(const UINT32*)&jit.m_fregs[i * 4];
+            const UINT32 exp = *(const UINT32*)&m_fregs[i * 4];
+            if(val != exp)
+                Log_Printf(LOG_WARN, "[i860]   f%d=%08X, expected %08X", i, val, exp);
+        }
+        for(int i = 0; i < 6; i++) {
+            if(jit.m_cregs[i] != m_cregs[i])
+                Log_Printf(LOG_WARN, "[i860]   cr%d=%08X, expected %08X", i, jit.m_cregs[i], m_cregs[i]);
+        }
+        if(jit.m_pc != m_pc)
+            Log_Printf(LOG_WARN, "[i860]   pc=%08X, expected %08X", jit.m_pc, m_pc);
+        if((jit.m_flow ^ m_flow) & (TRAP_MASK | PC_UPDATED))
+            Log_Printf(LOG_WARN, "[i860]   flow=%08X, expected %08X", jit.m_flow, m_flow);
+        for(int i = 0; i < 3; i++) {
+            if(jit.m_A[i].val.d != m_A[i].val.d || jit.m_A[i].stat.arp != m_A[i].stat.arp)
+                Log_Printf(LOG_WARN, "[i860]   A%d=%016llX/%d, expected %016llX/%d", i,
+                           (unsigned long long)jit.m_A[i].val.d, jit.m_A[i].stat.arp, (unsigned long long)m_A[i].val.d, m_A[i].stat.arp);
+            if(jit.m_M[i].val.d != m_M[i].val.d || jit.m_M[i].stat.mrp != m_M[i].stat.mrp)
+                Log_Printf(LOG_WARN, "[i860]   M%d=%016llX/%d, expected %016llX/%d", i,
+                           (unsigned long long)jit.m_M[i].val.d, jit.m_M[i].stat.mrp, (unsigned long long)m_M[i].val.d, m_M[i].stat.mrp);
+        }
+        if(memcmp(&jit.m_KR, &m_KR, sizeof(m_KR)) || memcmp(&jit.m_KI, &m_KI, sizeof(m_KI)) || memcmp(&jit.m_T, &m_T, sizeof(m_T)))
+            Log_Printf(LOG_WARN, "[i860]   KR/KI/T differ");
+    }
+    return retired;
+}
+#endif
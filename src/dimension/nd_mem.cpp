@@ -135,8 +135,15 @@ public:
 
 class ND_VRAM : public ND_Addrbank {
     Uint8* base;
+    volatile Uint8* dirty;
+    
+    /* unaligned accesses reach up to addr+5 */
+    inline void mark_dirty(Uint32 addr) const {
+        dirty[addr>>ND_VRAM_DIRTY_SHIFT] = 1;
+        dirty[((addr+5)&ND_VRAM_MASK)>>ND_VRAM_DIRTY_SHIFT] = 1;
+    }
 public:
-    ND_VRAM(NextDimension* nd) : ND_Addrbank(nd), base(nd->vram) {
+    ND_VRAM(NextDimension* nd) : ND_Addrbank(nd), base(nd->vram), dirty(nd->vram_dirty) {
         // sanity checks for ARGB mem access
         lput(0, 0x12345678);
         if(lget(0) != 0x12345678) {fprintf(stderr, "ND_VRAM: 32 bit access check failed\n");  goto error;}
@@ -183,6 +190,7 @@ public:
             case 2: base[addr-2] = l >> 24; base[addr+1] = l >> 16; base[addr+4] = l >> 8; base[addr+3] = l; break;
             case 3: base[addr+0] = l >> 24; base[addr+3] = l >> 16; base[addr+2] = l >> 8; base[addr+1] = l; break;
         }
+        mark_dirty(addr);
     }
 
     Uint32 wget(Uint32 addr) const {
@@ -204,6 +212,7 @@ public:
             case 2: base[addr-2] = w >> 8; base[addr+1] = w; break;
             case 3: base[addr+0] = w >> 8; base[addr+3] = w; break;
         }
+        mark_dirty(addr);
     }
 
     Uint32 bget(Uint32 addr) const {
@@ -225,6 +234,7 @@ public:
             case 2: base[addr-2] = b; break;
             case 3: base[addr+0] = b; break;
         }
+        mark_dirty(addr);
     }
 };
 
@@ -449,10 +459,17 @@ void NextDimension::map_banks (ND_Addrbank *bank, int start, int size) {
     return;
 }
 
+void NextDimension::map_pages (Uint8** pages, Uint8* base, Uint32 mask, int start, int size) {
+    for (int bnr = start; bnr < start + size; bnr++)
+        pages[nd_pageindex((Uint32)bnr << 16)] = base + (((Uint32)bnr << 16) & mask);
+}
+
 void NextDimension::init_mem_banks(void) {
     ND_Addrbank* nd_illegal_bank = new ND_Addrbank(this);
     for (int i = 0; i < 65536; i++)
         nd_put_mem_bank(i<<16, nd_illegal_bank);
+    memset(ram_pages,  0, sizeof(ram_pages));
+    memset(vram_pages, 0, sizeof(vram_pages));
 }
 
 #define write_log printf
@@ -473,6 +490,7 @@ void NextDimension::mem_init(void) {
         if (ConfigureParams.Dimension.board[ND_NUM(slot)].nMemoryBankSize[bank]) {
             bankmask[bank] = ND_RAM_BANKMASK|((ConfigureParams.Dimension.board[ND_NUM(slot)].nMemoryBankSize[bank]<<20)-1);
             map_banks(new ND_RAM(this, bank), (ND_RAM_START+(bank*ND_RAM_BANKSIZE))>>16, ND_RAM_BANKSIZE >> 16);
+            map_pages(ram_pages, ram, bankmask[bank], (ND_RAM_START+(bank*ND_RAM_BANKSIZE))>>16, ND_RAM_BANKSIZE >> 16);
             write_log("[ND] Slot %i: Mapping main memory bank%d at $%08x: %iMB\n", slot, bank,
                       (ND_RAM_START+(bank*ND_RAM_BANKSIZE)), ConfigureParams.Dimension.board[ND_NUM(slot)].nMemoryBankSize[bank]);
         } else {
@@ -486,6 +504,7 @@ void NextDimension::mem_init(void) {
     write_log("[ND] Slot %i: Mapping video memory at $%08x: %iMB\n", slot,
               ND_VRAM_START, ND_VRAM_SIZE/(1024*1024));
     map_banks(new ND_VRAM(this), ND_VRAM_START>>16, (4*ND_VRAM_SIZE)>>16);
+    map_pages(vram_pages, vram, ND_VRAM_MASK, ND_VRAM_START>>16, (4*ND_VRAM_SIZE)>>16);
     
 	write_log("[ND] Slot %i: Mapping ROM at $%08x: %ikB\n", slot,
               ND_EEPROM_START, ND_EEPROM_SIZE/1024);
@@ -29,6 +29,17 @@ typedef void (*nd_mem_put_func)(int, uaecptr, uae_u32) REGPARAM;
 #define nd_bankindex(addr) (((uaecptr)(addr)) >> 16)
 #define nd_put_mem_bank(addr, b) (mem_banks[nd_bankindex(addr)] = (b))
 
+/* Host page tables for direct RAM and VRAM access from the i860. They only
+ * cover the board space at 0xF0000000, addresses outside of it have no host
+ * page and go through the memory banks. */
+#define ND_PAGE_SIZE    0x00010000
+#define ND_PAGE_MASK    0x0000FFFF
+#define ND_PAGES        (ND_BOARD_SIZE/ND_PAGE_SIZE)
+
+#define nd_pageindex(addr) ((((uaecptr)(addr)) & ND_BOARD_MASK) >> 16)
+#define nd_get_page(pages, addr) \
+    ((((uaecptr)(addr)) & ND_BOARD_BITS) == ND_BOARD_BITS ? (pages)[nd_pageindex(addr)] : NULL)
+
 #ifdef __cplusplus
 }
 
@@ -48,6 +59,7 @@ public:
     virtual void bput(Uint32 addr, Uint32 val) const;
     
     ND_Addrbank(NextDimension* nd);
+    virtual ~ND_Addrbank() {}
 };
 
 #endif /* __cplusplus */
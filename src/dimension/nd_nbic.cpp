@@ -6,6 +6,7 @@
 #include "nd_nbic.hpp"
 #include "dimension.hpp"
 #include "log.h"
+#include "memorySnapShot.h"
 
 /* NeXTdimention NBIC */
 #define ND_NBIC_INTR    0x80
@@ -56,10 +57,7 @@ void  NBIC::write(int addr, Uint8 val) {
         case 0x0C:
             Log_Printf(ND_LOG_IO_WR, "[ND] Slot %i: NBIC Interrupt mask write %02X at %08X", slot,val,addr);
             intmask = val;
-            if(val & ND_NBIC_INTR)
-                remInterMask |= 1 << slot;
-            else
-                remInterMask &= ~(1 << slot);
+            set_slot_bit(&remInterMask, slot, val & ND_NBIC_INTR);
             break;
         case 0x0D:
         case 0x0E:
@@ -133,11 +131,19 @@ void NBIC::bput(Uint32 addr, Uint8 b) {
 void NBIC::set_intstatus(bool set) {
 	if (set) {
         intstatus |= ND_NBIC_INTR;
-        remInter  |= 1 << slot;
 	} else {
         intstatus &= ~ND_NBIC_INTR;
-        remInter  &= ~(1 << slot);
 	}
+    set_slot_bit(&remInter, slot, set);
+}
+
+/* Lock-free update of one slot bit, other boards may update theirs concurrently */
+void NBIC::set_slot_bit(atomic_int* bits, int slot, bool set) {
+    int old_value, new_value;
+    do {
+        old_value = host_atomic_get(bits);
+        new_value = set ? (old_value | (1 << slot)) : (old_value & ~(1 << slot));
+    } while (!host_atomic_cas(bits, old_value, new_value));
 }
 
 
@@ -147,17 +153,33 @@ void NBIC::init(void) {
     /* Release any interrupt that may be pending */
     intmask      = 0;
     intstatus    = 0;
-    remInter     = 0;
-    remInterMask = 0;
-    set_interrupt(INT_REMOTE, RELEASE_INT);
+    set_slot_bit(&remInter,     slot, false);
+    set_slot_bit(&remInterMask, slot, false);
+    nd_nbic_interrupt();
 }
 
-volatile Uint32 NBIC::remInter;
-volatile Uint32 NBIC::remInterMask;
+atomic_int NBIC::remInter;
+atomic_int NBIC::remInterMask;
+
+/* Save/restore NBIC state including the remote interrupt bits of this slot */
+void NBIC::snapshot(bool save) {
+    bool inter     = host_atomic_get(&remInter)     & (1 << slot);
+    bool interMask = host_atomic_get(&remInterMask) & (1 << slot);
+    
+    MemorySnapShot_Store(&intstatus, sizeof(intstatus));
+    MemorySnapShot_Store(&intmask,   sizeof(intmask));
+    MemorySnapShot_Store(&inter,     sizeof(inter));
+    MemorySnapShot_Store(&interMask, sizeof(interMask));
+    
+    if(!save) {
+        set_slot_bit(&remInter,     slot, inter);
+        set_slot_bit(&remInterMask, slot, interMask);
+    }
+}
 
-/* Interrupt function, called from ,68k thread */
+/* Interrupt function, called from m68k thread */
 void nd_nbic_interrupt(void) {
-    if (NBIC::remInter&NBIC::remInterMask) {
+    if (host_atomic_get(&NBIC::remInter) & host_atomic_get(&NBIC::remInterMask)) {
         set_interrupt(INT_REMOTE, SET_INT);
     } else {
         set_interrupt(INT_REMOTE, RELEASE_INT);
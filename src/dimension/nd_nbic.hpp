@@ -14,8 +14,10 @@ class NBIC {
     Uint8  intstatus;
     Uint8  intmask;
 public:
-    static volatile Uint32 remInter;
-    static volatile Uint32 remInterMask;
+    /* Remote interrupt bits of all slots, updated by each board's i860 thread */
+    static atomic_int remInter;
+    static atomic_int remInterMask;
+    static void set_slot_bit(atomic_int* bits, int slot, bool set);
 
     NBIC(int slot, int id);
     
@@ -31,6 +33,7 @@ public:
     
     void   init(void);
     void   set_intstatus(bool set);
+    void   snapshot(bool save);
 };
 
 extern "C" {
@@ -10,7 +10,7 @@
 volatile bool NDSDL::ndVBLtoggle;
 volatile bool NDSDL::ndVideoVBLtoggle;
 
-NDSDL::NDSDL(int slot, Uint32* vram) : slot(slot), doRepaint(true), repaintThread(NULL), ndWindow(NULL), ndRenderer(NULL), vram(vram) {}
+NDSDL::NDSDL(int slot, Uint32* vram, volatile Uint8* vram_dirty) : slot(slot), doRepaint(true), repaintThread(NULL), ndWindow(NULL), ndRenderer(NULL), vram(vram), vram_dirty(vram_dirty) {}
 
 int NDSDL::repainter(void *_this) {
     return ((NDSDL*)_this)->repainter();
@@ -28,12 +28,18 @@ int NDSDL::repainter(void) {
     
     SDL_AtomicSet(&blitNDFB, 1);
     
+    /* Start with a complete frame */
+    memset((void*)vram_dirty, 1, ND_VRAM_DIRTY_SIZE);
+    
     while(doRepaint) {
         if (SDL_AtomicGet(&blitNDFB)) {
-            blitDimension(vram, ndTexture);
-            SDL_RenderClear(ndRenderer);
-            SDL_RenderCopy(ndRenderer, ndTexture, NULL, NULL);
-            SDL_RenderPresent(ndRenderer);
+            if (blitDimension(vram, vram_dirty, ndTexture)) {
+                SDL_RenderClear(ndRenderer);
+                SDL_RenderCopy(ndRenderer, ndTexture, NULL, NULL);
+                SDL_RenderPresent(ndRenderer);
+            } else {
+                host_sleep_ms(10);
+            }
         } else {
             host_sleep_ms(100);
         }
@@ -50,6 +56,10 @@ void NDSDL::init(void) {
     int x, y, w, h;
     char title[32], name[32];
 
+    if (bHeadless) {
+        return;
+    }
+
     if(!ndWindow) {
         SDL_GetWindowPosition(sdlWindow, &x, &y);
         SDL_GetWindowSize(sdlWindow, &w, &h);
@@ -92,7 +102,6 @@ void nd_vbl_handler(void)       {
     FOR_EACH_SLOT(slot) {
         IF_NEXT_DIMENSION(slot, nd) {
             host_blank(nd->slot, ND_DISPLAY, NDSDL::ndVBLtoggle);
-            nd->i860.i860cycles = (1000*1000*33)/136;
         }
     }
     NDSDL::ndVBLtoggle = !NDSDL::ndVBLtoggle;
@@ -107,8 +116,7 @@ void nd_video_vbl_handler(void) {
 
     FOR_EACH_SLOT(slot) {
         IF_NEXT_DIMENSION(slot, nd) {
-            host_blank(slot, ND_VIDEO, NDSDL::ndVideoVBLtoggle);
-            nd->i860.i860cycles = nd->i860.i860cycles; // make compiler happy
+            host_blank(nd->slot, ND_VIDEO, NDSDL::ndVideoVBLtoggle);
         }
     }
     NDSDL::ndVideoVBLtoggle = !NDSDL::ndVideoVBLtoggle;
@@ -118,7 +126,9 @@ void nd_video_vbl_handler(void) {
 }
 
 void NDSDL::uninit(void) {
-    SDL_HideWindow(ndWindow);
+    if (ndWindow) {
+        SDL_HideWindow(ndWindow);
+    }
 }
 
 void NDSDL::pause(bool pause) {
@@ -17,6 +17,7 @@ class NDSDL {
     SDL_Renderer* ndRenderer;
     SDL_atomic_t  blitNDFB;
     Uint32*       vram;
+    volatile Uint8* vram_dirty;
     
     static int    repainter(void *_this);
     int           repainter(void);
@@ -24,7 +25,7 @@ public:
     static volatile bool ndVBLtoggle;
     static volatile bool ndVideoVBLtoggle;
 
-    NDSDL(int slot, Uint32* vram);
+    NDSDL(int slot, Uint32* vram, volatile Uint8* vram_dirty);
     void    init(void);
     void    uninit(void);
     void    pause(bool pause);
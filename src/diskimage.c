@@ -0,0 +1,250 @@
+/*  Previous - diskimage.c
+
+ This file is distributed under the GNU Public License, version 2 or at
+ your option any later version. Read the file gpl.txt for details.
+
+ Disk image access for SCSI, MO and floppy drives.
+
+ Where the host supports it and System.bMapDiskImages is set, images are
+ mapped into memory. Sector reads and writes are then plain copies from
+ and to the mapping and do not need any system calls. The page cache is
+ shared with other processes using the same image. Images that cannot be
+ mapped (empty files, files too big for the address space or hosts without
+ mmap) are accessed with stdio. Accesses beyond the end of a mapped image
+ also use stdio.
+
+ If another process truncates a mapped image, accessing the pages beyond
+ the new end raises SIGBUS. The handler replaces the mapping with zero
+ pages, so that the access completes, and marks the image. The access is
+ then repeated with stdio and the image is no longer mapped. Images whose
+ size changed are also unmapped when they are flushed.
+
+ */
+
+#include <errno.h>
+#include <signal.h>
+
+#include "main.h"
+#include "configuration.h"
+#include "log.h"
+#include "file.h"
+#include "diskimage.h"
+
+#if HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
+
+#define DISKIMAGE_MAX_MAPPED 16
+
+struct diskimage {
+    FILE*  fp;
+    Uint8* map;         /* mapped image or NULL */
+    Uint64 size;
+    bool   writable;
+    volatile sig_atomic_t faulted;  /* mapping was replaced after SIGBUS */
+};
+
+
+#if HAVE_SYS_MMAN_H
+/* Mapped images, searched by the SIGBUS handler */
+static DISKIMAGE* volatile mapped[DISKIMAGE_MAX_MAPPED];
+static struct sigaction    oldSigbus;
+static bool                sigbusInstalled = false;
+
+static void diskimage_sigbus(int sig, siginfo_t *info, void *context) {
+    Uint8* addr = (Uint8*)info->si_addr;
+    int i;
+
+    for (i = 0; i < DISKIMAGE_MAX_MAPPED; i++) {
+        DISKIMAGE* img = mapped[i];
+        if (img && img->map && addr >= img->map && addr < img->map + img->size) {
+            /* Let the access complete on zero pages, the caller repeats it */
+            if (mmap(img->map, (size_t)img->size, PROT_READ|PROT_WRITE,
+                     MAP_FIXED|MAP_PRIVATE|MAP_ANONYMOUS, -1, 0) != MAP_FAILED) {
+                img->faulted = 1;
+                return;
+            }
+        }
+    }
+    /* Not ours, the fault happens again with the previous handler */
+    sigaction(SIGBUS, &oldSigbus, NULL);
+}
+
+static void diskimage_install_sigbus(void) {
+    struct sigaction sa;
+
+    if (sigbusInstalled) {
+        return;
+    }
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = diskimage_sigbus;
+    sa.sa_flags     = SA_SIGINFO;
+    sigemptyset(&sa.sa_mask);
+    sigbusInstalled = sigaction(SIGBUS, &sa, &oldSigbus) == 0;
+}
+
+static void diskimage_map(DISKIMAGE *img) {
+    void* map;
+    int   i;
+
+    if (!ConfigureParams.System.bMapDiskImages ||
+        img->size == 0 || img->size != (Uint64)(size_t)img->size) {
+        return;
+    }
+    diskimage_install_sigbus();
+    for (i = 0; i < DISKIMAGE_MAX_MAPPED && mapped[i]; i++) {}
+    if (!sigbusInstalled || i == DISKIMAGE_MAX_MAPPED) {
+        return;
+    }
+    map = mmap(NULL, (size_t)img->size, img->writable ? (PROT_READ|PROT_WRITE) : PROT_READ,
+               MAP_SHARED, fileno(img->fp), 0);
+    if (map == MAP_FAILED) {
+        Log_Printf(LOG_DEBUG, "[DiskImage] Cannot map image: %s", strerror(errno));
+        return;
+    }
+    img->map  = map;
+    mapped[i] = img;
+}
+
+static void diskimage_unmap(DISKIMAGE *img) {
+    int i;
+
+    if (img->map) {
+        for (i = 0; i < DISKIMAGE_MAX_MAPPED; i++) {
+            if (mapped[i] == img) {
+                mapped[i] = NULL;
+            }
+        }
+        if (img->writable && !img->faulted) {
+            msync(img->map, (size_t)img->size, MS_SYNC);
+        }
+        munmap(img->map, (size_t)img->size);
+        img->map = NULL;
+    }
+}
+
+/* Continue with stdio after the image changed under the mapping */
+static void diskimage_fallback(DISKIMAGE *img) {
+    Log_Printf(LOG_WARN, "[DiskImage] Image file changed size, no longer mapping it");
+    diskimage_unmap(img);
+    img->faulted = 0;
+}
+
+static bool diskimage_size_changed(DISKIMAGE *img) {
+    struct stat st;
+    return fstat(fileno(img->fp), &st) == 0 && (Uint64)st.st_size != img->size;
+}
+#else
+static void diskimage_map(DISKIMAGE *img) {}
+static void diskimage_unmap(DISKIMAGE *img) {}
+static void diskimage_fallback(DISKIMAGE *img) {}
+#endif
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Open a disk image for reading or for reading and writing.
+ * Returns NULL if the image cannot be opened.
+ */
+DISKIMAGE *DiskImage_Open(const char *pszFileName, bool bWritable) {
+    DISKIMAGE* img;
+    FILE*      fp = File_Open(pszFileName, bWritable ? "rb+" : "rb");
+
+    if (fp == NULL) {
+        return NULL;
+    }
+    img = calloc(1, sizeof(DISKIMAGE));
+    if (img == NULL) {
+        File_Close(fp);
+        return NULL;
+    }
+    img->fp       = fp;
+    img->writable = bWritable;
+    img->size     = File_Length(pszFileName);
+
+    diskimage_map(img);
+
+    Log_Printf(LOG_DEBUG, "[DiskImage] Opened %s (%s, %s)", pszFileName,
+               bWritable ? "read/write" : "read only", img->map ? "mapped" : "stdio");
+    return img;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Write back and close a disk image.
+ */
+void DiskImage_Close(DISKIMAGE *img) {
+    if (img) {
+        DiskImage_Flush(img);
+        diskimage_unmap(img);
+        File_Close(img->fp);
+        free(img);
+    }
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Size of the image in bytes when it was opened.
+ */
+Uint64 DiskImage_Size(DISKIMAGE *img) {
+    return img->size;
+}
+
+bool DiskImage_IsMapped(DISKIMAGE *img) {
+    return img->map != NULL;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Read data from the image and return status.
+ */
+bool DiskImage_Read(DISKIMAGE *img, Uint8 *data, Uint32 size, Uint64 offset) {
+    if (img->map && offset + size <= img->size) {
+        memcpy(data, img->map + offset, size);
+        if (!img->faulted) {
+            return true;
+        }
+        diskimage_fallback(img);
+    }
+    return File_Read(data, size, offset, img->fp);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Write data to the image and return status.
+ */
+bool DiskImage_Write(DISKIMAGE *img, Uint8 *data, Uint32 size, Uint64 offset) {
+    if (img->map && offset + size <= img->size) {
+        memcpy(img->map + offset, data, size);
+        if (!img->faulted) {
+            return true;
+        }
+        diskimage_fallback(img);
+    }
+    return File_Write(data, size, offset, img->fp);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Write all modified data back to the image file. Stop mapping the image
+ * if its size was changed by another process.
+ */
+void DiskImage_Flush(DISKIMAGE *img) {
+#if HAVE_SYS_MMAN_H
+    if (img->map && (img->faulted || diskimage_size_changed(img))) {
+        diskimage_fallback(img);
+    } else if (img->map && img->writable) {
+        msync(img->map, (size_t)img->size, MS_SYNC);
+    }
+#endif
+    fflush(img->fp);
+}
@@ -425,7 +425,7 @@ uint64_t VirtualFS::getFileHandle(const VFSPath& absoluteVFSPath) {
 
 const string NFSD_ATTRS(".nfsd_fattrs");
     
-void VirtualFS::setFileAttrs(const VFSPath& absoluteVFSpath, const FileAttrs& fstat) {
+bool VirtualFS::setFileAttrs(const VFSPath& absoluteVFSpath, const FileAttrs& fstat) {
     VFSPath path   = removeAlias(absoluteVFSpath);
     string fname(absoluteVFSpath.filename());
 
@@ -439,7 +439,13 @@ void VirtualFS::setFileAttrs(const VFSPath& absoluteVFSpath, const FileAttrs& fs
 #else
     if(::setxattr(hostPath.c_str(), NFSD_ATTRS.c_str(), serialized.c_str(), serialized.length(), 0, XATTR_NOFOLLOW) != 0)
 #endif
+    {
         printf("setxattr(%s) failed\n", hostPath.c_str());
+        return false;
+    }
+    return true;
+#else
+    return false;
 #endif
 }
 
@@ -678,6 +684,15 @@ int VirtualFS::vfsStat(const VFSPath& absoluteVFSpath, struct stat& fstat) {
 #endif
 }
 
+int VirtualFS::vfsTruncate(const VFSPath& absoluteVFSpath, uint64_t size) {
+    int fd = ::open(toHostPath(absoluteVFSpath).c_str(), O_WRONLY);
+    if(fd < 0)
+        return errno;
+    int result = get_error(::ftruncate(fd, size));
+    ::close(fd);
+    return result;
+}
+
 int VirtualFS::vfsUtimes(const VFSPath& absoluteVFSpath, const struct timeval times[2]) {
 #ifdef _WIN32
     return 0; // not supported
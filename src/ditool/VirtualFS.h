@@ -141,7 +141,7 @@ public:
     virtual void      move            (uint64_t fileHandleFrom, const VFSPath& absoluteVFSpathTo) = 0;
     virtual void      remove          (uint64_t fileHandle) = 0;
     virtual uint64_t  getFileHandle   (const VFSPath& absoluteVFSpath);
-    virtual void      setFileAttrs    (const VFSPath& absoluteVFSpath, const FileAttrs& fstat);
+    virtual bool      setFileAttrs    (const VFSPath& absoluteVFSpath, const FileAttrs& fstat);
     virtual FileAttrs getFileAttrs    (const VFSPath& path);
     virtual uint32_t  fileId          (uint64_t ino);
     virtual void      touch           (const VFSPath& absoluteVFSpath);
@@ -158,6 +158,7 @@ public:
     int                   vfsNftw    (const VFSPath& absoluteVFSpath, int (*fn)(const char *, const struct stat *ptr, int flag, struct FTW *), int depth, int flags);
     int                   vfsStatvfs (const VFSPath& absoluteVFSpath, struct statvfs& fsstat);
     int                   vfsStat    (const VFSPath& absoluteVFSpath, struct stat& fstat);
+    int                   vfsTruncate(const VFSPath& absoluteVFSpath, uint64_t size);
     int                   vfsUtimes  (const VFSPath& absoluteVFSpath, const struct timeval times[2]);
     uint32_t              vfsGetUID  (const VFSPath& absoluteVFSpath, bool useParent);
     uint32_t              vfsGetGID  (const VFSPath& absoluteVFSpath, bool useParent);
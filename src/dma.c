@@ -23,6 +23,8 @@
 #include "snd.h"
 #include "dsp.h"
 #include "mmu_common.h"
+#include "memorySnapShot.h"
+#include "evtrace.h"
 
 #define LOG_DMA_LEVEL LOG_DEBUG
 
@@ -164,7 +166,8 @@ void DMA_CSR_Read(void) { // 0x02000010, length of register is byte on 68030 bas
     
     IoMem[IoAccessCurrentAddress & IO_SEG_MASK] = dma[channel].csr;
     IoMem[(IoAccessCurrentAddress+1) & IO_SEG_MASK] = IoMem[(IoAccessCurrentAddress+2) & IO_SEG_MASK] = IoMem[(IoAccessCurrentAddress+3) & IO_SEG_MASK] = 0x00; // just to be sure
-    Log_Printf(LOG_DMA_LEVEL,"DMA CSR read at $%08x val=$%02x PC=$%08x\n", IoAccessCurrentAddress, dma[channel].csr, m68k_getpc());
+    EVTRACE_LOG(EV_DMA_CSR_RD, channel, dma[channel].csr, 0, 0,
+                LOG_DMA_LEVEL,"DMA CSR read at $%08x val=$%02x PC=$%08x\n", IoAccessCurrentAddress, dma[channel].csr, m68k_getpc());
 }
 
 void DMA_CSR_Write(void) {
@@ -172,7 +175,8 @@ void DMA_CSR_Write(void) {
     int interrupt = get_interrupt_type(channel);
     Uint8 writecsr = IoMem[IoAccessCurrentAddress & IO_SEG_MASK]|IoMem[(IoAccessCurrentAddress+1) & IO_SEG_MASK]|IoMem[(IoAccessCurrentAddress+2) & IO_SEG_MASK]|IoMem[(IoAccessCurrentAddress+3) & IO_SEG_MASK];
 
-    Log_Printf(LOG_DMA_LEVEL,"DMA CSR write at $%08x val=$%02x PC=$%08x\n", IoAccessCurrentAddress, writecsr, m68k_getpc());
+    EVTRACE_LOG(EV_DMA_CSR_WR, channel, writecsr, 0, 0,
+                LOG_DMA_LEVEL,"DMA CSR write at $%08x val=$%02x PC=$%08x\n", IoAccessCurrentAddress, writecsr, m68k_getpc());
     
     /* For debugging */
     if(writecsr&DMA_DEV2M)
@@ -384,6 +388,7 @@ void dma_interrupt(int channel) {
         }
     }
     if (dma[channel].csr&DMA_COMPLETE) {
+        EVTRACE(EV_DMA_INTR, channel, dma[channel].csr, dma[channel].next, dma[channel].limit);
         set_interrupt(interrupt, SET_INT);
     }
 }
@@ -423,10 +428,17 @@ void dma_esp_write_memory(void) {
                     }
                 } else {
                     while (espdma_buf_limit<DMA_BURST_SIZE && esp_counter>0 && SCSIbus.phase==PHASE_DI) {
-                        espdma_buf[espdma_buf_limit]=SCSIdisk_Send_Data();
-                        esp_counter--;
-                        espdma_buf_limit++;
-                        espdma_buf_size++;
+                        int n = DMA_BURST_SIZE-espdma_buf_limit;
+                        if ((Uint32)n>esp_counter) {
+                            n = esp_counter;
+                        }
+                        n = SCSIdisk_Send_Data_Burst(espdma_buf+espdma_buf_limit, n);
+                        if (n==0) {
+                            break;
+                        }
+                        esp_counter-=n;
+                        espdma_buf_limit+=n;
+                        espdma_buf_size+=n;
                     }
                 }
             }
@@ -1211,3 +1223,18 @@ void tdma_flush_buffer(int channel) {
 	
 	dma_interrupt(CHANNEL_SCSI);
 }
+
+
+/* Save/restore DMA channels and internal buffers */
+void DMA_MemorySnapShot_Capture(bool bSave) {
+	MemorySnapShot_Store(dma, sizeof(dma));
+	MemorySnapShot_Store(&espdma_buf_size, sizeof(espdma_buf_size));
+	MemorySnapShot_Store(&espdma_buf_limit, sizeof(espdma_buf_limit));
+	MemorySnapShot_Store(espdma_buf, sizeof(espdma_buf));
+	MemorySnapShot_Store(&modma_buf_size, sizeof(modma_buf_size));
+	MemorySnapShot_Store(&modma_buf_limit, sizeof(modma_buf_limit));
+	MemorySnapShot_Store(modma_buf, sizeof(modma_buf));
+	MemorySnapShot_Store(&saved_next_turbo, sizeof(saved_next_turbo));
+	MemorySnapShot_Store(m2m_buffer, sizeof(m2m_buffer));
+	MemorySnapShot_Store(&m2m_buffer_size, sizeof(m2m_buffer_size));
+}
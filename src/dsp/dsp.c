@@ -33,6 +33,7 @@
 #include "m68000.h"
 #include "sysReg.h"
 #include "dma.h"
+#include "memorySnapShot.h"
 
 #if ENABLE_DSP_EMU
 #include "dsp_cpu.h"
@@ -271,6 +272,21 @@ void DSP_Run(int nHostCycles)
 #endif
 }
 
+/**
+ * Save/Restore snapshot of DSP state
+ */
+void DSP_MemorySnapShot_Capture(bool bSave)
+{
+	MemorySnapShot_Store(&bDspEmulated, sizeof(bDspEmulated));
+	MemorySnapShot_Store(&bDspHostInterruptPending, sizeof(bDspHostInterruptPending));
+	MemorySnapShot_Store(&dsp_dma_unpacked, sizeof(dsp_dma_unpacked));
+	MemorySnapShot_Store(&dsp_intr_at_block_end, sizeof(dsp_intr_at_block_end));
+#if ENABLE_DSP_EMU
+	MemorySnapShot_Store(&dsp_core, sizeof(dsp_core));
+	MemorySnapShot_Store(&save_cycles, sizeof(save_cycles));
+#endif
+}
+
 /**
  * Enable/disable DSP debugging mode
  */
@@ -8,6 +8,8 @@
 
 #ifndef _WIN32
 #include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
 #else
 #undef TCHAR
 #include <winsock2.h>
@@ -19,14 +21,69 @@ int inet_aton(const char *cp, struct in_addr *addr);
 /****************/
 /* -- SLIRP -- */
 
-/* queue prototypes */
-queueADT	slirpq;
+/* Packets from SLIRP to the guest are passed through a ring of
+ * preallocated slots. SLIRP only produces packets while slirp_mutex
+ * is held and only the emulation thread consumes them, so the ring
+ * indices can be updated without taking the lock.
+ */
+#define SLIRP_RING_SIZE 128 /* must be a power of two */
+
+static struct queuepacket slirp_ring[SLIRP_RING_SIZE];
+static atomic_int slirp_ring_head; /* next slot to write, advanced by SLIRP */
+static atomic_int slirp_ring_tail; /* next slot to read, advanced by emulation thread */
 
 int slirp_inited;
 int slirp_started;
 static SDL_mutex *slirp_mutex = NULL;
 SDL_Thread *tick_func_handle;
 
+/* The tick thread blocks in select until a socket is ready, a SLIRP
+ * timer expires or the guest sends a packet. Guest packets are signalled
+ * through a pipe. Windows can only select on sockets, there the thread
+ * polls every SLIRP_TICK_MS.
+ */
+static int slirp_wakeup[2] = { -1, -1 };
+
+#ifndef _WIN32
+static void slirp_wakeup_init(void) {
+    if (pipe(slirp_wakeup) < 0) {
+        Log_Printf(LOG_WARN, "[SLIRP] Cannot create wakeup pipe, polling");
+        slirp_wakeup[0] = slirp_wakeup[1] = -1;
+        return;
+    }
+    fcntl(slirp_wakeup[0], F_SETFL, O_NONBLOCK);
+    fcntl(slirp_wakeup[1], F_SETFL, O_NONBLOCK);
+}
+
+static void slirp_wakeup_uninit(void) {
+    if (slirp_wakeup[0] >= 0) {
+        close(slirp_wakeup[0]);
+        close(slirp_wakeup[1]);
+        slirp_wakeup[0] = slirp_wakeup[1] = -1;
+    }
+}
+
+static void slirp_wakeup_signal(void) {
+    char c = 0;
+    if (slirp_wakeup[1] >= 0) {
+        /* If the pipe is full the thread is going to wake up anyway */
+        if (write(slirp_wakeup[1], &c, 1) < 0) {}
+    }
+}
+
+static void slirp_wakeup_drain(fd_set *rfds) {
+    char buf[64];
+    if (slirp_wakeup[0] >= 0 && FD_ISSET(slirp_wakeup[0], rfds)) {
+        while (read(slirp_wakeup[0], buf, sizeof(buf)) > 0) {}
+    }
+}
+#else
+static void slirp_wakeup_init(void) {}
+static void slirp_wakeup_uninit(void) {}
+static void slirp_wakeup_signal(void) {}
+static void slirp_wakeup_drain(fd_set *rfds) {}
+#endif
+
 //Is slirp initalized?
 //Is set to true from the init, and false on ethernet disconnect
 int slirp_can_output(void)
@@ -36,21 +93,36 @@ int slirp_can_output(void)
 
 //This is a callback function for SLiRP that sends a packet
 //to the calling library.  In this case I stuff
-//it in q queue
+//it in the ring. It is always called with slirp_mutex held.
 void slirp_output (const unsigned char *pkt, int pkt_len)
 {
     struct queuepacket *p;
-    p=(struct queuepacket *)malloc(sizeof(struct queuepacket));
-    SDL_LockMutex(slirp_mutex);
+    unsigned int head = host_atomic_get(&slirp_ring_head);
+    unsigned int tail = host_atomic_get(&slirp_ring_tail);
+    
+    if (pkt_len > (int)sizeof(p->data)) {
+        Log_Printf(LOG_WARN, "[SLIRP] Dropping oversized packet (%i bytes)",pkt_len);
+        return;
+    }
+    if (head - tail >= SLIRP_RING_SIZE) {
+        Log_Printf(LOG_WARN, "[SLIRP] Receive ring full, dropping packet");
+        return;
+    }
+    p=&slirp_ring[head & (SLIRP_RING_SIZE-1)];
     p->len=pkt_len;
     memcpy(p->data,pkt,pkt_len);
-    QueueEnter(slirpq,p);
-    SDL_UnlockMutex(slirp_mutex);
+    /* Publish the slot after it is filled */
+    host_atomic_set(&slirp_ring_head, head+1);
     Log_Printf(LOG_EN_SLIRP_LEVEL, "[SLIRP] Output packet with %i bytes to queue",pkt_len);
 }
 
-//This function is to be periodically called
+#define SLIRP_TICK_MS   10
+#define SLIRP_IDLE_MS   1000
+#define SLIRP_RIP_SEC   30
+
+//This function is to be called in a loop
 //to keep the internal packet state flowing.
+//It waits until there is something to do.
 static void slirp_tick(void)
 {
     int ret2,nfds;
@@ -68,13 +140,24 @@ static void slirp_tick(void)
         timeout=slirp_select_fill(&nfds,&rfds,&wfds,&xfds); //this can crash
         SDL_UnlockMutex(slirp_mutex);
         
-        if(timeout<0)
-            timeout=500;
-        tv.tv_sec=0;
-        tv.tv_usec = timeout;    //basilisk default 10000
+        if (slirp_wakeup[0] >= 0) {
+            FD_SET(slirp_wakeup[0], &rfds);
+            if (slirp_wakeup[0] > nfds)
+                nfds = slirp_wakeup[0];
+            /* No timer pending: sleep until woken up */
+            if(timeout<0)
+                timeout=SLIRP_IDLE_MS*1000;
+        } else {
+            host_sleep_ms(SLIRP_TICK_MS);
+            if(timeout<0)
+                timeout=500;
+        }
+        tv.tv_sec  = timeout / 1000000;
+        tv.tv_usec = timeout % 1000000;    //basilisk default 10000
         
         ret2 = select(nfds + 1, &rfds, &wfds, &xfds, &tv);
         if(ret2>=0){
+            slirp_wakeup_drain(&rfds);
             SDL_LockMutex(slirp_mutex);
             slirp_select_poll(&rfds, &wfds, &xfds);
             SDL_UnlockMutex(slirp_mutex);
@@ -96,9 +179,6 @@ static void slirp_rip_tick(void)
 }
 
 
-#define SLIRP_TICK_MS   10
-#define SLIRP_RIP_SEC   30
-
 static int tick_func(void *arg)
 {
     Uint32 time = host_get_save_time();
@@ -107,7 +187,6 @@ static int tick_func(void *arg)
 
     while(slirp_started)
     {
-        host_sleep_ms(SLIRP_TICK_MS);
         slirp_tick();
         
         // for routing information protocol
@@ -127,18 +206,23 @@ static int tick_func(void *arg)
 }
 
 
+//Called from the emulation thread when the receiver is idle.
+//Packets the receiver does not accept are drained in one go
+//until a packet is received or the ring is empty.
 void enet_slirp_queue_poll(void)
 {
-    SDL_LockMutex(slirp_mutex);
-    if (QueuePeek(slirpq)>0)
+    unsigned int tail = host_atomic_get(&slirp_ring_tail);
+    unsigned int head = host_atomic_get(&slirp_ring_head);
+    
+    while (tail != head && enet_rx_buffer.size == 0)
     {
-        struct queuepacket *qp;
-        qp=QueueDelete(slirpq);
+        struct queuepacket *qp = &slirp_ring[tail & (SLIRP_RING_SIZE-1)];
         Log_Printf(LOG_EN_SLIRP_LEVEL, "[SLIRP] Getting packet from queue");
         enet_receive(qp->data,qp->len);
-        free(qp);
+        tail++;
     }
-    SDL_UnlockMutex(slirp_mutex);
+    /* Release the slots to SLIRP */
+    host_atomic_set(&slirp_ring_tail, tail);
 }
 
 void enet_slirp_input(Uint8 *pkt, int pkt_len) {
@@ -147,6 +231,8 @@ void enet_slirp_input(Uint8 *pkt, int pkt_len) {
         SDL_LockMutex(slirp_mutex);
         slirp_input(pkt,pkt_len);
         SDL_UnlockMutex(slirp_mutex);
+        /* Let the tick thread pick up new or writable sockets */
+        slirp_wakeup_signal();
     }
 }
 
@@ -156,9 +242,10 @@ void enet_slirp_stop(void) {
     if (slirp_started) {
         Log_Printf(LOG_WARN, "Stopping SLIRP");
         slirp_started=0;
-        QueueDestroy(slirpq);
-        SDL_DestroyMutex(slirp_mutex);
+        slirp_wakeup_signal();
         SDL_WaitThread(tick_func_handle, &ret);
+        SDL_DestroyMutex(slirp_mutex);
+        slirp_wakeup_uninit();
     }
 }
 
@@ -176,8 +263,10 @@ void enet_slirp_start(Uint8 *mac) {
                    mac[0],mac[1],mac[2],mac[3],mac[4],mac[5]);
         memcpy(client_ethaddr, mac, 6);
         slirp_started=1;
-        slirpq = QueueCreate();
+        host_atomic_set(&slirp_ring_head, 0);
+        host_atomic_set(&slirp_ring_tail, 0);
         slirp_mutex=SDL_CreateMutex();
+        slirp_wakeup_init();
         tick_func_handle=SDL_CreateThread(tick_func,"SLiRPTickThread", (void *)NULL);
     }
     
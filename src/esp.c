@@ -10,6 +10,8 @@
 #include "sysReg.h"
 #include "dma.h"
 #include "scsi.h"
+#include "memorySnapShot.h"
+#include "evtrace.h"
 
 #define LOG_ESPDMA_LEVEL    LOG_DEBUG   /* Print debugging messages for ESP DMA registers */
 #define LOG_ESPCMD_LEVEL    LOG_DEBUG   /* Print debugging messages for ESP commands */
@@ -362,7 +364,8 @@ Uint8 esp_fifo_read(void) {
             fifo[i]=fifo[i+1];
         fifo[ESP_FIFO_SIZE-1] = 0x00;
         fifoflags--;
-        Log_Printf(LOG_ESPFIFO_LEVEL,"ESP FIFO: Reading byte, val=%02x, size = %i", val, fifoflags);
+        EVTRACE_LOG(EV_ESP_FIFO_RD, val, fifoflags, 0, 0,
+                    LOG_ESPFIFO_LEVEL,"ESP FIFO: Reading byte, val=%02x, size = %i", val, fifoflags);
     } else {
         val = 0x00;
         Log_Printf(LOG_WARN, "ESP FIFO read: FIFO is empty!\n");
@@ -378,7 +381,8 @@ void esp_fifo_write(Uint8 val) {
     } else {
         fifoflags++;
         fifo[fifoflags-1] = val;
-        Log_Printf(LOG_ESPFIFO_LEVEL,"ESP FIFO: Writing byte %i, val=%02x", fifoflags-1, fifo[fifoflags-1]);
+        EVTRACE_LOG(EV_ESP_FIFO_WR, val, fifoflags, 0, 0,
+                    LOG_ESPFIFO_LEVEL,"ESP FIFO: Writing byte %i, val=%02x", fifoflags-1, fifo[fifoflags-1]);
     }
 }
 
@@ -436,6 +440,7 @@ void esp_finish_command(void) {
 }
 
 void esp_start_command(Uint8 cmd) {
+    EVTRACE(EV_ESP_CMD, cmd, 0, 0, 0);
     esp_cmd_state |= ESP_CMD_INPROGRESS;
     
     /* Check if command is valid for actual state */
@@ -570,6 +575,7 @@ void ESP_InterruptHandler(void) {
 void esp_raise_irq(void) {
     if(!(status & STAT_INT)) {
         status |= STAT_INT;
+        EVTRACE(EV_ESP_IRQ, status, intstatus, 0, 0);
         
         if (esp_dma.control&ESPCTRL_ENABLE_INT) {
             set_interrupt(INT_SCSI, SET_INT);
@@ -900,6 +906,32 @@ void esp_message_accepted(void) {
 
 
 
+/* Save/restore ESP state */
+void ESP_MemorySnapShot_Capture(bool bSave) {
+    MemorySnapShot_Store(&esp_dma, sizeof(esp_dma));
+    MemorySnapShot_Store(&esp_state, sizeof(esp_state));
+    MemorySnapShot_Store(&esp_cmd_state, sizeof(esp_cmd_state));
+    MemorySnapShot_Store(&esp_io_state, sizeof(esp_io_state));
+    MemorySnapShot_Store(&esp_counter, sizeof(esp_counter));
+    MemorySnapShot_Store(&mode_dma, sizeof(mode_dma));
+    MemorySnapShot_Store(&writetranscountl, sizeof(writetranscountl));
+    MemorySnapShot_Store(&writetranscounth, sizeof(writetranscounth));
+    MemorySnapShot_Store(fifo, sizeof(fifo));
+    MemorySnapShot_Store(command, sizeof(command));
+    MemorySnapShot_Store(&status, sizeof(status));
+    MemorySnapShot_Store(&selectbusid, sizeof(selectbusid));
+    MemorySnapShot_Store(&intstatus, sizeof(intstatus));
+    MemorySnapShot_Store(&selecttimeout, sizeof(selecttimeout));
+    MemorySnapShot_Store(&seqstep, sizeof(seqstep));
+    MemorySnapShot_Store(&syncperiod, sizeof(syncperiod));
+    MemorySnapShot_Store(&fifoflags, sizeof(fifoflags));
+    MemorySnapShot_Store(&syncoffset, sizeof(syncoffset));
+    MemorySnapShot_Store(&configuration, sizeof(configuration));
+    MemorySnapShot_Store(&clockconv, sizeof(clockconv));
+    MemorySnapShot_Store(&esptest, sizeof(esptest));
+}
+
+
 #if 0 /* this is for target commands! */
 /* Decode command to determine the command group and thus the
  * length of the incoming command. Set "valid group code" bit
@@ -19,6 +19,7 @@
 #include "enet_pcap.h"
 #include "cycInt.h"
 #include "statusbar.h"
+#include "memorySnapShot.h"
 
 
 #define LOG_EN_LEVEL        LOG_DEBUG
@@ -318,6 +319,19 @@ static bool rx_chain;
 static int old_size;
 static int en_state;
 
+
+/* Save/restore ethernet controller state */
+void Ethernet_MemorySnapShot_Capture(bool bSave) {
+    MemorySnapShot_Store(&enet_tx_buffer, sizeof(enet_tx_buffer));
+    MemorySnapShot_Store(&enet_rx_buffer, sizeof(enet_rx_buffer));
+    MemorySnapShot_Store(&enet, sizeof(enet));
+    MemorySnapShot_Store(&receiver_state, sizeof(receiver_state));
+    MemorySnapShot_Store(&tx_done, sizeof(tx_done));
+    MemorySnapShot_Store(&rx_chain, sizeof(rx_chain));
+    MemorySnapShot_Store(&old_size, sizeof(old_size));
+    MemorySnapShot_Store(&en_state, sizeof(en_state));
+}
+
 #define EN_DISCONNECTED    0
 #define EN_LOOPBACK        1
 #define EN_THINWIRE        2
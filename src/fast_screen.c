@@ -23,6 +23,7 @@ const char Screen_fileid[] = "Previous fast_screen.c : " __DATE__ " " __TIME__;
 #include "screen.h"
 #include "statusbar.h"
 #include "video.h"
+#include "blit.h"
 
 SDL_Window*   sdlWindow;
 SDL_Surface*  sdlscrn = NULL;   /* The SDL screen surface */
@@ -54,147 +55,165 @@ static SDL_Rect      statusBar;
 static SDL_Rect      screenRect;
 
 
-static Uint32 BW2RGB[0x400];
-static Uint32 COL2RGB[0x10000];
+/*
+ Dirty line tracking. The video memory write handlers mark blocks of
+ video memory in a dirty map. Only lines that touch dirty blocks are
+ converted and uploaded to the texture. Blocks are cleared before their
+ lines are converted, so writes during conversion show up next time.
+ The dirty line flags are kept by the caller, because the main repainter
+ and the NeXTdimension repainters run on different threads.
+ */
+#define BLIT_MAX_LINES 832 /* NeXT_SCRN_HEIGHT */
 
-static Uint32 bw2rgb(SDL_PixelFormat* format, int bw) {
-    switch(bw & 3) {
-        case 3:  return SDL_MapRGB(format, 0,   0,   0);
-        case 2:  return SDL_MapRGB(format, 85,  85,  85);
-        case 1:  return SDL_MapRGB(format, 170, 170, 170);
-        case 0:  return SDL_MapRGB(format, 255, 255, 255);
-        default: return 0;
+static bool blitFindDirty(bool* lines, volatile Uint8* dirty, int shift, int offset, int pitch, int size) {
+    bool any       = false;
+    bool lastDirty = false;
+    int  last      = -1;
+    for(int y = 0; y < NeXT_SCRN_HEIGHT; y++) {
+        int  start = offset + y * pitch;
+        bool line  = false;
+        /* Lines are in ascending order, blocks shared by two lines are only read once */
+        for(int i = start >> shift; i <= (start + size - 1) >> shift; i++) {
+            if (i != last) {
+                last      = i;
+                lastDirty = dirty[i];
+                if (lastDirty) dirty[i] = 0;
+            }
+            line |= lastDirty;
+        }
+        lines[y]     = line;
+        any         |= line;
     }
+    return any;
 }
 
-static Uint32 col2rgb(SDL_PixelFormat* format, int col) {
-    int r = col & 0xF000; r >>= 12; r |= r << 4;
-    int g = col & 0x0F00; g >>= 8;  g |= g << 4;
-    int b = col & 0x00F0; b >>= 4;  b |= b << 4;
-    return SDL_MapRGB(format, r,   g,   b);
+/* Number of dirty lines starting at line y */
+static int blitDirtyRun(const bool* lines, int y) {
+    int n = 0;
+    while (y + n < NeXT_SCRN_HEIGHT && lines[y + n]) n++;
+    return n;
 }
 
-/*
- BW format is 2bit per pixel
- */
-static void blitBW(SDL_Texture* tex) {
-    void* pixels;
-    int   d;
-    int   pitch = (NeXT_SCRN_WIDTH + (ConfigureParams.System.bTurbo ? 0 : 32)) / 4;
-    SDL_LockTexture(tex, NULL, &pixels, &d);
-    Uint32* dst = (Uint32*)pixels;
+/* Convert dirty lines with a line kernel and upload them */
+static void blitDirtyLines(const bool* lines, SDL_Texture* tex, blitLineFunc line, const Uint8* src, int pitch) {
     for(int y = 0; y < NeXT_SCRN_HEIGHT; y++) {
-        int src     = y * pitch;
-        for(int x = 0; x < NeXT_SCRN_WIDTH/4; x++, src++) {
-            int idx = NEXTVideo[src] * 4;
-            *dst++  = BW2RGB[idx+0];
-            *dst++  = BW2RGB[idx+1];
-            *dst++  = BW2RGB[idx+2];
-            *dst++  = BW2RGB[idx+3];
+        int n = blitDirtyRun(lines, y);
+        if (n) {
+            SDL_Rect r = {0, y, NeXT_SCRN_WIDTH, n};
+            void*    pixels;
+            int      texPitch;
+            SDL_LockTexture(tex, &r, &pixels, &texPitch);
+            for(int i = 0; i < n; i++) {
+                line((Uint32*)((Uint8*)pixels + i * texPitch), src + (y + i) * pitch, NeXT_SCRN_WIDTH);
+            }
+            SDL_UnlockTexture(tex);
+            y += n;
         }
     }
-    SDL_UnlockTexture(tex);
 }
 
-/*
- Color format is 4bit per pixel, big-endian: RGBx
- */
-static void blitColor(SDL_Texture* tex) {
-    void* pixels;
-    int   d;
-    int pitch = NeXT_SCRN_WIDTH + (ConfigureParams.System.bTurbo ? 0 : 32);
-    SDL_LockTexture(tex, NULL, &pixels, &d);
-    Uint32* dst = (Uint32*)pixels;
-    for(int y = 0; y < NeXT_SCRN_HEIGHT; y++) {
-        Uint16* src = (Uint16*)NEXTVideo + (y*pitch);
-        for(int x = 0; x < NeXT_SCRN_WIDTH; x++) {
-            *dst++ = COL2RGB[*src++];
-        }
+static bool blitBW(SDL_Texture* tex) {
+    bool lines[BLIT_MAX_LINES];
+    int  pitch = (NeXT_SCRN_WIDTH + (ConfigureParams.System.bTurbo ? 0 : 32)) / 4;
+    if (!blitFindDirty(lines, NEXTVideoDirty, NEXT_VIDEO_DIRTY_SHIFT, 0, pitch, NeXT_SCRN_WIDTH / 4)) {
+        return false;
     }
-    SDL_UnlockTexture(tex);
+    blitDirtyLines(lines, tex, blitBWLine, NEXTVideo, pitch);
+    return true;
 }
 
-/*
- Dimension format is 8bit per pixel, big-endian: RRGGBBAA
- */
-void blitDimension(Uint32* vram, SDL_Texture* tex) {
+static bool blitColor(SDL_Texture* tex) {
+    bool lines[BLIT_MAX_LINES];
+    int  pitch = (NeXT_SCRN_WIDTH + (ConfigureParams.System.bTurbo ? 0 : 32)) * 2;
+    if (!blitFindDirty(lines, NEXTVideoDirty, NEXT_VIDEO_DIRTY_SHIFT, 0, pitch, NeXT_SCRN_WIDTH * 2)) {
+        return false;
+    }
+    blitDirtyLines(lines, tex, blitColorLine, NEXTVideo, pitch);
+    return true;
+}
+
+bool blitDimension(Uint32* vram, volatile Uint8* dirty, SDL_Texture* tex) {
 #if ND_STEP
     Uint32* src = &vram[0];
 #else
     Uint32* src = &vram[16];
 #endif
+    int     pitch = NeXT_SCRN_WIDTH + 32;
     int     d;
     Uint32  format;
+    bool    lines[BLIT_MAX_LINES];
+    
+    if (!blitFindDirty(lines, dirty, ND_VRAM_DIRTY_SHIFT, (int)(src - vram) * 4, pitch * 4, NeXT_SCRN_WIDTH * 4)) {
+        return false;
+    }
+    
     SDL_QueryTexture(tex, &format, &d, &d, &d);
-    if(SDL_BYTEORDER == SDL_BIG_ENDIAN) {
-        /* Add big-endian accelerated blit loops as needed here */
-        switch (format) {
-            default: {
-                void*   pixels;
-                SDL_LockTexture(tex, NULL, &pixels, &d);
-                Uint32* dst = (Uint32*)pixels;
-
-                /* fallback to SDL_MapRGB */
-                SDL_PixelFormat* pformat = SDL_AllocFormat(format);
-                for(int y = NeXT_SCRN_HEIGHT; --y >= 0;) {
-                    for(int x = NeXT_SCRN_WIDTH; --x >= 0;) {
-                        Uint32 v = *src++;
-                        *dst++   = SDL_MapRGB(pformat, (v >> 8) & 0xFF, (v>>16) & 0xFF, (v>>24) & 0xFF);
-                    }
-                    src += 32;
-                }
-                SDL_FreeFormat(pformat);
-                SDL_UnlockTexture(tex);
-                break;
+    if(SDL_BYTEORDER == SDL_LIL_ENDIAN && format == SDL_PIXELFORMAT_ARGB8888) {
+        for(int y = 0; y < NeXT_SCRN_HEIGHT; y++) {
+            int n = blitDirtyRun(lines, y);
+            if (n) {
+                SDL_Rect r = {0, y, NeXT_SCRN_WIDTH, n};
+                SDL_UpdateTexture(tex, &r, src + y * pitch, pitch * 4);
+                y += n;
             }
         }
     } else {
-        /* Add little-endian accelerated blit loops as needed here */
-        switch (format) {
-            case SDL_PIXELFORMAT_ARGB8888: {
-                SDL_UpdateTexture(tex, NULL, src, (NeXT_SCRN_WIDTH+32)*4);
-                break;
-            }
-            default: {
-                void*   pixels;
-                SDL_LockTexture(tex, NULL, &pixels, &d);
-                Uint32* dst = (Uint32*)pixels;
-
-                /* fallback to SDL_MapRGB */
-                SDL_PixelFormat* pformat = SDL_AllocFormat(format);
-                for(int y = NeXT_SCRN_HEIGHT; --y >= 0;) {
-                    for(int x = NeXT_SCRN_WIDTH; --x >= 0;) {
-                        Uint32 v = *src++;
-                        *dst++   = SDL_MapRGB(pformat, (v >> 16) & 0xFF, (v>>8) & 0xFF, (v>>0) & 0xFF);
-                    }
-                    src += 32;
+        /* Convert with shifts derived from the texture format */
+        ndformat_t            f;
+        blitDimensionLineFunc line;
+        blitDimensionFormat(&f, format);
+        line = blitDimensionSelect(&f, BLIT_ISA_BEST);
+        
+        for(int y = 0; y < NeXT_SCRN_HEIGHT; y++) {
+            int n = blitDirtyRun(lines, y);
+            if (n) {
+                SDL_Rect r = {0, y, NeXT_SCRN_WIDTH, n};
+                void*    pixels;
+                int      texPitch;
+                SDL_LockTexture(tex, &r, &pixels, &texPitch);
+                for(int i = 0; i < n; i++) {
+                    line((Uint32*)((Uint8*)pixels + i * texPitch), src + (y + i) * pitch, NeXT_SCRN_WIDTH, &f);
                 }
-                SDL_FreeFormat(pformat);
                 SDL_UnlockTexture(tex);
-                break;
+                y += n;
             }
         }
     }
+    return true;
 }
 
 /*
- Blit NeXT framebuffer to texture.
+ Blit NeXT framebuffer to texture. Returns true if anything changed.
  */
 static bool blitScreen(SDL_Texture* tex) {
+    static int lastMode = -1;
+    int        mode;
+    
     if (ConfigureParams.Screen.nMonitorType==MONITOR_TYPE_DIMENSION) {
-        Uint32* vram = nd_vram_for_slot(ND_SLOT(ConfigureParams.Screen.nMonitorNum));
+        int slot = ND_SLOT(ConfigureParams.Screen.nMonitorNum);
+        Uint32*         vram  = nd_vram_for_slot(slot);
+        volatile Uint8* dirty = nd_vram_dirty_for_slot(slot);
         if (vram) {
-            blitDimension(vram, tex);
-            return true;
+            /* Redraw everything after switching the display */
+            mode = 0x100 | slot;
+            if (mode != lastMode) {
+                memset((void*)dirty, 1, ND_VRAM_DIRTY_SIZE);
+                lastMode = mode;
+            }
+            return blitDimension(vram, dirty, tex);
         }
     } else {
         if (NEXTVideo) {
+            mode = (ConfigureParams.System.bColor ? 2 : 0) | (ConfigureParams.System.bTurbo ? 1 : 0);
+            if (mode != lastMode) {
+                memset((void*)NEXTVideoDirty, 1, NEXT_VIDEO_DIRTY_SIZE);
+                lastMode = mode;
+            }
             if (ConfigureParams.System.bColor) {
-                blitColor(tex);
+                return blitColor(tex);
             } else {
-                blitBW(tex);
+                return blitBW(tex);
             }
-            return true;
         }
     }
     return false;
@@ -244,18 +263,8 @@ static int repainter(void* unused) {
     /* Configure some SDL stuff: */
     SDL_ShowCursor(SDL_DISABLE);
     
-    /* Setup lookup tables */
-    SDL_PixelFormat* pformat = SDL_AllocFormat(format);
-    /* initialize BW lookup table */
-    for(int i = 0; i < 0x100; i++) {
-        BW2RGB[i*4+0] = bw2rgb(pformat, i>>6);
-        BW2RGB[i*4+1] = bw2rgb(pformat, i>>4);
-        BW2RGB[i*4+2] = bw2rgb(pformat, i>>2);
-        BW2RGB[i*4+3] = bw2rgb(pformat, i>>0);
-    }
-    /* initialize color lookup table */
-    for(int i = 0; i < 0x10000; i++)
-        COL2RGB[SDL_BYTEORDER == SDL_BIG_ENDIAN ? i : SDL_Swap16(i)] = col2rgb(pformat, i);
+    /* Setup lookup tables and select conversion kernels */
+    blitInit(format);
     
     /* Initialization done -> signal */
     SDL_SemPost(initLatch);
@@ -315,7 +324,8 @@ void Screen_Pause(bool pause) {
 
 /*-----------------------------------------------------------------------*/
 /**
- * Init Screen, creates window and starts repaint thread
+ * Init Screen, creates window and starts repaint thread.
+ * In headless mode there is no window, sdlscrn stays NULL.
  */
 void Screen_Init(void) {
     /* Set initial window resolution */
@@ -340,6 +350,11 @@ void Screen_Init(void) {
     screenRect.h = height;
     screenRect.w = width;
     
+    if (bHeadless) {
+        fprintf(stderr, "Headless mode, no SDL screen\n");
+        return;
+    }
+    
     /* Set new video mode */
     SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
     
@@ -400,7 +415,7 @@ void Screen_UnInit(void) {
 void Screen_EnterFullScreen(void) {
     bool bWasRunning;
 
-    if (!bInFullScreen) {
+    if (!bInFullScreen && sdlscrn) {
         /* Hold things... */
         bWasRunning = Main_PauseEmulation(false);
         bInFullScreen = true;
@@ -548,6 +563,9 @@ static void statusBarUpdate(void) {
 }
 
 bool Update_StatusBar(void) {
+    if (!sdlscrn) {
+        return !bQuitProgram;
+    }
     shieldStatusBarUpdate = true;
     Statusbar_OverlayBackup(sdlscrn);
     Statusbar_Update(sdlscrn);
@@ -10,6 +10,7 @@
 #include "floppy.h"
 #include "cycInt.h"
 #include "file.h"
+#include "diskimage.h"
 #include "statusbar.h"
 
 
@@ -48,7 +49,7 @@ struct {
     Uint8 sector;
     Uint8 blocksize;
     
-    FILE* dsk;
+    DISKIMAGE* dsk;
     Uint32 floppysize;
     
     Uint32 seekoffset;
@@ -989,7 +990,7 @@ static void floppy_read_sector(void) {
         Log_Printf(LOG_FLP_CMD_LEVEL, "[Floppy] Read sector at offset %i",logical_sec);
 
         flp_buffer.size = flp_buffer.limit = sec_size;
-        File_Read(flp_buffer.data, flp_buffer.size, logical_sec*sec_size, flpdrv[drive].dsk);
+        DiskImage_Read(flpdrv[drive].dsk, flp_buffer.data, flp_buffer.size, logical_sec*sec_size);
         flpdrv[drive].sector++;
         flp_sector_counter--;
     }
@@ -1017,7 +1018,7 @@ static void floppy_write_sector(void) {
     } else {
         Log_Printf(LOG_FLP_CMD_LEVEL, "[Floppy] Write sector at offset %i",logical_sec);
         
-        File_Write(flp_buffer.data, flp_buffer.size, logical_sec*sec_size, flpdrv[drive].dsk);
+        DiskImage_Write(flpdrv[drive].dsk, flp_buffer.data, flp_buffer.size, logical_sec*sec_size);
         flp_buffer.size = 0;
         flp_buffer.limit = sec_size;
         flpdrv[drive].sector++;
@@ -1060,7 +1061,7 @@ static void floppy_format_sector(void) {
     } else {
         Log_Printf(LOG_FLP_CMD_LEVEL, "[Floppy] Format sector at offset %i (%i/%i/%i), blocksize: %i",
                    logical_sec,c,h,s,sec_size);
-        File_Write(flp_buffer.data, flp_buffer.size, logical_sec*sec_size, flpdrv[drive].dsk);
+        DiskImage_Write(flpdrv[drive].dsk, flp_buffer.data, flp_buffer.size, logical_sec*sec_size);
         flp_buffer.size = 0;
         flp_buffer.limit = 4;
     }
@@ -1173,9 +1174,9 @@ static void Floppy_Init(void) {
 
 static void Floppy_Uninit(void) {
     if (flpdrv[0].dsk)
-        File_Close(flpdrv[0].dsk);
+        DiskImage_Close(flpdrv[0].dsk);
     if (flpdrv[1].dsk) {
-        File_Close(flpdrv[1].dsk);
+        DiskImage_Close(flpdrv[1].dsk);
     }
     flpdrv[0].dsk = flpdrv[1].dsk = NULL;
     flpdrv[0].inserted = flpdrv[1].inserted = false;
@@ -1214,7 +1215,7 @@ int Floppy_Insert(int drive) {
     }
     
     if (ConfigureParams.Floppy.drive[drive].bWriteProtected) {
-        flpdrv[drive].dsk = File_Open(ConfigureParams.Floppy.drive[drive].szImageName, "rb");
+        flpdrv[drive].dsk = DiskImage_Open(ConfigureParams.Floppy.drive[drive].szImageName, false);
         if (flpdrv[drive].dsk == NULL) {
             Log_Printf(LOG_WARN, "Floppy Disk%i: Cannot open image file %s\n",
                        drive, ConfigureParams.Floppy.drive[drive].szImageName);
@@ -1225,10 +1226,10 @@ int Floppy_Insert(int drive) {
         }
         flpdrv[drive].protected=true;
     } else {
-        flpdrv[drive].dsk = File_Open(ConfigureParams.Floppy.drive[drive].szImageName, "rb+");
+        flpdrv[drive].dsk = DiskImage_Open(ConfigureParams.Floppy.drive[drive].szImageName, true);
         flpdrv[drive].protected=false;
         if (flpdrv[drive].dsk == NULL) {
-            flpdrv[drive].dsk = File_Open(ConfigureParams.Floppy.drive[drive].szImageName, "rb");
+            flpdrv[drive].dsk = DiskImage_Open(ConfigureParams.Floppy.drive[drive].szImageName, false);
             if (flpdrv[drive].dsk == NULL) {
                 Log_Printf(LOG_WARN, "Floppy Disk%i: Cannot open image file %s\n",
                            drive, ConfigureParams.Floppy.drive[drive].szImageName);
@@ -1264,7 +1265,7 @@ void Floppy_Eject(int drive) {
     Log_Printf(LOG_WARN, "Unloading floppy disk %i",drive);
     Log_Printf(LOG_WARN, "Floppy disk %i: Eject",drive);
     
-    File_Close(flpdrv[drive].dsk);
+    DiskImage_Close(flpdrv[drive].dsk);
     flpdrv[drive].floppysize = 0;
     flpdrv[drive].blocksize = 0;
     flpdrv[drive].dsk=NULL;
@@ -1275,6 +1276,15 @@ void Floppy_Eject(int drive) {
     ConfigureParams.Floppy.drive[drive].szImageName[0]='\0';
 }
 
+void Floppy_FlushDisks(void) {
+    int i;
+    for (i = 0; i < FLP_MAX_DRIVES; i++) {
+        if (flpdrv[i].dsk) {
+            DiskImage_Flush(flpdrv[i].dsk);
+        }
+    }
+}
+
 void Floppy_Reset(void) {
     Floppy_Uninit();
     Floppy_Init();
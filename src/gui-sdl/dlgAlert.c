@@ -151,6 +151,12 @@ static int DlgAlert_ShowDlg(const char *text)
 
 	free(orig_t);
 
+	/* No screen in headless mode, just log the text */
+	if (!sdlscrn) {
+		fprintf(stderr, "%s\n", text);
+		return false;
+	}
+
 	if (SDLGui_SetScreen(sdlscrn))
 		return false;
 	SDLGui_CenterDlg(alertdlg);
@@ -1,3 +1,6 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
 #include "config.h"
 
 #if HAVE_NANOSLEEP
@@ -9,6 +12,11 @@
 #endif
 #endif
 #include <errno.h>
+#if defined(__linux__)
+#include <sched.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
 
 #include "host.h"
 #include "configuration.h"
@@ -16,6 +24,7 @@
 #include "log.h"
 #include "memory.h"
 #include "newcpu.h"
+#include "memorySnapShot.h"
 
 /* NeXTdimension blank handling, see nd_sdl.c */
 void nd_display_blank(int num);
@@ -42,23 +51,29 @@ static bool         currentIsRealtime;
 static Uint64       hardClockExpected;
 static Uint64       hardClockActual;
 static time_t       unixTimeStart;
-static lock_t       timeLock;
-static Uint64       saveTime;
+static atomic_int   saveTime;
+static Uint64       saveTimeNext;
 
 // external
 extern Sint64       nCyclesMainCounter;
 extern struct regstruct regs;
 
-static inline Uint64 real_time(void) {
-    Uint64 rt = (SDL_GetPerformanceCounter() - perfCounterStart);
-    if (perfCounterFreqInt) {
-        rt /= perfDivisor;
-    } else {
-        rt *= perfMultiplicator;
-    }
-    return rt;
+// Clocks in microseconds, selected once by host_reset and host_switch_time
+static Uint64 real_time_div(void) {
+    return (SDL_GetPerformanceCounter() - perfCounterStart) / perfDivisor;
 }
 
+static Uint64 real_time_mul(void) {
+    return (SDL_GetPerformanceCounter() - perfCounterStart) * perfMultiplicator;
+}
+
+static Uint64 cycle_time(void) {
+    return (nCyclesMainCounter - cycleCounterStart) / cycleDivisor;
+}
+
+static Uint64 (*real_time)(void) = real_time_div;
+static Uint64 (*host_clock)(void) = cycle_time;
+
 #define DAY_TO_US (1000000ULL * 60 * 60 * 24)
 
 // Report counter capacity
@@ -142,7 +157,7 @@ void host_reset(void) {
     hardClockActual   = 0;
     enableRealtime    = ConfigureParams.System.bRealtime;
     osDarkmatter      = false;
-    saveTime          = 0;
+    saveTimeNext      = 0;
     
     for(int i = NUM_BLANKS; --i >= 0;) {
         vblCounter[i] = 0;
@@ -154,6 +169,8 @@ void host_reset(void) {
     perfCounterFreqInt = (perfFrequency % 1000000ULL) == 0;
     perfDivisor        = perfFrequency / 1000000ULL;
     perfMultiplicator  = 1000000.0 / perfFrequency;
+    real_time          = perfCounterFreqInt ? real_time_div : real_time_mul;
+    host_clock         = cycle_time;
     
     host_report_limits();
     host_check_unix_time();
@@ -194,56 +211,50 @@ void host_hardclock(int expected, int actual) {
     }
 }
 
-// this can be used by other threads to read hostTime
+// this can be used by other threads to read hostTime in seconds
 Uint64 host_get_save_time() {
-    Uint64 hostTime;
-    host_lock(&timeLock);
-    hostTime = saveTime;
-    host_unlock(&timeLock);
-    return hostTime / 1000000ULL;
+    return host_atomic_get(&saveTime);
 }
 
-// Return current time as microseconds
-Uint64 host_time_us() {
-    Uint64 hostTime;
-    
-    host_lock(&timeLock);
+// Switch between real-time and cycle-time, m68k thread only
+static void host_switch_time(Uint64 hostTime, bool realtime) {
+    Uint64 realTime = real_time();
     
     if(currentIsRealtime) {
-        hostTime = real_time();
+        // switching from real-time to cycle-time
+        cycleCounterStart = nCyclesMainCounter - realTime * cycleDivisor;
     } else {
-        hostTime  = nCyclesMainCounter - cycleCounterStart;
-        hostTime /= cycleDivisor;
+        // switching from cycle-time to real-time
+        Sint64 realTimeOffset = (Sint64)hostTime - realTime;
+        if(realTimeOffset > 0) {
+            // if hostTime is in the future, wait until realTime is there as well
+            if(realTimeOffset > 10000LL)
+                host_sleep_us(realTimeOffset);
+            else
+                while(real_time() < hostTime) {}
+        }
     }
+    currentIsRealtime = realtime;
+    host_clock        = realtime ? real_time : cycle_time;
+}
+
+// Return current time as microseconds. All state is owned by the m68k
+// thread, other threads only read the published seconds.
+Uint64 host_time_us() {
+    Uint64 hostTime = host_clock();
     
-    // save hostTime to be read by other threads
-    saveTime = hostTime;
+    // publish hostTime to other threads once per second
+    if(hostTime >= saveTimeNext) {
+        host_atomic_set(&saveTime, (int)(hostTime / 1000000ULL));
+        saveTimeNext = (hostTime / 1000000ULL + 1) * 1000000ULL;
+    }
     
     // switch to realtime if...
     // 1) ...realtime mode is enabled and...
     // 2) ...either we are running darkmatter or the m68k CPU is in user mode
     bool state = (osDarkmatter || !(regs.s)) && enableRealtime;
-    if(currentIsRealtime != state) {
-        Uint64 realTime  = real_time();
-        
-        if(currentIsRealtime) {
-            // switching from real-time to cycle-time
-            cycleCounterStart = nCyclesMainCounter - realTime * cycleDivisor;
-        } else {
-            // switching from cycle-time to real-time
-            Sint64 realTimeOffset = (Sint64)hostTime - realTime;
-            if(realTimeOffset > 0) {
-                // if hostTime is in the future, wait until realTime is there as well
-                if(realTimeOffset > 10000LL)
-                    host_sleep_us(realTimeOffset);
-                else
-                    while(real_time() < hostTime) {}
-            }
-        }
-        currentIsRealtime = state;
-    }
-    
-    host_unlock(&timeLock);
+    if(currentIsRealtime != state)
+        host_switch_time(hostTime, state);
     
     return hostTime;
 }
@@ -295,6 +306,33 @@ void host_pause_time(bool pausing) {
     }
 }
 
+// Save/restore the emulated time base. On restore time continues in cycle-time
+// mode from the saved host time, with the realtime counter rebased to match.
+void Host_MemorySnapShot_Capture(bool bSave) {
+    Uint64 hostTime = 0;
+    Sint64 unixTime = unixTimeStart;
+    
+    if(bSave)
+        hostTime = host_time_us();
+    
+    MemorySnapShot_Store(&hostTime, sizeof(hostTime));
+    MemorySnapShot_Store(&unixTime, sizeof(unixTime));
+    MemorySnapShot_Store(&osDarkmatter, sizeof(osDarkmatter));
+    
+    if(!bSave) {
+        Uint64 perfCounter = SDL_GetPerformanceCounter();
+        
+        cycleCounterStart = nCyclesMainCounter - hostTime * cycleDivisor;
+        perfCounterStart  = perfCounter - (hostTime / 1000000ULL) * perfFrequency;
+        perfCounterStart -= ((hostTime % 1000000ULL) * perfFrequency) / 1000000ULL;
+        pauseTimeStamp    = perfCounter;
+        currentIsRealtime = false;
+        host_clock        = cycle_time;
+        saveTimeNext      = 0;
+        unixTimeStart     = unixTime;
+    }
+}
+
 /*-----------------------------------------------------------------------*/
 /**
  * Sleep for a given number of micro seconds.
@@ -356,6 +394,20 @@ int host_thread_wait(thread_t* thread) {
   return status;
 }
 
+/* Pin the calling thread to a host CPU, returns false if not supported */
+bool host_thread_affinity(int cpu) {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+  return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) != 0;
+#else
+  return false;
+#endif
+}
+
 mutex_t* host_mutex_create(void) {
     return SDL_CreateMutex();
 }
@@ -372,6 +424,23 @@ void host_mutex_destroy(mutex_t* mutex) {
     SDL_DestroyMutex(mutex);
 }
 
+cond_t* host_cond_create(void) {
+    return SDL_CreateCond();
+}
+
+/* Wait for a signal or until the timeout expires, mutex must be locked */
+void host_cond_wait(cond_t* cond, mutex_t* mutex, Uint32 ms) {
+    SDL_CondWaitTimeout(cond, mutex, ms);
+}
+
+void host_cond_signal(cond_t* cond) {
+    SDL_CondSignal(cond);
+}
+
+void host_cond_destroy(cond_t* cond) {
+    SDL_DestroyCond(cond);
+}
+
 int host_num_cpus() {
   return  SDL_GetCPUCount();
 }
@@ -387,7 +456,7 @@ const char* host_report(Uint64 realTime, Uint64 hostTime) {
     hardClock /= hardClockActual == 0 ? 1 : hardClockActual;
     
     char* r = report;
-    r += sprintf(r, "[%s] hostTime:%llu hardClock:%.3fMHz", enableRealtime ? "Variable" : "CycleTime", hostTime, hardClock);
+    r += sprintf(r, "[%s] hostTime:%llu hardClock:%.3fMHz", enableRealtime ? "Variable" : "CycleTime", (unsigned long long)hostTime, hardClock);
 
     for(int i = NUM_BLANKS; --i >= 0;) {
         r += sprintf(r, " %s:%.1fHz", BLANKS[i], (double)vblCounter[i]/dVT);
@@ -0,0 +1,51 @@
+/*
+  Previous - blit.h
+
+  This file is distributed under the GNU Public License, version 2 or at
+  your option any later version. Read the file gpl.txt for details.
+*/
+
+#ifndef PREV_BLIT_H
+#define PREV_BLIT_H
+
+#include <SDL.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Converts one line of the framebuffer to the texture format */
+typedef void (*blitLineFunc)(Uint32* dst, const Uint8* src, int width);
+
+/* Channel positions for NeXTdimension to texture conversion */
+typedef struct {
+    int    rIn, gIn, bIn;
+    int    rOut, gOut, bOut;
+    int    rLoss, gLoss, bLoss;
+    Uint32 aMask;
+} ndformat_t;
+
+typedef void (*blitDimensionLineFunc)(Uint32* dst, const Uint32* src, int width, const ndformat_t* f);
+
+/* Highest instruction set the kernels may use */
+enum {
+    BLIT_ISA_SCALAR,
+    BLIT_ISA_SSE2,
+    BLIT_ISA_AVX2,
+    BLIT_ISA_NEON,
+    BLIT_ISA_BEST,
+};
+
+extern blitLineFunc blitBWLine;
+extern blitLineFunc blitColorLine;
+
+void blitInit(Uint32 format);
+bool blitSelect(Uint32 format, int isa);
+void blitDimensionFormat(ndformat_t* f, Uint32 format);
+blitDimensionLineFunc blitDimensionSelect(const ndformat_t* f, int isa);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PREV_BLIT_H */
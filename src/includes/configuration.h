@@ -94,6 +94,8 @@ typedef enum {
   SHORTCUT_QUIT,
   SHORTCUT_DIMENSION,
   SHORTCUT_STATUSBAR,
+  SHORTCUT_SAVEMEM,
+  SHORTCUT_LOADMEM,
   SHORTCUT_KEYS,  /* number of shortcuts */
   SHORTCUT_NONE
 } SHORTCUTKEYIDX;
@@ -134,6 +136,7 @@ typedef struct
 {
   int nMemoryBankSize[4];
   MEMORY_SPEED nMemorySpeed;
+  char szMemoryCaptureFileName[FILENAME_MAX];
 } CNF_MEMORY;
 
 
@@ -188,6 +191,7 @@ typedef enum
 typedef struct {
     SCSIDISK target[ESP_MAX_DEVS];
     int nWriteProtection;
+    char szOverlayDir[FILENAME_MAX];
 } CNF_SCSI;
 
 
@@ -329,6 +333,7 @@ typedef struct
   FPUTYPE n_FPUType;
   bool bCompatibleFPU;            /* More compatible FPU */
   bool bMMU;                      /* TRUE if MMU is enabled */
+  bool bMapDiskImages;            /* Access disk images through mmap */
 } CNF_SYSTEM;
 
 /* NeXT Dimension configuration */
@@ -342,6 +347,7 @@ typedef struct
 
 typedef struct {
     bool bI860Thread;
+    bool bI860JIT;
     bool bMainDisplay;
     int nMainDisplay;
     NDBOARD board[ND_MAX_BOARDS];
@@ -51,14 +51,13 @@ enum {
 typedef struct
 {
     int    type;   /* Type of time (CPU Cycles, microseconds) or NONE for inactive */
-    Sint64 time;   /* number of CPU cycles to go until interupt or absolute microsecond timeout until interrupt */
+    Sint64 time;   /* absolute CPU cycle or microsecond timeout until interrupt (cycles to go for PendingInterrupt) */
     void (*pFunction)(void);
 } INTERRUPTHANDLER;
 
 extern INTERRUPTHANDLER PendingInterrupt;
 
 extern Sint64 nCyclesMainCounter;
-extern Sint64 nCyclesOver;
 
 extern int usCheckCycles;
 
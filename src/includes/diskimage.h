@@ -0,0 +1,31 @@
+/*
+  Previous - diskimage.h
+
+  This file is distributed under the GNU Public License, version 2 or at
+  your option any later version. Read the file gpl.txt for details.
+*/
+
+#pragma once
+
+#ifndef __DISKIMAGE_H__
+#define __DISKIMAGE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct diskimage DISKIMAGE;
+
+DISKIMAGE *DiskImage_Open(const char *pszFileName, bool bWritable);
+void       DiskImage_Close(DISKIMAGE *img);
+Uint64     DiskImage_Size(DISKIMAGE *img);
+bool       DiskImage_IsMapped(DISKIMAGE *img);
+bool       DiskImage_Read(DISKIMAGE *img, Uint8 *data, Uint32 size, Uint64 offset);
+bool       DiskImage_Write(DISKIMAGE *img, Uint8 *data, Uint32 size, Uint64 offset);
+void       DiskImage_Flush(DISKIMAGE *img);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __DISKIMAGE_H__ */
@@ -77,3 +77,5 @@ void M2MDMA_IO_Handler(void);
 
 /* Function for video interrupt */
 void dma_video_interrupt(void);
+
+void DMA_MemorySnapShot_Capture(bool bSave);
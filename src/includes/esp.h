@@ -81,3 +81,5 @@ extern Uint32 esp_counter;
 
 void ESP_InterruptHandler(void);
 void ESP_IO_Handler(void);
+
+void ESP_MemorySnapShot_Capture(bool bSave);
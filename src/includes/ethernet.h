@@ -39,6 +39,7 @@ extern EthernetBuffer enet_rx_buffer;
 void ENET_IO_Handler(void);
 void Ethernet_Reset(bool hard);
 void enet_receive(Uint8 *pkt, int len);
+void Ethernet_MemorySnapShot_Capture(bool bSave);
 
 /* Turbo ethernet controller */
 void EN_Turbo_RX_Status_Read(void);
@@ -16,6 +16,7 @@ void FLP_IO_Handler(void);
 void Floppy_Reset(void);
 int Floppy_Insert(int drive);
 void Floppy_Eject(int drive);
+void Floppy_FlushDisks(void);
 
 typedef struct {
     Uint8 data[1024];
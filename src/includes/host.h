@@ -36,6 +36,7 @@ extern "C" {
     typedef SDL_Thread         thread_t;
     typedef SDL_ThreadFunction thread_func_t;
     typedef SDL_mutex          mutex_t;
+    typedef SDL_cond           cond_t;
     
     void        host_reset(void);
     void        host_blank(int slot, int src, bool state);
@@ -55,6 +56,7 @@ extern "C" {
     void        host_hardclock(int expected, int actual);
     Sint64      host_real_time_offset(void);
     void        host_pause_time(bool pausing);
+    void        Host_MemorySnapShot_Capture(bool bSave);
     const char* host_report(Uint64 realTime, Uint64 hostTime);
     
     void        host_lock(lock_t* lock);
@@ -67,8 +69,13 @@ extern "C" {
     void        host_mutex_lock(mutex_t* mutex);
     void        host_mutex_unlock(mutex_t* mutex);
     void        host_mutex_destroy(mutex_t* mutex);
+    cond_t*     host_cond_create(void);
+    void        host_cond_wait(cond_t* cond, mutex_t* mutex, Uint32 ms);
+    void        host_cond_signal(cond_t* cond);
+    void        host_cond_destroy(cond_t* cond);
     thread_t*   host_thread_create(thread_func_t, const char* name, void* data);
     int         host_thread_wait(thread_t* thread);
+    bool        host_thread_affinity(int cpu);
     Uint8*      host_malloc_aligned(size_t size);
     #ifdef __cplusplus
 }
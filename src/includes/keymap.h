@@ -19,6 +19,7 @@ void Keymap_DebounceAllKeys(void);
 void Keymap_KeyDown(SDL_Keysym *sdlkey);
 void Keymap_MouseWheel(SDL_MouseWheelEvent* event);
 void Keymap_KeyUp(SDL_Keysym *sdlkey);
+bool Keymap_GetCharacterKey(char asckey, SDL_Keysym *sdlkey, bool *shift);
 void Keymap_SimulateCharacter(char asckey, bool press);
 
 void Keymap_MouseMove(int dx, int dy, float lin, float exp);
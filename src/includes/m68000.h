@@ -165,8 +165,6 @@ extern const char *OpcodeName[];
  * Add CPU cycles.
  */
 static inline void M68000_AddCycles(int cycles) {
-    nCyclesOver += cycles;
-    
     if(PendingInterrupt.type == CYC_INT_CPU)
         PendingInterrupt.time -= cycles;
 
@@ -181,6 +179,8 @@ static inline void M68000_AddCycles(int cycles) {
 
 void M68000_Init(void);
 void M68000_Reset(bool bCold);
+void M68000_MemorySnapShot_Capture(bool bSave);
+void M68000_ApplySnapShot(void);
 void M68000_Stop(void);
 void M68000_Start(void);
 void M68000_CheckCpuSettings(void);
@@ -0,0 +1,23 @@
+/*
+  Hatari - memorySnapShot.h
+
+  This file is distributed under the GNU Public License, version 2 or at
+  your option any later version. Read the file gpl.txt for details.
+*/
+
+#ifndef HATARI_MEMORYSNAPSHOT_H
+#define HATARI_MEMORYSNAPSHOT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+extern void MemorySnapShot_Capture(const char *pszFileName, bool bConfirm);
+extern void MemorySnapShot_Restore(const char *pszFileName, bool bConfirm);
+extern void MemorySnapShot_Store(void *pData, int Size);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* HATARI_MEMORYSNAPSHOT_H */
@@ -1,9 +1,11 @@
 void MO_Reset(void);
 void MO_Insert(int disk);
 void MO_Eject(int disk);
+void MO_FlushDisks(void);
 
 void MO_InterruptHandler(void);
 void MO_IO_Handler(void);
+void MO_MemorySnapShot_Capture(bool bSave);
 void ECC_IO_Handler(void);
 
 typedef struct {
@@ -0,0 +1,21 @@
+/*
+  Previous - options.h
+
+  This file is distributed under the GNU Public License, version 2 or at
+  your option any later version. Read the file gpl.txt for details.
+*/
+
+#ifndef PREVIOUS_OPTIONS_H
+#define PREVIOUS_OPTIONS_H
+
+/* Startup actions requested on the command line */
+extern const char *Opt_MemStateFile;    /* Memory snapshot to restore */
+extern bool        Opt_CommitOverlays;  /* Write SCSI overlays to disk images */
+extern bool        Opt_DiscardOverlays; /* Empty SCSI overlays */
+extern const char *Opt_ScriptFile;      /* Input script for headless mode */
+extern const char *Opt_EvTraceFile;     /* Binary event trace output */
+extern const char *Opt_EvTraceMask;     /* Subsystems to trace */
+
+extern bool Opt_ParseParameters(int argc, const char * const argv[]);
+
+#endif /* PREVIOUS_OPTIONS_H */
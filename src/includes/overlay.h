@@ -0,0 +1,37 @@
+/*
+  Previous - overlay.h
+
+  This file is distributed under the GNU Public License, version 2 or at
+  your option any later version. Read the file gpl.txt for details.
+*/
+
+#pragma once
+
+#ifndef __OVERLAY_H__
+#define __OVERLAY_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define OVERLAY_BLOCKSIZE   512
+
+typedef struct overlay OVERLAY;
+
+bool     Overlay_IsOverlay(const char *pszFileName);
+OVERLAY *Overlay_Open(const char *pszBaseName, const char *pszDeltaName);
+void     Overlay_Close(OVERLAY *ovl);
+Uint64   Overlay_Size(OVERLAY *ovl);
+Uint32   Overlay_Blocks(OVERLAY *ovl);
+bool     Overlay_IsWritable(OVERLAY *ovl);
+bool     Overlay_Read(OVERLAY *ovl, Uint8 *data, Uint32 block);
+bool     Overlay_Write(OVERLAY *ovl, Uint8 *data, Uint32 block);
+bool     Overlay_Commit(OVERLAY *ovl);
+void     Overlay_Discard(OVERLAY *ovl);
+void     Overlay_Flush(OVERLAY *ovl);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __OVERLAY_H__ */
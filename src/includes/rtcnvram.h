@@ -10,3 +10,4 @@ void nvram_checksum(int force);
 char * get_rtc_ram_info(void);
 
 void RTC_Reset(void);
+void RTC_MemorySnapShot_Capture(bool bSave);
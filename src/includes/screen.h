@@ -35,7 +35,7 @@ void Screen_StatusbarChanged(void);
 bool Update_StatusBar(void);
 void SDL_UpdateRects(SDL_Surface *screen, int numrects, SDL_Rect *rects);
 void SDL_UpdateRect(SDL_Surface *screen, Sint32 x, Sint32 y, Sint32 w, Sint32 h);
-void blitDimension(Uint32* vram, SDL_Texture* tex);
+bool blitDimension(Uint32* vram, volatile Uint8* dirty, SDL_Texture* tex);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,23 @@
+/*
+  Previous - screenSnapShot.h
+
+  This file is distributed under the GNU Public License, version 2 or at
+  your option any later version. Read the file gpl.txt for details.
+*/
+
+#pragma once
+
+#ifndef __SCREENSNAPSHOT_H__
+#define __SCREENSNAPSHOT_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+bool ScreenSnapShot_SavePNG(const char *pszFileName);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __SCREENSNAPSHOT_H__ */
@@ -0,0 +1,17 @@
+/*
+  Previous - script.h
+
+  This file is distributed under the GNU Public License, version 2 or at
+  your option any later version. Read the file gpl.txt for details.
+*/
+
+#pragma once
+
+#ifndef __SCRIPT_H__
+#define __SCRIPT_H__
+
+bool Script_Init(const char *pszFileName);
+void Script_UnInit(void);
+void Script_Process(void);
+
+#endif /* __SCRIPT_H__ */
@@ -20,10 +20,12 @@ extern SCSIBusStatus SCSIbus;
 #define SCSI_CDB_MAX_SIZE 12
 
 
-/* This buffer temporarily stores data to be written to memory or disk */
+/* This buffer temporarily stores data to be written to memory or disk.
+ * Reads fill it with up to SCSI_BUFFER_BLOCKS blocks at once. */
+#define SCSI_BUFFER_BLOCKS 64
 
 typedef struct {
-    Uint8 data[512]; /* FIXME: BLOCKSIZE */
+    Uint8 data[SCSI_BUFFER_BLOCKS*512];
     int limit;
     int size;
     bool disk;
@@ -38,12 +40,21 @@ void SCSI_Uninit(void);
 void SCSI_Reset(void);
 void SCSI_Insert(Uint8 target);
 void SCSI_Eject(Uint8 target);
+void SCSI_CommitOverlays(void);
+void SCSI_FlushDisks(void);
+void SCSI_DiscardOverlays(void);
 
 Uint8 SCSIdisk_Send_Status(void);
 Uint8 SCSIdisk_Send_Message(void);
 Uint8 SCSIdisk_Send_Data(void);
+int SCSIdisk_Send_Data_Burst(Uint8 *dst, int max);
 void SCSIdisk_Receive_Data(Uint8 val);
 bool SCSIdisk_Select(Uint8 target);
 void SCSIdisk_Receive_Command(Uint8 *commandbuf, Uint8 identify);
 
 Sint64 SCSIdisk_Time(void);
+
+void SCSI_MemorySnapShot_Capture(bool bSave);
+
+const char* SCSI_Reports(Uint64 realTime, Uint64 hostTime);
+void SCSI_CacheInfo(FILE *fp);
@@ -65,6 +65,7 @@ int scr_get_interrupt_level(Uint32 interrupt);
 
 extern Uint32 scrIntStat;
 extern Uint32 scrIntMask;
+extern int    scrIntLevel;
 
 /**
  * Return interrupt number (1 - 7), 0 means no interrupt.
@@ -72,16 +73,16 @@ extern Uint32 scrIntMask;
  * due to the interrupt level field in the SR.
  */
 static inline int intlev(void) {
-    /* Poll interrupt level from interrupt status and mask registers
-     * --> see sysReg.c
+    /* Interrupt level is updated on changes of the interrupt status and
+     * mask registers, which also set SPCFLAG_INT --> see sysReg.c
      */
-    Uint32 interrupt = scrIntStat&scrIntMask;
-    return interrupt ? scr_get_interrupt_level(interrupt) : 0;
+    return scrIntLevel;
 }
 
 void set_dsp_interrupt(Uint8 state);
 
 void SCR_Reset(void);
+void SCR_MemorySnapShot_Capture(bool bSave);
     
 void SCR1_Read0(void);
 void SCR1_Read1(void);
@@ -8,4 +8,5 @@ void tmc_bput(uaecptr addr, uae_u32 b);
 
 void tmc_video_interrupt(void);
 
-void TMC_Reset(void);
\ No newline at end of file
+void TMC_Reset(void);
+void TMC_MemorySnapShot_Capture(bool bSave);
\ No newline at end of file
@@ -475,34 +475,91 @@ void Keymap_KeyUp(SDL_Keysym *sdlkey) {
     kms_keyup(next_mod, next_key);
 }
 
+/* Keys of the characters that are not letters on a US keyboard. The key
+ * symbol is the unshifted character. */
+static const struct {
+	char key;		/* character without shift */
+	char shifted;		/* character with shift */
+	SDL_Scancode scancode;
+} KeymapCharacters[] = {
+	{ '1',  '!', SDL_SCANCODE_1 },
+	{ '2',  '@', SDL_SCANCODE_2 },
+	{ '3',  '#', SDL_SCANCODE_3 },
+	{ '4',  '$', SDL_SCANCODE_4 },
+	{ '5',  '%', SDL_SCANCODE_5 },
+	{ '6',  '^', SDL_SCANCODE_6 },
+	{ '7',  '&', SDL_SCANCODE_7 },
+	{ '8',  '*', SDL_SCANCODE_8 },
+	{ '9',  '(', SDL_SCANCODE_9 },
+	{ '0',  ')', SDL_SCANCODE_0 },
+	{ '-',  '_', SDL_SCANCODE_MINUS },
+	{ '=',  '+', SDL_SCANCODE_EQUALS },
+	{ '[',  '{', SDL_SCANCODE_LEFTBRACKET },
+	{ ']',  '}', SDL_SCANCODE_RIGHTBRACKET },
+	{ '\\', '|', SDL_SCANCODE_BACKSLASH },
+	{ ';',  ':', SDL_SCANCODE_SEMICOLON },
+	{ '\'', '"', SDL_SCANCODE_APOSTROPHE },
+	{ '`',  '~', SDL_SCANCODE_NONUSBACKSLASH },	/* same key as SDLK_BACKQUOTE */
+	{ ',',  '<', SDL_SCANCODE_COMMA },
+	{ '.',  '>', SDL_SCANCODE_PERIOD },
+	{ '/',  '?', SDL_SCANCODE_SLASH },
+	{ ' ',  ' ', SDL_SCANCODE_SPACE },
+	{ '\t', '\t', SDL_SCANCODE_TAB },
+};
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Get the key symbol and scancode of the key that types the given character
+ * and whether shift has to be held. Returns false if there is no such key.
+ */
+bool Keymap_GetCharacterKey(char asckey, SDL_Keysym *sdlkey, bool *shift)
+{
+	int i;
+
+	sdlkey->mod = KMOD_NONE;
+	if (isalpha((unsigned char)asckey)) {
+		sdlkey->sym = tolower((unsigned char)asckey);
+		sdlkey->scancode = SDL_SCANCODE_A + (sdlkey->sym - 'a');
+		*shift = isupper((unsigned char)asckey);
+		return true;
+	}
+	for (i = 0; i < ARRAYSIZE(KeymapCharacters); i++) {
+		if (asckey == KeymapCharacters[i].key || asckey == KeymapCharacters[i].shifted) {
+			sdlkey->sym = KeymapCharacters[i].key;
+			sdlkey->scancode = KeymapCharacters[i].scancode;
+			*shift = asckey != KeymapCharacters[i].key;
+			return true;
+		}
+	}
+	return false;
+}
+
 /*-----------------------------------------------------------------------*/
 /**
  * Simulate press or release of a key corresponding to given character
  */
 void Keymap_SimulateCharacter(char asckey, bool press)
 {
-	SDL_Keysym sdlkey;
-
-	sdlkey.mod = KMOD_NONE;
-	sdlkey.scancode = 0;
-	if (isupper(asckey)) {
-		if (press) {
-			sdlkey.sym = SDLK_LSHIFT;
-			Keymap_KeyDown(&sdlkey);
-		}
-		sdlkey.sym = tolower(asckey);
+	SDL_Keysym sdlkey, shiftkey;
+	bool shift;
+
+	if (!Keymap_GetCharacterKey(asckey, &sdlkey, &shift))
+		return;
+
+	shiftkey.sym = SDLK_LSHIFT;
+	shiftkey.scancode = SDL_SCANCODE_LSHIFT;
+	shiftkey.mod = KMOD_NONE;
+	if (shift)
 		sdlkey.mod = KMOD_LSHIFT;
-	} else {
-		sdlkey.sym = asckey;
-	}
+
 	if (press) {
+		if (shift)
+			Keymap_KeyDown(&shiftkey);
 		Keymap_KeyDown(&sdlkey);
 	} else {
 		Keymap_KeyUp(&sdlkey);
-		if (isupper(asckey)) {
-			sdlkey.sym = SDLK_LSHIFT;
-			Keymap_KeyUp(&sdlkey);
-		}
+		if (shift)
+			Keymap_KeyUp(&shiftkey);
 	}
 }
 
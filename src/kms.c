@@ -19,6 +19,7 @@
 #include "rtcnvram.h"
 #include "snd.h"
 #include "host.h"
+#include "memorySnapShot.h"
 
 #define LOG_KMS_REG_LEVEL LOG_DEBUG
 #define LOG_KMS_LEVEL     LOG_DEBUG
@@ -761,3 +762,10 @@ void KMS_Reset(void) {
     kms.rev = ConfigureParams.System.bTurbo?REV_NEW:REV_OLD;
     kms_reset();
 }
+
+/* Save/restore keyboard, mouse and sound interface state */
+void KMS_MemorySnapShot_Capture(bool bSave) {
+    MemorySnapShot_Store(&kms, sizeof(kms));
+    MemorySnapShot_Store(&kms_codec_dma_blockend, sizeof(kms_codec_dma_blockend));
+    MemorySnapShot_Store(&m_button_right, sizeof(m_button_right));
+}
@@ -15,7 +15,12 @@ const char M68000_fileid[] = "Hatari m68000.c : " __DATE__ " " __TIME__;
 #include "cycInt.h"
 #include "m68000.h"
 
+#include "memorySnapShot.h"
+
 #include "mmu_common.h"
+#include "cpummu.h"
+#include "cpummu030.h"
+#include "fpp.h"
 
 Uint32 BusErrorAddress;         /* Stores the offending address for bus-/address errors */
 Uint32 BusErrorPC;              /* Value of the PC when bus error occurs */
@@ -141,6 +146,15 @@ void M68000_Init(void)
 
 int pendingInterrupts = 0;
 
+/* CPU state restored from a memory snapshot. It is applied after the core
+ * has been reset in m68k_go(), see M68000_ApplySnapShot() */
+static bool bSnapShotPending = false;
+static struct regstruct SnapShotRegs;
+static uae_u32 SnapShotFP[8][3];
+static uae_u64 SnapShotSrp030, SnapShotCrp030;
+static uae_u32 SnapShotTt0030, SnapShotTt1030, SnapShotTc030;
+static uae_u16 SnapShotMmusr030;
+
 /*-----------------------------------------------------------------------*/
 /**
  * Reset CPU 68000 variables
@@ -149,6 +163,7 @@ void M68000_Reset(bool bCold)
 {
 	if (bCold) {
 		pendingInterrupts = 0;
+		bSnapShotPending = false;
 		
 		/* Now reset the WINUAE CPU core */
 		m68k_reset();
@@ -159,6 +174,194 @@ void M68000_Reset(bool bCold)
 }
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Save/Restore snapshot of CPU, MMU and FPU variables ('MemorySnapShot_Store'
+ * handles type). The restored state is kept until the CPU core has been reset
+ * and is then applied by M68000_ApplySnapShot().
+ */
+void M68000_MemorySnapShot_Capture(bool bSave)
+{
+	struct regstruct *r = &SnapShotRegs;
+	int i;
+
+	if (bSave)
+	{
+		MakeSR();
+		memcpy(r->regs, regs.regs, sizeof(r->regs));
+		r->pc = m68k_getpc();
+		r->irc = regs.irc;
+		r->ir = regs.ir;
+		r->ird = regs.ird;
+		r->usp = regs.usp;
+		r->isp = regs.isp;
+		r->msp = regs.msp;
+		r->sr = regs.sr;
+		r->stopped = regs.stopped;
+		r->vbr = regs.vbr;
+		r->sfc = regs.sfc;
+		r->dfc = regs.dfc;
+		r->fpcr = regs.fpcr;
+		r->fpsr = fpp_get_fpsr();
+		r->fpiar = regs.fpiar;
+		r->cacr = regs.cacr;
+		r->caar = regs.caar;
+		r->itt0 = regs.itt0;
+		r->itt1 = regs.itt1;
+		r->dtt0 = regs.dtt0;
+		r->dtt1 = regs.dtt1;
+		r->tcr = regs.tcr;
+		r->mmusr = regs.mmusr;
+		r->urp = regs.urp;
+		r->srp = regs.srp;
+		r->buscr = regs.buscr;
+		r->mmu_fslw = regs.mmu_fslw;
+		r->mmu_fault_addr = regs.mmu_fault_addr;
+		r->mmu_effective_addr = regs.mmu_effective_addr;
+		r->mmu_ssw = regs.mmu_ssw;
+		r->pcr = regs.pcr;
+		for (i = 0; i < 8; i++)
+			fpp_from_exten_fmovem(&regs.fp[i], &SnapShotFP[i][0], &SnapShotFP[i][1], &SnapShotFP[i][2]);
+		SnapShotSrp030 = srp_030;
+		SnapShotCrp030 = crp_030;
+		SnapShotTt0030 = tt0_030;
+		SnapShotTt1030 = tt1_030;
+		SnapShotTc030 = tc_030;
+		SnapShotMmusr030 = mmusr_030;
+	}
+
+	MemorySnapShot_Store(&pendingInterrupts, sizeof(pendingInterrupts));
+	MemorySnapShot_Store(r->regs, sizeof(r->regs));
+	MemorySnapShot_Store(&r->pc, sizeof(r->pc));
+	MemorySnapShot_Store(&r->irc, sizeof(r->irc));
+	MemorySnapShot_Store(&r->ir, sizeof(r->ir));
+	MemorySnapShot_Store(&r->ird, sizeof(r->ird));
+	MemorySnapShot_Store(&r->usp, sizeof(r->usp));
+	MemorySnapShot_Store(&r->isp, sizeof(r->isp));
+	MemorySnapShot_Store(&r->msp, sizeof(r->msp));
+	MemorySnapShot_Store(&r->sr, sizeof(r->sr));
+	MemorySnapShot_Store(&r->stopped, sizeof(r->stopped));
+	MemorySnapShot_Store(&r->vbr, sizeof(r->vbr));
+	MemorySnapShot_Store(&r->sfc, sizeof(r->sfc));
+	MemorySnapShot_Store(&r->dfc, sizeof(r->dfc));
+	MemorySnapShot_Store(&r->fpcr, sizeof(r->fpcr));
+	MemorySnapShot_Store(&r->fpsr, sizeof(r->fpsr));
+	MemorySnapShot_Store(&r->fpiar, sizeof(r->fpiar));
+	MemorySnapShot_Store(SnapShotFP, sizeof(SnapShotFP));
+	MemorySnapShot_Store(&r->cacr, sizeof(r->cacr));
+	MemorySnapShot_Store(&r->caar, sizeof(r->caar));
+	MemorySnapShot_Store(&r->itt0, sizeof(r->itt0));
+	MemorySnapShot_Store(&r->itt1, sizeof(r->itt1));
+	MemorySnapShot_Store(&r->dtt0, sizeof(r->dtt0));
+	MemorySnapShot_Store(&r->dtt1, sizeof(r->dtt1));
+	MemorySnapShot_Store(&r->tcr, sizeof(r->tcr));
+	MemorySnapShot_Store(&r->mmusr, sizeof(r->mmusr));
+	MemorySnapShot_Store(&r->urp, sizeof(r->urp));
+	MemorySnapShot_Store(&r->srp, sizeof(r->srp));
+	MemorySnapShot_Store(&r->buscr, sizeof(r->buscr));
+	MemorySnapShot_Store(&r->mmu_fslw, sizeof(r->mmu_fslw));
+	MemorySnapShot_Store(&r->mmu_fault_addr, sizeof(r->mmu_fault_addr));
+	MemorySnapShot_Store(&r->mmu_effective_addr, sizeof(r->mmu_effective_addr));
+	MemorySnapShot_Store(&r->mmu_ssw, sizeof(r->mmu_ssw));
+	MemorySnapShot_Store(&r->pcr, sizeof(r->pcr));
+	MemorySnapShot_Store(&SnapShotSrp030, sizeof(SnapShotSrp030));
+	MemorySnapShot_Store(&SnapShotCrp030, sizeof(SnapShotCrp030));
+	MemorySnapShot_Store(&SnapShotTt0030, sizeof(SnapShotTt0030));
+	MemorySnapShot_Store(&SnapShotTt1030, sizeof(SnapShotTt1030));
+	MemorySnapShot_Store(&SnapShotTc030, sizeof(SnapShotTc030));
+	MemorySnapShot_Store(&SnapShotMmusr030, sizeof(SnapShotMmusr030));
+
+	if (!bSave)
+	{
+		bSnapShotPending = true;
+		/* Do not let the old CPU state take interrupts until the core is reset */
+		regs.intmask = 7;
+	}
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Apply CPU state restored from a memory snapshot. Called from m68k_go()
+ * right after the CPU core has been reset.
+ */
+void M68000_ApplySnapShot(void)
+{
+	struct regstruct *r = &SnapShotRegs;
+	int i;
+
+	if (!bSnapShotPending)
+		return;
+	bSnapShotPending = false;
+
+	memcpy(regs.regs, r->regs, sizeof(regs.regs));
+	regs.irc = r->irc;
+	regs.ir = r->ir;
+	regs.ird = r->ird;
+	regs.usp = r->usp;
+	regs.isp = r->isp;
+	regs.msp = r->msp;
+	regs.sr = r->sr;
+	regs.t1 = (regs.sr >> 15) & 1;
+	regs.t0 = (regs.sr >> 14) & 1;
+	regs.s = (regs.sr >> 13) & 1;
+	regs.m = (regs.sr >> 12) & 1;
+	regs.intmask = (regs.sr >> 8) & 7;
+	SET_XFLG((regs.sr >> 4) & 1);
+	SET_NFLG((regs.sr >> 3) & 1);
+	SET_ZFLG((regs.sr >> 2) & 1);
+	SET_VFLG((regs.sr >> 1) & 1);
+	SET_CFLG(regs.sr & 1);
+	regs.stopped = r->stopped;
+	regs.vbr = r->vbr;
+	regs.sfc = r->sfc;
+	regs.dfc = r->dfc;
+
+	for (i = 0; i < 8; i++)
+		fpp_to_exten_fmovem(&regs.fp[i], SnapShotFP[i][0], SnapShotFP[i][1], SnapShotFP[i][2]);
+	fpp_set_fpcr(r->fpcr);
+	fpp_set_fpsr(r->fpsr);
+	fpp_set_fpiar(r->fpiar);
+
+	regs.cacr = r->cacr;
+	regs.caar = r->caar;
+	regs.itt0 = r->itt0;
+	regs.itt1 = r->itt1;
+	regs.dtt0 = r->dtt0;
+	regs.dtt1 = r->dtt1;
+	regs.tcr = r->tcr;
+	regs.mmusr = r->mmusr;
+	regs.urp = r->urp;
+	regs.srp = r->srp;
+	regs.buscr = r->buscr;
+	regs.mmu_fslw = r->mmu_fslw;
+	regs.mmu_fault_addr = r->mmu_fault_addr;
+	regs.mmu_effective_addr = r->mmu_effective_addr;
+	regs.mmu_ssw = r->mmu_ssw;
+	regs.pcr = r->pcr;
+	mmu_tt_modified();
+	set_cpu_caches(true);
+
+	if (currprefs.mmu_model >= 68040) {
+		mmu_set_tc(regs.tcr);
+		mmu_set_super(regs.s != 0);
+		mmu_flush_atc_all(true);
+	} else if (currprefs.mmu_model == 68030) {
+		srp_030 = SnapShotSrp030;
+		crp_030 = SnapShotCrp030;
+		tt0_030 = SnapShotTt0030;
+		tt1_030 = SnapShotTt1030;
+		tc_030 = SnapShotTc030;
+		mmusr_030 = SnapShotMmusr030;
+		mmu030_decode_regs();
+	}
+
+	m68k_setpc_normal(r->pc);
+	if (regs.stopped)
+		M68000_SetSpecial(SPCFLAG_STOP);
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * Stop 680x0 emulation
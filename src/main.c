@@ -19,9 +19,13 @@ const char Main_fileid[] = "Hatari main.c : " __DATE__ " " __TIME__;
 #include "keymap.h"
 #include "log.h"
 #include "m68000.h"
+#include "memorySnapShot.h"
+#include "options.h"
 #include "paths.h"
 #include "reset.h"
+#include "scsi.h"
 #include "screen.h"
+#include "script.h"
 #include "sdlgui.h"
 #include "shortcut.h"
 #include "snd.h"
@@ -30,7 +34,10 @@ const char Main_fileid[] = "Hatari main.c : " __DATE__ " " __TIME__;
 #include "video.h"
 #include "audio.h"
 #include "debugui.h"
+#include "evtrace.h"
 #include "file.h"
+#include "floppy.h"
+#include "mo.h"
 #include "dsp.h"
 #include "host.h"
 #include "dimension.hpp"
@@ -45,6 +52,7 @@ const char Main_fileid[] = "Hatari main.c : " __DATE__ " " __TIME__;
 int nFrameSkips;
 
 bool bQuitProgram = false;                /* Flag to quit program cleanly */
+bool bHeadless = false;                   /* Run without window and SDL events */
 
 static bool bEmulationActive = true;      /* Run emulation when started */
 static bool bAccurateDelays;              /* Host system has an accurate SDL_Delay()? */
@@ -101,6 +109,7 @@ const char* Main_SpeedMsg() {
 static const report_t reports[] = {
     {"ND",    nd_reports},
     {"Host",  host_report},
+    {"SCSI",  SCSI_Reports},
 };
 #endif
 
@@ -120,6 +129,12 @@ bool Main_PauseEmulation(bool visualize) {
 	Screen_Pause(true);
 	Sound_Pause(true);
 	NextBus_Pause(true);
+	SCSI_FlushDisks();
+	MO_FlushDisks();
+	Floppy_FlushDisks();
+
+	if (bHeadless)
+		return true;
 
 	if (visualize) {
 		Statusbar_AddMessage("Emulation paused", 100);
@@ -153,6 +168,9 @@ bool Main_UnPauseEmulation(void) {
 	Sound_Pause(false);
 	NextBus_Pause(false);
 
+	if (bHeadless)
+		return true;
+
 	/* Set mouse pointer to the middle of the screen and hide it */
 	Main_WarpMouse(sdlscrn->w/2, sdlscrn->h/2);
 	SDL_ShowCursor(SDL_DISABLE);
@@ -167,7 +185,7 @@ bool Main_UnPauseEmulation(void) {
  * Optionally ask user whether to quit and set bQuitProgram accordingly
  */
 void Main_RequestQuit(void) {
-	if (ConfigureParams.Log.bConfirmQuit) {
+	if (ConfigureParams.Log.bConfirmQuit && !bHeadless) {
 		Main_PauseEmulation(true);
 		bQuitProgram = false;	/* if set true, dialog exits */
 		bQuitProgram = DlgAlert_Query("All unsaved data will be lost.\nDo you really want to quit?");
@@ -301,6 +319,9 @@ void Main_EventHandler(void) {
         statusBarUpdate = 0;
     }
     
+    /* Feed scripted input, if any, one step per call */
+    Script_Process();
+    
     do {
         bContinueProcessing = false;
         
@@ -316,6 +337,18 @@ void Main_EventHandler(void) {
                 break;
         }
         
+        if (bHeadless) {
+            /* No window, input can only come from the script */
+            if (bEmulationActive) {
+                Sint64 time_offset = host_real_time_offset() / 1000;
+                if(time_offset > 10)
+                    host_sleep_ms(time_offset);
+            } else {
+                host_sleep_ms(10);
+            }
+            continue;
+        }
+        
         if (bEmulationActive) {
             Sint64 time_offset = host_real_time_offset() / 1000;
             if(time_offset > 10)
@@ -421,6 +454,8 @@ void Main_EventHandlerInterrupt() {
  * Set Hatari window title. Use NULL for default
  */
 void Main_SetTitle(const char *title) {
+    if (bHeadless)
+        return;
     if (title)
         SDL_SetWindowTitle(sdlWindow, title);
     else
@@ -441,7 +476,7 @@ static void Main_Init(void) {
 
 	/* Init SDL's video subsystem. Note: Audio and joystick subsystems
 	   will be initialized later (failures there are not fatal). */
-	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) < 0)
+	if (SDL_Init(bHeadless ? SDL_INIT_TIMER : (SDL_INIT_VIDEO | SDL_INIT_TIMER)) < 0)
 	{
 		fprintf(stderr, "Could not initialize the SDL library:\n %s\n", SDL_GetError() );
 		exit(-1);
@@ -453,26 +488,52 @@ static void Main_Init(void) {
 	M68000_Init();                /* Init CPU emulation */
 	Keymap_Init();
 
-    /* call menu at startup */
-    if (!File_Exists(sConfigFileName) || ConfigureParams.ConfigDialog.bShowConfigDialogAtStartup) {
-        Dialog_DoProperty();
+    /* call menu at startup, there are no dialogs in headless mode */
+    if (!bHeadless) {
+        if (!File_Exists(sConfigFileName) || ConfigureParams.ConfigDialog.bShowConfigDialogAtStartup) {
+            Dialog_DoProperty();
+            if (bQuitProgram) {
+                SDL_Quit();
+                exit(-2);
+            }
+        }
+
+        Dialog_CheckFiles();
+    
         if (bQuitProgram) {
             SDL_Quit();
             exit(-2);
         }
     }
-
-    Dialog_CheckFiles();
     
-    if (bQuitProgram) {
+    Reset_Cold();
+    
+	IoMem_Init();
+	
+    /* Apply or throw away changes stored in SCSI disk overlays */
+    if (Opt_CommitOverlays) {
+        SCSI_CommitOverlays();
+    } else if (Opt_DiscardOverlays) {
+        SCSI_DiscardOverlays();
+    }
+    
+    /* Restore memory snapshot given on the command line */
+    if (Opt_MemStateFile) {
+        MemorySnapShot_Restore(Opt_MemStateFile, false);
+    }
+    
+    /* Open input script */
+    if (Opt_ScriptFile && !Script_Init(Opt_ScriptFile)) {
         SDL_Quit();
         exit(-2);
     }
     
-    Reset_Cold();
+    /* Enable binary event tracing */
+    if (!EvTrace_Init(Opt_EvTraceFile, Opt_EvTraceMask)) {
+        SDL_Quit();
+        exit(-2);
+    }
     
-	IoMem_Init();
-	
     /* Start EventHandler */
     CycInt_AddRelativeInterruptUs(500*1000, 0, INTERRUPT_EVENT_LOOP);
     
@@ -491,6 +552,8 @@ static void Main_UnInit(void) {
 	SDLGui_UnInit();
 	Screen_UnInit();
 	Exit680x0();
+	Script_UnInit();
+	EvTrace_UnInit();
 
 	/* SDL uninit: */
 	SDL_Quit();
@@ -592,13 +655,11 @@ int main(int argc, char *argv[]) {
 	/* Now load the values from the configuration file */
 	Main_LoadInitialConfig();
     
-#if 0 /* FIXME: This sometimes causes exits when starting from application bundles */
 	/* Check for any passed parameters */
 	if (!Opt_ParseParameters(argc, (const char * const *)argv))
 	{
 		return 1;
 	}
-#endif
 	/* monitor type option might require "reset" -> true */
 	Configuration_Apply(true);
 
@@ -0,0 +1,265 @@
+/*
+  Hatari - memorySnapShot.c
+
+  This file is distributed under the GNU Public License, version 2 or at
+  your option any later version. Read the file gpl.txt for details.
+
+  Memory Snapshot
+
+  This handles the saving/restoring of the emulator's state so any application
+  can be saved and restored at any time. The snapshot contains the machine
+  configuration, the CPU, MMU and FPU state, RAM and video memory, the
+  interrupt table and the state of all devices including the DSP and
+  NeXTdimension boards. Disk images are not part of the snapshot, so the same
+  images have to be available when the snapshot is restored.
+  The file is compressed with zlib to reduce disk space used.
+*/
+const char MemorySnapShot_fileid[] = "Previous memorySnapShot.c : " __DATE__ " " __TIME__;
+
+#include <errno.h>
+#include <zlib.h>
+
+#include "main.h"
+#include "configuration.h"
+#include "change.h"
+#include "file.h"
+#include "log.h"
+#include "host.h"
+#include "ioMem.h"
+#include "memorySnapShot.h"
+#include "cycInt.h"
+#include "m68000.h"
+#include "bmap.h"
+#include "sysReg.h"
+#include "tmc.h"
+#include "adb.h"
+#include "nbic.h"
+#include "rtcnvram.h"
+#include "dma.h"
+#include "esp.h"
+#include "scsi.h"
+#include "mo.h"
+#include "ethernet.h"
+#include "kms.h"
+#include "dsp.h"
+#include "NextBus.hpp"
+
+
+#define VERSION_STRING      "Previous 2.5 snapshot 3" /* Version of compatible memory snapshots */
+
+static gzFile CaptureFile;
+static bool bCaptureSave, bCaptureError;
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Open/Create snapshot file, and set flag so 'MemorySnapShot_Store' knows
+ * how to handle data.
+ */
+static bool MemorySnapShot_OpenFile(const char *pszFileName, bool bSave, bool bConfirm)
+{
+	char VersionString[] = VERSION_STRING;
+
+	/* Set error */
+	bCaptureError = false;
+
+	/* after opening file, set bCaptureSave to indicate whether
+	 * 'MemorySnapShot_Store' should load from or save to a file
+	 */
+	if (bSave)
+	{
+		if (bConfirm && !File_QueryOverwrite(pszFileName))
+			return false;
+
+		/* Save */
+		CaptureFile = gzopen(pszFileName, "wb");
+		if (!CaptureFile)
+		{
+			fprintf(stderr, "Failed to open save file '%s': %s\n",
+			        pszFileName, strerror(errno));
+			bCaptureError = true;
+			return false;
+		}
+		bCaptureSave = true;
+		/* Store version string */
+		MemorySnapShot_Store(VersionString, sizeof(VersionString));
+	}
+	else
+	{
+		/* Restore */
+		CaptureFile = gzopen(pszFileName, "rb");
+		if (!CaptureFile)
+		{
+			fprintf(stderr, "Failed to open file '%s': %s\n",
+			        pszFileName, strerror(errno));
+			bCaptureError = true;
+			return false;
+		}
+		bCaptureSave = false;
+		/* Restore version string */
+		MemorySnapShot_Store(VersionString, sizeof(VersionString));
+		/* Does match current version? */
+		if (bCaptureError || strcmp(VersionString, VERSION_STRING))
+		{
+			/* No, inform user and error */
+			Log_AlertDlg(LOG_ERROR, "Unable to restore memory state.\n"
+			             "File is not a compatible " PROG_NAME " snapshot.");
+			gzclose(CaptureFile);
+			bCaptureError = true;
+			return false;
+		}
+	}
+
+	/* All OK */
+	return true;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Close snapshot file.
+ */
+static void MemorySnapShot_CloseFile(void)
+{
+	if (gzclose(CaptureFile) != Z_OK)
+		bCaptureError = true;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Save/Restore data to/from file.
+ */
+void MemorySnapShot_Store(void *pData, int Size)
+{
+	int nBytes;
+
+	/* Check no file errors */
+	if (!bCaptureError)
+	{
+		/* Saving or Restoring? */
+		if (bCaptureSave)
+			nBytes = gzwrite(CaptureFile, pData, Size);
+		else
+			nBytes = gzread(CaptureFile, pData, Size);
+
+		/* Did save OK? */
+		if (nBytes != Size)
+			bCaptureError = true;
+	}
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Save/Restore the state of all emulated modules. The interrupt table and
+ * the main cycle counter go first, the host time base depends on them.
+ */
+static void MemorySnapShot_CaptureModules(bool bSave)
+{
+	CycInt_MemorySnapShot_Capture(bSave);
+	Host_MemorySnapShot_Capture(bSave);
+	M68000_MemorySnapShot_Capture(bSave);
+	Memory_MemorySnapShot_Capture(bSave);
+	BMAP_MemorySnapShot_Capture(bSave);
+	SCR_MemorySnapShot_Capture(bSave);
+	TMC_MemorySnapShot_Capture(bSave);
+	ADB_MemorySnapShot_Capture(bSave);
+	NBIC_MemorySnapShot_Capture(bSave);
+	RTC_MemorySnapShot_Capture(bSave);
+	DMA_MemorySnapShot_Capture(bSave);
+	ESP_MemorySnapShot_Capture(bSave);
+	SCSI_MemorySnapShot_Capture(bSave);
+	MO_MemorySnapShot_Capture(bSave);
+	Ethernet_MemorySnapShot_Capture(bSave);
+	KMS_MemorySnapShot_Capture(bSave);
+	DSP_MemorySnapShot_Capture(bSave);
+	NextBus_MemorySnapShot_Capture(bSave);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Save 'snapshot' of memory/chips/emulation variables
+ */
+void MemorySnapShot_Capture(const char *pszFileName, bool bConfirm)
+{
+	bool bWasRunning = Main_PauseEmulation(false);
+
+	/* Set to 'saving' */
+	if (MemorySnapShot_OpenFile(pszFileName, true, bConfirm))
+	{
+		/* Capture each files details */
+		Configuration_MemorySnapShot_Capture(true);
+		MemorySnapShot_CaptureModules(true);
+
+		/* And close */
+		MemorySnapShot_CloseFile();
+
+		/* Did error? */
+		if (bCaptureError)
+			Log_AlertDlg(LOG_ERROR, "Unable to save memory state to file '%s'.", pszFileName);
+		else if (bConfirm)
+			Log_AlertDlg(LOG_INFO, "Memory state file saved.");
+	}
+
+	if (bWasRunning)
+		Main_UnPauseEmulation();
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Restore 'snapshot' of memory/chips/emulation variables. The machine is
+ * cold reset with the configuration from the snapshot first, so memory
+ * and NeXTdimension boards are set up for the saved machine.
+ */
+void MemorySnapShot_Restore(const char *pszFileName, bool bConfirm)
+{
+	CNF_PARAMS current;
+	bool bWasRunning = Main_PauseEmulation(false);
+
+	/* Set to 'restore' */
+	if (MemorySnapShot_OpenFile(pszFileName, false, bConfirm))
+	{
+		current = ConfigureParams;
+
+		Configuration_MemorySnapShot_Capture(false);
+
+		if (bCaptureError)
+		{
+			/* Nothing has been changed yet */
+			ConfigureParams = current;
+			MemorySnapShot_CloseFile();
+			Log_AlertDlg(LOG_ERROR, "Unable to restore memory state from file '%s'.", pszFileName);
+		}
+		else
+		{
+			/* Reset the machine as configured in the snapshot */
+			Change_CopyChangedParamsToConfiguration(&current, &ConfigureParams, true);
+			IoMem_Init();
+
+			/* Reload each files details */
+			MemorySnapShot_CaptureModules(false);
+
+			/* And close */
+			MemorySnapShot_CloseFile();
+
+			/* Did error? */
+			if (bCaptureError)
+			{
+				Log_AlertDlg(LOG_ERROR, "Unable to restore memory state from file '%s'.\n"
+				             "Return to old parameters...", pszFileName);
+				Change_CopyChangedParamsToConfiguration(&ConfigureParams, &current, true);
+				IoMem_Init();
+			}
+			else if (bConfirm)
+			{
+				Log_AlertDlg(LOG_INFO, "Memory state file restored.");
+			}
+		}
+	}
+
+	if (bWasRunning)
+		Main_UnPauseEmulation();
+}
@@ -23,9 +23,10 @@
 #include "sysReg.h"
 #include "dma.h"
 #include "floppy.h"
-#include "file.h"
+#include "diskimage.h"
 #include "rs.h"
 #include "statusbar.h"
+#include "memorySnapShot.h"
 
 
 #define LOG_MO_REG_LEVEL    LOG_DEBUG
@@ -70,7 +71,7 @@ struct {
     Uint32 ho_head_pos;
     Uint32 sec_offset;
     
-    FILE* dsk;
+    DISKIMAGE* dsk;
     
     bool spinning;
     bool spiraling;
@@ -1015,7 +1016,7 @@ void mo_read_sector(Uint32 sector_id) {
     Log_Printf(LOG_MO_IO_LEVEL, "MO disk %i: Read sector at offset %i (%i sectors remaining)",
                dnum, sector_num, osp.sector_count-1);
     
-    File_Read(ecc_buffer[eccin].data, MO_SECTORSIZE_DISK, sector_num*MO_SECTORSIZE_DISK, mo[dnum].dsk);
+    DiskImage_Read(mo[dnum].dsk, ecc_buffer[eccin].data, MO_SECTORSIZE_DISK, (Uint64)sector_num*MO_SECTORSIZE_DISK);
     
     ecc_buffer[eccin].limit = ecc_buffer[eccin].size = MO_SECTORSIZE_DISK;
 }
@@ -1027,7 +1028,7 @@ void mo_write_sector(Uint32 sector_id) {
                dnum, sector_num, osp.sector_count-1);
     
     if (ecc_buffer[eccout].limit==MO_SECTORSIZE_DISK) {
-        File_Write(ecc_buffer[eccout].data, MO_SECTORSIZE_DISK, sector_num*MO_SECTORSIZE_DISK, mo[dnum].dsk);
+        DiskImage_Write(mo[dnum].dsk, ecc_buffer[eccout].data, MO_SECTORSIZE_DISK, (Uint64)sector_num*MO_SECTORSIZE_DISK);
 
         ecc_buffer[eccout].size = 0;
         ecc_buffer[eccout].limit = MO_SECTORSIZE_DATA;
@@ -1047,7 +1048,7 @@ void mo_erase_sector(Uint32 sector_id) {
     Uint8 erase_buf[MO_SECTORSIZE_DISK];
     memset(erase_buf, 0xFF, MO_SECTORSIZE_DISK);
     
-    File_Write(erase_buf, MO_SECTORSIZE_DISK, sector_num*MO_SECTORSIZE_DISK, mo[dnum].dsk);
+    DiskImage_Write(mo[dnum].dsk, erase_buf, MO_SECTORSIZE_DISK, (Uint64)sector_num*MO_SECTORSIZE_DISK);
 }
 
 void mo_verify_sector(Uint32 sector_id) {
@@ -1056,7 +1057,7 @@ void mo_verify_sector(Uint32 sector_id) {
     Log_Printf(LOG_MO_IO_LEVEL, "MO disk %i: Verify sector at offset %i (%i sectors remaining)",
                dnum, sector_num, osp.sector_count-1);
     
-    File_Read(ecc_buffer[eccin].data, MO_SECTORSIZE_DISK, sector_num*MO_SECTORSIZE_DISK, mo[dnum].dsk);
+    DiskImage_Read(mo[dnum].dsk, ecc_buffer[eccin].data, MO_SECTORSIZE_DISK, (Uint64)sector_num*MO_SECTORSIZE_DISK);
     
     ecc_buffer[eccin].limit = ecc_buffer[eccin].size = MO_SECTORSIZE_DISK;
 }
@@ -1488,7 +1489,7 @@ void mo_eject_disk(int drive) {
 
     Log_Printf(LOG_WARN, "MO disk %i: Eject",drive);
     
-    File_Close(mo[drive].dsk);
+    DiskImage_Close(mo[drive].dsk);
     mo[drive].dsk=NULL;
     mo[drive].inserted=false;
     mo[drive].spinning=false;
@@ -1502,12 +1503,12 @@ void mo_insert_disk(int drive) {
     Log_Printf(LOG_WARN, "MO disk %i: Insert",drive);
     
     if (!ConfigureParams.MO.drive[drive].bWriteProtected) {
-        mo[drive].dsk = File_Open(ConfigureParams.MO.drive[drive].szImageName, "rb+");
+        mo[drive].dsk = DiskImage_Open(ConfigureParams.MO.drive[drive].szImageName, true);
         mo[drive].inserted=true;
         mo[drive].protected=false;
     }
     if (ConfigureParams.MO.drive[drive].bWriteProtected || mo[drive].dsk == NULL) {
-        mo[drive].dsk = File_Open(ConfigureParams.MO.drive[drive].szImageName, "rb");
+        mo[drive].dsk = DiskImage_Open(ConfigureParams.MO.drive[drive].szImageName, false);
         if (mo[drive].dsk == NULL) {
             Log_Printf(LOG_WARN, "MO disk %i: Cannot open image file %s\n",
                        drive, ConfigureParams.MO.drive[drive].szImageName);
@@ -1687,7 +1688,7 @@ void MO_Reset(void) {
     
     for (dnum=0; dnum<MO_MAX_DRIVES; dnum++) {
         if (mo[dnum].dsk) {
-            File_Close(mo[dnum].dsk);
+            DiskImage_Close(mo[dnum].dsk);
             mo[dnum].dsk=NULL;
         }
         mo[dnum].connected=false;
@@ -1723,3 +1724,52 @@ void MO_Eject(int drive) {
 
     mo_eject_disk(drive);
 }
+
+void MO_FlushDisks(void) {
+    int i;
+    for (i = 0; i < MO_MAX_DRIVES; i++) {
+        if (mo[i].dsk) {
+            DiskImage_Flush(mo[i].dsk);
+        }
+    }
+}
+
+
+/* Save/restore optical disk controller and drive state. The disk images
+ * and the insert/enable state of the drives are not part of the snapshot. */
+void MO_MemorySnapShot_Capture(bool bSave) {
+    int i;
+    
+    MemorySnapShot_Store(ecc_buffer, sizeof(ecc_buffer));
+    MemorySnapShot_Store(&osp, sizeof(osp));
+    
+    for (i = 0; i < MO_MAX_DRIVES; i++) {
+        MemorySnapShot_Store(&mo[i].status, sizeof(mo[i].status));
+        MemorySnapShot_Store(&mo[i].dstat, sizeof(mo[i].dstat));
+        MemorySnapShot_Store(&mo[i].estat, sizeof(mo[i].estat));
+        MemorySnapShot_Store(&mo[i].hstat, sizeof(mo[i].hstat));
+        MemorySnapShot_Store(&mo[i].head, sizeof(mo[i].head));
+        MemorySnapShot_Store(&mo[i].head_pos, sizeof(mo[i].head_pos));
+        MemorySnapShot_Store(&mo[i].ho_head_pos, sizeof(mo[i].ho_head_pos));
+        MemorySnapShot_Store(&mo[i].sec_offset, sizeof(mo[i].sec_offset));
+        MemorySnapShot_Store(&mo[i].spinning, sizeof(mo[i].spinning));
+        MemorySnapShot_Store(&mo[i].spiraling, sizeof(mo[i].spiraling));
+        MemorySnapShot_Store(&mo[i].seeking, sizeof(mo[i].seeking));
+        MemorySnapShot_Store(&mo[i].attn, sizeof(mo[i].attn));
+        MemorySnapShot_Store(&mo[i].complete, sizeof(mo[i].complete));
+    }
+    
+    MemorySnapShot_Store(&dnum, sizeof(dnum));
+    MemorySnapShot_Store(&sector_increment, sizeof(sector_increment));
+    MemorySnapShot_Store(&ecc_mode, sizeof(ecc_mode));
+    MemorySnapShot_Store(&ecc_state, sizeof(ecc_state));
+    MemorySnapShot_Store(&fmt_mode, sizeof(fmt_mode));
+    MemorySnapShot_Store(&write_timing, sizeof(write_timing));
+    MemorySnapShot_Store(&sector_timer, sizeof(sector_timer));
+    MemorySnapShot_Store(&ecc_repeat, sizeof(ecc_repeat));
+    MemorySnapShot_Store(&eccin, sizeof(eccin));
+    MemorySnapShot_Store(&eccout, sizeof(eccout));
+    MemorySnapShot_Store(&delayed_compl, sizeof(delayed_compl));
+    MemorySnapShot_Store(&delayed_attn, sizeof(delayed_attn));
+    MemorySnapShot_Store(&delayed_drive, sizeof(delayed_drive));
+}
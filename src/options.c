@@ -0,0 +1,216 @@
+/*
+  Previous - options.c
+
+  This file is distributed under the GNU Public License, version 2 or at
+  your option any later version. Read the file gpl.txt for details.
+
+  Functions for parsing the command line options. Options that change
+  the configuration override the values from the configuration file,
+  the others request actions at startup.
+*/
+const char Options_fileid[] = "Previous options.c : " __DATE__ " " __TIME__;
+
+#include "main.h"
+#include "configuration.h"
+#include "options.h"
+
+const char *Opt_MemStateFile    = NULL;
+bool        Opt_CommitOverlays  = false;
+bool        Opt_DiscardOverlays = false;
+const char *Opt_ScriptFile      = NULL;
+const char *Opt_EvTraceFile     = NULL;
+const char *Opt_EvTraceMask     = NULL;
+
+enum {
+	OPT_HELP,
+	OPT_VERSION,
+	OPT_MEMSTATE,
+	OPT_OVERLAY,
+	OPT_OVERLAY_COMMIT,
+	OPT_OVERLAY_DISCARD,
+	OPT_DISK_MMAP,
+	OPT_HEADLESS,
+	OPT_SCRIPT,
+	OPT_EVTRACE,
+	OPT_EVTRACE_MASK
+};
+
+typedef struct {
+	unsigned int id;	/* option ID */
+	const char *chr;	/* short option */
+	const char *str;	/* long option */
+	const char *arg;	/* type name for argument, if any */
+	const char *desc;	/* option description */
+} opt_t;
+
+static const opt_t PreviousOptions[] = {
+	{ OPT_HELP,            "-h", "--help",
+	  NULL, "Print command line options and exit" },
+	{ OPT_VERSION,         "-v", "--version",
+	  NULL, "Print version number and exit" },
+	{ OPT_MEMSTATE,        NULL, "--memstate",
+	  "<file>", "Restore memory snapshot <file> at startup" },
+	{ OPT_OVERLAY,         NULL, "--overlay",
+	  "<dir>", "Keep SCSI disk changes in delta files in <dir>" },
+	{ OPT_OVERLAY_COMMIT,  NULL, "--overlay-commit",
+	  NULL, "Write SCSI disk overlays to the disk images at startup" },
+	{ OPT_OVERLAY_DISCARD, NULL, "--overlay-discard",
+	  NULL, "Throw away SCSI disk overlays at startup" },
+	{ OPT_DISK_MMAP,       NULL, "--disk-mmap",
+	  "<bool>", "Access disk images through memory mapping" },
+	{ OPT_HEADLESS,        NULL, "--headless",
+	  NULL, "Run without window, input comes from --script" },
+	{ OPT_SCRIPT,          NULL, "--script",
+	  "<file>", "Read input from script <file> (see script.c)" },
+	{ OPT_EVTRACE,         NULL, "--evtrace",
+	  "<file>", "Write binary event trace to <file> on exit" },
+	{ OPT_EVTRACE_MASK,    NULL, "--evtrace-mask",
+	  "<list>", "Trace subsystems in <list> (bus,dma,esp,scsi,i860 or all)" },
+};
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Print program usage.
+ */
+static void Opt_ShowHelp(const char *name)
+{
+	char buf[32];
+	int i;
+
+	printf("Usage:\n %s [options]\n\nOptions:\n", name);
+	for (i = 0; i < ARRAYSIZE(PreviousOptions); i++)
+	{
+		const opt_t *opt = &PreviousOptions[i];
+		snprintf(buf, sizeof(buf), "%s%s%s", opt->str,
+		         opt->arg ? " " : "", opt->arg ? opt->arg : "");
+		printf("  %-3s %-24s %s\n", opt->chr ? opt->chr : "", buf, opt->desc);
+	}
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Return the option matching the given command line argument or NULL.
+ */
+static const opt_t *Opt_Find(const char *str)
+{
+	int i;
+
+	for (i = 0; i < ARRAYSIZE(PreviousOptions); i++)
+	{
+		const opt_t *opt = &PreviousOptions[i];
+		if ((opt->chr && !strcmp(str, opt->chr)) || !strcmp(str, opt->str))
+			return opt;
+	}
+	return NULL;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Parse a boolean option argument. Return false if it is not one of
+ * on/off, yes/no, true/false or 1/0.
+ */
+static bool Opt_Bool(const char *arg, bool *value)
+{
+	if (!strcasecmp(arg, "on") || !strcasecmp(arg, "yes") ||
+	    !strcasecmp(arg, "true") || !strcmp(arg, "1"))
+	{
+		*value = true;
+		return true;
+	}
+	if (!strcasecmp(arg, "off") || !strcasecmp(arg, "no") ||
+	    !strcasecmp(arg, "false") || !strcmp(arg, "0"))
+	{
+		*value = false;
+		return true;
+	}
+	return false;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Parse the command line options and set the corresponding configuration
+ * values and startup actions. Return false if the program should exit,
+ * i.e. on errors or after printing help or version.
+ */
+bool Opt_ParseParameters(int argc, const char * const argv[])
+{
+	const opt_t *opt;
+	const char *arg;
+	int i;
+
+	for (i = 1; i < argc; i++)
+	{
+		/* Process serial number passed by macOS when started from a bundle */
+		if (!strncmp(argv[i], "-psn_", 5))
+			continue;
+
+		opt = Opt_Find(argv[i]);
+		if (!opt)
+		{
+			fprintf(stderr, "Unknown option '%s'. Use --help for a list of options.\n", argv[i]);
+			return false;
+		}
+		arg = NULL;
+		if (opt->arg)
+		{
+			if (i + 1 >= argc)
+			{
+				fprintf(stderr, "Missing argument %s for option '%s'.\n", opt->arg, argv[i]);
+				return false;
+			}
+			arg = argv[++i];
+		}
+
+		switch (opt->id)
+		{
+		case OPT_HELP:
+			Opt_ShowHelp(argv[0]);
+			return false;
+		case OPT_VERSION:
+			printf("%s\n", PROG_NAME);
+			return false;
+		case OPT_MEMSTATE:
+			Opt_MemStateFile = arg;
+			break;
+		case OPT_OVERLAY:
+			if (strlen(arg) >= sizeof(ConfigureParams.SCSI.szOverlayDir))
+			{
+				fprintf(stderr, "Overlay directory name too long: %s\n", arg);
+				return false;
+			}
+			strcpy(ConfigureParams.SCSI.szOverlayDir, arg);
+			ConfigureParams.SCSI.nWriteProtection = WRITEPROT_ON;
+			break;
+		case OPT_OVERLAY_COMMIT:
+			Opt_CommitOverlays = true;
+			break;
+		case OPT_OVERLAY_DISCARD:
+			Opt_DiscardOverlays = true;
+			break;
+		case OPT_DISK_MMAP:
+			if (!Opt_Bool(arg, &ConfigureParams.System.bMapDiskImages))
+			{
+				fprintf(stderr, "Invalid value '%s' for option '%s'.\n", arg, opt->str);
+				return false;
+			}
+			break;
+		case OPT_HEADLESS:
+			bHeadless = true;
+			break;
+		case OPT_SCRIPT:
+			Opt_ScriptFile = arg;
+			break;
+		case OPT_EVTRACE:
+			Opt_EvTraceFile = arg;
+			break;
+		case OPT_EVTRACE_MASK:
+			Opt_EvTraceMask = arg;
+			break;
+		}
+	}
+	return true;
+}
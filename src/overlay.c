@@ -0,0 +1,539 @@
+/*  Previous - overlay.c
+
+ This file is distributed under the GNU Public License, version 2 or at
+ your option any later version. Read the file gpl.txt for details.
+
+ Copy-on-write overlay for disk images.
+
+ Writes to an overlaid image go to a delta file instead of the base image.
+ The base image is only opened for reading, so many emulator instances can
+ share one read-only image with a small delta file each. The base of an
+ overlay can itself be an overlay, which allows chaining deltas.
+
+ Delta file format (all values little endian):
+
+ 0x0000  magic "PRVOVL01"
+ 0x0008  block size (Uint32)
+ 0x000C  number of stored blocks (Uint32)
+ 0x0010  size of the base image in bytes (Uint64)
+ 0x0018  path of the base image (zero terminated)
+ 0x0400  stored blocks: block number (Uint32) followed by the block data
+
+ Blocks are appended in the order they are first written. Later writes to
+ the same block overwrite it in place. A new record is written completely
+ before the number of stored blocks is updated, so a record that was cut
+ short by a crash is not used. The block index is kept in memory and only
+ allocated for regions of the disk that have been written.
+
+ */
+
+#include <errno.h>
+
+#include "main.h"
+#include "log.h"
+#include "file.h"
+#include "overlay.h"
+#include "diskimage.h"
+
+#if HAVE_FTRUNCATE
+#include <unistd.h>
+#endif
+
+#define OVERLAY_MAGIC       "PRVOVL01"
+#define OVERLAY_MAGIC_SIZE  8
+#define OVERLAY_HEADER_SIZE 0x400
+#define OVERLAY_COUNT_OFFSET 0x0C
+#define OVERLAY_PATH_OFFSET 0x18
+#define OVERLAY_PATH_SIZE   (OVERLAY_HEADER_SIZE-OVERLAY_PATH_OFFSET)
+#define OVERLAY_RECORD_SIZE (4+OVERLAY_BLOCKSIZE)
+
+/* Block index pages */
+#define OVERLAY_PAGE_BITS   10
+#define OVERLAY_PAGE_SIZE   (1<<OVERLAY_PAGE_BITS)
+#define OVERLAY_PAGE_MASK   (OVERLAY_PAGE_SIZE-1)
+
+struct overlay {
+    FILE*    delta;
+    bool     temporary;
+    bool     writable;  /* delta is the writable top of the chain */
+
+    char     base_name[OVERLAY_PATH_SIZE];
+    DISKIMAGE* base;    /* base image, if not chained */
+    OVERLAY* parent;    /* base overlay, if chained */
+
+    Uint64   size;
+    Uint32   blocks;
+    Uint32   records;
+
+    Uint32** index;     /* record number + 1 for each written block */
+    Uint32   pages;
+};
+
+
+/* Helpers for little endian values */
+static void overlay_put32(Uint8 *buf, Uint32 val) {
+    buf[0] = val; buf[1] = val>>8; buf[2] = val>>16; buf[3] = val>>24;
+}
+
+static Uint32 overlay_get32(const Uint8 *buf) {
+    return buf[0] | (buf[1]<<8) | (buf[2]<<16) | ((Uint32)buf[3]<<24);
+}
+
+static void overlay_put64(Uint8 *buf, Uint64 val) {
+    overlay_put32(buf, val);
+    overlay_put32(buf+4, val>>32);
+}
+
+static Uint64 overlay_get64(const Uint8 *buf) {
+    return overlay_get32(buf) | ((Uint64)overlay_get32(buf+4)<<32);
+}
+
+static Uint64 overlay_record_offset(Uint32 record) {
+    return OVERLAY_HEADER_SIZE + (Uint64)record * OVERLAY_RECORD_SIZE;
+}
+
+
+/* Block index */
+static Uint32 overlay_lookup(OVERLAY *ovl, Uint32 block) {
+    Uint32* page = ovl->index[block>>OVERLAY_PAGE_BITS];
+    return page ? page[block&OVERLAY_PAGE_MASK] : 0;
+}
+
+static bool overlay_insert(OVERLAY *ovl, Uint32 block, Uint32 record) {
+    Uint32** page = &ovl->index[block>>OVERLAY_PAGE_BITS];
+    if (!*page) {
+        *page = calloc(OVERLAY_PAGE_SIZE, sizeof(Uint32));
+        if (!*page) {
+            Log_Printf(LOG_WARN, "[Overlay] Out of memory for block index");
+            return false;
+        }
+    }
+    (*page)[block&OVERLAY_PAGE_MASK] = record + 1;
+    return true;
+}
+
+static void overlay_clear_index(OVERLAY *ovl) {
+    Uint32 i;
+    for (i = 0; i < ovl->pages; i++) {
+        free(ovl->index[i]);
+        ovl->index[i] = NULL;
+    }
+}
+
+
+/* Header access */
+static bool overlay_read_header(FILE *fp, char *base_name, Uint64 *size, Uint32 *records) {
+    Uint8 header[OVERLAY_HEADER_SIZE];
+
+    if (!File_Read(header, OVERLAY_HEADER_SIZE, 0, fp) ||
+        memcmp(header, OVERLAY_MAGIC, OVERLAY_MAGIC_SIZE) ||
+        overlay_get32(header+8) != OVERLAY_BLOCKSIZE) {
+        return false;
+    }
+    *records = overlay_get32(header+12);
+    *size    = overlay_get64(header+16);
+    memcpy(base_name, header+OVERLAY_PATH_OFFSET, OVERLAY_PATH_SIZE);
+    base_name[OVERLAY_PATH_SIZE-1] = '\0';
+    return true;
+}
+
+static bool overlay_write_header(OVERLAY *ovl) {
+    Uint8 header[OVERLAY_HEADER_SIZE];
+
+    memset(header, 0, sizeof(header));
+    memcpy(header, OVERLAY_MAGIC, OVERLAY_MAGIC_SIZE);
+    overlay_put32(header+8, OVERLAY_BLOCKSIZE);
+    overlay_put32(header+12, ovl->records);
+    overlay_put64(header+16, ovl->size);
+    memcpy(header+OVERLAY_PATH_OFFSET, ovl->base_name, strlen(ovl->base_name));
+
+    return File_Write(header, OVERLAY_HEADER_SIZE, 0, ovl->delta);
+}
+
+static bool overlay_write_count(OVERLAY *ovl) {
+    Uint8 buf[4];
+
+    overlay_put32(buf, ovl->records);
+    return File_Write(buf, 4, OVERLAY_COUNT_OFFSET, ovl->delta);
+}
+
+/* Cut off records beyond the current count */
+static void overlay_truncate(OVERLAY *ovl) {
+    fflush(ovl->delta);
+#if HAVE_FTRUNCATE
+    if (ftruncate(fileno(ovl->delta), overlay_record_offset(ovl->records))) {
+        Log_Printf(LOG_WARN, "[Overlay] Cannot truncate delta file: %s", strerror(errno));
+    }
+#endif
+}
+
+/* Compare image paths after making them absolute */
+static bool overlay_same_path(const char *name1, const char *name2) {
+    char path1[FILENAME_MAX];
+    char path2[FILENAME_MAX];
+
+    if (!strcmp(name1, name2)) {
+        return true;
+    }
+    if (strlen(name1) >= FILENAME_MAX || strlen(name2) >= FILENAME_MAX) {
+        return false;
+    }
+    strcpy(path1, name1);
+    strcpy(path2, name2);
+    File_MakeAbsoluteName(path1);
+    File_MakeAbsoluteName(path2);
+    return !strcmp(path1, path2);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Check if a file is an overlay delta file.
+ */
+bool Overlay_IsOverlay(const char *pszFileName) {
+    char magic[OVERLAY_MAGIC_SIZE];
+    bool result = false;
+    FILE* fp = File_Open(pszFileName, "rb");
+
+    if (fp) {
+        result = fread(magic, OVERLAY_MAGIC_SIZE, 1, fp) == 1 &&
+                 !memcmp(magic, OVERLAY_MAGIC, OVERLAY_MAGIC_SIZE);
+        File_Close(fp);
+    }
+    return result;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Open an overlay on top of a base image. Chained base overlays are opened
+ * read-only and their delta files are never modified.
+ */
+static OVERLAY *overlay_open(const char *pszBaseName, const char *pszDeltaName, bool writable) {
+    char   hdr_base[OVERLAY_PATH_SIZE];
+    Uint64 hdr_size = 0;
+    Uint32 hdr_records = 0;
+    off_t  file_size;
+    Uint32 file_records;
+    Uint32 i;
+    Uint8  buf[4];
+    bool   existing = false;
+    bool   created  = false;
+
+    OVERLAY* ovl = calloc(1, sizeof(OVERLAY));
+    if (ovl == NULL) {
+        return NULL;
+    }
+
+    /* Open delta file */
+    if (pszDeltaName == NULL) {
+        ovl->delta = tmpfile();
+        ovl->temporary = true;
+        ovl->writable  = true;
+        created        = true;
+    } else if (File_Exists(pszDeltaName) && Overlay_IsOverlay(pszDeltaName)) {
+        if (writable) {
+            ovl->delta = File_Open(pszDeltaName, "rb+");
+            ovl->writable = ovl->delta != NULL;
+        }
+        if (ovl->delta == NULL) {
+            /* Shared chained deltas may be read-only */
+            ovl->delta = File_Open(pszDeltaName, "rb");
+        }
+        if (ovl->delta) {
+            existing = overlay_read_header(ovl->delta, hdr_base, &hdr_size, &hdr_records);
+        }
+    } else if (File_Exists(pszDeltaName)) {
+        Log_Printf(LOG_WARN, "[Overlay] %s exists and is not a delta file", pszDeltaName);
+    } else if (pszBaseName && writable) {
+        ovl->delta = File_Open(pszDeltaName, "wb+");
+        ovl->writable = ovl->delta != NULL;
+        created       = true;
+    }
+    if (ovl->delta == NULL) {
+        Log_Printf(LOG_WARN, "[Overlay] Cannot open delta file %s", pszDeltaName ? pszDeltaName : "(temporary)");
+        free(ovl);
+        return NULL;
+    }
+
+    if (pszBaseName == NULL) {
+        if (!existing) {
+            Log_Printf(LOG_WARN, "[Overlay] %s is not a valid delta file", pszDeltaName ? pszDeltaName : "(temporary)");
+            File_Close(ovl->delta);
+            free(ovl);
+            return NULL;
+        }
+        pszBaseName = hdr_base;
+    } else if (existing && !overlay_same_path(pszBaseName, hdr_base)) {
+        Log_Printf(LOG_WARN, "[Overlay] Delta file %s belongs to %s, not to %s", pszDeltaName, hdr_base, pszBaseName);
+        File_Close(ovl->delta);
+        free(ovl);
+        return NULL;
+    } else if (!existing && !created) {
+        Log_Printf(LOG_WARN, "[Overlay] %s is not a valid delta file", pszDeltaName);
+        File_Close(ovl->delta);
+        free(ovl);
+        return NULL;
+    }
+    if (strlen(pszBaseName) >= OVERLAY_PATH_SIZE) {
+        Log_Printf(LOG_WARN, "[Overlay] Base image path too long: %s", pszBaseName);
+        File_Close(ovl->delta);
+        free(ovl);
+        return NULL;
+    }
+    strcpy(ovl->base_name, pszBaseName);
+
+    /* Open base image, chain if it is an overlay itself */
+    if (Overlay_IsOverlay(ovl->base_name)) {
+        ovl->parent = overlay_open(NULL, ovl->base_name, false);
+        if (ovl->parent) {
+            ovl->size = Overlay_Size(ovl->parent);
+        }
+    } else {
+        ovl->base = DiskImage_Open(ovl->base_name, false);
+        if (ovl->base) {
+            ovl->size = DiskImage_Size(ovl->base);
+        }
+    }
+    if (ovl->parent == NULL && ovl->base == NULL) {
+        Log_Printf(LOG_WARN, "[Overlay] Cannot open base image %s", ovl->base_name);
+        File_Close(ovl->delta);
+        free(ovl);
+        return NULL;
+    }
+
+    if (existing && hdr_size != ovl->size) {
+        Log_Printf(LOG_WARN, "[Overlay] Size of %s changed. Not using delta file %s.", ovl->base_name, pszDeltaName);
+        Overlay_Close(ovl->parent);
+        DiskImage_Close(ovl->base);
+        File_Close(ovl->delta);
+        free(ovl);
+        return NULL;
+    }
+
+    ovl->blocks = ovl->size / OVERLAY_BLOCKSIZE;
+    ovl->pages  = (ovl->blocks + OVERLAY_PAGE_SIZE - 1) >> OVERLAY_PAGE_BITS;
+    ovl->index  = calloc(ovl->pages + 1, sizeof(Uint32*));
+    if (ovl->index == NULL) {
+        Log_Printf(LOG_WARN, "[Overlay] Out of memory for block index of %s", ovl->base_name);
+        Overlay_Close(ovl);
+        return NULL;
+    }
+
+    /* Rebuild block index from existing delta file, ignore incomplete records */
+    if (existing) {
+        file_size    = File_Length(pszDeltaName);
+        file_records = file_size > OVERLAY_HEADER_SIZE ? (file_size - OVERLAY_HEADER_SIZE) / OVERLAY_RECORD_SIZE : 0;
+        if (hdr_records > file_records) {
+            Log_Printf(LOG_WARN, "[Overlay] %s is truncated, using %i of %i blocks", pszDeltaName, file_records, hdr_records);
+            hdr_records = file_records;
+        }
+        for (i = 0; i < hdr_records; i++) {
+            if (!File_Read(buf, 4, overlay_record_offset(i), ovl->delta)) {
+                break;
+            }
+            if (overlay_get32(buf) < ovl->blocks && !overlay_insert(ovl, overlay_get32(buf), i)) {
+                Overlay_Close(ovl);
+                return NULL;
+            }
+        }
+        ovl->records = i;
+        Log_Printf(LOG_WARN, "[Overlay] Using %i modified blocks from %s", ovl->records, pszDeltaName);
+    }
+    if (ovl->writable) {
+        overlay_write_header(ovl);
+    } else if (writable) {
+        Log_Printf(LOG_WARN, "[Overlay] Delta file %s is read-only", pszDeltaName);
+    }
+
+    return ovl;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Open an overlay on top of a base image. If pszDeltaName is NULL a
+ * temporary delta is used that is removed when the overlay is closed.
+ * If pszBaseName is NULL the base image recorded in the existing delta
+ * file is used. An existing delta file that belongs to another base image
+ * or to a base image of different size is not opened.
+ */
+OVERLAY *Overlay_Open(const char *pszBaseName, const char *pszDeltaName) {
+    return overlay_open(pszBaseName, pszDeltaName, true);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Close overlay and all chained overlays.
+ */
+void Overlay_Close(OVERLAY *ovl) {
+    if (ovl == NULL) {
+        return;
+    }
+    if (ovl->parent) {
+        Overlay_Close(ovl->parent);
+    }
+    DiskImage_Close(ovl->base);
+    File_Close(ovl->delta);
+
+    if (ovl->index) {
+        overlay_clear_index(ovl);
+        free(ovl->index);
+    }
+    free(ovl);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Return size of overlaid image in bytes and in blocks.
+ */
+Uint64 Overlay_Size(OVERLAY *ovl) {
+    return ovl->size;
+}
+
+Uint32 Overlay_Blocks(OVERLAY *ovl) {
+    return ovl->blocks;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Check if writes are possible. Read-only delta files can not be written.
+ */
+bool Overlay_IsWritable(OVERLAY *ovl) {
+    return ovl->writable;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Read one block. Blocks that have not been written are read from the
+ * base image or the next overlay in the chain.
+ */
+bool Overlay_Read(OVERLAY *ovl, Uint8 *data, Uint32 block) {
+    Uint32 record;
+
+    if (block >= ovl->blocks) {
+        return false;
+    }
+    record = overlay_lookup(ovl, block);
+    if (record) {
+        return File_Read(data, OVERLAY_BLOCKSIZE, overlay_record_offset(record-1)+4, ovl->delta);
+    }
+    if (ovl->parent) {
+        return Overlay_Read(ovl->parent, data, block);
+    }
+    return DiskImage_Read(ovl->base, data, OVERLAY_BLOCKSIZE, (Uint64)block*OVERLAY_BLOCKSIZE);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Write one block to the delta file. A new block is appended as a complete
+ * record before the record count in the header is updated.
+ */
+bool Overlay_Write(OVERLAY *ovl, Uint8 *data, Uint32 block) {
+    Uint32 record;
+    Uint8  buf[4];
+
+    if (block >= ovl->blocks || !ovl->writable) {
+        return false;
+    }
+    record = overlay_lookup(ovl, block);
+    if (record) {
+        return File_Write(data, OVERLAY_BLOCKSIZE, overlay_record_offset(record-1)+4, ovl->delta);
+    }
+
+    record = ovl->records;
+    overlay_put32(buf, block);
+    if (!File_Write(buf, 4, overlay_record_offset(record), ovl->delta) ||
+        !File_Write(data, OVERLAY_BLOCKSIZE, overlay_record_offset(record)+4, ovl->delta) ||
+        !overlay_insert(ovl, block, record)) {
+        return false;
+    }
+    ovl->records = record + 1;
+    return overlay_write_count(ovl);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Write all modified blocks to the base image or the next overlay in the
+ * chain and empty the delta file.
+ */
+bool Overlay_Commit(OVERLAY *ovl) {
+    Uint8  data[OVERLAY_BLOCKSIZE];
+    Uint8  buf[4];
+    Uint32 i, block;
+    bool   result = true;
+    FILE*  base = NULL;
+
+    if (!ovl->writable) {
+        return false;
+    }
+    if (ovl->parent == NULL) {
+        base = File_Open(ovl->base_name, "rb+");
+    } else if (!ovl->parent->writable) {
+        /* Chained deltas are opened read-only, reopen for writing */
+        base = File_Open(ovl->base_name, "rb+");
+        if (base) {
+            File_Close(ovl->parent->delta);
+            ovl->parent->delta    = base;
+            ovl->parent->writable = true;
+            base = NULL;
+        }
+    }
+    if (base == NULL && (ovl->parent == NULL || !ovl->parent->writable)) {
+        Log_Printf(LOG_WARN, "[Overlay] Cannot commit to %s: image is not writable", ovl->base_name);
+        return false;
+    }
+
+    for (i = 0; i < ovl->records && result; i++) {
+        result = File_Read(buf, 4, overlay_record_offset(i), ovl->delta) &&
+                 File_Read(data, OVERLAY_BLOCKSIZE, overlay_record_offset(i)+4, ovl->delta);
+        if (result) {
+            block = overlay_get32(buf);
+            if (base) {
+                result = File_Write(data, OVERLAY_BLOCKSIZE, (Uint64)block*OVERLAY_BLOCKSIZE, base);
+            } else {
+                result = Overlay_Write(ovl->parent, data, block);
+            }
+        }
+    }
+    File_Close(base);
+
+    if (result) {
+        Log_Printf(LOG_WARN, "[Overlay] Committed %i blocks to %s", ovl->records, ovl->base_name);
+        Overlay_Discard(ovl);
+    } else {
+        Log_Printf(LOG_WARN, "[Overlay] Error while committing to %s", ovl->base_name);
+    }
+    return result;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Throw away all modified blocks and shrink the delta file to its header.
+ */
+void Overlay_Discard(OVERLAY *ovl) {
+    if (!ovl->writable) {
+        return;
+    }
+    overlay_clear_index(ovl);
+    ovl->records = 0;
+    overlay_write_count(ovl);
+    overlay_truncate(ovl);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Write buffered blocks of the delta file to disk.
+ */
+void Overlay_Flush(OVERLAY *ovl) {
+    if (ovl->writable) {
+        fflush(ovl->delta);
+    }
+}
@@ -16,6 +16,7 @@
 #include "dimension.hpp"
 #include "sysReg.h"
 #include "rtcnvram.h"
+#include "memorySnapShot.h"
 
 #include <time.h>
 
@@ -1091,3 +1092,14 @@ char * get_rtc_ram_info(void) {
     return rtc_ram_info;
 }
 #endif
+
+
+/* Save/restore RTC state */
+void RTC_MemorySnapShot_Capture(bool bSave) {
+    MemorySnapShot_Store(&rtc_addr, sizeof(rtc_addr));
+    MemorySnapShot_Store(&rtc_val, sizeof(rtc_val));
+    MemorySnapShot_Store(&rtc_data, sizeof(rtc_data));
+    MemorySnapShot_Store(&phase, sizeof(phase));
+    MemorySnapShot_Store(&rtc, sizeof(rtc));
+    MemorySnapShot_Store(&newrtc, sizeof(newrtc));
+}
@@ -0,0 +1,156 @@
+/*  Previous - screenSnapShot.c
+
+ This file is distributed under the GNU Public License, version 2 or at
+ your option any later version. Read the file gpl.txt for details.
+
+ Save the emulated framebuffer to a PNG file.
+
+ The picture is converted directly from guest video memory, so this works
+ without a window or renderer (e.g. in headless mode). The NeXTdimension
+ framebuffer is saved instead of the main framebuffer when the monitor is
+ set to NeXTdimension.
+
+ */
+
+#include "main.h"
+#include "configuration.h"
+#include "log.h"
+#include "file.h"
+#include "m68000.h"
+#include "dimension.hpp"
+#include "screenSnapShot.h"
+
+#if HAVE_LIBPNG
+#include <png.h>
+
+#define SNAPSHOT_WIDTH  1120
+#define SNAPSHOT_HEIGHT 832
+
+/*
+ BW format is 2bit per pixel, 3 is black
+ */
+static void snapshot_bw_line(Uint8* dst, const Uint8* src) {
+    static const Uint8 gray[4] = { 255, 170, 85, 0 };
+    for(int x = 0; x < SNAPSHOT_WIDTH; x++) {
+        Uint8 g = gray[(src[x/4] >> (6 - 2 * (x & 3))) & 3];
+        *dst++  = g;
+        *dst++  = g;
+        *dst++  = g;
+    }
+}
+
+/*
+ Color format is 4bit per pixel, big-endian: RGBx
+ */
+static void snapshot_color_line(Uint8* dst, const Uint8* src) {
+    for(int x = 0; x < SNAPSHOT_WIDTH; x++, src += 2) {
+        *dst++ = (src[0] >> 4)   * 0x11;
+        *dst++ = (src[0] & 0x0F) * 0x11;
+        *dst++ = (src[1] >> 4)   * 0x11;
+    }
+}
+
+/*
+ Dimension format is 8bit per pixel, big-endian: RRGGBBAA
+ */
+static void snapshot_dimension_line(Uint8* dst, const Uint32* src) {
+    const int rIn = SDL_BYTEORDER == SDL_BIG_ENDIAN ? 8  : 16;
+    const int gIn = SDL_BYTEORDER == SDL_BIG_ENDIAN ? 16 : 8;
+    const int bIn = SDL_BYTEORDER == SDL_BIG_ENDIAN ? 24 : 0;
+    for(int x = 0; x < SNAPSHOT_WIDTH; x++) {
+        Uint32 v = *src++;
+        *dst++   = v >> rIn;
+        *dst++   = v >> gIn;
+        *dst++   = v >> bIn;
+    }
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Save the current framebuffer as 24 bit RGB PNG. Returns true on success.
+ */
+bool ScreenSnapShot_SavePNG(const char *pszFileName) {
+    png_structp png_ptr;
+    png_infop   info_ptr;
+    png_byte*   row;
+    FILE*       fp;
+    Uint32*     vram = NULL;
+    int         pitch;
+
+    if (ConfigureParams.Screen.nMonitorType == MONITOR_TYPE_DIMENSION) {
+        vram = nd_vram_for_slot(ND_SLOT(ConfigureParams.Screen.nMonitorNum));
+        if (!vram) {
+            Log_Printf(LOG_WARN, "[Screen] No NeXTdimension framebuffer to save.");
+            return false;
+        }
+#if !ND_STEP
+        vram += 16;
+#endif
+        pitch = SNAPSHOT_WIDTH + 32;
+    } else if (!NEXTVideo) {
+        Log_Printf(LOG_WARN, "[Screen] No framebuffer to save.");
+        return false;
+    } else if (ConfigureParams.System.bColor) {
+        pitch = (SNAPSHOT_WIDTH + (ConfigureParams.System.bTurbo ? 0 : 32)) * 2;
+    } else {
+        pitch = (SNAPSHOT_WIDTH + (ConfigureParams.System.bTurbo ? 0 : 32)) / 4;
+    }
+
+    fp = File_Open(pszFileName, "wb");
+    if (!fp) {
+        Log_Printf(LOG_WARN, "[Screen] Could not create %s.", pszFileName);
+        return false;
+    }
+
+    png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    if (!png_ptr) {
+        File_Close(fp);
+        return false;
+    }
+    info_ptr = png_create_info_struct(png_ptr);
+    row      = malloc(SNAPSHOT_WIDTH * 3);
+    if (!info_ptr || !row || setjmp(png_jmpbuf(png_ptr))) {
+        free(row);
+        png_destroy_write_struct(&png_ptr, &info_ptr);
+        File_Close(fp);
+        Log_Printf(LOG_WARN, "[Screen] Could not write %s.", pszFileName);
+        return false;
+    }
+
+    png_init_io(png_ptr, fp);
+    png_set_IHDR(png_ptr,
+                 info_ptr,
+                 SNAPSHOT_WIDTH,
+                 SNAPSHOT_HEIGHT,
+                 8,
+                 PNG_COLOR_TYPE_RGB,
+                 PNG_INTERLACE_NONE,
+                 PNG_COMPRESSION_TYPE_DEFAULT,
+                 PNG_FILTER_TYPE_DEFAULT);
+    png_write_info(png_ptr, info_ptr);
+
+    for(int y = 0; y < SNAPSHOT_HEIGHT; y++) {
+        if (vram) {
+            snapshot_dimension_line(row, vram + y * pitch);
+        } else if (ConfigureParams.System.bColor) {
+            snapshot_color_line(row, NEXTVideo + y * pitch);
+        } else {
+            snapshot_bw_line(row, NEXTVideo + y * pitch);
+        }
+        png_write_row(png_ptr, row);
+    }
+    png_write_end(png_ptr, NULL);
+
+    free(row);
+    png_destroy_write_struct(&png_ptr, &info_ptr);
+    File_Close(fp);
+
+    Log_Printf(LOG_WARN, "[Screen] Saved screen to %s.", pszFileName);
+    return true;
+}
+#else
+bool ScreenSnapShot_SavePNG(const char *pszFileName) {
+    Log_Printf(LOG_WARN, "[Screen] Saving screen not supported (no PNG library).");
+    return false;
+}
+#endif
@@ -0,0 +1,275 @@
+/*  Previous - script.c
+
+ This file is distributed under the GNU Public License, version 2 or at
+ your option any later version. Read the file gpl.txt for details.
+
+ Scripted input, mainly for headless operation.
+
+ The script is a text file with one command per line. Empty lines and
+ lines starting with '#' are ignored. Times are in milliseconds of
+ emulated time.
+
+   wait <ms>              pause the script
+   key <name>             press and release a key (character or SDL key
+                          name, e.g. Return, see ScriptKeys)
+   keydown <name>         press a key
+   keyup <name>           release a key
+   type <text>            type the rest of the line
+   mouse <dx> <dy>        move the mouse
+   click [left|right]     press and release a mouse button
+   screenshot <file.png>  save the framebuffer
+   quit                   quit the emulator
+
+ Key and button releases and each typed character take one event handler
+ cycle, so the guest sees separate press and release events.
+
+ */
+
+#include <ctype.h>
+
+#include "main.h"
+#include "log.h"
+#include "file.h"
+#include "host.h"
+#include "keymap.h"
+#include "screenSnapShot.h"
+#include "script.h"
+
+#define SCRIPT_LINE_LEN 256
+
+enum {
+    SCRIPT_IDLE,
+    SCRIPT_KEY_UP,
+    SCRIPT_MOUSE_UP,
+    SCRIPT_TYPE,
+};
+
+static FILE*      scriptFile = NULL;
+static int        scriptLine;
+static int        scriptState;
+static Uint64     scriptWait;
+static SDL_Keysym scriptKey;
+static bool       scriptButton;
+static char       scriptText[SCRIPT_LINE_LEN];
+static int        scriptTextPos;
+static bool       scriptTextUp;
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Open the input script. Returns false if it cannot be read.
+ */
+bool Script_Init(const char *pszFileName) {
+    scriptFile = File_Open(pszFileName, "r");
+    if (!scriptFile) {
+        fprintf(stderr, "Cannot open input script '%s'\n", pszFileName);
+        return false;
+    }
+    scriptLine  = 0;
+    scriptState = SCRIPT_IDLE;
+    scriptWait  = 0;
+    return true;
+}
+
+void Script_UnInit(void) {
+    if (scriptFile) {
+        File_Close(scriptFile);
+        scriptFile = NULL;
+    }
+}
+
+/* Names of the keys that do not type a character. These are the SDL key
+ * names, but the SDL lookup functions need an initialized video subsystem,
+ * which headless mode does not have. */
+static const struct {
+    const char  *name;
+    SDL_Scancode scancode;
+    SDL_Keycode  sym;
+} ScriptKeys[] = {
+    { "Return",       SDL_SCANCODE_RETURN,      SDLK_RETURN },
+    { "Escape",       SDL_SCANCODE_ESCAPE,      SDLK_ESCAPE },
+    { "Backspace",    SDL_SCANCODE_BACKSPACE,   SDLK_BACKSPACE },
+    { "Tab",          SDL_SCANCODE_TAB,         SDLK_TAB },
+    { "Space",        SDL_SCANCODE_SPACE,       SDLK_SPACE },
+    { "Delete",       SDL_SCANCODE_DELETE,      SDLK_DELETE },
+    { "Home",         SDL_SCANCODE_HOME,        SDLK_HOME },
+    { "End",          SDL_SCANCODE_END,         SDLK_END },
+    { "PageUp",       SDL_SCANCODE_PAGEUP,      SDLK_PAGEUP },
+    { "PageDown",     SDL_SCANCODE_PAGEDOWN,    SDLK_PAGEDOWN },
+    { "Up",           SDL_SCANCODE_UP,          SDLK_UP },
+    { "Down",         SDL_SCANCODE_DOWN,        SDLK_DOWN },
+    { "Left",         SDL_SCANCODE_LEFT,        SDLK_LEFT },
+    { "Right",        SDL_SCANCODE_RIGHT,       SDLK_RIGHT },
+    { "F1",           SDL_SCANCODE_F1,          SDLK_F1 },
+    { "F2",           SDL_SCANCODE_F2,          SDLK_F2 },
+    { "F5",           SDL_SCANCODE_F5,          SDLK_F5 },
+    { "F6",           SDL_SCANCODE_F6,          SDLK_F6 },
+    { "F10",          SDL_SCANCODE_F10,         SDLK_F10 },
+    { "CapsLock",     SDL_SCANCODE_CAPSLOCK,    SDLK_CAPSLOCK },
+    { "Left Shift",   SDL_SCANCODE_LSHIFT,      SDLK_LSHIFT },
+    { "Right Shift",  SDL_SCANCODE_RSHIFT,      SDLK_RSHIFT },
+    { "Left Ctrl",    SDL_SCANCODE_LCTRL,       SDLK_LCTRL },
+    { "Right Ctrl",   SDL_SCANCODE_RCTRL,       SDLK_RCTRL },
+    { "Left Alt",     SDL_SCANCODE_LALT,        SDLK_LALT },
+    { "Right Alt",    SDL_SCANCODE_RALT,        SDLK_RALT },
+    { "Left GUI",     SDL_SCANCODE_LGUI,        SDLK_LGUI },
+    { "Right GUI",    SDL_SCANCODE_RGUI,        SDLK_RGUI },
+    { "Keypad 0",     SDL_SCANCODE_KP_0,        SDLK_KP_0 },
+    { "Keypad 1",     SDL_SCANCODE_KP_1,        SDLK_KP_1 },
+    { "Keypad 2",     SDL_SCANCODE_KP_2,        SDLK_KP_2 },
+    { "Keypad 3",     SDL_SCANCODE_KP_3,        SDLK_KP_3 },
+    { "Keypad 4",     SDL_SCANCODE_KP_4,        SDLK_KP_4 },
+    { "Keypad 5",     SDL_SCANCODE_KP_5,        SDLK_KP_5 },
+    { "Keypad 6",     SDL_SCANCODE_KP_6,        SDLK_KP_6 },
+    { "Keypad 7",     SDL_SCANCODE_KP_7,        SDLK_KP_7 },
+    { "Keypad 8",     SDL_SCANCODE_KP_8,        SDLK_KP_8 },
+    { "Keypad 9",     SDL_SCANCODE_KP_9,        SDLK_KP_9 },
+    { "Keypad .",     SDL_SCANCODE_KP_PERIOD,   SDLK_KP_PERIOD },
+    { "Keypad +",     SDL_SCANCODE_KP_PLUS,     SDLK_KP_PLUS },
+    { "Keypad -",     SDL_SCANCODE_KP_MINUS,    SDLK_KP_MINUS },
+    { "Keypad *",     SDL_SCANCODE_KP_MULTIPLY, SDLK_KP_MULTIPLY },
+    { "Keypad /",     SDL_SCANCODE_KP_DIVIDE,   SDLK_KP_DIVIDE },
+    { "Keypad =",     SDL_SCANCODE_KP_EQUALS,   SDLK_KP_EQUALS },
+    { "Keypad Enter", SDL_SCANCODE_KP_ENTER,    SDLK_KP_ENTER },
+};
+
+static bool script_keysym(const char *name, SDL_Keysym *key) {
+    bool shift;
+    int  i;
+
+    key->mod = KMOD_NONE;
+    if (name[0] && !name[1] && Keymap_GetCharacterKey(name[0], key, &shift)) {
+        return true;
+    }
+    for (i = 0; i < ARRAYSIZE(ScriptKeys); i++) {
+        if (!strcasecmp(name, ScriptKeys[i].name)) {
+            key->scancode = ScriptKeys[i].scancode;
+            key->sym      = ScriptKeys[i].sym;
+            return true;
+        }
+    }
+    fprintf(stderr, "Script line %d: unknown key '%s'\n", scriptLine, name);
+    return false;
+}
+
+/* Execute one script command, returns true if the script has to yield */
+static bool script_command(char *line) {
+    char *cmd, *arg;
+    int   dx, dy;
+
+    cmd = line;
+    while (isspace((unsigned char)*cmd)) cmd++;
+    if (*cmd == '\0' || *cmd == '#') {
+        return false;
+    }
+    arg = cmd;
+    while (*arg && !isspace((unsigned char)*arg)) arg++;
+    if (*arg) {
+        *arg++ = '\0';
+        while (isspace((unsigned char)*arg)) arg++;
+    }
+    /* strip line end */
+    arg[strcspn(arg, "\r\n")] = '\0';
+
+    if (!strcmp(cmd, "wait")) {
+        scriptWait = host_time_ms() + atoi(arg);
+        return true;
+    } else if (!strcmp(cmd, "key")) {
+        if (script_keysym(arg, &scriptKey)) {
+            Keymap_KeyDown(&scriptKey);
+            scriptState = SCRIPT_KEY_UP;
+            return true;
+        }
+    } else if (!strcmp(cmd, "keydown")) {
+        SDL_Keysym key;
+        if (script_keysym(arg, &key)) {
+            Keymap_KeyDown(&key);
+            return true;
+        }
+    } else if (!strcmp(cmd, "keyup")) {
+        SDL_Keysym key;
+        if (script_keysym(arg, &key)) {
+            Keymap_KeyUp(&key);
+            return true;
+        }
+    } else if (!strcmp(cmd, "type")) {
+        strcpy(scriptText, arg);
+        scriptTextPos = 0;
+        scriptTextUp  = false;
+        scriptState   = SCRIPT_TYPE;
+        return true;
+    } else if (!strcmp(cmd, "mouse")) {
+        if (sscanf(arg, "%d %d", &dx, &dy) == 2) {
+            Keymap_MouseMove(dx, dy, 1.0, 1.0);
+            return true;
+        }
+        fprintf(stderr, "Script line %d: mouse needs dx and dy\n", scriptLine);
+    } else if (!strcmp(cmd, "click")) {
+        scriptButton = strcmp(arg, "right") != 0;
+        Keymap_MouseDown(scriptButton);
+        scriptState = SCRIPT_MOUSE_UP;
+        return true;
+    } else if (!strcmp(cmd, "screenshot")) {
+        ScreenSnapShot_SavePNG(arg);
+    } else if (!strcmp(cmd, "quit")) {
+        Main_RequestQuit();
+        return true;
+    } else {
+        fprintf(stderr, "Script line %d: unknown command '%s'\n", scriptLine, cmd);
+    }
+    return false;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Feed the next step of the script to the emulator. Called from the
+ * event handler.
+ */
+void Script_Process(void) {
+    char line[SCRIPT_LINE_LEN];
+
+    if (!scriptFile) {
+        return;
+    }
+
+    switch (scriptState) {
+        case SCRIPT_KEY_UP:
+            Keymap_KeyUp(&scriptKey);
+            scriptState = SCRIPT_IDLE;
+            return;
+        case SCRIPT_MOUSE_UP:
+            Keymap_MouseUp(scriptButton);
+            scriptState = SCRIPT_IDLE;
+            return;
+        case SCRIPT_TYPE:
+            if (scriptText[scriptTextPos]) {
+                Keymap_SimulateCharacter(scriptText[scriptTextPos], !scriptTextUp);
+                if (scriptTextUp) {
+                    scriptTextPos++;
+                }
+                scriptTextUp = !scriptTextUp;
+                return;
+            }
+            scriptState = SCRIPT_IDLE;
+            break;
+        default:
+            break;
+    }
+
+    if (scriptWait) {
+        if (host_time_ms() < scriptWait) {
+            return;
+        }
+        scriptWait = 0;
+    }
+
+    while (fgets(line, sizeof(line), scriptFile)) {
+        scriptLine++;
+        if (script_command(line)) {
+            return;
+        }
+    }
+    Log_Printf(LOG_WARN, "[Script] End of input script.");
+    Script_UnInit();
+}
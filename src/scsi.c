@@ -8,6 +8,10 @@
 #include "statusbar.h"
 #include "scsi.h"
 #include "file.h"
+#include "overlay.h"
+#include "diskimage.h"
+#include "memorySnapShot.h"
+#include "evtrace.h"
 
 #define LOG_SCSI_LEVEL  LOG_DEBUG    /* Print debugging messages */
 
@@ -94,6 +98,7 @@
 #define CMD_REQ_SENSE       0x03    /* Request sense */
 #define CMD_SHIP            0x1B    /* Ship drive */
 #define CMD_READ_CAPACITY1  0x25    /* Read capacity (class 1) */
+#define CMD_SYNC_CACHE1     0x35    /* Synchronize cache (class 1) */
 
 SCSIBusStatus SCSIbus;
 SCSIBuffer scsi_buffer;
@@ -109,6 +114,7 @@ void SCSI_WriteSector(Uint8 *cdb);
 void SCSI_RequestSense(Uint8 *cdb);
 void SCSI_ModeSense(Uint8 *cdb);
 void SCSI_FormatDrive(Uint8 *cdb);
+void SCSI_SynchronizeCache(Uint8 *cdb);
 
 
 /* Helpers */
@@ -124,7 +130,7 @@ void scsi_write_sector(void);
 /* SCSI disk */
 struct {
     SCSI_DEVTYPE devtype;
-    FILE* dsk;
+    DISKIMAGE* dsk;
     Uint64 size;
     bool readonly;
     Uint8 lun;
@@ -142,10 +148,204 @@ struct {
     Uint32 blockcounter;
     Uint32 lastlba;
     
-    Uint8** shadow;
+    OVERLAY* overlay;
 } SCSIdisk[ESP_MAX_DEVS];
 
 
+/* Read cache
+ *
+ * Each target has a small set of cache lines holding consecutive blocks
+ * of the disk image. Lines are replaced in least recently used order.
+ * When a read continues where the previous one ended, the following line
+ * is filled too, so sequential reads usually find their data in memory.
+ * Writes go to the disk immediately and update cached blocks. Images that
+ * are mapped into memory are read directly and bypass the cache. */
+#define SCSI_CACHE_LINE_BLOCKS  64
+#define SCSI_CACHE_LINES        32
+#define SCSI_CACHE_LINE_SIZE    (SCSI_CACHE_LINE_BLOCKS*BLOCKSIZE)
+#define SCSI_CACHE_INVALID      0xFFFFFFFF
+
+static struct {
+    Uint8* data;
+    struct {
+        Uint32 tag;     /* first block of the line */
+        Uint32 blocks;  /* number of valid blocks */
+        Uint32 used;
+    } line[SCSI_CACHE_LINES];
+    Uint32 stamp;
+    Uint32 next;        /* block following the last read */
+    Uint64 hits;
+    Uint64 misses;
+} scsi_cache[ESP_MAX_DEVS];
+
+static void scsi_cache_flush(Uint8 target) {
+    int i;
+    for (i = 0; i < SCSI_CACHE_LINES; i++) {
+        scsi_cache[target].line[i].tag = SCSI_CACHE_INVALID;
+        scsi_cache[target].line[i].blocks = 0;
+        scsi_cache[target].line[i].used = 0;
+    }
+    scsi_cache[target].next = SCSI_CACHE_INVALID;
+}
+
+static void scsi_cache_free(Uint8 target) {
+    scsi_cache_flush(target);
+    free(scsi_cache[target].data);
+    scsi_cache[target].data = NULL;
+}
+
+/* Read blocks directly from the disk image */
+static void scsi_disk_read(Uint8 target, Uint8* buf, Uint32 lba, Uint32 blocks) {
+    if (SCSIdisk[target].overlay) {
+        while (blocks--) {
+            Overlay_Read(SCSIdisk[target].overlay, buf, lba++);
+            buf += BLOCKSIZE;
+        }
+    } else {
+        DiskImage_Read(SCSIdisk[target].dsk, buf, blocks*BLOCKSIZE, ((Uint64)lba)*BLOCKSIZE);
+    }
+}
+
+static int scsi_cache_find(Uint8 target, Uint32 tag) {
+    int i;
+    for (i = 0; i < SCSI_CACHE_LINES; i++) {
+        if (scsi_cache[target].line[i].tag == tag) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Load the line starting at block tag, replacing the least recently used line */
+static int scsi_cache_fill(Uint8 target, Uint32 tag) {
+    Uint32 disksize = SCSIdisk[target].size/BLOCKSIZE;
+    Uint32 blocks = SCSI_CACHE_LINE_BLOCKS;
+    int i, victim = 0;
+    
+    for (i = 1; i < SCSI_CACHE_LINES; i++) {
+        if (scsi_cache[target].line[i].used < scsi_cache[target].line[victim].used) {
+            victim = i;
+        }
+    }
+    if (tag + blocks > disksize) {
+        blocks = disksize - tag;
+    }
+    scsi_disk_read(target, scsi_cache[target].data + victim*SCSI_CACHE_LINE_SIZE, tag, blocks);
+    
+    scsi_cache[target].line[victim].tag = tag;
+    scsi_cache[target].line[victim].blocks = blocks;
+    scsi_cache[target].line[victim].used = scsi_cache[target].stamp;
+    return victim;
+}
+
+/* Read blocks through the cache. All blocks must be inside the disk. */
+static void scsi_cache_read(Uint8 target, Uint8* buf, Uint32 lba, Uint32 blocks) {
+    Uint32 disksize = SCSIdisk[target].size/BLOCKSIZE;
+    Uint32 tag, offset, n;
+    bool sequential;
+    int i;
+    
+    if (lba + blocks > disksize || /* partial block at the end of the image */
+        (SCSIdisk[target].dsk && DiskImage_IsMapped(SCSIdisk[target].dsk))) {
+        scsi_disk_read(target, buf, lba, blocks);
+        return;
+    }
+    
+    if (scsi_cache[target].data == NULL) {
+        scsi_cache[target].data = malloc(SCSI_CACHE_LINES*SCSI_CACHE_LINE_SIZE);
+        if (scsi_cache[target].data == NULL) {
+            scsi_disk_read(target, buf, lba, blocks);
+            return;
+        }
+        scsi_cache_flush(target);
+    }
+    
+    sequential = (lba == scsi_cache[target].next);
+    scsi_cache[target].next = lba + blocks;
+    
+    while (blocks > 0) {
+        tag = lba - (lba % SCSI_CACHE_LINE_BLOCKS);
+        offset = lba - tag;
+        n = SCSI_CACHE_LINE_BLOCKS - offset;
+        if (n > blocks) {
+            n = blocks;
+        }
+        scsi_cache[target].stamp++;
+        i = scsi_cache_find(target, tag);
+        if (i < 0) {
+            scsi_cache[target].misses += n;
+            i = scsi_cache_fill(target, tag);
+        } else {
+            scsi_cache[target].hits += n;
+            scsi_cache[target].line[i].used = scsi_cache[target].stamp;
+        }
+        memcpy(buf, scsi_cache[target].data + i*SCSI_CACHE_LINE_SIZE + offset*BLOCKSIZE, n*BLOCKSIZE);
+        buf += n*BLOCKSIZE;
+        lba += n;
+        blocks -= n;
+    }
+    
+    /* Read ahead */
+    tag = lba - (lba % SCSI_CACHE_LINE_BLOCKS) + SCSI_CACHE_LINE_BLOCKS;
+    if (sequential && tag < disksize && scsi_cache_find(target, tag) < 0) {
+        scsi_cache_fill(target, tag);
+    }
+}
+
+/* Update a written block if it is cached */
+static void scsi_cache_write(Uint8 target, Uint8* buf, Uint32 lba) {
+    Uint32 tag = lba - (lba % SCSI_CACHE_LINE_BLOCKS);
+    int i;
+    
+    if (scsi_cache[target].data == NULL) {
+        return;
+    }
+    i = scsi_cache_find(target, tag);
+    if (i >= 0 && lba - tag < scsi_cache[target].line[i].blocks) {
+        memcpy(scsi_cache[target].data + i*SCSI_CACHE_LINE_SIZE + (lba-tag)*BLOCKSIZE, buf, BLOCKSIZE);
+    }
+}
+
+const char* SCSI_Reports(Uint64 realTime, Uint64 hostTime) {
+    static char   report[64];
+    static Uint64 lastHits;
+    static Uint64 lastMisses;
+    Uint64 hits = 0, misses = 0;
+    int i;
+    
+    for (i = 0; i < ESP_MAX_DEVS; i++) {
+        hits   += scsi_cache[i].hits;
+        misses += scsi_cache[i].misses;
+    }
+    if (hits + misses - lastHits - lastMisses) {
+        sprintf(report, "cache=%.1f%% (%llu blocks)",
+                (100.0 * (hits - lastHits)) / (hits + misses - lastHits - lastMisses),
+                (unsigned long long)(hits + misses - lastHits - lastMisses));
+    } else {
+        report[0] = '\0';
+    }
+    lastHits   = hits;
+    lastMisses = misses;
+    
+    return report;
+}
+
+void SCSI_CacheInfo(FILE *fp) {
+    int i;
+    
+    fprintf(fp, "SCSI read cache: %d lines of %d blocks per target\n",
+            SCSI_CACHE_LINES, SCSI_CACHE_LINE_BLOCKS);
+    for (i = 0; i < ESP_MAX_DEVS; i++) {
+        if (scsi_cache[i].hits || scsi_cache[i].misses) {
+            fprintf(fp, "Target %d: %llu hits, %llu misses (%.1f%%)\n", i,
+                    (unsigned long long)scsi_cache[i].hits,
+                    (unsigned long long)scsi_cache[i].misses,
+                    (100.0 * scsi_cache[i].hits) / (scsi_cache[i].hits + scsi_cache[i].misses));
+        }
+    }
+}
+
+
 /* Mode Pages */
 #define MODEPAGE_MAX_SIZE 24
 
@@ -174,7 +374,7 @@ void SCSI_Init(void) {
 void SCSI_Uninit(void) {
     int i;
     for (i = 0; i < ESP_MAX_DEVS; i++) {
-        if (SCSIdisk[i].dsk) {
+        if (SCSIdisk[i].dsk || SCSIdisk[i].overlay) {
             SCSI_Eject(i);
         }
     }
@@ -186,11 +386,82 @@ void SCSI_Reset(void) {
 }
 
 void SCSI_Eject(Uint8 i) {
-    File_Close(SCSIdisk[i].dsk);
+    DiskImage_Close(SCSIdisk[i].dsk);
     SCSIdisk[i].dsk = NULL;
     SCSIdisk[i].size = 0;
     SCSIdisk[i].readonly = false;
-    SCSIdisk[i].shadow = NULL;
+    Overlay_Close(SCSIdisk[i].overlay);
+    SCSIdisk[i].overlay = NULL;
+    scsi_cache_free(i);
+}
+
+/* Open image with a copy-on-write overlay. With write protection the image
+ * is not modified and writes go to a delta file in the overlay directory or
+ * to a temporary delta file. An image that is a delta file itself is opened
+ * as overlay on top of its base image. */
+static void SCSI_OpenOverlay(Uint8 i) {
+    char delta[sizeof(ConfigureParams.SCSI.szOverlayDir)+16];
+    
+    if (ConfigureParams.SCSI.nWriteProtection != WRITEPROT_ON) {
+        SCSIdisk[i].overlay = Overlay_Open(NULL, ConfigureParams.SCSI.target[i].szImageName);
+    } else if (ConfigureParams.SCSI.szOverlayDir[0]) {
+        if (snprintf(delta, sizeof(delta), "%s%ctarget%i.ovl", ConfigureParams.SCSI.szOverlayDir, PATHSEP, i) < (int)sizeof(delta)) {
+            SCSIdisk[i].overlay = Overlay_Open(ConfigureParams.SCSI.target[i].szImageName, delta);
+        }
+    } else {
+        SCSIdisk[i].overlay = Overlay_Open(ConfigureParams.SCSI.target[i].szImageName, NULL);
+    }
+    
+    if (SCSIdisk[i].overlay == NULL) {
+        Log_Printf(LOG_WARN, "SCSI Disk%i: Cannot open overlay for image file %s\n",
+                   i, ConfigureParams.SCSI.target[i].szImageName);
+        SCSIdisk[i].size = 0;
+        SCSIdisk[i].readonly = false;
+        if (SCSIdisk[i].devtype == DEVTYPE_HARDDISK) {
+            SCSIdisk[i].devtype = DEVTYPE_NONE;
+        }
+    } else {
+        SCSIdisk[i].size = Overlay_Size(SCSIdisk[i].overlay);
+        SCSIdisk[i].readonly = !Overlay_IsWritable(SCSIdisk[i].overlay);
+    }
+}
+
+/* Write overlay contents to the disk images or throw them away */
+void SCSI_CommitOverlays(void) {
+    int i;
+    for (i = 0; i < ESP_MAX_DEVS; i++) {
+        if (SCSIdisk[i].overlay) {
+            Overlay_Commit(SCSIdisk[i].overlay);
+        }
+    }
+}
+
+/* Write modified data of memory mapped disk images to the image files */
+/* Write modified data of memory mapped images and overlays to disk */
+static void scsi_flush(Uint8 i) {
+    if (SCSIdisk[i].dsk) {
+        DiskImage_Flush(SCSIdisk[i].dsk);
+    }
+    if (SCSIdisk[i].overlay) {
+        Overlay_Flush(SCSIdisk[i].overlay);
+    }
+}
+
+void SCSI_FlushDisks(void) {
+    int i;
+    for (i = 0; i < ESP_MAX_DEVS; i++) {
+        scsi_flush(i);
+    }
+}
+
+void SCSI_DiscardOverlays(void) {
+    int i;
+    for (i = 0; i < ESP_MAX_DEVS; i++) {
+        if (SCSIdisk[i].overlay) {
+            Overlay_Discard(SCSIdisk[i].overlay);
+            scsi_cache_flush(i);
+        }
+    }
 }
 
 static void SCSI_EjectDisk(Uint8 i) {
@@ -206,7 +477,8 @@ void SCSI_Insert(Uint8 i) {
     SCSIdisk[i].sense.valid = false;
     SCSIdisk[i].lba = SCSIdisk[i].lastlba = SCSIdisk[i].blockcounter = 0;
     
-    SCSIdisk[i].shadow = NULL;
+    SCSIdisk[i].overlay = NULL;
+    scsi_cache_flush(i);
     
     Log_Printf(LOG_WARN, "SCSI Disk%i: %s\n",i,ConfigureParams.SCSI.target[i].szImageName);
     
@@ -214,7 +486,7 @@ void SCSI_Insert(Uint8 i) {
         ConfigureParams.SCSI.target[i].bDiskInserted) {
         if (ConfigureParams.SCSI.target[i].bWriteProtected ||
             ConfigureParams.SCSI.target[i].nDeviceType==DEVTYPE_CD) {
-            SCSIdisk[i].dsk = File_Open(ConfigureParams.SCSI.target[i].szImageName, "rb");
+            SCSIdisk[i].dsk = DiskImage_Open(ConfigureParams.SCSI.target[i].szImageName, false);
             if (SCSIdisk[i].dsk == NULL) {
                 Log_Printf(LOG_WARN, "SCSI Disk%i: Cannot open image file %s\n",
                            i, ConfigureParams.SCSI.target[i].szImageName);
@@ -227,10 +499,13 @@ void SCSI_Insert(Uint8 i) {
                 SCSIdisk[i].size = File_Length(ConfigureParams.SCSI.target[i].szImageName);
                 SCSIdisk[i].readonly = true;
             }
+        } else if (ConfigureParams.SCSI.nWriteProtection == WRITEPROT_ON ||
+                   Overlay_IsOverlay(ConfigureParams.SCSI.target[i].szImageName)) {
+            SCSI_OpenOverlay(i);
         } else {
-            SCSIdisk[i].dsk = File_Open(ConfigureParams.SCSI.target[i].szImageName, "rb+");
+            SCSIdisk[i].dsk = DiskImage_Open(ConfigureParams.SCSI.target[i].szImageName, true);
             if (SCSIdisk[i].dsk == NULL) {
-                SCSIdisk[i].dsk = File_Open(ConfigureParams.SCSI.target[i].szImageName, "rb");
+                SCSIdisk[i].dsk = DiskImage_Open(ConfigureParams.SCSI.target[i].szImageName, false);
                 if (SCSIdisk[i].dsk == NULL) {
                     Log_Printf(LOG_WARN, "SCSI Disk%i: Cannot open image file %s\n",
                                i, ConfigureParams.SCSI.target[i].szImageName);
@@ -322,8 +597,6 @@ void SCSIdisk_Receive_Command(Uint8 *cdb, Uint8 identify) {
     
     SCSIdisk[SCSIbus.target].lun = lun;
     
-    Log_Printf(LOG_SCSI_LEVEL, "SCSI command: Opcode = $%02x, target = %i, lun = %i\n", cdb[0], SCSIbus.target,lun);
-    
     SCSI_Emulate_Command(cdb);
 }
 
@@ -332,6 +605,9 @@ void SCSI_Emulate_Command(Uint8 *cdb) {
     Uint8 opcode = cdb[0];
     Uint8 target = SCSIbus.target;
     
+    EVTRACE_LOG(EV_SCSI_CMD, target, opcode, 0, 0,
+                LOG_SCSI_LEVEL, "SCSI command: Opcode = $%02x, target = %i, lun = %i\n", opcode, target, SCSIdisk[target].lun);
+    
     /* First check for lun-independent commands */
     switch (opcode) {
         case CMD_INQUIRY:
@@ -394,6 +670,10 @@ void SCSI_Emulate_Command(Uint8 *cdb) {
                     Log_Printf(LOG_SCSI_LEVEL, "SCSI command: Format drive\n");
                     SCSI_FormatDrive(cdb);
                     break;
+                case CMD_SYNC_CACHE1:
+                    Log_Printf(LOG_SCSI_LEVEL, "SCSI command: Synchronize cache\n");
+                    SCSI_SynchronizeCache(cdb);
+                    break;
                     /* as of yet unsupported commands */
                 case CMD_VERIFY_TRACK:
                 case CMD_FORMAT_TRACK:
@@ -648,7 +928,7 @@ void SCSI_TestUnitReady(Uint8 *cdb) {
     
     if (SCSIdisk[target].devtype!=DEVTYPE_NONE &&
         SCSIdisk[target].devtype!=DEVTYPE_HARDDISK &&
-        SCSIdisk[target].dsk==NULL) { /* Empty drive */
+        SCSIdisk[target].dsk==NULL && SCSIdisk[target].overlay==NULL) { /* Empty drive */
         SCSIdisk[target].status = STAT_CHECK_COND;
         SCSIdisk[target].sense.code = SC_NOT_READY;
         SCSIbus.phase = PHASE_ST;
@@ -722,21 +1002,12 @@ void scsi_write_sector(void) {
     offset = ((Uint64)SCSIdisk[target].lba)*BLOCKSIZE;
     
     if (offset < SCSIdisk[target].size) {
-        if (ConfigureParams.SCSI.nWriteProtection != WRITEPROT_ON) {
-            File_Write(scsi_buffer.data, BLOCKSIZE, offset, SCSIdisk[target].dsk);
+        if (SCSIdisk[target].overlay) {
+            Overlay_Write(SCSIdisk[target].overlay, scsi_buffer.data, SCSIdisk[target].lba);
         } else {
-            Log_Printf(LOG_SCSI_LEVEL, "[SCSI] WARNING: File write disabled!");
-            if(SCSIdisk[target].shadow) {
-                if(!(SCSIdisk[target].shadow[SCSIdisk[target].lba]))
-                    SCSIdisk[target].shadow[SCSIdisk[target].lba] = malloc(BLOCKSIZE);
-                memcpy(SCSIdisk[target].shadow[SCSIdisk[target].lba], scsi_buffer.data, BLOCKSIZE);
-            } else {
-                Uint32 blocks = SCSIdisk[target].size / BLOCKSIZE;
-                SCSIdisk[target].shadow = malloc(sizeof(Uint8*) * blocks);
-                for(int i = blocks; --i >= 0;)
-                    SCSIdisk[target].shadow[i] = NULL;
-            }
+            DiskImage_Write(SCSIdisk[target].dsk, scsi_buffer.data, BLOCKSIZE, offset);
         }
+        scsi_cache_write(target, scsi_buffer.data, SCSIdisk[target].lba);
         scsi_buffer.limit = BLOCKSIZE;
         scsi_buffer.size = 0;
 
@@ -762,6 +1033,7 @@ void SCSIdisk_Receive_Data(Uint8 val) {
      * and write the buffer contents to the disk. */
     scsi_buffer.data[scsi_buffer.size]=val;
     scsi_buffer.size++;
+    EVTRACE(EV_SCSI_RECV, val, scsi_buffer.size, scsi_buffer.limit, 0);
     if (scsi_buffer.size==scsi_buffer.limit) {
         if (scsi_buffer.disk==true) {
             scsi_write_sector();  /* sets status phase if done or error */
@@ -790,30 +1062,39 @@ void SCSI_ReadSector(Uint8 *cdb) {
 void scsi_read_sector(void) {
     Uint8 target = SCSIbus.target;
     Uint64 offset = 0;
+    Uint32 blocks;
     
     if (SCSIdisk[target].blockcounter==0) {
         SCSIbus.phase = PHASE_ST;
         return;
     }
     
-    Log_Printf(LOG_SCSI_LEVEL, "[SCSI] Reading block at offset %i (%i blocks remaining).",
-               SCSIdisk[target].lba,SCSIdisk[target].blockcounter-1);
-    
     offset = ((Uint64)SCSIdisk[target].lba)*BLOCKSIZE;
     
     if (offset < SCSIdisk[target].size) {
-        if (SCSIdisk[target].shadow && SCSIdisk[target].shadow[SCSIdisk[target].lba]) {
-            memcpy(scsi_buffer.data, SCSIdisk[target].shadow[SCSIdisk[target].lba], BLOCKSIZE);
-        } else {
-            File_Read(scsi_buffer.data, BLOCKSIZE, offset, SCSIdisk[target].dsk);
+        /* Read as many blocks as fit in the buffer and are on the disk */
+        blocks = SCSIdisk[target].blockcounter;
+        if (blocks > SCSI_BUFFER_BLOCKS) {
+            blocks = SCSI_BUFFER_BLOCKS;
         }
-        scsi_buffer.limit = scsi_buffer.size = BLOCKSIZE;
+        if (offset + blocks*BLOCKSIZE > SCSIdisk[target].size) {
+            blocks = (SCSIdisk[target].size - offset) / BLOCKSIZE;
+            if (blocks == 0) {
+                blocks = 1;
+            }
+        }
+        
+        Log_Printf(LOG_SCSI_LEVEL, "[SCSI] Reading %i block(s) at offset %i (%i blocks remaining).",
+                   blocks,SCSIdisk[target].lba,SCSIdisk[target].blockcounter-blocks);
+        
+        scsi_cache_read(target, scsi_buffer.data, SCSIdisk[target].lba, blocks);
+        scsi_buffer.limit = scsi_buffer.size = blocks*BLOCKSIZE;
 
         SCSIdisk[target].status = STAT_GOOD;
         SCSIdisk[target].sense.code = SC_NO_ERROR;
         SCSIdisk[target].sense.valid = false;
-        SCSIdisk[target].lba++;
-        SCSIdisk[target].blockcounter--;
+        SCSIdisk[target].lba += blocks;
+        SCSIdisk[target].blockcounter -= blocks;
     } else {
         SCSIdisk[target].status = STAT_CHECK_COND;
         SCSIdisk[target].sense.code = SC_INVALID_LBA;
@@ -827,6 +1108,7 @@ Uint8 SCSIdisk_Send_Data(void) {
     /* Send one byte. If the transfer is complete, set status phase */
     Uint8 val=scsi_buffer.data[scsi_buffer.limit-scsi_buffer.size];
     scsi_buffer.size--;
+    EVTRACE(EV_SCSI_SEND, val, scsi_buffer.size, 0, 0);
     if (scsi_buffer.size==0) {
         if (scsi_buffer.disk==true) {
             scsi_read_sector(); /* sets status phase if done or error */
@@ -837,6 +1119,26 @@ Uint8 SCSIdisk_Send_Data(void) {
     return val;
 }
 
+/* Send up to max bytes at once. Behaves like repeated calls to
+ * SCSIdisk_Send_Data, but stops at the end of the buffered blocks. */
+int SCSIdisk_Send_Data_Burst(Uint8 *dst, int max) {
+    int n = scsi_buffer.size;
+    if (n > max) {
+        n = max;
+    }
+    memcpy(dst, scsi_buffer.data+scsi_buffer.limit-scsi_buffer.size, n);
+    scsi_buffer.size -= n;
+    EVTRACE(EV_SCSI_BURST, n, scsi_buffer.size, 0, 0);
+    if (scsi_buffer.size==0) {
+        if (scsi_buffer.disk==true) {
+            scsi_read_sector(); /* sets status phase if done or error */
+        } else {
+            SCSIbus.phase = PHASE_ST;
+        }
+    }
+    return n;
+}
+
 
 void SCSI_Inquiry (Uint8 *cdb) {
     Uint8 target = SCSIbus.target;
@@ -904,12 +1206,24 @@ void SCSI_Inquiry (Uint8 *cdb) {
 }
 
 
+void SCSI_SynchronizeCache(Uint8 *cdb) {
+    Uint8 target = SCSIbus.target;
+    
+    scsi_flush(target);
+    
+    SCSIdisk[target].status = STAT_GOOD;
+    SCSIdisk[target].sense.code = SC_NO_ERROR;
+    SCSIdisk[target].sense.valid = false;
+    SCSIbus.phase = PHASE_ST;
+}
+
 void SCSI_StartStop(Uint8 *cdb) {
     Uint8 target = SCSIbus.target;
     
     switch (cdb[4]&0x03) {
         case 0:
             Log_Printf(LOG_SCSI_LEVEL, "[SCSI] Stop disk %i", target);
+            scsi_flush(target);
             break;
         case 1:
             Log_Printf(LOG_SCSI_LEVEL, "[SCSI] Start disk %i", target);
@@ -1136,3 +1450,26 @@ void SCSI_FormatDrive(Uint8 *cdb) {
         SCSIbus.phase = PHASE_ST;
     }
 }
+
+
+/* Save/restore SCSI bus and target state. Disk images and overlays are
+ * not part of the snapshot. */
+void SCSI_MemorySnapShot_Capture(bool bSave) {
+    int i;
+    
+    MemorySnapShot_Store(&SCSIbus, sizeof(SCSIbus));
+    MemorySnapShot_Store(&scsi_buffer, sizeof(scsi_buffer));
+    
+    for (i = 0; i < ESP_MAX_DEVS; i++) {
+        if (!bSave) {
+            scsi_cache_flush(i);
+        }
+        MemorySnapShot_Store(&SCSIdisk[i].lun, sizeof(SCSIdisk[i].lun));
+        MemorySnapShot_Store(&SCSIdisk[i].status, sizeof(SCSIdisk[i].status));
+        MemorySnapShot_Store(&SCSIdisk[i].message, sizeof(SCSIdisk[i].message));
+        MemorySnapShot_Store(&SCSIdisk[i].sense, sizeof(SCSIdisk[i].sense));
+        MemorySnapShot_Store(&SCSIdisk[i].lba, sizeof(SCSIdisk[i].lba));
+        MemorySnapShot_Store(&SCSIdisk[i].blockcounter, sizeof(SCSIdisk[i].blockcounter));
+        MemorySnapShot_Store(&SCSIdisk[i].lastlba, sizeof(SCSIdisk[i].lastlba));
+    }
+}
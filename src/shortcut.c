@@ -14,6 +14,7 @@ const char ShortCut_fileid[] = "Hatari shortcut.c : " __DATE__ " " __TIME__;
 #include "dialog.h"
 #include "file.h"
 #include "m68000.h"
+#include "memorySnapShot.h"
 #include "dimension.hpp"
 #include "reset.h"
 #include "screen.h"
@@ -208,6 +209,12 @@ void ShortCut_ActKey(void)
 	 case SHORTCUT_STATUSBAR:
 		ShortCut_StatusBar();
 		break;
+	 case SHORTCUT_SAVEMEM:
+		MemorySnapShot_Capture(ConfigureParams.Memory.szMemoryCaptureFileName, true);
+		break;
+	 case SHORTCUT_LOADMEM:
+		MemorySnapShot_Restore(ConfigureParams.Memory.szMemoryCaptureFileName, true);
+		break;
 	 case SHORTCUT_KEYS:
 	 case SHORTCUT_NONE:
 		/* ERROR: cannot happen, just make compiler happy */
@@ -289,6 +296,10 @@ int ShortCut_CheckKeys(int modkey, int symkey, bool press)
 {
 	SHORTCUTKEYIDX key;
 
+	/* Without window all keys go to the emulated machine */
+	if (bHeadless)
+		return 0;
+
 #if defined(__APPLE__)
     if ((modkey&(KMOD_RCTRL|KMOD_LCTRL)) && (modkey&(KMOD_RALT|KMOD_LALT)))
 #else
@@ -66,20 +66,26 @@ void CSocket::close(void) {
 }
 
 void CSocket::send(void) {
+	send(&m_Output, &m_RemoteAddr);
+}
+
+// Datagram replies may be sent by another thread than the receive thread,
+// see CRPCServer. They go to the address of their call.
+void CSocket::send(XDROutput* pOutStream, const struct sockaddr_in* pRemoteAddr) {
 	if (m_Socket == INVALID_SOCKET)
 		return;
 
     ssize_t nBytes = 0;
 	if (m_nType == SOCK_STREAM)
-		nBytes = ::send(m_Socket, (const char *)m_Output.data(), m_Output.size(), 0);
+		nBytes = ::send(m_Socket, (const char *)pOutStream->data(), pOutStream->size(), 0);
 	else if (m_nType == SOCK_DGRAM)
-		nBytes = sendto(m_Socket, (const char *)m_Output.data(), m_Output.size(), 0, (struct sockaddr *)&m_RemoteAddr, sizeof(struct sockaddr));
+		nBytes = sendto(m_Socket, (const char *)pOutStream->data(), pOutStream->size(), 0, (struct sockaddr *)pRemoteAddr, sizeof(struct sockaddr));
     
     if(nBytes < 0)
         perror("[NFSD] Socket send");
-    else if(nBytes != m_Output.size())
+    else if(nBytes != pOutStream->size())
         perror("[NFSD] Socket send, size mismatch");
-    m_Output.reset();  //clear output buffer
+    pOutStream->reset();  //clear output buffer
 }
 
 bool CSocket::active(void) {
@@ -94,6 +100,10 @@ int CSocket::getRemotePort(void) {
     return htons(m_RemoteAddr.sin_port);
 }
 
+const struct sockaddr_in* CSocket::getRemoteSockAddr(void) {
+    return &m_RemoteAddr;
+}
+
 XDRInput* CSocket::getInputStream(void) {
 	return &m_Input;
 }
@@ -129,6 +139,18 @@ void CSocket::run(void) {
         else if(nBytes == -1 && errno == EAGAIN)
             continue;
 		else if (nBytes > 0) {
+            if (m_nType == SOCK_STREAM) {
+                // large records (e.g. NFSv3 writes) arrive in several segments
+                while (nBytes >= 4) {
+                    size_t recordSize = (ntohl(*(uint32_t*)m_Input.data()) & ~0x80000000) + 4;
+                    if (recordSize > m_Input.getCapacity() || static_cast<size_t>(nBytes) >= recordSize)
+                        break;
+                    ssize_t nMore = recv(m_Socket, (char*)m_Input.data() + nBytes, recordSize - nBytes, 0);
+                    if (nMore <= 0)
+                        break;
+                    nBytes += nMore;
+                }
+            }
 			m_Input.resize(nBytes);  //bytes received
             if (m_nType == SOCK_STREAM) {
                 m_Input.read(&header);
@@ -24,9 +24,11 @@ public:
 	void           open(int socket, ISocketListener *pListener, struct sockaddr_in *pRemoteAddr = NULL);
 	void           close(void);
 	void           send(void);
+	void           send(XDROutput* pOutStream, const struct sockaddr_in* pRemoteAddr);
 	bool           active(void);
 	const char*    getRemoteAddress(void);
 	int            getRemotePort(void);
+	const struct sockaddr_in* getRemoteSockAddr(void);
 	XDRInput*      getInputStream(void);
 	XDROutput*     getOutputStream(void);
 	void           run(void);
@@ -5,21 +5,57 @@
 //  Created by Simon Schubiger on 04.03.19.
 //
 
+#include "config.h"
 #include "FileTableNFSD.h"
 #include "compat.h"
+#include <algorithm>
 #include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#ifdef _WIN32
+#include <io.h>
+#endif
+
+#ifndef _WIN32
+#if !HAVE_STRUCT_STAT_ST_MTIMESPEC
+#define st_mtimespec st_mtim
+#define st_ctimespec st_ctim
+#endif
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
 
 using namespace std;
 
 FileTableNFSD::FileTableNFSD(const HostPath& basePath, const VFSPath& basePathAlias)
 : VirtualFS(basePath, basePathAlias)
-, mutex(host_mutex_create()) {}
+, mutex(host_mutex_create())
+, fileMutex(host_mutex_create())
+, attrMutex(host_mutex_create())
+, attrHits(0)
+, attrMisses(0) {}
 
 FileTableNFSD::~FileTableNFSD(void) {
+    logAttrStats();
+    while(!(openFiles.empty()))
+        closeFile(openFiles.begin());
+    host_mutex_destroy(attrMutex);
+    host_mutex_destroy(fileMutex);
     host_mutex_destroy(mutex);
 }
 
+// Locking: mutex protects the handle table, fileMutex the cached host files
+// and directory listings and attrMutex the attribute cache. fileMutex may be
+// held while taking one of the others, never the other way round. File I/O
+// is done without any of them, see HostFile.
+
 bool FileTableNFSD::getCanonicalPath(uint64_t fhandle, std::string& result) {
+    {
+        NFSDLock lock(fileMutex);
+        closeIdleFiles(time(NULL));
+    }
     NFSDLock lock(mutex);
     map<uint64_t, string>::iterator iter(handle2path.find(fhandle));
     if(iter != handle2path.end()) {
@@ -30,34 +66,374 @@ bool FileTableNFSD::getCanonicalPath(uint64_t fhandle, std::string& result) {
 }
 
 int FileTableNFSD::stat(const VFSPath& absoluteVFSpath, struct stat& fstat) {
-    NFSDLock lock(mutex);
     return VirtualFS::stat(absoluteVFSpath, fstat);
 }
 
 void FileTableNFSD::move(uint64_t fileHandleFrom, const VFSPath& absoluteVFSpathTo) {
+    NFSDLock fileLock(fileMutex);
+    map<uint64_t, OpenFile>::iterator iter(openFiles.find(fileHandleFrom));
+    if(iter != openFiles.end()) closeFile(iter);
+    dirSnapshots.erase(fileHandleFrom);
+    
+    uint64_t fileHandleTo(VirtualFS::getFileHandle(absoluteVFSpathTo));
     NFSDLock lock(mutex);
     handle2path.erase(fileHandleFrom);
-    handle2path[VirtualFS::getFileHandle(absoluteVFSpathTo)] = absoluteVFSpathTo.canonicalize().string();
+    handle2path[fileHandleTo] = absoluteVFSpathTo.canonicalize().string();
 }
 
 void FileTableNFSD::remove(uint64_t fileHandle) {
+    NFSDLock fileLock(fileMutex);
+    map<uint64_t, OpenFile>::iterator iter(openFiles.find(fileHandle));
+    if(iter != openFiles.end()) closeFile(iter);
+    dirSnapshots.erase(fileHandle);
+    
     NFSDLock lock(mutex);
     handle2path.erase(fileHandle);
 }
 
 uint64_t FileTableNFSD::getFileHandle(const VFSPath& absoluteVFSpath) {
-    NFSDLock lock(mutex);
     uint64_t result(VirtualFS::getFileHandle(absoluteVFSpath));
+    NFSDLock lock(mutex);
     handle2path[result] = absoluteVFSpath.canonicalize().string();
     return result;
 }
 
-void FileTableNFSD::setFileAttrs(const VFSPath& absoluteVFSpath, const FileAttrs& fstat) {
-    NFSDLock lock(mutex);
-    VirtualFS::setFileAttrs(absoluteVFSpath, fstat);
+//----- cached file attributes
+//
+// File attributes are stored in an extended attribute of the host file or,
+// if there is none, derived from the host file and its parent directories.
+// The attributes are cached per host inode. A cached entry is valid as long
+// as modification and status change time of the host file are unchanged,
+// so it costs a single lstat to validate it. Setting the extended attribute
+// changes the status change time of the host file, therefore changes made
+// by other host processes invalidate the cache as well.
+
+bool FileTableNFSD::hostStat(const VFSPath& absoluteVFSpath, struct stat& fstat) {
+#ifdef _WIN32
+    return ::stat(toHostPath(absoluteVFSpath).c_str(), &fstat) == 0;
+#else
+    return ::lstat(toHostPath(absoluteVFSpath).c_str(), &fstat) == 0;
+#endif
+}
+
+static uint64_t attr_key(const struct stat& fstat) {
+    return (static_cast<uint64_t>(fstat.st_dev) << 32) ^ static_cast<uint64_t>(fstat.st_ino);
+}
+
+void FileTableNFSD::cacheAttrs(const struct stat& fstat, const FileAttrs& attrs) {
+    if(attrCache.size() >= NFSD_ATTR_CACHE)
+        attrCache.clear();
+    
+    CachedAttrs entry(attrs);
+#ifdef _WIN32
+    entry.mtime     = fstat.st_mtime;
+    entry.mtimeNsec = 0;
+    entry.ctime     = fstat.st_ctime;
+    entry.ctimeNsec = 0;
+#else
+    entry.mtime     = fstat.st_mtimespec.tv_sec;
+    entry.mtimeNsec = fstat.st_mtimespec.tv_nsec;
+    entry.ctime     = fstat.st_ctimespec.tv_sec;
+    entry.ctimeNsec = fstat.st_ctimespec.tv_nsec;
+#endif
+    map<uint64_t, CachedAttrs>::iterator iter(attrCache.find(attr_key(fstat)));
+    if(iter != attrCache.end())
+        iter->second = entry;
+    else
+        attrCache.insert(make_pair(attr_key(fstat), entry));
+}
+
+void FileTableNFSD::logAttrStats(void) {
+    uint32_t lookups = attrHits + attrMisses;
+    if(lookups)
+        printf("[NFSD] attribute cache: %u hits, %u misses (%u%% hit rate)\n",
+               attrHits, attrMisses, static_cast<uint32_t>((uint64_t)attrHits * 100 / lookups));
+}
+
+bool FileTableNFSD::setFileAttrs(const VFSPath& absoluteVFSpath, const FileAttrs& fstat) {
+    NFSDLock lock(attrMutex);
+    bool result = VirtualFS::setFileAttrs(absoluteVFSpath, fstat);
+    
+    struct stat hstat;
+    if(hostStat(absoluteVFSpath, hstat)) {
+        // files without stored attributes inherit uid/gid from their directory
+        if(S_ISDIR(hstat.st_mode))
+            attrCache.clear();
+        if(result)
+            cacheAttrs(hstat, FileAttrs(fstat.serialize())); // as getFileAttrs reads them back
+        else
+            attrCache.erase(attr_key(hstat));
+    }
+    return result;
 }
 
 FileAttrs FileTableNFSD::getFileAttrs(const VFSPath& absoluteVFSpath) {
+    NFSDLock lock(attrMutex);
+    
+    if(attrHits + attrMisses >= NFSD_ATTR_LOG) {
+        logAttrStats();
+        attrHits   = 0;
+        attrMisses = 0;
+    }
+    
+    struct stat hstat;
+    if(!(hostStat(absoluteVFSpath, hstat)))
+        return VirtualFS::getFileAttrs(absoluteVFSpath);
+    
+    map<uint64_t, CachedAttrs>::iterator iter(attrCache.find(attr_key(hstat)));
+    if(iter != attrCache.end()) {
+#ifdef _WIN32
+        if(iter->second.mtime == hstat.st_mtime && iter->second.ctime == hstat.st_ctime) {
+#else
+        if(iter->second.mtime     == hstat.st_mtimespec.tv_sec  &&
+           iter->second.mtimeNsec == hstat.st_mtimespec.tv_nsec &&
+           iter->second.ctime     == hstat.st_ctimespec.tv_sec  &&
+           iter->second.ctimeNsec == hstat.st_ctimespec.tv_nsec) {
+#endif
+            attrHits++;
+            return iter->second.attrs;
+        }
+    }
+    
+    attrMisses++;
+    FileAttrs result(VirtualFS::getFileAttrs(absoluteVFSpath));
+    cacheAttrs(hstat, result);
+    return result;
+}
+
+//----- cached host files
+//
+// READ and WRITE RPCs come in small chunks. Instead of opening and closing
+// the host file for every chunk, host file descriptors are kept open per
+// NFS file handle. The least recently used file is closed if the cache is
+// full and files are closed after NFSD_OPEN_FILE_IDLE seconds without use.
+// Cached files are closed when the file is removed, renamed or its
+// attributes are changed. I/O is done without fileMutex, so RPCs for
+// different files do not wait for each other. The host file descriptor is
+// shared with the I/O in progress and only closed after it is done.
+
+FileTableNFSD::HostFile::HostFile(int fd) : fd(fd) {
+#ifdef _WIN32
+    mutex = host_mutex_create();
+#endif
+}
+
+FileTableNFSD::HostFile::~HostFile(void) {
+    ::close(fd);
+#ifdef _WIN32
+    host_mutex_destroy(mutex);
+#endif
+}
+
+ssize_t FileTableNFSD::HostFile::read(size_t fileOffset, void* dst, size_t count) {
+#ifdef _WIN32
     NFSDLock lock(mutex);
-    return VirtualFS::getFileAttrs(absoluteVFSpath);
+    if(::lseek(fd, fileOffset, SEEK_SET) < 0)
+        return -1;
+    return ::read(fd, dst, count);
+#else
+    return ::pread(fd, dst, count, fileOffset);
+#endif
+}
+
+ssize_t FileTableNFSD::HostFile::write(size_t fileOffset, const void* src, size_t count) {
+#ifdef _WIN32
+    NFSDLock lock(mutex);
+    if(::lseek(fd, fileOffset, SEEK_SET) < 0)
+        return -1;
+    return ::write(fd, src, count);
+#else
+    return ::pwrite(fd, src, count, fileOffset);
+#endif
+}
+
+int FileTableNFSD::HostFile::sync(void) {
+#ifdef _WIN32
+    return ::_commit(fd) ? errno : 0;
+#else
+    return ::fsync(fd) ? errno : 0;
+#endif
+}
+
+void FileTableNFSD::closeFile(map<uint64_t, OpenFile>::iterator iter) {
+    openFiles.erase(iter);
+}
+
+void FileTableNFSD::closeIdleFiles(time_t now) {
+    for(map<uint64_t, OpenFile>::iterator iter = openFiles.begin(); iter != openFiles.end();) {
+        map<uint64_t, OpenFile>::iterator next(iter); ++next;
+        if(now - iter->second.lastUse >= NFSD_OPEN_FILE_IDLE)
+            closeFile(iter);
+        iter = next;
+    }
+}
+
+FileTableNFSD::OpenFile* FileTableNFSD::openFile(uint64_t fileHandle, const VFSPath& absoluteVFSpath, bool writable) {
+    time_t now = time(NULL);
+    
+    map<uint64_t, OpenFile>::iterator iter(openFiles.find(fileHandle));
+    if(iter != openFiles.end()) {
+        if(iter->second.writable || !(writable)) {
+            iter->second.lastUse = now;
+            return &iter->second;
+        }
+        closeFile(iter); // reopen for writing
+    }
+    
+    int fd = ::open(toHostPath(absoluteVFSpath).c_str(), (writable ? O_RDWR : O_RDONLY) | O_BINARY);
+    if(fd < 0)
+        return NULL;
+    
+    if(openFiles.size() >= NFSD_OPEN_FILES) {
+        map<uint64_t, OpenFile>::iterator lru(openFiles.begin());
+        for(iter = openFiles.begin(); iter != openFiles.end(); ++iter)
+            if(iter->second.lastUse < lru->second.lastUse)
+                lru = iter;
+        closeFile(lru);
+    }
+    
+    OpenFile& file = openFiles[fileHandle];
+    file.file     = std::make_shared<HostFile>(fd);
+    file.writable = writable;
+    file.lastUse  = now;
+    return &file;
+}
+
+ssize_t FileTableNFSD::read(uint64_t fileHandle, const VFSPath& absoluteVFSpath, size_t fileOffset, void* dst, size_t count) {
+    shared_ptr<HostFile> hostFile;
+    {
+        NFSDLock lock(fileMutex);
+        OpenFile* file = openFile(fileHandle, absoluteVFSpath, false);
+        if(!(file)) {
+            // no permission on host, VFSFile temporarily changes the mode
+            VFSFile vfsFile(*this, absoluteVFSpath, "rb");
+            return vfsFile.isOpen() ? vfsFile.read(fileOffset, dst, count) : -1;
+        }
+        hostFile = file->file;
+    }
+    return hostFile->read(fileOffset, dst, count);
+}
+
+ssize_t FileTableNFSD::write(uint64_t fileHandle, const VFSPath& absoluteVFSpath, size_t fileOffset, void* src, size_t count) {
+    shared_ptr<HostFile> hostFile;
+    {
+        NFSDLock lock(fileMutex);
+        map<uint64_t, OpenFile>::iterator iter(openFiles.find(fileHandle));
+        if(iter == openFiles.end() || !(iter->second.writable)) {
+            // only plain files can be written
+            FileAttrs attrs = VirtualFS::getFileAttrs(absoluteVFSpath);
+            if((attrs.mode & S_IFMT) != S_IFREG) {
+                errno = EISDIR;
+                return -1;
+            }
+        }
+        OpenFile* file = openFile(fileHandle, absoluteVFSpath, true);
+        if(!(file)) {
+            // no permission on host, VFSFile temporarily changes the mode
+            VFSFile vfsFile(*this, absoluteVFSpath, "r+b");
+            return vfsFile.isOpen() ? vfsFile.write(fileOffset, src, count) : -1;
+        }
+        hostFile = file->file;
+    }
+    return hostFile->write(fileOffset, src, count);
+}
+
+int FileTableNFSD::sync(uint64_t fileHandle, const VFSPath& absoluteVFSpath) {
+    shared_ptr<HostFile> hostFile;
+    {
+        NFSDLock lock(fileMutex);
+        OpenFile* file = openFile(fileHandle, absoluteVFSpath, false);
+        if(!(file))
+            return errno;
+        hostFile = file->file;
+    }
+    return hostFile->sync();
+}
+
+void FileTableNFSD::invalidate(uint64_t fileHandle) {
+    NFSDLock lock(fileMutex);
+    map<uint64_t, OpenFile>::iterator iter(openFiles.find(fileHandle));
+    if(iter != openFiles.end()) closeFile(iter);
+    dirSnapshots.erase(fileHandle);
+}
+
+//----- cached directory listings
+//
+// READDIR RPCs continue a listing at a cookie. Instead of reading the host
+// directory up to the cookie for every RPC, the sorted directory entries
+// are kept per directory handle and the cookie is the index into the
+// entries. A listing is read again if it starts at cookie 0, if the
+// modification time of the directory changed or after the directory has
+// been changed through the server (see invalidate).
+
+int FileTableNFSD::scanDir(const VFSPath& absoluteVFSpath, DirSnapshot& snapshot) {
+    DIR* dir = vfsOpendir(absoluteVFSpath);
+    if(!(dir))
+        return errno;
+    
+    snapshot.entries.clear();
+    for(struct dirent* fileinfo = ::readdir(dir); fileinfo; fileinfo = ::readdir(dir)) {
+#if HAVE_STRUCT_DIRENT_D_NAMELEN
+        size_t namelen = fileinfo->d_namlen;
+#else
+        size_t namelen = strlen(fileinfo->d_name);
+#endif
+        NFSDDirEntry entry;
+        entry.name = string(fileinfo->d_name, namelen);
+#ifdef _WIN32
+        entry.fileId = fileId(getFileHandle(VFSPath(absoluteVFSpath) / VFSPath(entry.name)));
+#else
+        entry.fileId = fileId(fileinfo->d_ino);
+#endif
+        snapshot.entries.push_back(entry);
+    }
+    closedir(dir);
+    
+    sort(snapshot.entries.begin(), snapshot.entries.end());
+    return 0;
+}
+
+int FileTableNFSD::readDir(uint64_t fileHandle, const VFSPath& absoluteVFSpath, uint32_t cookie, size_t maxCount,
+                           vector<NFSDDirEntry>& result, bool& eof) {
+    NFSDLock lock(fileMutex);
+    
+    struct stat fstat;
+    if(vfsStat(absoluteVFSpath, fstat))
+        return errno;
+#ifdef _WIN32
+    time_t mtime     = fstat.st_mtime;
+    long   mtimeNsec = 0;
+#else
+    time_t mtime     = fstat.st_mtimespec.tv_sec;
+    long   mtimeNsec = fstat.st_mtimespec.tv_nsec;
+#endif
+    
+    map<uint64_t, DirSnapshot>::iterator iter(dirSnapshots.find(fileHandle));
+    if(iter == dirSnapshots.end() || cookie == 0 ||
+       iter->second.mtime != mtime || iter->second.mtimeNsec != mtimeNsec) {
+        if(iter == dirSnapshots.end() && dirSnapshots.size() >= NFSD_DIR_SNAPSHOTS) {
+            map<uint64_t, DirSnapshot>::iterator lru(dirSnapshots.begin());
+            for(iter = dirSnapshots.begin(); iter != dirSnapshots.end(); ++iter)
+                if(iter->second.lastUse < lru->second.lastUse)
+                    lru = iter;
+            dirSnapshots.erase(lru);
+        }
+        DirSnapshot& snapshot = dirSnapshots[fileHandle];
+        if(int err = scanDir(absoluteVFSpath, snapshot)) {
+            dirSnapshots.erase(fileHandle);
+            return err;
+        }
+        snapshot.mtime     = mtime;
+        snapshot.mtimeNsec = mtimeNsec;
+        iter = dirSnapshots.find(fileHandle);
+    }
+    
+    DirSnapshot& snapshot = iter->second;
+    snapshot.lastUse = time(NULL);
+    
+    result.clear();
+    for(size_t i = cookie; i < snapshot.entries.size() && result.size() < maxCount; i++)
+        result.push_back(snapshot.entries[i]);
+    eof = cookie + result.size() >= snapshot.entries.size();
+    return 0;
 }
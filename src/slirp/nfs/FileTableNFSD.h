@@ -11,10 +11,73 @@
 #include "../../ditool/VirtualFS.h"
 #include "XDRStream.h"
 #include "host.h"
+#include <memory>
+
+#define NFSD_OPEN_FILES     16 // max number of cached host files
+#define NFSD_OPEN_FILE_IDLE 5  // seconds until an unused host file is closed
+#define NFSD_DIR_SNAPSHOTS  8  // max number of cached directory listings
+#define NFSD_ATTR_CACHE     1024 // max number of cached file attributes
+#define NFSD_ATTR_LOG       0x10000 // attribute cache lookups between statistics
+
+struct NFSDDirEntry {
+    std::string name;
+    uint32_t    fileId;
+    
+    bool operator < (const NFSDDirEntry& entry) const {return name < entry.name;}
+};
 
 class FileTableNFSD : public VirtualFS {
+    // host file descriptor, closed when the last user is done with it
+    class HostFile {
+        int      fd;
+#ifdef _WIN32
+        mutex_t* mutex; // lseek and read/write are not atomic
+#endif
+    public:
+        HostFile(int fd);
+        ~HostFile(void);
+        ssize_t read (size_t fileOffset, void* dst, size_t count);
+        ssize_t write(size_t fileOffset, const void* src, size_t count);
+        int     sync (void);
+    };
+    struct OpenFile {
+        std::shared_ptr<HostFile> file;
+        bool                      writable;
+        time_t                    lastUse;
+    };
+    struct DirSnapshot {
+        std::vector<NFSDDirEntry> entries;
+        time_t                    mtime;
+        long                      mtimeNsec;
+        time_t                    lastUse;
+    };
+    struct CachedAttrs {
+        FileAttrs attrs;
+        time_t    mtime;
+        long      mtimeNsec;
+        time_t    ctime;
+        long      ctimeNsec;
+        
+        CachedAttrs(const FileAttrs& attrs) : attrs(attrs) {}
+    };
+    
     mutex_t*                        mutex;
+    mutex_t*                        fileMutex;
+    mutex_t*                        attrMutex;
     std::map<uint64_t, std::string> handle2path;
+    std::map<uint64_t, OpenFile>    openFiles;
+    std::map<uint64_t, DirSnapshot> dirSnapshots;
+    std::map<uint64_t, CachedAttrs> attrCache;
+    uint32_t                        attrHits;
+    uint32_t                        attrMisses;
+    
+    OpenFile*           openFile        (uint64_t fileHandle, const VFSPath& absoluteVFSpath, bool writable);
+    void                closeFile       (std::map<uint64_t, OpenFile>::iterator iter);
+    void                closeIdleFiles  (time_t now);
+    int                 scanDir         (const VFSPath& absoluteVFSpath, DirSnapshot& snapshot);
+    bool                hostStat        (const VFSPath& absoluteVFSpath, struct stat& fstat);
+    void                cacheAttrs      (const struct stat& fstat, const FileAttrs& attrs);
+    void                logAttrStats    (void);
 public:
     FileTableNFSD(const HostPath& basePath, const VFSPath& basePathAlias);
     virtual ~FileTableNFSD(void);
@@ -23,10 +86,16 @@ public:
     virtual void        move            (uint64_t fileHandleFrom, const VFSPath& absoluteVFSpathTo);
     virtual void        remove          (uint64_t fileHandle);
     virtual uint64_t    getFileHandle   (const VFSPath& absoluteVFSpath);
-    virtual void        setFileAttrs    (const VFSPath& absoluteVFSpath, const FileAttrs& fstat);
+    virtual bool        setFileAttrs    (const VFSPath& absoluteVFSpath, const FileAttrs& fstat);
     virtual FileAttrs   getFileAttrs    (const VFSPath& absoluteVFSpath);
     
     bool                getCanonicalPath(uint64_t handle, std::string& result);
+    ssize_t             read            (uint64_t fileHandle, const VFSPath& absoluteVFSpath, size_t fileOffset, void* dst, size_t count);
+    ssize_t             write           (uint64_t fileHandle, const VFSPath& absoluteVFSpath, size_t fileOffset, void* src, size_t count);
+    int                 sync            (uint64_t fileHandle, const VFSPath& absoluteVFSpath);
+    void                invalidate      (uint64_t fileHandle);
+    int                 readDir         (uint64_t fileHandle, const VFSPath& absoluteVFSpath, uint32_t cookie, size_t maxCount,
+                                         std::vector<NFSDDirEntry>& result, bool& eof);
 };
 
 #endif /* FileTableNFSD_hpp */
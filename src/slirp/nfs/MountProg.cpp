@@ -46,7 +46,8 @@ int CMountProg::procedureMNT(void) {
         } else {
             m_out->write(FHSIZE_NFS3);
             m_out->write(data, FHSIZE_NFS3);
-            m_out->write(0);  //flavor
+            m_out->write(1);  //flavor count
+            m_out->write(1);  //AUTH_UNIX
         }
         
         m_mounts[m_param->remoteAddr].push_back(path);
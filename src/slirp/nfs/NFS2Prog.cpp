@@ -92,7 +92,7 @@ int CNFS2Prog::procedureGETATTR(void) {
     return PRC_OK;
 }
 
-static void set_attrs(const string& path, const FileAttrs& fstat) {
+void set_attrs(const string& path, const FileAttrs& fstat) {
     FileAttrs newAttrs = nfsd_fts[0]->getFileAttrs(path);
 
     if(FileAttrs::valid16(fstat.mode)) {
@@ -159,14 +159,16 @@ static struct stat read_stat(XDRInput* xin) {
 
 int CNFS2Prog::procedureSETATTR(void) {
     string   path;
+    uint64_t fhandle;
     
-	getPath(path);
+	getPath(path, &fhandle);
     
     log("SETATTR %s", path.c_str());
     
 	if (!(checkFile(path)))
 		return PRC_OK;
 
+    nfsd_fts[0]->invalidate(fhandle);
     set_attrs(path, FileAttrs(read_stat(m_in)));
     
     m_out->write(NFS_OK);
@@ -203,6 +205,7 @@ int nfs_err(int error) {
         case 0:      return NFS_OK;
         case ENOENT: return NFSERR_NOENT;
         case EACCES: return NFSERR_ACCES;
+        case EISDIR: return NFSERR_ISDIR;
         case EINVAL: return NFSERR_IO;
         default:
             return NFSERR_IO;
@@ -234,8 +237,9 @@ int CNFS2Prog::procedureREAD(void) {
     uint32_t nOffset;
     uint32_t nCount;
     uint32_t nTotalCount;
+    uint64_t fhandle;
 
-	getPath(path);
+	getPath(path, &fhandle);
     log("READ %s", path.c_str());
 	if (!(checkFile(path)))
 		return PRC_OK;
@@ -245,10 +249,9 @@ int CNFS2Prog::procedureREAD(void) {
 	m_in->read(&nTotalCount);
     
     XDROpaque buffer(nCount);
-    VFSFile file(*nfsd_fts[0], path, "rb");
-    if(file.isOpen()) {
-        nCount = file.read(nOffset, buffer.m_data, buffer.m_size);
-        buffer.resize(nCount);
+    ssize_t   nRead = nfsd_fts[0]->read(fhandle, path, nOffset, buffer.m_data, buffer.m_size);
+    if(nRead >= 0) {
+        buffer.resize(nRead);
         m_out->write(NFS_OK);
     } else {
         buffer.resize(0);
@@ -270,8 +273,9 @@ int CNFS2Prog::procedureWRITE(void) {
     uint32_t nBeginOffset;
     uint32_t nOffset;
     uint32_t nTotalCount;
+    uint64_t fhandle;
 
-	getPath(path);
+	getPath(path, &fhandle);
     log("WRITE %s", path.c_str());
 	if (!(checkFile(path)))
 		return PRC_OK;
@@ -283,17 +287,10 @@ int CNFS2Prog::procedureWRITE(void) {
     XDROpaque buffer;
 	m_in->read(buffer);
 
-    FileAttrs attrs = nfsd_fts[0]->getFileAttrs(path);
-    if((attrs.mode & S_IFMT) == S_IFREG) {
-        VFSFile file(*nfsd_fts[0], path, "r+b");
-        if(file.isOpen()) {
-            file.write(nOffset, buffer.m_data, buffer.m_size);
-            m_out->write(NFS_OK);
-        } else {
-            m_out->write(nfs_err(errno));
-        }
+    if(nfsd_fts[0]->write(fhandle, path, nOffset, buffer.m_data, buffer.m_size) >= 0) {
+        m_out->write(NFS_OK);
     } else {
-        m_out->write(NFSERR_ISDIR);
+        m_out->write(nfs_err(errno));
     }
 
 	writeFileAttributes(path);
@@ -302,11 +299,13 @@ int CNFS2Prog::procedureWRITE(void) {
 }
 
 int CNFS2Prog::procedureCREATE(void) {
-    string path;
+    string   path;
+    uint64_t dirHandle;
     
-	if(!(getFullPath(path)))
+	if(!(getFullPath(path, &dirHandle)))
 		return PRC_OK;
     log("CREATE %s", path.c_str());
+    nfsd_fts[0]->invalidate(dirHandle);
     
     FileAttrs fstat(read_stat(m_in));
     
@@ -337,9 +336,10 @@ int CNFS2Prog::procedureCREATE(void) {
 }
 
 int CNFS2Prog::procedureREMOVE(void) {
-    string path;
+    string   path;
+    uint64_t dirHandle;
 
-	getFullPath(path);
+	getFullPath(path, &dirHandle);
     log("REMOVE %s", path.c_str());
 	if (!(checkFile(path)))
 		return PRC_OK;
@@ -348,24 +348,29 @@ int CNFS2Prog::procedureREMOVE(void) {
     int err = nfs_err(nfsd_fts[0]->vfsRemove(path));
     m_out->write(err);
     if(!(err)) nfsd_fts[0]->remove(fileHandle);
+    nfsd_fts[0]->invalidate(dirHandle);
 
     return PRC_OK;
 }
 
 int CNFS2Prog::procedureRENAME(void) {
-    string pathFrom;
-    string pathTo;
+    string   pathFrom;
+    string   pathTo;
+    uint64_t dirHandleFrom;
+    uint64_t dirHandleTo;
 
-	getFullPath(pathFrom);
+	getFullPath(pathFrom, &dirHandleFrom);
 	if (!(checkFile(pathFrom)))
 		return PRC_OK;
-	getFullPath(pathTo);
+	getFullPath(pathTo, &dirHandleTo);
     log("RENAME %s->%s", pathFrom.c_str(), pathTo.c_str());
 
     uint64_t fileHandleFrom(nfsd_fts[0]->getFileHandle(pathFrom));
     int err = nfs_err(nfsd_fts[0]->vfsRename(pathFrom, pathTo));
     m_out->write(err);
     if(!(err)) nfsd_fts[0]->move(fileHandleFrom, pathTo);
+    nfsd_fts[0]->invalidate(dirHandleFrom);
+    nfsd_fts[0]->invalidate(dirHandleTo);
     
     return PRC_OK;
 }
@@ -373,20 +378,23 @@ int CNFS2Prog::procedureRENAME(void) {
 int CNFS2Prog::procedureLINK(void) {
     string   to;
     string   from;
+    uint64_t dirHandle;
 
     getPath(from);
-    getFullPath(to);
+    getFullPath(to, &dirHandle);
     log("LINK %s->%s", from.c_str(), to.c_str());
     
     m_out->write(nfs_err(nfsd_fts[0]->vfsLink(from, to, false)));
+    nfsd_fts[0]->invalidate(dirHandle);
     
     return PRC_OK;
 }
 
 int CNFS2Prog::procedureSYMLINK(void) {
-    string to;
+    string   to;
+    uint64_t dirHandle;
     
-    getFullPath(to);
+    getFullPath(to, &dirHandle);
     XDRString from;
     m_in->read(from);
     log("SYMLINK %s->%s", from.c_str(), to.c_str());
@@ -395,16 +403,19 @@ int CNFS2Prog::procedureSYMLINK(void) {
     int err = nfsd_fts[0]->vfsLink(from.c_str(), to, true);
     if(!(err)) set_attrs(to, fstat);
     m_out->write(nfs_err(err));
+    nfsd_fts[0]->invalidate(dirHandle);
     
     return PRC_OK;
 }
 
 int CNFS2Prog::procedureMKDIR(void) {
-    string path;
+    string   path;
+    uint64_t dirHandle;
 
 	log("MKDIR");
-	if(!(getFullPath(path)))
+	if(!(getFullPath(path, &dirHandle)))
 		return PRC_OK;
+    nfsd_fts[0]->invalidate(dirHandle);
 
     FileAttrs fstat(read_stat(m_in));
     if(int err = nfsd_fts[0]->vfsMkdir(path, DEFAULT_PERM)) {
@@ -420,10 +431,11 @@ int CNFS2Prog::procedureMKDIR(void) {
 }
 
 int CNFS2Prog::procedureRMDIR(void) {
-    string path;
+    string   path;
+    uint64_t dirHandle;
 
 	log("RMDIR");
-	getFullPath(path);
+	getFullPath(path, &dirHandle);
 	if (!(checkFile(path)))
 		return PRC_OK;
     
@@ -431,13 +443,13 @@ int CNFS2Prog::procedureRMDIR(void) {
     int err = nfs_err(nfsd_fts[0]->vfsNftw(path, VirtualFS::remove, 3, FTW_DEPTH | FTW_PHYS));
     m_out->write(err);
     if(!(err)) nfsd_fts[0]->remove(fileHandle);
+    nfsd_fts[0]->invalidate(dirHandle);
     
     return PRC_OK;
 }
 
 int CNFS2Prog::procedureREADDIR(void) {
     string   path;
-    DIR*     handle;
     uint32_t cookie;
     uint32_t count;
     uint64_t fhandle;
@@ -450,46 +462,30 @@ int CNFS2Prog::procedureREADDIR(void) {
     
     log("READDIR %s", path.c_str());
     
-    uint32_t eof = 1;
-    handle          = nfsd_fts[0]->vfsOpendir(path);
-	if (handle) {
-        m_out->write(NFS_OK);
-        int skip = cookie;
-        for(struct dirent* fileinfo = readdir(handle); fileinfo; fileinfo = readdir(handle)) {
-#if HAVE_STRUCT_DIRENT_D_NAMELEN
-            size_t namelen = fileinfo->d_namlen;
-#else
-            size_t namelen = strlen(fileinfo->d_name);
-#endif
-            if(--skip >= 0) continue;
-            
-#ifndef _WIN32
-            m_out->write(1);  //value follows
-            m_out->write(nfsd_fts[0]->fileId(fileinfo->d_ino));
-#endif
-            string dname(fileinfo->d_name, namelen);
-            XDRString name(dname);
-            log("%d %s %s", cookie, path.c_str(), name.c_str());
-#ifdef _WIN32
-            const VFSPath pth = VFSPath(path) / VFSPath(dname);
-            const uint64_t fileno = nfsd_fts[0]->getFileHandle(pth);
-            m_out->write(1);  //value follows
-            m_out->write(nfsd_fts[0]->fileId(fileno));
-#endif
-            m_out->write(name);
-            m_out->write(cookie+1);
-            cookie++;
-            if(m_out->size() >= count - 128) { // 128: give some space for XDR data
-                eof = 0;
-                break;
-            }
-		};
-		closedir(handle);
-        m_out->write(0);  //no value follows
-        m_out->write(eof);
-    } else {
-        m_out->write(nfs_err(errno));
+    // an entry takes at least 20 bytes (value follows, fileid, name, cookie)
+    vector<NFSDDirEntry> entries;
+    bool                 eof;
+    if(int err = nfsd_fts[0]->readDir(fhandle, path, cookie, count / 20 + 1, entries, eof)) {
+        m_out->write(nfs_err(err));
+        return PRC_OK;
+    }
+    
+    m_out->write(NFS_OK);
+    for(size_t i = 0; i < entries.size(); i++) {
+        XDRString name(entries[i].name);
+        log("%d %s %s", cookie, path.c_str(), name.c_str());
+        m_out->write(1);  //value follows
+        m_out->write(entries[i].fileId);
+        m_out->write(name);
+        m_out->write(cookie+1);
+        cookie++;
+        if(m_out->size() >= count - 128) { // 128: give some space for XDR data
+            eof = i + 1 == entries.size() && eof;
+            break;
+        }
     }
+    m_out->write(0);  //no value follows
+    m_out->write(eof ? 1 : 0);
 
     return PRC_OK;
 }
@@ -535,8 +531,8 @@ bool CNFS2Prog::getPath(string& result, uint64_t* handle) {
     return nfsd_fts[0]->getCanonicalPath(data[0], result);
 }
 
-bool CNFS2Prog::getFullPath(string& result) {
-    if(!(getPath(result)))
+bool CNFS2Prog::getFullPath(string& result, uint64_t* dirHandle) {
+    if(!(getPath(result, dirHandle)))
         return false;
     
     XDRString path;
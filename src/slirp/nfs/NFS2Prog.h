@@ -32,7 +32,7 @@ protected:
 
 private:
     bool getPath(std::string& result, uint64_t* handle = NULL);
-    bool getFullPath(std::string& result);
+    bool getFullPath(std::string& result, uint64_t* dirHandle = NULL);
 	bool checkFile(const std::string& path);
     bool writeFileAttributes(const std::string& path);    
 };
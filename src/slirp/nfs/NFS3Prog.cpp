@@ -0,0 +1,970 @@
+#include <string.h>
+#include <stdio.h>
+#include <dirent.h>
+#include <ftw.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <sys/statvfs.h>
+#endif
+#include <sys/time.h>
+
+#include "config.h"
+#include "NFS3Prog.h"
+#include "FileTableNFSD.h"
+#include "CSocket.h"
+#include "nfsd.h"
+
+#ifndef _WIN32
+
+#if !HAVE_STRUCT_STAT_ST_ATIMESPEC
+#define st_atimespec st_atim
+#endif
+
+#if !HAVE_STRUCT_STAT_ST_MTIMESPEC
+#define st_mtimespec st_mtim
+#define st_ctimespec st_ctim
+#endif
+
+#endif
+
+using namespace std;
+
+enum {
+	NFS3_OK = 0,
+	NFS3ERR_PERM = 1,
+	NFS3ERR_NOENT = 2,
+	NFS3ERR_IO = 5,
+	NFS3ERR_NXIO = 6,
+	NFS3ERR_ACCES = 13,
+	NFS3ERR_EXIST = 17,
+	NFS3ERR_XDEV = 18,
+	NFS3ERR_NODEV = 19,
+	NFS3ERR_NOTDIR = 20,
+	NFS3ERR_ISDIR = 21,
+	NFS3ERR_INVAL = 22,
+	NFS3ERR_FBIG = 27,
+	NFS3ERR_NOSPC = 28,
+	NFS3ERR_ROFS = 30,
+	NFS3ERR_MLINK = 31,
+	NFS3ERR_NAMETOOLONG = 63,
+	NFS3ERR_NOTEMPTY = 66,
+	NFS3ERR_DQUOT = 69,
+	NFS3ERR_STALE = 70,
+	NFS3ERR_BADHANDLE = 10001,
+	NFS3ERR_NOT_SYNC = 10002,
+	NFS3ERR_NOTSUPP = 10004,
+	NFS3ERR_TOOSMALL = 10005,
+	NFS3ERR_SERVERFAULT = 10006,
+	NFS3ERR_BADTYPE = 10007,
+};
+
+enum NF3TYPE { NF3NON, NF3REG, NF3DIR, NF3BLK, NF3CHR, NF3LNK, NF3SOCK, NF3FIFO };
+
+enum { UNSTABLE, DATA_SYNC, FILE_SYNC };
+
+enum { UNCHECKED, GUARDED, EXCLUSIVE };
+
+enum { DONT_CHANGE, SET_TO_SERVER_TIME, SET_TO_CLIENT_TIME };
+
+enum {
+    ACCESS3_READ    = 0x0001,
+    ACCESS3_LOOKUP  = 0x0002,
+    ACCESS3_MODIFY  = 0x0004,
+    ACCESS3_EXTEND  = 0x0008,
+    ACCESS3_DELETE  = 0x0010,
+    ACCESS3_EXECUTE = 0x0020,
+};
+
+enum {
+    FSF3_LINK        = 0x0001,
+    FSF3_SYMLINK     = 0x0002,
+    FSF3_HOMOGENEOUS = 0x0008,
+    FSF3_CANSETTIME  = 0x0010,
+};
+
+static const int      BLOCK_SIZE       = 4096;
+static const uint32_t MAXDATA_UDP      = 8192;      // keep UDP replies in a reasonable number of IP fragments
+static const uint32_t MAXDATA_TCP      = 64 * 1024; // TCP records are reassembled by CSocket
+static const uint32_t ENTRY_SIZE       = 24;        // value follows, fileid, name length and cookie of a directory entry
+static const uint32_t ENTRYPLUS_SIZE   = 4 + 84 + 4 + 4 + FHSIZE_NFS3; // attributes and handle of a READDIRPLUS entry
+
+// a client detects a server restart (and resends uncommitted data) by a changed write verifier
+static const uint64_t WRITE_VERIFIER = static_cast<uint64_t>(time(NULL));
+
+extern void set_attrs(const string& path, const FileAttrs& fstat);
+
+CNFS3Prog::CNFS3Prog() : CRPCProg(PROG_NFS, 3, "nfsd") {
+    #define RPC_PROG_CLASS CNFS3Prog
+    SET_PROC(1,  GETATTR);
+    SET_PROC(2,  SETATTR);
+    SET_PROC(3,  LOOKUP);
+    SET_PROC(4,  ACCESS);
+    SET_PROC(5,  READLINK);
+    SET_PROC(6,  READ);
+    SET_PROC(7,  WRITE);
+    SET_PROC(8,  CREATE);
+    SET_PROC(9,  MKDIR);
+    SET_PROC(10, SYMLINK);
+    SET_PROC(11, MKNOD);
+    SET_PROC(12, REMOVE);
+    SET_PROC(13, RMDIR);
+    SET_PROC(14, RENAME);
+    SET_PROC(15, LINK);
+    SET_PROC(16, READDIR);
+    SET_PROC(17, READDIRPLUS);
+    SET_PROC(18, FSSTAT);
+    SET_PROC(19, FSINFO);
+    SET_PROC(20, PATHCONF);
+    SET_PROC(21, COMMIT);
+}
+
+CNFS3Prog::~CNFS3Prog() { }
+
+static void write_uint64(XDROutput* xout, uint64_t value) {
+    xout->write(static_cast<uint32_t>(value >> 32));
+    xout->write(static_cast<uint32_t>(value));
+}
+
+static uint64_t read_uint64(XDRInput* xin) {
+    uint32_t hi = 0;
+    uint32_t lo = 0;
+    xin->read(&hi);
+    xin->read(&lo);
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+}
+
+static int nfs3_err(int error) {
+    switch (error) {
+        case 0:            return NFS3_OK;
+        case EPERM:        return NFS3ERR_PERM;
+        case ENOENT:       return NFS3ERR_NOENT;
+        case ENXIO:        return NFS3ERR_NXIO;
+        case EACCES:       return NFS3ERR_ACCES;
+        case EEXIST:       return NFS3ERR_EXIST;
+        case EXDEV:        return NFS3ERR_XDEV;
+        case ENODEV:       return NFS3ERR_NODEV;
+        case ENOTDIR:      return NFS3ERR_NOTDIR;
+        case EISDIR:       return NFS3ERR_ISDIR;
+        case EINVAL:       return NFS3ERR_INVAL;
+        case EFBIG:        return NFS3ERR_FBIG;
+        case ENOSPC:       return NFS3ERR_NOSPC;
+        case EROFS:        return NFS3ERR_ROFS;
+        case EMLINK:       return NFS3ERR_MLINK;
+        case ENAMETOOLONG: return NFS3ERR_NAMETOOLONG;
+        case ENOTEMPTY:    return NFS3ERR_NOTEMPTY;
+#ifdef EDQUOT
+        case EDQUOT:       return NFS3ERR_DQUOT;
+#endif
+        default:
+            return NFS3ERR_IO;
+    }
+}
+
+//----- sattr3
+
+struct SAttr3 {
+    uint32_t       mode;
+    uint32_t       uid;
+    uint32_t       gid;
+    bool           setSize;
+    uint64_t       size;
+    uint32_t       setAtime;
+    struct timeval atime;
+    uint32_t       setMtime;
+    struct timeval mtime;
+};
+
+static void read_time(XDRInput* xin, uint32_t& how, struct timeval& time) {
+    uint32_t sec  = 0;
+    uint32_t nsec = 0;
+    xin->read(&how);
+    if(how == SET_TO_CLIENT_TIME) {
+        xin->read(&sec);
+        xin->read(&nsec);
+    }
+    time.tv_sec  = sec;
+    time.tv_usec = nsec / 1000;
+}
+
+static SAttr3 read_sattr(XDRInput* xin) {
+    SAttr3   result;
+    uint32_t set;
+
+    result.mode = result.uid = result.gid = FATTR_INVALID;
+    set = 0; xin->read(&set); if(set) xin->read(&result.mode);
+    set = 0; xin->read(&set); if(set) xin->read(&result.uid);
+    set = 0; xin->read(&set); if(set) xin->read(&result.gid);
+    set = 0; xin->read(&set); result.setSize = set != 0;
+    result.size = result.setSize ? read_uint64(xin) : 0;
+    read_time(xin, result.setAtime, result.atime);
+    read_time(xin, result.setMtime, result.mtime);
+    return result;
+}
+
+static int apply_sattr(const string& path, const SAttr3& sattr) {
+    if(FileAttrs::valid16(sattr.mode) || FileAttrs::valid16(sattr.uid) || FileAttrs::valid16(sattr.gid)) {
+        struct stat fstat;
+        memset(&fstat, 0, sizeof(fstat));
+        fstat.st_mode = sattr.mode;
+        fstat.st_uid  = sattr.uid;
+        fstat.st_gid  = sattr.gid;
+        fstat.st_rdev = FATTR_INVALID;
+#ifdef _WIN32
+        fstat.st_atime             = FATTR_INVALID;
+        fstat.st_mtime             = FATTR_INVALID;
+#else
+        fstat.st_atimespec.tv_sec  = FATTR_INVALID;
+        fstat.st_mtimespec.tv_sec  = FATTR_INVALID;
+#endif
+        set_attrs(path, FileAttrs(fstat));
+    }
+
+    if(sattr.setSize) {
+        if(int err = nfsd_fts[0]->vfsTruncate(path, sattr.size))
+            return err;
+    }
+
+    if(sattr.setAtime != DONT_CHANGE || sattr.setMtime != DONT_CHANGE) {
+        struct stat    fstat;
+        struct timeval now;
+        struct timeval times[2];
+        if(nfsd_fts[0]->vfsStat(path, fstat))
+            return errno;
+        gettimeofday(&now, NULL);
+#ifdef _WIN32
+        times[0].tv_sec  = fstat.st_atime;
+        times[0].tv_usec = 0;
+        times[1].tv_sec  = fstat.st_mtime;
+        times[1].tv_usec = 0;
+#else
+        times[0].tv_sec  = fstat.st_atimespec.tv_sec;
+        times[0].tv_usec = static_cast<int32_t>(fstat.st_atimespec.tv_nsec / 1000);
+        times[1].tv_sec  = fstat.st_mtimespec.tv_sec;
+        times[1].tv_usec = static_cast<int32_t>(fstat.st_mtimespec.tv_nsec / 1000);
+#endif
+        if     (sattr.setAtime == SET_TO_SERVER_TIME) times[0] = now;
+        else if(sattr.setAtime == SET_TO_CLIENT_TIME) times[0] = sattr.atime;
+        if     (sattr.setMtime == SET_TO_SERVER_TIME) times[1] = now;
+        else if(sattr.setMtime == SET_TO_CLIENT_TIME) times[1] = sattr.mtime;
+        if(int err = nfsd_fts[0]->vfsUtimes(path, times))
+            return err;
+    }
+    return 0;
+}
+
+// EXCLUSIVE CREATE keeps the client's verifier in atime and mtime of the new
+// file until the client sets the real attributes. A retransmitted CREATE
+// succeeds if the verifiers match.
+static bool exclusive_match(const string& path, const SAttr3& sattr) {
+    struct stat fstat;
+    if(nfsd_fts[0]->vfsStat(path, fstat))
+        return false;
+#ifdef _WIN32
+    return fstat.st_atime == sattr.atime.tv_sec && fstat.st_mtime == sattr.mtime.tv_sec;
+#else
+    return fstat.st_atimespec.tv_sec == sattr.atime.tv_sec && fstat.st_mtimespec.tv_sec == sattr.mtime.tv_sec;
+#endif
+}
+
+//----- procedures
+
+int CNFS3Prog::procedureGETATTR(void) {
+    string      path;
+    struct stat fstat;
+
+    getPath(path);
+    log("GETATTR %s", path.c_str());
+
+    uint32_t status = checkFile(path);
+    if(status == NFS3_OK && nfsd_fts[0]->stat(path, fstat))
+        status = nfs3_err(errno);
+    m_out->write(status);
+    if(status == NFS3_OK)
+        writeFileAttributes(path, fstat);
+    return PRC_OK;
+}
+
+int CNFS3Prog::procedureSETATTR(void) {
+    string   path;
+    uint64_t fhandle;
+    uint32_t check = 0;
+    uint32_t ctime_sec  = 0;
+    uint32_t ctime_nsec = 0;
+
+    getPath(path, &fhandle);
+    log("SETATTR %s", path.c_str());
+
+    SAttr3 sattr = read_sattr(m_in);
+    m_in->read(&check);
+    if(check) {
+        m_in->read(&ctime_sec);
+        m_in->read(&ctime_nsec);
+    }
+
+    uint32_t status = checkFile(path);
+    if(status == NFS3_OK && check) {
+        struct stat fstat;
+        if(nfsd_fts[0]->stat(path, fstat)) {
+            status = nfs3_err(errno);
+        } else {
+#ifdef _WIN32
+            if(static_cast<uint32_t>(fstat.st_ctime) != ctime_sec)
+#else
+            if(static_cast<uint32_t>(fstat.st_ctimespec.tv_sec)  != ctime_sec ||
+               static_cast<uint32_t>(fstat.st_ctimespec.tv_nsec) != ctime_nsec)
+#endif
+                status = NFS3ERR_NOT_SYNC;
+        }
+    }
+    if(status == NFS3_OK) {
+        nfsd_fts[0]->invalidate(fhandle);
+        status = nfs3_err(apply_sattr(path, sattr));
+    }
+
+    m_out->write(status);
+    writeWccData(path);
+    return PRC_OK;
+}
+
+int CNFS3Prog::procedureLOOKUP(void) {
+    string path;
+    string dir;
+
+    getFullPath(path, dir);
+    log("LOOKUP %s", path.c_str());
+
+    uint32_t status = checkFile(path);
+    uint64_t handle = 0;
+    if(status == NFS3_OK) {
+        handle = nfsd_fts[0]->getFileHandle(path);
+        if(!(handle)) status = NFS3ERR_NOENT;
+    }
+    m_out->write(status);
+    if(status == NFS3_OK) {
+        writeHandle(handle);
+        writePostOpAttributes(path);
+    }
+    writePostOpAttributes(dir);
+    return PRC_OK;
+}
+
+int CNFS3Prog::procedureACCESS(void) {
+    string      path;
+    uint32_t    access = 0;
+    struct stat fstat;
+
+    getPath(path);
+    m_in->read(&access);
+    log("ACCESS %s", path.c_str());
+
+    uint32_t status = checkFile(path);
+    if(status == NFS3_OK && nfsd_fts[0]->stat(path, fstat))
+        status = nfs3_err(errno);
+    m_out->write(status);
+    writePostOpAttributes(path);
+    if(status == NFS3_OK) {
+        // the guest user owns all exported files
+        uint32_t result = 0;
+        if(fstat.st_mode & S_IRUSR) result |= ACCESS3_READ;
+        if(fstat.st_mode & S_IWUSR) result |= ACCESS3_MODIFY | ACCESS3_EXTEND | ACCESS3_DELETE;
+        if(fstat.st_mode & S_IXUSR) result |= S_ISDIR(fstat.st_mode) ? ACCESS3_LOOKUP : ACCESS3_EXECUTE;
+        m_out->write(result & access);
+    }
+    return PRC_OK;
+}
+
+int CNFS3Prog::procedureREADLINK(void) {
+    string  path;
+    VFSPath result;
+
+    getPath(path);
+    log("READLINK %s", path.c_str());
+
+    uint32_t status = checkFile(path);
+    if(status == NFS3_OK)
+        status = nfs3_err(nfsd_fts[0]->vfsReadlink(path, result));
+    m_out->write(status);
+    writePostOpAttributes(path);
+    if(status == NFS3_OK) {
+        XDRString data(result.string());
+        m_out->write(data);
+    }
+    return PRC_OK;
+}
+
+int CNFS3Prog::procedureREAD(void) {
+    string   path;
+    uint64_t fhandle;
+    uint32_t count = 0;
+
+    getPath(path, &fhandle);
+    uint64_t offset = read_uint64(m_in);
+    m_in->read(&count);
+    log("READ %s", path.c_str());
+
+    uint32_t maxCount = m_param->sockType == SOCK_STREAM ? MAXDATA_TCP : MAXDATA_UDP;
+    if(count > maxCount) count = maxCount;
+
+    uint32_t  status = checkFile(path);
+    XDROpaque buffer(status == NFS3_OK ? count : 0);
+    if(status == NFS3_OK) {
+        ssize_t nRead = nfsd_fts[0]->read(fhandle, path, offset, buffer.m_data, buffer.m_size);
+        if(nRead >= 0) buffer.resize(nRead);
+        else           status = nfs3_err(errno);
+    }
+
+    m_out->write(status);
+    writePostOpAttributes(path);
+    if(status == NFS3_OK) {
+        struct stat fstat;
+        bool eof = nfsd_fts[0]->vfsStat(path, fstat) == 0 && offset + buffer.m_size >= static_cast<uint64_t>(fstat.st_size);
+        m_out->write(static_cast<uint32_t>(buffer.m_size));
+        m_out->write(eof ? 1 : 0);
+        m_out->write(buffer);
+    }
+    return PRC_OK;
+}
+
+int CNFS3Prog::procedureWRITE(void) {
+    string    path;
+    uint64_t  fhandle;
+    uint32_t  count  = 0;
+    uint32_t  stable = UNSTABLE;
+    XDROpaque buffer;
+
+    getPath(path, &fhandle);
+    uint64_t offset = read_uint64(m_in);
+    m_in->read(&count);
+    m_in->read(&stable);
+    m_in->read(buffer);
+    log("WRITE %s", path.c_str());
+
+    // unstable writes go to the host page cache and are flushed on COMMIT
+    uint32_t status = checkFile(path);
+    if(status == NFS3_OK && nfsd_fts[0]->write(fhandle, path, offset, buffer.m_data, buffer.m_size) < 0)
+        status = nfs3_err(errno);
+    if(status == NFS3_OK && stable != UNSTABLE)
+        status = nfs3_err(nfsd_fts[0]->sync(fhandle, path));
+
+    m_out->write(status);
+    writeWccData(path);
+    if(status == NFS3_OK) {
+        m_out->write(static_cast<uint32_t>(buffer.m_size));
+        m_out->write(stable == UNSTABLE ? UNSTABLE : FILE_SYNC);
+        write_uint64(m_out, WRITE_VERIFIER);
+    }
+    return PRC_OK;
+}
+
+int CNFS3Prog::procedureCREATE(void) {
+    string   path;
+    string   dir;
+    uint64_t dirHandle;
+    uint32_t how = UNCHECKED;
+    SAttr3   sattr;
+
+    if(!(getFullPath(path, dir, &dirHandle)))
+        return createResult(NFS3ERR_STALE, path, dir);
+    log("CREATE %s", path.c_str());
+    nfsd_fts[0]->invalidate(dirHandle);
+
+    m_in->read(&how);
+    if(how == EXCLUSIVE) {
+        uint32_t verf[2] = {0, 0};
+        m_in->read(&verf[0]);
+        m_in->read(&verf[1]);
+        sattr = SAttr3();
+        sattr.mode = sattr.uid = sattr.gid = FATTR_INVALID;
+        sattr.setAtime = sattr.setMtime = SET_TO_CLIENT_TIME;
+        sattr.atime.tv_sec = verf[0];
+        sattr.mtime.tv_sec = verf[1];
+    } else {
+        sattr = read_sattr(m_in);
+    }
+
+    if(!(FileAttrs::valid16(sattr.uid))) sattr.uid = nfsd_fts[0]->vfsGetUID(path, false);
+    if(!(FileAttrs::valid16(sattr.gid))) sattr.gid = nfsd_fts[0]->vfsGetGID(path, true);
+
+    if(nfsd_fts[0]->vfsAccess(path, F_OK) == 0) {
+        if(how == EXCLUSIVE && exclusive_match(path, sattr))
+            return createResult(NFS3_OK, path, dir);
+        if(how != UNCHECKED)
+            return createResult(NFS3ERR_EXIST, path, dir);
+    } else {
+        VFSFile file(*nfsd_fts[0], path, "wb");
+        if(!(file.isOpen()))
+            return createResult(nfs3_err(errno), path, dir);
+    }
+    return createResult(nfs3_err(apply_sattr(path, sattr)), path, dir);
+}
+
+int CNFS3Prog::procedureMKDIR(void) {
+    string   path;
+    string   dir;
+    uint64_t dirHandle;
+
+    if(!(getFullPath(path, dir, &dirHandle)))
+        return createResult(NFS3ERR_STALE, path, dir);
+    log("MKDIR %s", path.c_str());
+    nfsd_fts[0]->invalidate(dirHandle);
+
+    SAttr3 sattr = read_sattr(m_in);
+    int    err   = nfsd_fts[0]->vfsMkdir(path, DEFAULT_PERM);
+    if(!(err)) err = apply_sattr(path, sattr);
+    return createResult(nfs3_err(err), path, dir);
+}
+
+int CNFS3Prog::procedureSYMLINK(void) {
+    string    path;
+    string    dir;
+    uint64_t  dirHandle;
+    XDRString from;
+
+    if(!(getFullPath(path, dir, &dirHandle)))
+        return createResult(NFS3ERR_STALE, path, dir);
+    SAttr3 sattr = read_sattr(m_in);
+    m_in->read(from);
+    log("SYMLINK %s->%s", from.c_str(), path.c_str());
+    nfsd_fts[0]->invalidate(dirHandle);
+
+    int err = nfsd_fts[0]->vfsLink(from.c_str(), path, true);
+    if(!(err)) apply_sattr(path, sattr);
+    return createResult(nfs3_err(err), path, dir);
+}
+
+int CNFS3Prog::procedureMKNOD(void) {
+    string   path;
+    string   dir;
+    uint64_t dirHandle;
+    uint32_t type  = NF3NON;
+    uint32_t major = 0;
+    uint32_t minor = 0;
+    SAttr3   sattr;
+
+    if(!(getFullPath(path, dir, &dirHandle)))
+        return createResult(NFS3ERR_STALE, path, dir);
+    log("MKNOD %s", path.c_str());
+    nfsd_fts[0]->invalidate(dirHandle);
+
+    m_in->read(&type);
+    uint32_t format;
+    switch(type) {
+        case NF3CHR:  format = S_IFCHR;  break;
+        case NF3BLK:  format = S_IFBLK;  break;
+#ifndef _WIN32
+        case NF3SOCK: format = S_IFSOCK; break;
+        case NF3FIFO: format = S_IFIFO;  break;
+#endif
+        default:
+            return createResult(NFS3ERR_BADTYPE, path, dir);
+    }
+    sattr = read_sattr(m_in);
+    if(type == NF3CHR || type == NF3BLK) {
+        m_in->read(&major);
+        m_in->read(&minor);
+    }
+
+    // special files are empty host files with the format stored in the file attributes
+    if(nfsd_fts[0]->vfsAccess(path, F_OK) == 0)
+        return createResult(NFS3ERR_EXIST, path, dir);
+    {
+        VFSFile file(*nfsd_fts[0], path, "wb");
+        if(!(file.isOpen()))
+            return createResult(nfs3_err(errno), path, dir);
+    }
+    sattr.mode = format | (FileAttrs::valid16(sattr.mode) ? sattr.mode & 07777 : 0644);
+    if(int err = apply_sattr(path, sattr))
+        return createResult(nfs3_err(err), path, dir);
+    if(type == NF3CHR || type == NF3BLK) {
+        FileAttrs attrs = nfsd_fts[0]->getFileAttrs(path);
+        attrs.rdev = (major << 8) | (minor & 0xFF);
+        nfsd_fts[0]->setFileAttrs(path, attrs);
+    }
+    return createResult(NFS3_OK, path, dir);
+}
+
+int CNFS3Prog::procedureREMOVE(void) {
+    string   path;
+    string   dir;
+    uint64_t dirHandle;
+
+    getFullPath(path, dir, &dirHandle);
+    log("REMOVE %s", path.c_str());
+
+    uint32_t status = checkFile(path);
+    if(status == NFS3_OK) {
+        uint64_t fileHandle(nfsd_fts[0]->getFileHandle(path));
+        status = nfs3_err(nfsd_fts[0]->vfsRemove(path));
+        if(status == NFS3_OK) nfsd_fts[0]->remove(fileHandle);
+        nfsd_fts[0]->invalidate(dirHandle);
+    }
+    m_out->write(status);
+    writeWccData(dir);
+    return PRC_OK;
+}
+
+int CNFS3Prog::procedureRMDIR(void) {
+    string   path;
+    string   dir;
+    uint64_t dirHandle;
+
+    getFullPath(path, dir, &dirHandle);
+    log("RMDIR %s", path.c_str());
+
+    uint32_t status = checkFile(path);
+    if(status == NFS3_OK) {
+        uint64_t fileHandle(nfsd_fts[0]->getFileHandle(path));
+        status = nfs3_err(nfsd_fts[0]->vfsNftw(path, VirtualFS::remove, 3, FTW_DEPTH | FTW_PHYS));
+        if(status == NFS3_OK) nfsd_fts[0]->remove(fileHandle);
+        nfsd_fts[0]->invalidate(dirHandle);
+    }
+    m_out->write(status);
+    writeWccData(dir);
+    return PRC_OK;
+}
+
+int CNFS3Prog::procedureRENAME(void) {
+    string   pathFrom;
+    string   dirFrom;
+    uint64_t dirHandleFrom;
+    string   pathTo;
+    string   dirTo;
+    uint64_t dirHandleTo;
+
+    getFullPath(pathFrom, dirFrom, &dirHandleFrom);
+    getFullPath(pathTo,   dirTo,   &dirHandleTo);
+    log("RENAME %s->%s", pathFrom.c_str(), pathTo.c_str());
+
+    uint32_t status = checkFile(pathFrom);
+    if(status == NFS3_OK && dirTo.empty())
+        status = NFS3ERR_STALE;
+    if(status == NFS3_OK) {
+        uint64_t fileHandleFrom(nfsd_fts[0]->getFileHandle(pathFrom));
+        status = nfs3_err(nfsd_fts[0]->vfsRename(pathFrom, pathTo));
+        if(status == NFS3_OK) nfsd_fts[0]->move(fileHandleFrom, pathTo);
+        nfsd_fts[0]->invalidate(dirHandleFrom);
+        nfsd_fts[0]->invalidate(dirHandleTo);
+    }
+    m_out->write(status);
+    writeWccData(dirFrom);
+    writeWccData(dirTo);
+    return PRC_OK;
+}
+
+int CNFS3Prog::procedureLINK(void) {
+    string   from;
+    string   to;
+    string   dir;
+    uint64_t dirHandle;
+
+    getPath(from);
+    getFullPath(to, dir, &dirHandle);
+    log("LINK %s->%s", from.c_str(), to.c_str());
+
+    uint32_t status = checkFile(from);
+    if(status == NFS3_OK && dir.empty())
+        status = NFS3ERR_STALE;
+    if(status == NFS3_OK) {
+        status = nfs3_err(nfsd_fts[0]->vfsLink(from, to, false));
+        nfsd_fts[0]->invalidate(dirHandle);
+    }
+    m_out->write(status);
+    writePostOpAttributes(from);
+    writeWccData(dir);
+    return PRC_OK;
+}
+
+int CNFS3Prog::procedureREADDIR(void) {
+    return readDir(false);
+}
+
+int CNFS3Prog::procedureREADDIRPLUS(void) {
+    return readDir(true);
+}
+
+int CNFS3Prog::readDir(bool plus) {
+    string   path;
+    uint64_t fhandle;
+    uint32_t dirCount = 0;
+    uint32_t maxCount = 0;
+
+    getPath(path, &fhandle);
+    uint64_t cookie = read_uint64(m_in);
+    m_in->skip(8); // cookie verifier, cookies are indices into a stable, sorted listing
+    m_in->read(&dirCount);
+    if(plus) m_in->read(&maxCount);
+    else     maxCount = dirCount;
+    log("%s %s", plus ? "READDIRPLUS" : "READDIR", path.c_str());
+
+    vector<NFSDDirEntry> entries;
+    bool                 eof    = true;
+    uint32_t             status = checkFile(path);
+    if(status == NFS3_OK && cookie > 0xFFFFFFFF)
+        status = NFS3ERR_INVAL;
+    if(status == NFS3_OK)
+        status = nfs3_err(nfsd_fts[0]->readDir(fhandle, path, static_cast<uint32_t>(cookie), dirCount / ENTRY_SIZE + 1, entries, eof));
+
+    m_out->write(status);
+    writePostOpAttributes(path);
+    if(status != NFS3_OK)
+        return PRC_OK;
+
+    write_uint64(m_out, 0); // cookie verifier
+    for(size_t i = 0; i < entries.size(); i++) {
+        size_t entrySize = ENTRY_SIZE + ((entries[i].name.length() + 3) & ~3) + (plus ? ENTRYPLUS_SIZE : 0);
+        if(i && m_out->size() + entrySize + 8 > maxCount) {
+            eof = false;
+            break;
+        }
+        XDRString name(entries[i].name);
+        m_out->write(1);  //value follows
+        write_uint64(m_out, entries[i].fileId);
+        m_out->write(name);
+        write_uint64(m_out, ++cookie);
+        if(plus) {
+            if(entries[i].name == "." || entries[i].name == "..") {
+                m_out->write(0); // no attributes
+                m_out->write(0); // no handle
+            } else {
+                string entryPath(path);
+                if(entryPath[entryPath.length()-1] != '/') entryPath += "/";
+                entryPath += entries[i].name;
+                writePostOpAttributes(entryPath);
+                writePostOpHandle(entryPath);
+            }
+        }
+    }
+    m_out->write(0);  //no value follows
+    m_out->write(eof ? 1 : 0);
+    return PRC_OK;
+}
+
+int CNFS3Prog::procedureFSSTAT(void) {
+    string         path;
+    struct statvfs fsstat;
+
+    getPath(path);
+    log("FSSTAT %s", path.c_str());
+
+    memset(&fsstat, 0, sizeof(fsstat));
+    uint32_t status = checkFile(path);
+    if(status == NFS3_OK)
+        status = nfs3_err(nfsd_fts[0]->vfsStatvfs(path, fsstat));
+    m_out->write(status);
+    writePostOpAttributes(path);
+    if(status == NFS3_OK) {
+        write_uint64(m_out, static_cast<uint64_t>(fsstat.f_blocks) * fsstat.f_frsize); //total bytes
+        write_uint64(m_out, static_cast<uint64_t>(fsstat.f_bfree)  * fsstat.f_frsize); //free bytes
+        write_uint64(m_out, static_cast<uint64_t>(fsstat.f_bavail) * fsstat.f_frsize); //available bytes
+        write_uint64(m_out, fsstat.f_files);  //total files
+        write_uint64(m_out, fsstat.f_ffree);  //free files
+        write_uint64(m_out, fsstat.f_favail); //available files
+        m_out->write(0); //invarsec
+    }
+    return PRC_OK;
+}
+
+int CNFS3Prog::procedureFSINFO(void) {
+    string path;
+
+    getPath(path);
+    log("FSINFO %s", path.c_str());
+
+    uint32_t status = checkFile(path);
+    m_out->write(status);
+    writePostOpAttributes(path);
+    if(status == NFS3_OK) {
+        uint32_t maxData = m_param->sockType == SOCK_STREAM ? MAXDATA_TCP : MAXDATA_UDP;
+        m_out->write(maxData);     //rtmax
+        m_out->write(maxData);     //rtpref
+        m_out->write(BLOCK_SIZE);  //rtmult
+        m_out->write(maxData);     //wtmax
+        m_out->write(maxData);     //wtpref
+        m_out->write(BLOCK_SIZE);  //wtmult
+        m_out->write(MAXDATA_UDP); //dtpref
+        write_uint64(m_out, 0x7FFFFFFFFFFFFFFFULL); //maxfilesize
+        m_out->write(0);           //time_delta seconds
+        m_out->write(1000);        //time_delta nseconds, times are set with utimes
+        m_out->write(FSF3_LINK | FSF3_SYMLINK | FSF3_HOMOGENEOUS | FSF3_CANSETTIME);
+    }
+    return PRC_OK;
+}
+
+int CNFS3Prog::procedurePATHCONF(void) {
+    string path;
+
+    getPath(path);
+    log("PATHCONF %s", path.c_str());
+
+    uint32_t status = checkFile(path);
+    m_out->write(status);
+    writePostOpAttributes(path);
+    if(status == NFS3_OK) {
+        m_out->write(255);        //linkmax
+        m_out->write(MAXNAMELEN); //name_max
+        m_out->write(1);          //no_trunc
+        m_out->write(0);          //chown_restricted
+        m_out->write(0);          //case_insensitive
+        m_out->write(1);          //case_preserving
+    }
+    return PRC_OK;
+}
+
+int CNFS3Prog::procedureCOMMIT(void) {
+    string   path;
+    uint64_t fhandle;
+    uint32_t count = 0;
+
+    getPath(path, &fhandle);
+    read_uint64(m_in); // offset, the whole file is flushed
+    m_in->read(&count);
+    log("COMMIT %s", path.c_str());
+
+    uint32_t status = checkFile(path);
+    if(status == NFS3_OK)
+        status = nfs3_err(nfsd_fts[0]->sync(fhandle, path));
+    m_out->write(status);
+    writeWccData(path);
+    if(status == NFS3_OK)
+        write_uint64(m_out, WRITE_VERIFIER);
+    return PRC_OK;
+}
+
+//----- helpers
+
+bool CNFS3Prog::getPath(string& result, uint64_t* handle) {
+    XDROpaque fh;
+    uint64_t  data = 0;
+    m_in->read(fh);
+    if(fh.m_size >= sizeof(data))
+        memcpy(&data, fh.m_data, sizeof(data));
+    if(handle) *handle = data;
+    return nfsd_fts[0]->getCanonicalPath(data, result);
+}
+
+bool CNFS3Prog::getFullPath(string& result, string& dir, uint64_t* dirHandle) {
+    bool valid = getPath(dir, dirHandle);
+
+    XDRString name;
+    m_in->read(name);
+    if(!(valid)) {
+        result.clear();
+        dir.clear();
+        return false;
+    }
+    result = dir;
+    if(result[result.length()-1] != '/') result += "/";
+    result += name.c_str();
+    return true;
+}
+
+uint32_t CNFS3Prog::checkFile(const string& path) {
+    if (path.length() == 0)
+        return NFS3ERR_STALE;
+
+#ifndef _WIN32
+    // links always pass (will be resolved on the client side via readlink)
+    struct stat fstat;
+    if(nfsd_fts[0]->stat(path, fstat) == 0 && (fstat.st_mode & S_IFMT) == S_IFLNK)
+        return NFS3_OK;
+#endif
+
+    if(nfsd_fts[0]->vfsAccess(path, F_OK))
+        return NFS3ERR_NOENT;
+
+    return NFS3_OK;
+}
+
+void CNFS3Prog::writeHandle(uint64_t handle) {
+    uint64_t data[8] = {handle, 0, 0, 0, 0, 0, 0, 0};
+    m_out->write(FHSIZE_NFS3);
+    m_out->write(data, FHSIZE_NFS3);
+}
+
+void CNFS3Prog::writePostOpHandle(const string& path) {
+    uint64_t handle = path.empty() ? 0 : nfsd_fts[0]->getFileHandle(path);
+    if(handle) {
+        m_out->write(1);
+        writeHandle(handle);
+    } else {
+        m_out->write(0);
+    }
+}
+
+void CNFS3Prog::writePostOpAttributes(const string& path) {
+    struct stat fstat;
+    if(!(path.empty()) && nfsd_fts[0]->stat(path, fstat) == 0) {
+        m_out->write(1);
+        writeFileAttributes(path, fstat);
+    } else {
+        m_out->write(0);
+    }
+}
+
+void CNFS3Prog::writeWccData(const string& path) {
+    m_out->write(0); // no pre operation attributes
+    writePostOpAttributes(path);
+}
+
+int CNFS3Prog::createResult(int status, const string& path, const string& dir) {
+    m_out->write(status);
+    if(status == NFS3_OK) {
+        writePostOpHandle(path);
+        writePostOpAttributes(path);
+    }
+    writeWccData(dir);
+    return PRC_OK;
+}
+
+void CNFS3Prog::writeFileAttributes(const string& path, const struct stat& fstat) {
+    uint32_t type = NF3NON;
+    if     (S_ISREG (fstat.st_mode)) type = NF3REG;
+    else if(S_ISDIR (fstat.st_mode)) type = NF3DIR;
+    else if(S_ISBLK (fstat.st_mode)) type = NF3BLK;
+    else if(S_ISCHR (fstat.st_mode)) type = NF3CHR;
+#ifndef _WIN32
+    else if(S_ISLNK (fstat.st_mode)) type = NF3LNK;
+    else if(S_ISSOCK(fstat.st_mode)) type = NF3SOCK;
+    else if(S_ISFIFO(fstat.st_mode)) type = NF3FIFO;
+
+    m_out->write(type);                                     //type
+    m_out->write(fstat.st_mode & 07777);                    //mode
+    m_out->write(fstat.st_nlink);                           //nlink
+    m_out->write(fstat.st_uid);                             //uid
+    m_out->write(fstat.st_gid);                             //gid
+    write_uint64(m_out, fstat.st_size);                     //size
+    write_uint64(m_out, static_cast<uint64_t>(fstat.st_blocks) * 512); //used
+    m_out->write(static_cast<uint32_t>(fstat.st_rdev >> 8));   //rdev major
+    m_out->write(static_cast<uint32_t>(fstat.st_rdev & 0xFF)); //rdev minor
+    write_uint64(m_out, fstat.st_dev);                      //fsid
+    write_uint64(m_out, nfsd_fts[0]->fileId(fstat.st_ino)); //fileid
+    m_out->write(static_cast<uint32_t>(fstat.st_atimespec.tv_sec));  //atime
+    m_out->write(static_cast<uint32_t>(fstat.st_atimespec.tv_nsec)); //atime
+    m_out->write(static_cast<uint32_t>(fstat.st_mtimespec.tv_sec));  //mtime
+    m_out->write(static_cast<uint32_t>(fstat.st_mtimespec.tv_nsec)); //mtime
+    m_out->write(static_cast<uint32_t>(fstat.st_ctimespec.tv_sec));  //ctime
+    m_out->write(static_cast<uint32_t>(fstat.st_ctimespec.tv_nsec)); //ctime
+#else
+    uint64_t size = fstat.st_size;
+    if (type == NF3DIR && size == 0) {
+        size = BLOCK_SIZE;
+    }
+    m_out->write(type);                                               //type
+    m_out->write(static_cast<uint32_t>(fstat.st_mode & 07777));       //mode
+    m_out->write(static_cast<uint32_t>(fstat.st_nlink));              //nlink
+    m_out->write(static_cast<uint32_t>(fstat.st_uid));                //uid
+    m_out->write(static_cast<uint32_t>(fstat.st_gid));                //gid
+    write_uint64(m_out, size);                                        //size
+    write_uint64(m_out, (size + BLOCK_SIZE - 1) & ~(uint64_t)(BLOCK_SIZE - 1)); //used
+    m_out->write(static_cast<uint32_t>(fstat.st_rdev >> 8));          //rdev major
+    m_out->write(static_cast<uint32_t>(fstat.st_rdev & 0xFF));        //rdev minor
+    write_uint64(m_out, fstat.st_dev);                                //fsid
+    write_uint64(m_out, nfsd_fts[0]->fileId(nfsd_fts[0]->getFileHandle(path))); //fileid
+    m_out->write(static_cast<uint32_t>(fstat.st_atime));              //atime
+    m_out->write(static_cast<uint32_t>(0));                           //atime
+    m_out->write(static_cast<uint32_t>(fstat.st_mtime));              //mtime
+    m_out->write(static_cast<uint32_t>(0));                           //mtime
+    m_out->write(static_cast<uint32_t>(fstat.st_ctime));              //ctime
+    m_out->write(static_cast<uint32_t>(0));                           //ctime
+#endif
+}
@@ -0,0 +1,51 @@
+#ifndef _NFS3PROG_H_
+#define _NFS3PROG_H_
+
+#include <string>
+#include <sys/stat.h>
+
+#include "RPCProg.h"
+
+class CNFS3Prog : public CRPCProg
+{
+public:
+	CNFS3Prog();
+	~CNFS3Prog();
+
+protected:
+	int procedureGETATTR(void);
+	int procedureSETATTR(void);
+	int procedureLOOKUP(void);
+	int procedureACCESS(void);
+	int procedureREADLINK(void);
+	int procedureREAD(void);
+	int procedureWRITE(void);
+	int procedureCREATE(void);
+	int procedureMKDIR(void);
+	int procedureSYMLINK(void);
+	int procedureMKNOD(void);
+	int procedureREMOVE(void);
+	int procedureRMDIR(void);
+	int procedureRENAME(void);
+	int procedureLINK(void);
+	int procedureREADDIR(void);
+	int procedureREADDIRPLUS(void);
+	int procedureFSSTAT(void);
+	int procedureFSINFO(void);
+	int procedurePATHCONF(void);
+	int procedureCOMMIT(void);
+
+private:
+	bool     getPath(std::string& result, uint64_t* handle = NULL);
+	bool     getFullPath(std::string& result, std::string& dir, uint64_t* dirHandle = NULL);
+	uint32_t checkFile(const std::string& path);
+	void     writeHandle(uint64_t handle);
+	void     writePostOpHandle(const std::string& path);
+	void     writeFileAttributes(const std::string& path, const struct stat& fstat);
+	void     writePostOpAttributes(const std::string& path);
+	void     writeWccData(const std::string& path);
+	int      createResult(int err, const std::string& path, const std::string& dirPath);
+	int      readDir(bool plus);
+};
+
+#endif
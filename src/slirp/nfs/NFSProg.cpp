@@ -2,6 +2,7 @@
 #include "nfsd.h"
 
 CNFSProg::CNFSProg() : CRPCProg(PROG_NFS, 0, "nfsd") {
+    m_bConcurrent = true;
 }
 
 CNFSProg::~CNFSProg() {}
@@ -14,6 +15,9 @@ int CNFSProg::process(void) {
     if (m_param->version == 2) {
         m_NFS2Prog.setup(m_in, m_out, m_param);
         return m_NFS2Prog.process();
+    } else if (m_param->version == 3) {
+        m_NFS3Prog.setup(m_in, m_out, m_param);
+        return m_NFS3Prog.process();
     } else {
         log("Client requested NFS version %u which isn't supported.\n", m_param->version);
         return PRC_NOTIMP;
@@ -24,4 +28,5 @@ void CNFSProg::setLogOn(bool bLogOn) {
     CRPCProg::setLogOn(bLogOn);
 
     m_NFS2Prog.setLogOn(bLogOn);
+    m_NFS3Prog.setLogOn(bLogOn);
 }
@@ -3,6 +3,7 @@
 
 #include "RPCProg.h"
 #include "NFS2Prog.h"
+#include "NFS3Prog.h"
 
 class CNFSProg : public CRPCProg
 {
@@ -16,6 +17,7 @@ class CNFSProg : public CRPCProg
 
 private:
     CNFS2Prog  m_NFS2Prog;
+    CNFS3Prog  m_NFS3Prog;
 };
 
 #endif
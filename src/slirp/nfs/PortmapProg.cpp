@@ -4,6 +4,7 @@
 #include "PortmapProg.h"
 #include "nfsd.h"
 #include "XDRStream.h"
+#include "compat.h"
 
 CPortmapProg::CPortmapProg() : CRPCProg(PROG_PORTMAP, 2, "portmapd") {
     #define RPC_PROG_CLASS CPortmapProg
@@ -82,12 +83,12 @@ int CPortmapProg::procedureCALLIT(void) {
     param.proc       = proc;
     param.version    = vers;
     param.remoteAddr = m_param->remoteAddr;
+    param.sockType   = m_param->sockType;
 
     XDRInput  din(in);
     XDROutput dout;
     
-    cprog->setup(&din, &dout, &param);
-    int result = cprog->process();
+    int result = cprog->call(&din, &dout, &param);
     
     m_out->write(m_param->sockType == SOCK_STREAM ? cprog->getPortTCP() : cprog->getPortUDP());
     XDROpaque out(XDROpaque(dout.data(), dout.size()));
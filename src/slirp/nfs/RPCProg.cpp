@@ -2,17 +2,24 @@
 #include <stdio.h>
 
 #include "RPCProg.h"
+#include "compat.h"
 #include "TCPServerSocket.h"
 #include "UDPServerSocket.h"
 
 using namespace std;
 
-CRPCProg::CRPCProg(int progNum, int version, const string& name) : m_bLogOn(true), m_progNum(progNum), m_version(version), m_name(name), m_portTCP(0), m_portUDP(0) {
+thread_local ProcessParam* CRPCProg::m_param = NULL;
+thread_local XDRInput*     CRPCProg::m_in    = NULL;
+thread_local XDROutput*    CRPCProg::m_out   = NULL;
+
+CRPCProg::CRPCProg(int progNum, int version, const string& name) : m_bLogOn(true), m_progNum(progNum), m_version(version), m_name(name), m_portTCP(0), m_portUDP(0), m_hMutex(host_mutex_create()), m_bConcurrent(false) {
     #define RPC_PROG_CLASS CRPCProg
     SET_PROC(0, NULL);
 }
 
-CRPCProg::~CRPCProg() {}
+CRPCProg::~CRPCProg() {
+    host_mutex_destroy(m_hMutex);
+}
 
 void CRPCProg::init(uint16_t portTCP, uint16_t portUDP) {
     m_portTCP = portTCP;
@@ -28,6 +35,28 @@ void CRPCProg::setup(XDRInput* xin, XDROutput* xout, ProcessParam* param) {
     m_param = param;
 }
 
+// Calls are processed by the receive thread of their socket. Programs which
+// keep all their state in structures with their own locks (like NFS, see
+// FileTableNFSD) process calls from different sockets concurrently, the
+// calls of other programs are serialized. The call of the thread is
+// restored afterwards because portmap CALLIT calls another program.
+int CRPCProg::call(XDRInput* xin, XDROutput* xout, ProcessParam* param) {
+    XDRInput*     in    = m_in;
+    XDROutput*    out   = m_out;
+    ProcessParam* outer = m_param;
+    int           result;
+
+    setup(xin, xout, param);
+    if(m_bConcurrent) {
+        result = process();
+    } else {
+        NFSDLock lock(m_hMutex);
+        result = process();
+    }
+    setup(in, out, outer);
+    return result;
+}
+
 int CRPCProg::process(void) {
     PPROC  proc = &CRPCProg::procedureNOTIMPL;
     string name("NOTIMPL");
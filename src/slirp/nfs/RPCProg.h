@@ -32,6 +32,7 @@ typedef struct
 #ifdef __cplusplus
 
 #include "XDRStream.h"
+#include "host.h"
 #include <string>
 #include <vector>
 
@@ -52,6 +53,7 @@ public:
     
     void         init(uint16_t portTCP, uint16_t portUDP);
     void         setup(XDRInput* xin, XDROutput* xout, ProcessParam* param);
+    int          call(XDRInput* xin, XDROutput* xout, ProcessParam* param);
 	virtual int  process(void);
 	virtual void setLogOn(bool bLogOn);
     int          getProgNum(void) const;
@@ -71,9 +73,13 @@ protected:
     std::string              m_name;
     uint16_t                 m_portTCP;
     uint16_t                 m_portUDP;
-    ProcessParam*            m_param;
-    XDRInput*                m_in;
-    XDROutput*               m_out;
+    mutex_t*                 m_hMutex;      // serializes calls of programs which are not concurrent
+    bool                     m_bConcurrent; // program keeps no state between calls
+
+    // the call processed by the current thread, see call()
+    static thread_local ProcessParam* m_param;
+    static thread_local XDRInput*     m_in;
+    static thread_local XDROutput*    m_out;
 
     void           setProc(int procNum, const std::string& name, PPROC proc);
 	size_t         log(const char *format, ...) const;
@@ -2,6 +2,7 @@
 
 #include "RPCServer.h"
 #include "TCPServerSocket.h"
+#include "nfsd.h"
 
 #include "compat.h"
 
@@ -47,26 +48,158 @@ typedef struct
 	OPAQUE_AUTH verf;
 } RPC_HEADER;
 
-CRPCServer::CRPCServer() : m_hMutex(host_mutex_create()) {
+CRPCServer::CRPCServer(int nWorkers) : m_hMutex(host_mutex_create()), m_nWorkers(nWorkers) {
 }
 
 CRPCServer::~CRPCServer() {
+    std::vector<Worker*> workers;
+    {
+        NFSDLock lock(m_hMutex);
+        workers.swap(m_workers);
+    }
+    for(size_t i = 0; i < workers.size(); i++) {
+        {
+            NFSDLock lock(workers[i]->hMutex);
+            workers[i]->queue.push_back(NULL);
+            host_cond_signal(workers[i]->hCond);
+        }
+        host_thread_wait(workers[i]->hThread);
+        for(size_t j = 0; j < workers[i]->queue.size(); j++)
+            delete workers[i]->queue[j];
+        host_cond_destroy(workers[i]->hCond);
+        host_mutex_destroy(workers[i]->hMutex);
+        delete workers[i];
+    }
 	host_mutex_destroy(m_hMutex);
 }
 
+// The workers are started with the first program
 void CRPCServer::set(int nProg, CRPCProg *pRPCProg) {
+    NFSDLock lock(m_hMutex);
 	m_pProgTable[nProg].push_back(pRPCProg);  //set program handler
+    while(m_workers.size() < static_cast<size_t>(m_nWorkers)) {
+        Worker* worker  = new Worker;
+        worker->pServer = this;
+        worker->hMutex  = host_mutex_create();
+        worker->hCond   = host_cond_create();
+        worker->hThread = host_thread_create(workerThread, "RPCWorker", worker);
+        m_workers.push_back(worker);
+    }
+}
+
+CRPCProg* CRPCServer::getProg(int nProg, int sockType, int port) {
+    NFSDLock lock(m_hMutex);
+    std::map<int, std::vector<CRPCProg*> >::iterator it = m_pProgTable.find(nProg);
+    if (it == m_pProgTable.end() || it->second.empty())
+        return NULL;
+    
+    CRPCProg* prog = it->second[0];
+    for(size_t i = 0; i < it->second.size(); i++) {
+        if (sockType == SOCK_STREAM) {
+            if(it->second[i]->getPortTCP() == port)
+                prog = it->second[i];
+        } else {
+            if(it->second[i]->getPortUDP() == port)
+                prog = it->second[i];
+        }
+    }
+    return prog;
 }
 
 void CRPCServer::setLogOn(bool bLogOn) {
+    NFSDLock lock(m_hMutex);
     for (std::map<int, std::vector<CRPCProg*> >::iterator it = m_pProgTable.begin(); it != m_pProgTable.end(); it++)
         for(size_t i = 0; i < it->second.size(); i++)
             it->second[i]->setLogOn(bLogOn);
 }
 
-void CRPCServer::socketReceived(CSocket *pSocket, uint32_t header) {
-    NFSDLock lock(m_hMutex);
+static uint32_t get_uint32(const uint8_t* data) {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return ntohl(value);
+}
 
+// Calls with the same key are processed in order by the same worker. NFS
+// calls are keyed by their file handle: the first 12 bytes of the arguments
+// contain the 64 bit handle of FileTableNFSD in NFSv2 and, after the length,
+// in NFSv3. Calls of other programs are keyed by their program.
+static uint32_t call_key(const uint8_t* data, size_t size) {
+    if (size < 8 * 4)
+        return 0;
+    uint32_t prog = get_uint32(data + 3 * 4);
+    uint32_t proc = get_uint32(data + 5 * 4);
+    size_t   pos  = 8 * 4;
+    size_t   len  = get_uint32(data + 7 * 4);  //credential
+    if (len > size - pos || size - pos - ((len + 3) & ~3) < 2 * 4)
+        return prog;
+    pos += ((len + 3) & ~3);
+    len  = get_uint32(data + pos + 4);  //verifier
+    pos += 2 * 4;
+    if (prog != PROG_NFS || proc == 0 || len > size - pos || size - pos - ((len + 3) & ~3) < 12)
+        return prog;
+    pos += ((len + 3) & ~3);
+    
+    uint32_t key = 2166136261u;  //FNV-1a
+    for (size_t i = 0; i < 12; i++)
+        key = (key ^ data[pos + i]) * 16777619u;
+    return key;
+}
+
+// Queues a datagram call for the worker of its key, returns false if there
+// are no workers
+bool CRPCServer::queue(CSocket* pSocket) {
+    XDRInput* pInStream = pSocket->getInputStream();
+    Worker*   worker    = NULL;
+    {
+        NFSDLock lock(m_hMutex);
+        if (m_workers.empty())
+            return false;
+        worker = m_workers[call_key(pInStream->data(), pInStream->size()) % m_workers.size()];
+    }
+    if (pInStream->size() == 0)
+        return true;
+    
+    Call* call          = new Call;
+    call->pSocket       = pSocket;
+    call->remoteAddr    = *pSocket->getRemoteSockAddr();
+    call->remoteAddrStr = pSocket->getRemoteAddress();
+    call->data.assign(pInStream->data(), pInStream->data() + pInStream->size());
+    
+    NFSDLock lock(worker->hMutex);
+    worker->queue.push_back(call);
+    host_cond_signal(worker->hCond);
+    return true;
+}
+
+int CRPCServer::workerThread(void* pData) {
+    Worker*   worker = (Worker*)pData;
+    XDROutput out;
+    for (;;) {
+        Call* call;
+        {
+            NFSDLock lock(worker->hMutex);
+            while (worker->queue.empty())
+                host_cond_wait(worker->hCond, worker->hMutex, 1000);
+            call = worker->queue.front();
+            if (call == NULL)
+                break;
+            worker->queue.pop_front();
+        }
+        XDRInput in(&call->data[0], call->data.size());
+        worker->pServer->process(SOCK_DGRAM, call->pSocket->getServerPort(), &in, &out, 0, call->remoteAddrStr.c_str());
+        call->pSocket->send(&out, &call->remoteAddr);
+        delete call;
+    }
+    return 0;
+}
+
+// Every socket has its own receive thread. Stream calls are processed by it
+// in order. All datagram calls of a program arrive on its one UDP socket,
+// they are copied and processed by the workers if there are any. See
+// CRPCProg::call() for which calls are processed concurrently.
+void CRPCServer::socketReceived(CSocket *pSocket, uint32_t header) {
+    if (pSocket->getType() == SOCK_DGRAM && queue(pSocket))
+        return;
     XDRInput* pInStream = pSocket->getInputStream();
 	while (pInStream->hasData()) {
 		int nResult = process(pSocket->getType(), pSocket->getServerPort(), pInStream, pSocket->getOutputStream(), header, pSocket->getRemoteAddress());  //process input data
@@ -81,6 +214,7 @@ int CRPCServer::process(int sockType, int port, XDRInput* pInStream, XDROutput*
     size_t headerPos;
 	ProcessParam param;
 	int nResult;
+	CRPCProg* prog = NULL;
 
 	nResult = PRC_OK;
     header.header = headerIn;
@@ -109,9 +243,11 @@ int CRPCServer::process(int sockType, int port, XDRInput* pInStream, XDROutput*
 	pOutStream->write(MSG_ACCEPTED);
 	pOutStream->write(header.verf.flavor);
 	pOutStream->write(header.verf.length);
+	if (nResult != PRC_FAIL)
+		prog = getProg(header.prog, sockType, port);
 	if (nResult == PRC_FAIL)  //input data is truncated
 		pOutStream->write(GARBAGE_ARGS);
-	else if (m_pProgTable.find(header.prog) == m_pProgTable.end() || m_pProgTable[header.prog].empty())  //program is unavailable
+	else if (prog == NULL)  //program is unavailable
 		pOutStream->write(PROG_UNAVAIL);
 	else
 	{
@@ -121,18 +257,7 @@ int CRPCServer::process(int sockType, int port, XDRInput* pInStream, XDROutput*
 		param.remoteAddr = pRemoteAddr;
         param.sockType   = sockType;
         
-        CRPCProg* prog = m_pProgTable[header.prog][0];
-        for(int i = 0; i < m_pProgTable[header.prog].size(); i++) {
-            if (sockType == SOCK_STREAM) {
-                if(m_pProgTable[header.prog][i]->getPortTCP() == port)
-                    prog = m_pProgTable[header.prog][i];
-            } else {
-                if(m_pProgTable[header.prog][i]->getPortUDP() == port)
-                    prog = m_pProgTable[header.prog][i];
-            }
-        }
-        prog->setup(pInStream, pOutStream, &param);
-		nResult = prog->process();
+		nResult = prog->call(pInStream, pOutStream, &param);
 
 		if (nResult == PRC_NOTIMP)  //procedure is not implemented
 		{
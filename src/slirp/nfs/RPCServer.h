@@ -7,19 +7,44 @@
 #include "host.h"
 #include <map>
 #include <vector>
+#include <deque>
+#include <string>
+
+/* The number of worker threads which process datagram calls */
+#define RPC_WORKERS 4
 
 class CRPCServer : public ISocketListener {
 public:
-	CRPCServer();
+	CRPCServer(int nWorkers = RPC_WORKERS);
 	virtual ~CRPCServer();
 	void set(int nProg, CRPCProg* pRPCProg);
 	void setLogOn(bool bLogOn);
 	void socketReceived(CSocket* pSocket, uint32_t header);
 protected:
+    struct Call {
+        CSocket*             pSocket;
+        struct sockaddr_in   remoteAddr;
+        std::string          remoteAddrStr;
+        std::vector<uint8_t> data;
+    };
+    
+    struct Worker {
+        CRPCServer*        pServer;
+        mutex_t*           hMutex; // protects queue
+        cond_t*            hCond;
+        std::deque<Call*>  queue;  // NULL stops the worker
+        thread_t*          hThread;
+    };
+    
     std::map<int, std::vector<CRPCProg*> > m_pProgTable;
-	mutex_t*                               m_hMutex;
+	mutex_t*                               m_hMutex; // protects m_pProgTable and m_workers
+    std::vector<Worker*>                   m_workers;
+    int                                    m_nWorkers;
     
+    CRPCProg* getProg(int nProg, int sockType, int port);
     int process(int nType, int port, XDRInput* pInStream, XDROutput* pOutStream, uint32_t headerIn, const char* pRemoteAddr);
+    bool queue(CSocket* pSocket);
+    static int workerThread(void* pData);
 };
 
 #endif
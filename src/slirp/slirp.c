@@ -127,6 +127,8 @@ static void slirp_cleanup(void)
 }
 #endif
 
+static void updtime(void);
+
 int slirp_init(struct in_addr *guest_addr)
 {
     // debug_init("/tmp/slirp.log", DEBUG_DEFAULT);
@@ -145,6 +147,10 @@ int slirp_init(struct in_addr *guest_addr)
 
     link_up = 1;
 
+    /* UDP sockets set their expiry time from curtime, which is otherwise
+     * only updated by slirp_select_poll */
+    updtime();
+
     if_init();
     ip_init();
 
@@ -215,12 +221,18 @@ int slirp_select_fill(int *pnfds,
 		 * *_slowtimo needs calling if there are IP fragments
 		 * in the fragment queue, or there are TCP connections active
 		 */
-		do_slowtimo = ((tcb.so_next != &tcb) ||
-			 (&ipq.ip_link != ipq.ip_link.next));
+		do_slowtimo = (&ipq.ip_link != ipq.ip_link.next);
 	
 		for (so = tcb.so_next; so != &tcb; so = so_next) {
 			so_next = so->so_next;
 			
+			/*
+			 * Listening sockets have no timers running, unless
+			 * they accept only once and have to time out
+			 */
+			if ((so->so_state & (SS_FACCEPTCONN|SS_FACCEPTONCE)) != SS_FACCEPTCONN)
+				do_slowtimo = 1;
+			
 			/*
 			 * See if we need a tcp_fasttimo
 			 */
@@ -341,9 +353,10 @@ int slirp_select_fill(int *pnfds,
 
 	/*
 	 * Adjust the timeout to make the minimum timeout
-	 * 2ms (XXX?) to lessen the CPU load
+	 * 2ms (XXX?) to lessen the CPU load. Without pending
+	 * timers return -1, the caller can then wait for I/O.
 	 */
-	if (timeout < (FAST_TIMO * 1000))
+	if (timeout >= 0 && timeout < (FAST_TIMO * 1000))
 		timeout = FAST_TIMO * 1000;
 
 	return timeout;
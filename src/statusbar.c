@@ -621,6 +621,10 @@ void Statusbar_Update(SDL_Surface *surf) {
 	SDL_Rect rect;
 	int i;
 
+	if (!surf) {
+		/* no screen in headless mode */
+		return;
+	}
 	if (!(StatusbarHeight && ConfigureParams.Screen.bShowStatusbar)) {
 		/* not enabled (anymore), show overlay led instead? */
 		if (ConfigureParams.Screen.bShowDriveLed) {
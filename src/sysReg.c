@@ -13,6 +13,7 @@
 #include "rtcnvram.h"
 #include "statusbar.h"
 #include "host.h"
+#include "memorySnapShot.h"
 
 #define LOG_SCR_LEVEL       LOG_DEBUG
 #define LOG_HARDCLOCK_LEVEL LOG_DEBUG
@@ -82,6 +83,19 @@ static Uint8 scr2_3=0x00;
 
 Uint32 scrIntStat=0x00000000;
 Uint32 scrIntMask=0x00000000;
+int    scrIntLevel=0;
+
+/* Recompute the interrupt level and make the cpu check it before the
+ * next instruction if it changed.
+ */
+static void scr_update_interrupt_level(void) {
+    int level = scr_get_interrupt_level(scrIntStat&scrIntMask);
+
+    if (level != scrIntLevel) {
+        scrIntLevel = level;
+        M68000_SetSpecial(SPCFLAG_INT);
+    }
+}
 
 /* System Control Register 1
  *
@@ -156,6 +170,7 @@ void SCR_Reset(void) {
     scr2_3=0x00;
     scrIntStat=0x00000000;
     scrIntMask=0x00000000;
+    scrIntLevel=0;
 
     Statusbar_SetSystemLed(false);
     rtc_interface_reset();
@@ -373,6 +388,7 @@ void SCR2_Write2(void)
     if (changed_bits&SCR2_TIMERIPL7) {
         Log_Printf(LOG_WARN,"[SCR2] TIMER IPL7 change at $%08x val=%x PC=$%08x\n",
                    IoAccessCurrentAddress,scr2_2&SCR2_TIMERIPL7,m68k_getpc());
+        scr_update_interrupt_level();
     }
 
     /* RTC enabled */
@@ -455,14 +471,15 @@ void set_dsp_interrupt(Uint8 state) {
 }
 
 void set_interrupt(Uint32 intr, Uint8 state) {
-    /* The interrupt gets polled by the cpu via intlev()
-     * --> see previous-glue.c
+    /* The cpu reads the interrupt level via intlev() when
+     * SPCFLAG_INT is set --> see newcpu.c
      */
     if (state==SET_INT) {
         scrIntStat |= intr;
     } else {
         scrIntStat &= ~intr;
     }
+    scr_update_interrupt_level();
 }
 
 int scr_get_interrupt_level(Uint32 interrupt) {
@@ -509,6 +526,7 @@ void IntRegMaskWrite(void) {
         scrIntMask |= INT_NONMASKABLE;
     }
     Log_Printf(LOG_DEBUG, "Interrupt mask: %08x", scrIntMask);
+    scr_update_interrupt_level();
 }
 
 
@@ -622,3 +640,30 @@ void color_video_interrupt(void) {
         col_vid_intr &= ~VID_CMD_ENABLE_INT;
     }
 }
+
+
+/* Save/restore system control registers, hardclock and event counter */
+
+void SCR_MemorySnapShot_Capture(bool bSave) {
+    MemorySnapShot_Store(&SCR_ROM_overlay, sizeof(SCR_ROM_overlay));
+    MemorySnapShot_Store(&scr1, sizeof(scr1));
+    MemorySnapShot_Store(&scr2_0, sizeof(scr2_0));
+    MemorySnapShot_Store(&scr2_1, sizeof(scr2_1));
+    MemorySnapShot_Store(&scr2_2, sizeof(scr2_2));
+    MemorySnapShot_Store(&scr2_3, sizeof(scr2_3));
+    MemorySnapShot_Store(&scrIntStat, sizeof(scrIntStat));
+    MemorySnapShot_Store(&scrIntMask, sizeof(scrIntMask));
+    MemorySnapShot_Store(&hardclock_csr, sizeof(hardclock_csr));
+    MemorySnapShot_Store(&hardclock1, sizeof(hardclock1));
+    MemorySnapShot_Store(&hardclock0, sizeof(hardclock0));
+    MemorySnapShot_Store(&latch_hardclock, sizeof(latch_hardclock));
+    MemorySnapShot_Store(&hardClockLastLatch, sizeof(hardClockLastLatch));
+    MemorySnapShot_Store(&sysTimerOffset, sizeof(sysTimerOffset));
+    MemorySnapShot_Store(&resetTimer, sizeof(resetTimer));
+    MemorySnapShot_Store(&col_vid_intr, sizeof(col_vid_intr));
+    
+    if (!bSave) {
+        scrIntLevel = scr_get_interrupt_level(scrIntStat&scrIntMask);
+        M68000_SetSpecial(SPCFLAG_INT);
+    }
+}
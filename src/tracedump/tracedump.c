@@ -0,0 +1,168 @@
+/*
+  Previous - tracedump.c
+
+  This file is distributed under the GNU Public License, version 2 or at
+  your option any later version. Read the file gpl.txt for details.
+
+  Decoder for binary event traces written with --evtrace. The records
+  of all rings are merged by emulated cycle and printed as text.
+
+  usage: tracedump <trace_file> [bus,dma,esp,scsi,i860]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "evtrace_format.h"
+
+typedef struct {
+    evtrace_record_t rec;
+    uint32_t         ring;
+    uint32_t         seq;
+} record_t;
+
+static const char* subsystems[] = {
+#define EVTRACE_SUB(sub, name) name,
+    EVTRACE_SUBSYSTEMS
+#undef EVTRACE_SUB
+};
+
+static const struct {
+    uint32_t    event;
+    const char* fmt;
+} events[] = {
+#define EVTRACE_EVENT(ev, sub, num, fmt) {ev, fmt},
+    EVTRACE_EVENTS
+#undef EVTRACE_EVENT
+};
+
+#define NUM_EVENTS (sizeof(events)/sizeof(events[0]))
+
+static int compare_records(const void* a, const void* b) {
+    const record_t* ra = (const record_t*)a;
+    const record_t* rb = (const record_t*)b;
+
+    if (ra->rec.cycles != rb->rec.cycles) return ra->rec.cycles < rb->rec.cycles ? -1 : 1;
+    if (ra->ring != rb->ring)             return ra->ring < rb->ring ? -1 : 1;
+    return ra->seq < rb->seq ? -1 : ra->seq > rb->seq;
+}
+
+static uint32_t parse_mask(const char* str) {
+    uint32_t mask = 0;
+    char     name[16];
+    size_t   len;
+    int      i;
+
+    while (*str) {
+        len = strcspn(str, ",");
+        if (len >= sizeof(name)) len = sizeof(name) - 1;
+        memcpy(name, str, len);
+        name[len] = '\0';
+        str += strcspn(str, ",");
+        if (*str) str++;
+
+        for (i = 0; i < EVTRACE_NUM_SUBSYSTEMS; i++) {
+            if (!strcmp(name, subsystems[i])) {
+                mask |= 1 << i;
+                break;
+            }
+        }
+        if (i == EVTRACE_NUM_SUBSYSTEMS) {
+            fprintf(stderr, "Unknown subsystem '%s'\n", name);
+            exit(1);
+        }
+    }
+    return mask;
+}
+
+static void print_record(const record_t* r, char names[][24]) {
+    const uint32_t* a   = r->rec.arg;
+    uint32_t        sub = EVTRACE_SUB_OF(r->rec.event);
+    size_t          i;
+
+    printf("%14llu %-16.24s %-4s ", (unsigned long long)r->rec.cycles, names[r->ring],
+           sub < EVTRACE_NUM_SUBSYSTEMS ? subsystems[sub] : "?");
+
+    for (i = 0; i < NUM_EVENTS; i++) {
+        if (events[i].event == r->rec.event) {
+            printf(events[i].fmt, a[0], a[1], a[2], a[3]);
+            printf("\n");
+            return;
+        }
+    }
+    printf("unknown event %04X: %08X %08X %08X %08X\n", r->rec.event, a[0], a[1], a[2], a[3]);
+}
+
+int main(int argc, char* argv[]) {
+    evtrace_header_t      header;
+    evtrace_ring_header_t ringHeader;
+    record_t*             records = NULL;
+    char                (*names)[24];
+    size_t                count = 0;
+    size_t                i;
+    uint32_t              mask  = (1 << EVTRACE_NUM_SUBSYSTEMS) - 1;
+    uint32_t              ring;
+    uint64_t              n;
+    FILE*                 fp;
+
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "usage: tracedump <trace_file> [bus,dma,esp,scsi,i860]\n");
+        return 1;
+    }
+    if (argc == 3) {
+        mask = parse_mask(argv[2]);
+    }
+
+    fp = fopen(argv[1], "rb");
+    if (!fp) {
+        perror(argv[1]);
+        return 1;
+    }
+    if (fread(&header, sizeof(header), 1, fp) != 1 ||
+        memcmp(header.magic, EVTRACE_MAGIC, sizeof(header.magic)) ||
+        header.version != EVTRACE_VERSION) {
+        fprintf(stderr, "%s: not an event trace of version %d\n", argv[1], EVTRACE_VERSION);
+        return 1;
+    }
+
+    names = calloc(header.rings ? header.rings : 1, sizeof(*names));
+    for (ring = 0; ring < header.rings; ring++) {
+        if (fread(&ringHeader, sizeof(ringHeader), 1, fp) != 1) {
+            fprintf(stderr, "%s: truncated ring header\n", argv[1]);
+            return 1;
+        }
+        memcpy(names[ring], ringHeader.name, sizeof(names[ring]));
+        names[ring][sizeof(names[ring])-1] = '\0';
+
+        if (ringHeader.records) {
+            records = realloc(records, (count + ringHeader.records) * sizeof(record_t));
+            if (!records) {
+                fprintf(stderr, "Out of memory\n");
+                return 1;
+            }
+        }
+        for (n = 0; n < ringHeader.records; n++) {
+            if (fread(&records[count].rec, sizeof(evtrace_record_t), 1, fp) != 1) {
+                fprintf(stderr, "%s: truncated ring '%s'\n", argv[1], names[ring]);
+                return 1;
+            }
+            if (mask & (1 << EVTRACE_SUB_OF(records[count].rec.event))) {
+                records[count].ring = ring;
+                records[count].seq  = n;
+                count++;
+            }
+        }
+    }
+    fclose(fp);
+
+    qsort(records, count, sizeof(record_t), compare_records);
+
+    for (i = 0; i < count; i++) {
+        print_record(&records[i], names);
+    }
+
+    free(records);
+    free(names);
+    return 0;
+}